@@ -5,6 +5,10 @@
 #define _FWTNotifiable_
 
 #import <FWTNotifiable/FWTNotifiableManager.h>
+#import <FWTNotifiable/FWTNotifiableOperation.h>
 #import <FWTNotifiable/FWTNotifiableLogger.h>
+#import <FWTNotifiable/FWTNotifiableMetrics.h>
+#import <FWTNotifiable/FWTDefaultNotifiableMetrics.h>
+#import <FWTNotifiable/FWTDefaultNotifiableLogger.h>
 
 #endif
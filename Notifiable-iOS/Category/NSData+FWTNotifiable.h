@@ -8,7 +8,13 @@
 
 @interface NSData (FWTNotifiable)
 
-/** Converts the notification token data into a NSString, removing invalid characters */
+/** Converts the notification token data into a lowercase hex NSString, cached on immutable data. Nil if the memory for the string can't be allocated. */
 - (NSString *)fwt_notificationTokenString;
 
+/** Gzip (RFC 1952) compressed copy of the data, or nil if the compression fails */
+- (NSData *)fwt_gzipCompressedData;
+
+/** Inflated copy of gzip (RFC 1952) compressed data, or nil if the data isn't a valid gzip stream */
+- (NSData *)fwt_gzipDecompressedData;
+
 @end
@@ -5,23 +5,127 @@
 //
 
 #import "NSData+FWTNotifiable.h"
+#import <objc/runtime.h>
+#import <zlib.h>
+
+// Window bits of 15 plus 16 makes zlib write the gzip header and trailer
+static int const FWTGzipWindowBits = 15 + 16;
+static int const FWTGzipMemoryLevel = 8;
+static NSUInteger const FWTGzipInflateChunkLength = 16384;
+static char FWTNotificationTokenStringKey[] = "FWTNotificationTokenString";
 
 @implementation NSData (FWTNotifiable)
 
-- (NSString *)hexString {
-    const unsigned char *bytes = (const unsigned char *)self.bytes;
-    NSMutableString *hex = [NSMutableString new];
-    for (NSInteger i = 0; i < self.length; i++) {
-        [hex appendFormat:@"%02x", bytes[i]];
+- (NSString *)fwt_notificationTokenString
+{
+    // The token data is not mutated once received, so the string is cached on the data and
+    // built only once for all the requests of the device. Mutable data is never cached.
+    NSString *cached = objc_getAssociatedObject(self, FWTNotificationTokenStringKey);
+    if (cached != nil) {
+        return cached;
     }
-    return [hex copy];
+    
+    NSString *tokenString = [self _fwt_hexString];
+    if (tokenString != nil && ![self isKindOfClass:[NSMutableData class]]) {
+        objc_setAssociatedObject(self, FWTNotificationTokenStringKey, tokenString, OBJC_ASSOCIATION_RETAIN);
+    }
+    return tokenString;
 }
 
-- (NSString *)fwt_notificationTokenString
+- (NSData *)fwt_gzipCompressedData
+{
+    if (self.length == 0 || self.length > UINT_MAX) {
+        return nil;
+    }
+    
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, FWTGzipWindowBits, FWTGzipMemoryLevel, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nil;
+    }
+    
+    // deflateBound is the worst case size, so the stream is compressed in a single pass
+    NSMutableData *compressed = [[NSMutableData alloc] initWithLength:deflateBound(&stream, (uLong)self.length)];
+    stream.next_in = (Bytef *)self.bytes;
+    stream.avail_in = (uInt)self.length;
+    stream.next_out = (Bytef *)compressed.mutableBytes;
+    stream.avail_out = (uInt)compressed.length;
+    
+    int status = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        return nil;
+    }
+    
+    [compressed setLength:stream.total_out];
+    return compressed;
+}
+
+- (NSData *)fwt_gzipDecompressedData
 {
-    NSString *tokenString = self.hexString;
-    NSString *clearToken = [[tokenString stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"<>"]] stringByReplacingOccurrencesOfString:@" " withString:@""];
-    return clearToken;
+    if (self.length == 0 || self.length > UINT_MAX) {
+        return nil;
+    }
+    
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, FWTGzipWindowBits) != Z_OK) {
+        return nil;
+    }
+    
+    // The inflated size isn't known upfront, so the output grows a chunk at a time
+    NSMutableData *decompressed = [[NSMutableData alloc] initWithLength:MAX(self.length * 2, FWTGzipInflateChunkLength)];
+    stream.next_in = (Bytef *)self.bytes;
+    stream.avail_in = (uInt)self.length;
+    
+    int status = Z_OK;
+    while (status == Z_OK) {
+        if (stream.total_out >= decompressed.length) {
+            [decompressed increaseLengthBy:FWTGzipInflateChunkLength];
+        }
+        stream.next_out = (Bytef *)decompressed.mutableBytes + stream.total_out;
+        stream.avail_out = (uInt)(decompressed.length - stream.total_out);
+        status = inflate(&stream, Z_NO_FLUSH);
+    }
+    inflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        return nil;
+    }
+    
+    [decompressed setLength:stream.total_out];
+    return decompressed;
+}
+
+#pragma mark - Private
+
+- (NSString *)_fwt_hexString
+{
+    NSUInteger length = self.length;
+    if (length == 0) {
+        return @"";
+    }
+    
+    static uint16_t table[256];
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        static char const digits[] = "0123456789abcdef";
+        for (NSUInteger byte = 0; byte < 256; byte++) {
+            char pair[2] = {digits[byte >> 4], digits[byte & 0xF]};
+            memcpy(&table[byte], pair, sizeof(pair));
+        }
+    });
+    
+    // Each byte is looked up as the two characters of its hex value and written straight into
+    // the buffer, which is then owned by the string without a copy.
+    uint8_t const *bytes = self.bytes;
+    char *hex = malloc(length * 2);
+    if (hex == NULL) {
+        return nil;
+    }
+    for (NSUInteger index = 0; index < length; index++) {
+        memcpy(hex + index * 2, &table[bytes[index]], sizeof(uint16_t));
+    }
+    return [[NSString alloc] initWithBytesNoCopy:hex length:length * 2 encoding:NSASCIIStringEncoding freeWhenDone:YES];
 }
 
 @end
@@ -15,13 +15,18 @@ NS_ASSUME_NONNULL_BEGIN
  - FWTErrorUserAliasMissing: The requested operation need the user alias information (HTTP 401).
  - FWTErrorForbidden: Authorization error (HTTP 403).
  - FWTErrorInvalidDeviceInformation: The request need more informations about the device.
+ - FWTErrorInvalidNotification: The notification doesn't have the n_id property.
+ - FWTErrorServiceUnavailable: The server is failing and the request was not sent.
+ - FWTErrorCancelled: The operation was cancelled, or superseded by a later one.
 */
 typedef NS_ENUM(NSInteger, FWTError) {
     FWTErrorInvalidOperation = -1004,
     FWTErrorUserAliasMissing,
     FWTErrorForbidden,
     FWTErrorInvalidDeviceInformation,
-    FWTErrorInvalidNotification
+    FWTErrorInvalidNotification,
+    FWTErrorServiceUnavailable,
+    FWTErrorCancelled
 };
 
 @interface NSError (FWTNotifiable)
@@ -87,6 +92,22 @@ typedef NS_ENUM(NSInteger, FWTError) {
  @param underlyingError Original error.
  */
 + (instancetype) fwt_invalidNotificationError:(NSError * _Nullable)underlyingError;
+/**
+ Create an error with the code FWTErrorServiceUnavailable.
+ 
+ @see FWTError
+ 
+ @param underlyingError Original error.
+ */
++ (instancetype) fwt_serviceUnavailableError:(NSError * _Nullable)underlyingError;
+/**
+ Create an error with the code FWTErrorCancelled.
+ 
+ @see FWTError
+ 
+ @param underlyingError Original error.
+ */
++ (instancetype) fwt_cancelledError:(NSError * _Nullable)underlyingError;
 
 - (NSString *) fwt_localizedMessage;
 
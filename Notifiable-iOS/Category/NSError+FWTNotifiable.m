@@ -74,6 +74,20 @@ static NSString * const FWTNotifiableErrorDomain = @"com.futureworkshops.FWTNoti
                 andUnderlyingError:underlyingError];
 }
 
++ (instancetype) fwt_serviceUnavailableError:(NSError * _Nullable)underlyingError
+{
+    return [self fwt_errorWithCode:FWTErrorServiceUnavailable
+                       description:@"The server is not available. Try again later."
+                andUnderlyingError:underlyingError];
+}
+
++ (instancetype) fwt_cancelledError:(NSError * _Nullable)underlyingError
+{
+    return [self fwt_errorWithCode:FWTErrorCancelled
+                       description:@"The operation was cancelled."
+                andUnderlyingError:underlyingError];
+}
+
 #pragma mark - Private methods
 
 + (instancetype) fwt_errorWithCode:(NSInteger)code
@@ -0,0 +1,24 @@
+//
+//  NSFileManager+FWTNotifiable.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface NSFileManager (FWTNotifiable)
+
+/**
+ Directory where the SDK keeps its files. When a group id is provided, the directory
+ lives in the shared group container, so it is accessible by the app extensions.
+ The directory is created if needed.
+ 
+ @param groupId Group id of the shared container. If nil, the app container is used.
+ */
+- (NSURL *)fwt_notifiableDirectoryWithGroupId:(NSString * _Nullable)groupId;
+
+@end
+
+NS_ASSUME_NONNULL_END
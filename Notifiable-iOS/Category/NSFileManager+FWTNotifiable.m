@@ -0,0 +1,29 @@
+//
+//  NSFileManager+FWTNotifiable.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "NSFileManager+FWTNotifiable.h"
+
+NSString * const FWTNotifiableDirectoryName = @"FWTNotifiable";
+
+@implementation NSFileManager (FWTNotifiable)
+
+- (NSURL *)fwt_notifiableDirectoryWithGroupId:(NSString * _Nullable)groupId
+{
+    NSURL *baseURL = nil;
+    if (groupId.length > 0) {
+        baseURL = [[self containerURLForSecurityApplicationGroupIdentifier:groupId] URLByAppendingPathComponent:@"Library/Application Support"
+                                                                                                   isDirectory:YES];
+    }
+    if (baseURL == nil) {
+        baseURL = [[self URLsForDirectory:NSApplicationSupportDirectory inDomains:NSUserDomainMask] firstObject];
+    }
+    
+    NSURL *directory = [baseURL URLByAppendingPathComponent:FWTNotifiableDirectoryName isDirectory:YES];
+    [self createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil];
+    return directory;
+}
+
+@end
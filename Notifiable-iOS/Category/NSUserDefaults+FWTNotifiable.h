@@ -19,6 +19,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (FWTServerConfiguration * _Nullable)storedConfiguration;
 - (void) storeConfiguration:(FWTServerConfiguration *)configuration;
+- (void) clearStoredConfiguration;
 
 - (void) syncronizeToGroupId:(NSString * _Nullable)groupId;
 
@@ -53,6 +53,11 @@
     [self synchronize];
 }
 
+- (void) clearStoredConfiguration {
+    [self removeObjectForKey:FWTNotifiableServerConfiguration];
+    [self synchronize];
+}
+
 - (void) clearStoredDevice {
     [self removeObjectForKey:FWTUserInfoNotifiableCurrentDeviceKey];
     [self synchronize];
@@ -0,0 +1,66 @@
+//
+//  FWTListenerRegistry.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@protocol FWTNotifiableManagerListener;
+
+/** Events of FWTNotifiableManagerListener that a listener implements */
+typedef NS_OPTIONS(NSUInteger, FWTListenerCapability) {
+    FWTListenerCapabilityNone = 0,
+    FWTListenerCapabilityDidRegisterToken = 1 << 0,
+    FWTListenerCapabilityDidReceiveNotification = 1 << 1,
+    FWTListenerCapabilityDidRegisterDevice = 1 << 2,
+    FWTListenerCapabilityDidFailToRegisterDevice = 1 << 3
+};
+
+/**
+ Weak list of listeners. The list is copied on each change, so sending an event only reads the
+ current snapshot, without waiting for the registrations.
+
+ The events that a listener implements are checked once, when it is registered. Each listener
+ receives its events in the order they were sent, on the queue given when it was registered.
+ */
+@interface FWTListenerRegistry : NSObject
+
+/** Number of listeners still alive */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ Register a listener. Registering a listener again has no effect.
+
+ @param queue Queue where the listener receives the events. Nil uses a background queue.
+ @return YES if the listener was added.
+ */
+- (BOOL)addListener:(id<FWTNotifiableManagerListener>)listener queue:(dispatch_queue_t _Nullable)queue;
+
+- (void)removeListener:(id<FWTNotifiableManagerListener>)listener;
+- (void)removeAllListeners;
+
+/**
+ Send an event to the listeners that implement it, each one on its own queue.
+
+ @param capability Event being sent.
+ @param block      Called once for each listener.
+ */
+- (void)notifyListenersWithCapability:(FWTListenerCapability)capability
+                           usingBlock:(void(^)(id<FWTNotifiableManagerListener> listener))block;
+
+/**
+ Send an event to the listeners that implement it, one after the other on the calling thread,
+ ignoring their queues. Used when the event must be handled before the caller goes on.
+ */
+- (void)notifyListenersInlineWithCapability:(FWTListenerCapability)capability
+                                 usingBlock:(void(^)(id<FWTNotifiableManagerListener> listener))block;
+
+/** Events implemented by an object */
++ (FWTListenerCapability)capabilitiesOfListener:(id)listener;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,159 @@
+//
+//  FWTListenerRegistry.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTListenerRegistry.h"
+#import "FWTNotifiableManager.h"
+
+NSString * const FWTListenerRegistryQueue = @"com.futureworkshops.notifiable.FWTListenerRegistry";
+
+@interface FWTListenerEntry : NSObject
+
+@property (nonatomic, weak, readonly) id<FWTNotifiableManagerListener> listener;
+@property (nonatomic, assign, readonly) FWTListenerCapability capabilities;
+/** Serial queue of the listener, targeting the queue it chose, so its events keep their order */
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+
+@end
+
+@implementation FWTListenerEntry
+
+- (instancetype)initWithListener:(id<FWTNotifiableManagerListener>)listener queue:(dispatch_queue_t)queue
+{
+    self = [super init];
+    if (self) {
+        self->_listener = listener;
+        self->_capabilities = [FWTListenerRegistry capabilitiesOfListener:listener];
+        self->_queue = dispatch_queue_create_with_target([FWTListenerRegistryQueue UTF8String], DISPATCH_QUEUE_SERIAL, queue);
+    }
+    return self;
+}
+
+@end
+
+@interface FWTListenerRegistry ()
+
+/** Replaced, never mutated, so it can be read while a listener is added */
+@property (atomic, copy) NSArray<FWTListenerEntry *> *entries;
+
+@end
+
+@implementation FWTListenerRegistry
+
++ (FWTListenerCapability)capabilitiesOfListener:(id)listener
+{
+    if (![listener conformsToProtocol:@protocol(FWTNotifiableManagerListener)]) {
+        return FWTListenerCapabilityNone;
+    }
+
+    FWTListenerCapability capabilities = FWTListenerCapabilityNone;
+    if ([listener respondsToSelector:@selector(applicationDidRegisterForRemoteNotificationsWithToken:)]) {
+        capabilities |= FWTListenerCapabilityDidRegisterToken;
+    }
+    if ([listener respondsToSelector:@selector(applicationDidReciveNotification:)]) {
+        capabilities |= FWTListenerCapabilityDidReceiveNotification;
+    }
+    if ([listener respondsToSelector:@selector(notifiableManager:didRegisterDevice:)]) {
+        capabilities |= FWTListenerCapabilityDidRegisterDevice;
+    }
+    if ([listener respondsToSelector:@selector(notifiableManager:didFailToRegisterDeviceWithError:)]) {
+        capabilities |= FWTListenerCapabilityDidFailToRegisterDevice;
+    }
+    return capabilities;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self->_entries = @[];
+    }
+    return self;
+}
+
+- (NSUInteger)count
+{
+    NSUInteger count = 0;
+    for (FWTListenerEntry *entry in self.entries) {
+        if (entry.listener != nil) {
+            count += 1;
+        }
+    }
+    return count;
+}
+
+- (BOOL)addListener:(id<FWTNotifiableManagerListener>)listener queue:(dispatch_queue_t)queue
+{
+    @synchronized(self) {
+        for (FWTListenerEntry *entry in self.entries) {
+            if (entry.listener == listener) {
+                return NO;
+            }
+        }
+
+        dispatch_queue_t targetQueue = queue ?: dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0);
+        FWTListenerEntry *entry = [[FWTListenerEntry alloc] initWithListener:listener queue:targetQueue];
+        self.entries = [[self _liveEntriesExcluding:nil] arrayByAddingObject:entry];
+        return YES;
+    }
+}
+
+- (void)removeListener:(id<FWTNotifiableManagerListener>)listener
+{
+    @synchronized(self) {
+        self.entries = [self _liveEntriesExcluding:listener];
+    }
+}
+
+- (void)removeAllListeners
+{
+    @synchronized(self) {
+        self.entries = @[];
+    }
+}
+
+- (void)notifyListenersWithCapability:(FWTListenerCapability)capability
+                           usingBlock:(void (^)(id<FWTNotifiableManagerListener>))block
+{
+    for (FWTListenerEntry *entry in self.entries) {
+        if ((entry.capabilities & capability) == 0) {
+            continue;
+        }
+        __weak FWTListenerEntry *weakEntry = entry;
+        dispatch_async(entry.queue, ^{
+            id<FWTNotifiableManagerListener> listener = weakEntry.listener;
+            if (listener) {
+                block(listener);
+            }
+        });
+    }
+}
+
+- (void)notifyListenersInlineWithCapability:(FWTListenerCapability)capability
+                                 usingBlock:(void (^)(id<FWTNotifiableManagerListener>))block
+{
+    for (FWTListenerEntry *entry in self.entries) {
+        id<FWTNotifiableManagerListener> listener = entry.listener;
+        if (listener != nil && (entry.capabilities & capability) != 0) {
+            block(listener);
+        }
+    }
+}
+
+#pragma mark - Private
+
+- (NSArray<FWTListenerEntry *> *)_liveEntriesExcluding:(id)listener
+{
+    NSMutableArray<FWTListenerEntry *> *entries = [[NSMutableArray alloc] initWithCapacity:self.entries.count];
+    for (FWTListenerEntry *entry in self.entries) {
+        id entryListener = entry.listener;
+        if (entryListener != nil && entryListener != listener) {
+            [entries addObject:entry];
+        }
+    }
+    return entries;
+}
+
+@end
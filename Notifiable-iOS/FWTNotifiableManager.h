@@ -14,9 +14,24 @@ extern NSString * const FWTNotifiableNotificationError;
 extern NSString * const FWTNotifiableNotificationDeviceToken;
 
 @protocol FWTNotifiableLogger;
+@protocol FWTNotifiableMetrics;
 
 @class FWTNotifiableDevice;
 @class FWTNotifiableManager;
+@class FWTNotifiableOperation;
+
+/**
+ Signature used to authenticate the requests sent to the server.
+ 
+ - FWTNotifiableSignatureHMACSHA1: `APIAuth` HMAC-SHA1, the body is not signed.
+ - FWTNotifiableSignatureHMACSHA256ContentMD5: `APIAuth-HMAC-SHA256`, signing the MD5 digest of the body.
+ - FWTNotifiableSignatureHMACSHA256ContentSHA256: `APIAuth-HMAC-SHA256`, signing the SHA256 digest of the body.
+ */
+typedef NS_ENUM(NSInteger, FWTNotifiableSignature) {
+    FWTNotifiableSignatureHMACSHA1,
+    FWTNotifiableSignatureHMACSHA256ContentMD5,
+    FWTNotifiableSignatureHMACSHA256ContentSHA256
+};
 
 typedef void (^FWTNotifiableOperationCompletionHandler)(FWTNotifiableDevice * _Nullable device, NSError * _Nullable error);
 typedef void (^FWTNotifiableListOperationCompletionHandler)(NSArray<FWTNotifiableDevice*> * _Nullable devices, NSError * _Nullable error);
@@ -48,6 +63,14 @@ NS_SWIFT_NAME(NotifiableManager)
 @property (nonatomic, assign) NSTimeInterval retryDelay;
 /** Level of the informations that will be logged by the manager */
 @property (nonatomic, strong) id<FWTNotifiableLogger> logger;
+/** Receives the latency, size and retries of the requests. Default: FWTDefaultNotifiableMetrics sharedMetrics */
+@property (nonatomic, strong, nullable) id<FWTNotifiableMetrics> metrics;
+/** Request bodies with at least this number of bytes are sent gzip compressed. Zero (default) disables the compression. */
+@property (nonatomic, assign) NSUInteger requestCompressionThreshold;
+/** Number of device updates that were not sent because nothing changed */
+@property (nonatomic, readonly, assign) NSUInteger avoidedUpdateCount;
+/** Queue where the completion handlers of the operations are called. Default: main queue */
+@property (nonatomic, strong) dispatch_queue_t callbackQueue;
 /** Current device. If the device is not registered, it will be nil. */
 @property (nonatomic, copy, readonly, nullable) FWTNotifiableDevice *currentDevice;
 
@@ -70,6 +93,30 @@ NS_SWIFT_NAME(NotifiableManager)
  */
 + (void)application:(UIApplication *)application didRegisterForRemoteNotificationsWithDeviceToken:(nonnull NSData *)deviceToken NS_SWIFT_NAME(application(_:didRegisterForRemoteNotificationsWithDeviceToken:));
 
+#pragma mark - Background uploads
+/**
+ When enabled, the notification receipts are uploaded through a background URL session, so they
+ reach the server even if the app is suspended right after the notification is opened. The app
+ delegate needs to forward application:handleEventsForBackgroundURLSession:completionHandler:.
+ Disabled by default.
+
+ The system can delay a background upload, and the request keeps the Date and Authorization headers
+ signed when it was created. When the server rejects an upload with a 401 because the signature
+ expired, the receipts are left in the outbox and sent again right away with a new signature.
+ */
+@property (class, nonatomic, assign) BOOL backgroundReceiptUploads;
+
+/**
+ Inform the Notifiable Manager that the system relaunched the application to deliver the events of
+ a background session.
+
+ @param application       Application that received the events
+ @param identifier        Identifier of the background session
+ @param completionHandler Handler given by the system, called once the events were handled
+ @return YES if the session belongs to the SDK. Otherwise, the completion handler is not used.
+ */
++ (BOOL)application:(UIApplication *)application handleEventsForBackgroundURLSession:(NSString *)identifier completionHandler:(void (^)(void))completionHandler NS_SWIFT_NAME(application(_:handleEventsForBackgroundURLSession:completionHandler:));
+
 #pragma mark - Listener operations
 /**
  Register an object to be informed when a asynchronous operation related to the managers is performed
@@ -77,6 +124,13 @@ NS_SWIFT_NAME(NotifiableManager)
  */
 + (void)registerManagerListener:(id<FWTNotifiableManagerListener>)listener NS_SWIFT_NAME(register(_:));
 
+/**
+ Register an object to be informed when a asynchronous operation related to the managers is performed
+ @param listener    Object to listen for the notifications
+ @param queue       Queue where the listener receives the notifications, in the order they were sent. Nil uses a background queue.
+ */
++ (void)registerManagerListener:(id<FWTNotifiableManagerListener>)listener queue:(dispatch_queue_t _Nullable)queue NS_SWIFT_NAME(register(_:queue:));
+
 /**
  Unregister an object previously registered as listener
  @param listener    Object previously registered
@@ -223,7 +277,8 @@ NS_SWIFT_NAME(NotifiableManager)
        andNotificationBlock:(_Nullable FWTNotifiableDidReceiveNotificationBlock)notificationBlock NS_SWIFT_NAME(init(url:accessId:secretKey:didRegister:didRecieve:))   DEPRECATED_MSG_ATTRIBUTE("Use the configureWithURL:accessId:secretKey: and simpler initializer instead");
 
 /**
-Init a notifiable manager with the configurations of the Notifiable-Rails server
+Init a notifiable manager with the configurations of the Notifiable-Rails server.
+The requests are performed by a session owned by the SDK, shared by all the managers.
  
 @see <a href="https://github.com/FutureWorkshops/notifiable-rails">Notifiable-Rails gem</a>
 
@@ -251,7 +306,8 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
                     andNotificationBlock:(_Nullable FWTNotifiableDidReceiveNotificationBlock)notificationBlock NS_SWIFT_NAME(init(session:didRegister:didRecieve:));
 
 /**
- Init a notifiable manager with the configurations of the Notifiable-Rails server
+ Init a notifiable manager with the configurations of the Notifiable-Rails server.
+ The requests are performed by a session owned by the SDK, shared by all the managers.
  
  @see <a href="https://github.com/FutureWorkshops/notifiable-rails">Notifiable-Rails gem</a>
  
@@ -306,6 +362,21 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
                 secretKey:(NSString *)secretKey
                   groupId:(NSString * _Nullable)groupId NS_SWIFT_NAME(configure(url:accessId:secretKey:groupId:));
 
+/**
+ This method configures the SDK to a specific Notifiable configuration
+ 
+ @param url         URL of the Notifiable server
+ @param accessId    Access Id of the specific application
+ @param secretKey   Secret Key of the specific application
+ @param signature   Signature expected by the server. Default: FWTNotifiableSignatureHMACSHA1
+ @param groupId     Context to which this configuration will be available
+ */
++ (void) configureWithURL:(NSURL *)url
+                 accessId:(NSString *)accessId
+                secretKey:(NSString *)secretKey
+                signature:(FWTNotifiableSignature)signature
+                  groupId:(NSString * _Nullable)groupId NS_SWIFT_NAME(configure(url:accessId:secretKey:signature:groupId:));
+
 #pragma mark - Register Anonymous device
 
 /**
@@ -317,11 +388,12 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
  @param locale              The locale of the device.
  @param customProperties   Aditional information about the device.
  @param handler             Block called once that the operation is finished.
+ @return Operation that can be cancelled. Later registrations on this manager supersede it.
  */
--(void)registerAnonymousDeviceWithName:(NSString * _Nullable)name
-                                locale:(NSLocale * _Nullable)locale
-                      customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-                  andCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(register(name:locale:properties:completion:));
+- (FWTNotifiableOperation *)registerAnonymousDeviceWithName:(NSString * _Nullable)name
+                                                     locale:(NSLocale * _Nullable)locale
+                                           customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                                       andCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(register(name:locale:properties:completion:));
 
 /**
  Register a device, without a user associated to it, but with a name to represent the device.
@@ -333,12 +405,13 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
  @param customProperties   Aditional information about the device.
  @param platformProperties  Aditional information that can be send as extra settings on the server
  @param handler             Block called once that the operation is finished.
+ @return Operation that can be cancelled. Later registrations on this manager supersede it.
  */
--(void)registerAnonymousDeviceWithName:(NSString * _Nullable)name
-                                locale:(NSLocale * _Nullable)locale
-                      customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-                    platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-                  andCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(register(name:locale:properties:platform:completion:));
+- (FWTNotifiableOperation *)registerAnonymousDeviceWithName:(NSString * _Nullable)name
+                                                     locale:(NSLocale * _Nullable)locale
+                                           customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                                         platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                                       andCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(register(name:locale:properties:platform:completion:));
 
 #pragma mark - Register device to a specific user
 
@@ -353,12 +426,13 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
  @param userAlias   The alias of the user in the server.
  @param customProperties   Aditional information about the device
  @param handler     Block called once that the operation is finished.
+ @return Operation that can be cancelled. Later registrations on this manager supersede it.
  */
-- (void)registerDeviceWithName:(NSString * _Nullable)deviceName
-                     userAlias:(NSString *)userAlias
-                        locale:(NSLocale * _Nullable)locale
-              customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-          andCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(register(name:userAlias:locale:properties:completion:));
+- (FWTNotifiableOperation *)registerDeviceWithName:(NSString * _Nullable)deviceName
+                                         userAlias:(NSString *)userAlias
+                                            locale:(NSLocale * _Nullable)locale
+                                  customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                              andCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(register(name:userAlias:locale:properties:completion:));
 
 /**
  Register a device, with a user associated to it, but with a name to represent the device.
@@ -372,13 +446,14 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
  @param customProperties   Aditional information about the device
  @param platformProperties  Aditional information that can be send as extra settings on the server
  @param handler     Block called once that the operation is finished.
+ @return Operation that can be cancelled. Later registrations on this manager supersede it.
  */
-- (void)registerDeviceWithName:(NSString * _Nullable)deviceName
-                     userAlias:(NSString *)userAlias
-                        locale:(NSLocale * _Nullable)locale
-              customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-            platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-          andCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(register(name:userAlias:locale:properties:platform:completion:));
+- (FWTNotifiableOperation *)registerDeviceWithName:(NSString * _Nullable)deviceName
+                                         userAlias:(NSString *)userAlias
+                                            locale:(NSLocale * _Nullable)locale
+                                  customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                                platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                              andCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(register(name:userAlias:locale:properties:platform:completion:));
 
 #pragma mark - Update device information
 /**
@@ -386,54 +461,60 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
  
  @param token   New device token.
  @param handler Block called once that the operation is finished.
+ @return Operation that can be cancelled.
 */
-- (void)updateDeviceToken:(NSData *)token
-        completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:completion:));
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData *)token
+                            completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:completion:));
 /**
  Update the device locale.
  
  @param locale  New device locale.
  @param handler Block called once that the operation is finished.
+ @return Operation that can be cancelled.
 */
-- (void)updateDeviceLocale:(NSLocale *)locale
-         completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(locale:completion:));
+- (FWTNotifiableOperation *)updateDeviceLocale:(NSLocale *)locale
+                             completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(locale:completion:));
 /**
  Update the device token and locale.
  
  @param token   New device token.
  @param locale  New device locale.
  @param handler Block called once that the operation is finished.
+ @return Operation that can be cancelled.
 */
-- (void)updateDeviceToken:(NSData *)token
-              andLocation:(NSLocale *)locale
-        completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:locale:completion:));
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData *)token
+                                  andLocation:(NSLocale *)locale
+                            completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:locale:completion:));
 
 /**
  Update the device name
  
  @param name    The name of the device in the server (not related to the user).
  @param handler Block called once that the operation is finished.
+ @return Operation that can be cancelled.
 */
-- (void)updateDeviceName:(NSString *)name
-       completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(name:completion:));
+- (FWTNotifiableOperation *)updateDeviceName:(NSString *)name
+                           completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(name:completion:));
 
 /**
  Update the device aditional informations
  
  @param customProperties   Aditional information about the device
  @param handler             Block called once that the operation is finished.
+ @return Operation that can be cancelled.
  */
-- (void)updateCustomProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-             completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(properties:completion:));
+- (FWTNotifiableOperation *)updateCustomProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                                 completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(properties:completion:));
 
 /**
  Update the device platform properties
  
  @param platformProperties  Platform properties
  @param handler             Block called once that the operation is finished.
+ @return Operation that can be cancelled.
  */
-- (void)updatePlatformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-               completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(platform:completion:));
+- (FWTNotifiableOperation *)updatePlatformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                                   completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(platform:completion:));
 
 /**
  Update the informations of the device without change the user.
@@ -443,12 +524,13 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
  @param locale              New device locale.
  @param customProperties   Aditional information about the device
  @param handler             Block called once that the operation is finished.
+ @return Operation that can be cancelled.
 */
-- (void)updateDeviceToken:(NSData * _Nullable)token
-               deviceName:(NSString * _Nullable)deviceName
-                   locale:(NSLocale * _Nullable)locale
-         customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-        completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:name:locale:properties:completion:));
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData * _Nullable)token
+                                   deviceName:(NSString * _Nullable)deviceName
+                                       locale:(NSLocale * _Nullable)locale
+                             customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                            completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:name:locale:properties:completion:));
 
 /**
  Update the informations of the device without change the user.
@@ -459,13 +541,14 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
  @param customProperties   Aditional information about the device
  @param platformProperties  Aditional information that can be send as extra settings on the server
  @param handler             Block called once that the operation is finished.
+ @return Operation that can be cancelled.
  */
-- (void)updateDeviceToken:(NSData * _Nullable)token
-               deviceName:(NSString * _Nullable)deviceName
-                   locale:(NSLocale * _Nullable)locale
-         customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-       platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-        completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:name:locale:properties:platform:completion:));
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData * _Nullable)token
+                                   deviceName:(NSString * _Nullable)deviceName
+                                       locale:(NSLocale * _Nullable)locale
+                             customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                           platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                            completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:name:locale:properties:platform:completion:));
 
 /**
  Update the informations of the device and change the user.
@@ -476,13 +559,14 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
  @param customProperties   Aditional information about the device.
  @param userAlias   The alias of the user in the server.
  @param handler             Block called once that the operation is finished.
+ @return Operation that can be cancelled.
  */
-- (void)updateDeviceToken:(NSData * _Nullable)token
-               deviceName:(NSString * _Nullable)deviceName
-                userAlias:(NSString * _Nullable)userAlias
-                   locale:(NSLocale * _Nullable)locale
-         customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-        completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:name:userAlias:locale:properties:completion:));
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData * _Nullable)token
+                                   deviceName:(NSString * _Nullable)deviceName
+                                    userAlias:(NSString * _Nullable)userAlias
+                                       locale:(NSLocale * _Nullable)locale
+                             customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                            completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:name:userAlias:locale:properties:completion:));
 
 /**
  Update the informations of the device and change the user.
@@ -494,14 +578,15 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
  @param platformProperties  Aditional information that can be send as extra settings on the server
  @param userAlias   The alias of the user in the server.
  @param handler             Block called once that the operation is finished.
+ @return Operation that can be cancelled.
  */
-- (void)updateDeviceToken:(NSData * _Nullable)token
-               deviceName:(NSString * _Nullable)deviceName
-                userAlias:(NSString * _Nullable)userAlias
-                   locale:(NSLocale * _Nullable)locale
-         customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-       platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-        completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:name:userAlias:locale:properties:platform:completion:));
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData * _Nullable)token
+                                   deviceName:(NSString * _Nullable)deviceName
+                                    userAlias:(NSString * _Nullable)userAlias
+                                       locale:(NSLocale * _Nullable)locale
+                             customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                           platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                            completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(update(deviceToken:name:userAlias:locale:properties:platform:completion:));
 
 #pragma mark - Device/user relationship
 /**
@@ -512,9 +597,10 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
  
  @param userAlias   The alias of the user in the server.
  @param handler     Block called once that the operation is finished.
+ @return Operation that can be cancelled. Later registrations on this manager supersede it.
 */
-- (void)associateDeviceToUser:(NSString *)userAlias
-            completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(associated(to:completion:));
+- (FWTNotifiableOperation *)associateDeviceToUser:(NSString *)userAlias
+                                completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(associated(to:completion:));
 
 /**
  Remove a token from a specific user and anonymise it. 
@@ -523,16 +609,18 @@ Init a notifiable manager with the configurations of the Notifiable-Rails server
  @warning   The device id and configuration will remain the same in the server.
  
  @param handler Block called once that the operation is finished.
+ @return Operation that can be cancelled. Later registrations on this manager supersede it.
 */
-- (void)anonymiseTokenWithCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(anonymise(completion:));
+- (FWTNotifiableOperation *)anonymiseTokenWithCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(anonymise(completion:));
 
 #pragma mark - Unregister
 /**
  Delete the device from the server.
 
  @param handler Block called once that the operation is finished.
+ @return Operation that can be cancelled. Later registrations on this manager supersede it.
 */
-- (void)unregisterTokenWithCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(unregister(completion:));
+- (FWTNotifiableOperation *)unregisterTokenWithCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(unregister(completion:));
 
 @end
 
@@ -8,76 +8,180 @@
 
 #import "FWTHTTPRequester.h"
 #import "FWTNotifiableAuthenticator.h"
+#import "FWTHMACSHA1Signer.h"
+#import "FWTHMACSHA256Signer.h"
 #import "FWTRequesterManager.h"
+#import "FWTRequesterPool.h"
+#import "FWTURLSessionFactory.h"
+#import "FWTBackgroundUploadTransport.h"
 #import "FWTNotifiableDevice+Private.h"
+#import "FWTNotifiableDeviceChanges.h"
 #import "NSError+FWTNotifiable.h"
 #import "NSLocale+FWTNotifiable.h"
 #import "FWTServerConfiguration.h"
 #import "NSUserDefaults+FWTNotifiable.h"
-#import "FWTNotifiableLogger.h"
+#import "FWTNotifiableStateStore.h"
+#import "FWTDeviceStateMachine.h"
+#import "FWTNotifiableLogging.h"
+#import "FWTNotificationOutbox.h"
+#import "FWTCircuitBreaker.h"
+#import "FWTNotifiableOperation+Private.h"
+#import "FWTListenerRegistry.h"
 
 NSString * const FWTNotifiableNotificationError = @"FWTNotifiableNotificationError";
+static NSString * const FWTNotifiableManagerListenerQueue = @"com.futureworkshops.notifiable.FWTNotifiableManager.listeners";
+
+// Notification service extensions have around 30 seconds to finish their work
+static NSTimeInterval const FWTNotifiableReceiptTimeout = 25;
 
-static NSHashTable *managerListeners;
-static NSHashTable *listeners;
 static NSData * tokenDataBuffer;
-static FWTRequesterManager *sharedRequesterManager;
+static BOOL backgroundReceiptUploads;
+
+static void FWTPerformOperationHandler(dispatch_queue_t queue, FWTNotifiableOperationCompletionHandler handler, FWTNotifiableDevice *device, NSError *error)
+{
+    if (handler == nil) {
+        return;
+    }
+    dispatch_async(queue, ^{
+        handler(device, error);
+    });
+}
 
 @interface FWTNotifiableManager () <FWTNotifiableManagerListener>
 
-@property (nonatomic, copy, readwrite, nullable) FWTNotifiableDevice *currentDevice;
 @property (nonatomic, strong) NSData *deviceTokenData;
 @property (nonatomic, strong) NSNotificationCenter *notificationCenter;
 @property (nonatomic, copy) FWTNotifiableDidRegisterBlock registerBlock;
 @property (nonatomic, copy) FWTNotifiableDidReceiveNotificationBlock notificationBlock;
 @property (nonatomic, strong, readonly) NSString *groupId;
-@property (nonatomic, strong, readonly) NSUserDefaults *userDefaults;
+@property (nonatomic, strong, readonly) FWTNotifiableStateStore *stateStore;
+/** Owner of the current device, committing the result of each operation at once */
+@property (nonatomic, strong, readonly) FWTDeviceStateMachine *deviceState;
 @property (nonatomic, strong, readonly) NSURLSession *urlSession;
+/** Settings of the requester managers of this manager, applied whenever the pool builds one */
+@property (nonatomic, copy) FWTRequesterSettings *requesterSettings;
+/** Operations started by this manager that may still be running */
+@property (nonatomic, strong, readonly) NSHashTable<FWTNotifiableOperation *> *pendingOperations;
 
 @end
 
 @implementation FWTNotifiableManager
 
-@synthesize currentDevice = _currentDevice;
-@synthesize userDefaults = _userDefaults;
+@synthesize stateStore = _stateStore;
+@synthesize deviceState = _deviceState;
 @synthesize urlSession = _urlSession;
 
-+ (FWTRequesterManager *)requestManagerWithUserDefaults:(NSUserDefaults *)userDefaults andSession:(NSURLSession *)session
++ (FWTRequesterManager *)requestManagerWithGroupId:(NSString *)groupId andSession:(NSURLSession *)session
 {
-    if (sharedRequesterManager == nil) {
-        FWTNotifiableAuthenticator *authenticator = [[FWTNotifiableAuthenticator alloc] initWithAccessId:[FWTNotifiableManager serverAccessIdWithUserDefaults:userDefaults]
-                                                                                            andSecretKey:[FWTNotifiableManager serverSecretKeyWithUserDefaults:userDefaults]];
-        FWTHTTPRequester *requester = [[FWTHTTPRequester alloc] initWithBaseURL:[FWTNotifiableManager serverURLWithUserDefaults:userDefaults]
+    return [self requestManagerWithGroupId:groupId session:session settings:nil];
+}
+
++ (FWTRequesterManager *)requestManagerWithGroupId:(NSString *)groupId
+                                           session:(NSURLSession *)session
+                                          settings:(FWTRequesterSettings *)settings
+{
+    FWTServerConfiguration *configuration = [FWTNotifiableManager savedConfigurationWithStateStore:[FWTNotifiableStateStore storeWithGroupId:groupId]];
+    return [[FWTRequesterPool sharedPool] requesterManagerForConfiguration:configuration
+                                                                  groupId:groupId
+                                                                  session:session
+                                                                 settings:settings
+                                                                  builder:^FWTRequesterManager *{
+        FWTNotifiableAuthenticator *authenticator = [[FWTNotifiableAuthenticator alloc] initWithSigner:[FWTNotifiableManager signerWithConfiguration:configuration]];
+        FWTHTTPRequester *requester = [[FWTHTTPRequester alloc] initWithBaseURL:configuration.serverURL
                                                                         session: session
                                                                andAuthenticator:authenticator];
-        sharedRequesterManager = [[FWTRequesterManager alloc] initWithRequester:requester];
-    }
-    return sharedRequesterManager;
+        NSString *host = requester.baseUrl.host;
+        if (host.length > 0) {
+            requester.circuitBreaker = [FWTCircuitBreaker breakerWithHost:host groupId:groupId];
+        }
+        if (FWTNotifiableManager.backgroundReceiptUploads) {
+            requester.backgroundTransport = [FWTNotifiableManager backgroundTransportWithGroupId:groupId];
+        }
+        FWTRequesterManager *requesterManager = [[FWTRequesterManager alloc] initWithRequester:requester];
+        // The responses are handled on the SDK queue, each manager delivers them on its own callback queue
+        requesterManager.callbackQueue = requesterManager.workQueue;
+        return requesterManager;
+    }];
 }
 
-+ (FWTServerConfiguration *)savedConfigurationWithUserDefaults:(NSUserDefaults *)userDefaults
++ (FWTBackgroundUploadTransport *)backgroundTransportWithGroupId:(NSString *)groupId
 {
-    FWTServerConfiguration *configuration = [userDefaults storedConfiguration];
-    return configuration;
+    FWTBackgroundUploadTransport *transport = [FWTBackgroundUploadTransport transportWithGroupId:groupId];
+    [FWTNotifiableManager reconcileUploadsOfTransport:transport];
+    return transport;
+}
+
+// Uploads that finish after the process that started them is gone acknowledge their events on the outbox.
+// Failed uploads leave the events pending, so they are sent again on the next drain. An upload delayed
+// by the system is signed with its creation date, so when the server rejects the signature the events
+// are drained right away, with a new one.
++ (void)reconcileUploadsOfTransport:(FWTBackgroundUploadTransport *)transport
+{
+    NSString *groupId = transport.groupId;
+    transport.reconciliationHandler = ^(NSURLRequest *request, NSData *body, NSHTTPURLResponse *response, NSError *error) {
+        if (error == nil && response.statusCode == 401) {
+            dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+                [FWTNotifiableManager drainOutboxWithGroupId:groupId andSession:[FWTURLSessionFactory sharedSession]];
+            });
+            return;
+        }
+        if (error || response.statusCode < 200 || response.statusCode >= 300) {
+            return;
+        }
+        BOOL opened = NO;
+        NSArray<NSNumber *> *notificationIds = [FWTHTTPRequester notificationIdsOfReceiptRequest:request body:body opened:&opened];
+        if (notificationIds.count == 0) {
+            return;
+        }
+        [[FWTNotificationOutbox outboxWithGroupId:groupId] acknowledgeEventsOfType:opened ? FWTNotificationOutboxEventTypeOpened : FWTNotificationOutboxEventTypeReceived
+                                                                   notificationIds:notificationIds];
+    };
 }
 
-+ (NSURL *) serverURLWithUserDefaults:(NSUserDefaults *)userDefaults
++ (void)drainOutboxWithGroupId:(NSString *)groupId andSession:(NSURLSession *)session
 {
-    return [self savedConfigurationWithUserDefaults:userDefaults].serverURL;
+    FWTNotificationOutbox *outbox = [FWTNotificationOutbox outboxWithGroupId:groupId];
+    if ([outbox pendingEvents].count == 0) {
+        return;
+    }
+    if ([FWTNotifiableManager serverURLWithStateStore:[FWTNotifiableStateStore storeWithGroupId:groupId]] == nil) {
+        return;
+    }
+    [outbox drainWithRequesterManager:[FWTNotifiableManager requestManagerWithGroupId:groupId andSession:session]
+                    completionHandler:nil];
 }
 
-+ (NSString *) serverAccessIdWithUserDefaults:(NSUserDefaults *)userDefaults
++ (FWTServerConfiguration *)savedConfigurationWithStateStore:(FWTNotifiableStateStore *)stateStore
 {
-    return [self savedConfigurationWithUserDefaults:userDefaults].serverAccessId;
+    FWTServerConfiguration *configuration = [stateStore configuration];
+    return configuration;
 }
 
-+ (NSString *) serverSecretKeyWithUserDefaults:(NSUserDefaults *)userDefaults
++ (NSURL *) serverURLWithStateStore:(FWTNotifiableStateStore *)stateStore
 {
-    return [self savedConfigurationWithUserDefaults:userDefaults].serverSecretKey;
+    return [self savedConfigurationWithStateStore:stateStore].serverURL;
 }
 
-+ (FWTNotifiableDevice *)storedDeviceWithUserDefaults:(NSUserDefaults *)userDefaults {
-    FWTNotifiableDevice *currentDevice = [userDefaults storedDevice];
++ (id<FWTRequestSigner>) signerWithConfiguration:(FWTServerConfiguration *)configuration
+{
+    switch (configuration.signature) {
+        case FWTNotifiableSignatureHMACSHA256ContentMD5:
+            return [[FWTHMACSHA256Signer alloc] initWithAccessId:configuration.serverAccessId
+                                                       secretKey:configuration.serverSecretKey
+                                                      bodyDigest:FWTBodyDigestMD5];
+        case FWTNotifiableSignatureHMACSHA256ContentSHA256:
+            return [[FWTHMACSHA256Signer alloc] initWithAccessId:configuration.serverAccessId
+                                                       secretKey:configuration.serverSecretKey
+                                                      bodyDigest:FWTBodyDigestSHA256];
+        case FWTNotifiableSignatureHMACSHA1:
+        default:
+            return [[FWTHMACSHA1Signer alloc] initWithAccessId:configuration.serverAccessId
+                                                     secretKey:configuration.serverSecretKey];
+    }
+}
+
++ (FWTNotifiableDevice *)storedDeviceWithStateStore:(FWTNotifiableStateStore *)stateStore {
+    FWTNotifiableDevice *currentDevice = [stateStore device];
     return currentDevice;
 }
 
@@ -95,12 +199,26 @@ static FWTRequesterManager *sharedRequesterManager;
                  accessId:(NSString *)accessId
                 secretKey:(NSString *)secretKey
                   groupId:(NSString * _Nullable)groupId
+{
+    [self configureWithURL:url
+                  accessId:accessId
+                 secretKey:secretKey
+                 signature:FWTNotifiableSignatureHMACSHA1
+                   groupId:groupId];
+}
+
++ (void) configureWithURL:(NSURL *)url
+                 accessId:(NSString *)accessId
+                secretKey:(NSString *)secretKey
+                signature:(FWTNotifiableSignature)signature
+                  groupId:(NSString * _Nullable)groupId
 {
     FWTServerConfiguration *configuration = [[FWTServerConfiguration alloc] initWithServerURL:url
                                                                                      accessId:accessId
-                                                                                 andSecretKey:secretKey];
-    [[NSUserDefaults userDefaultsWithGroupId:groupId] storeConfiguration:configuration];
-    sharedRequesterManager = nil;
+                                                                                    secretKey:secretKey
+                                                                                 andSignature:signature];
+    [[FWTNotifiableStateStore storeWithGroupId:groupId] storeConfiguration:configuration];
+    [[FWTRequesterPool sharedPool] removeRequesterManagersForGroupId:groupId];
 }
 
 - (instancetype)initWithURL:(NSURL *)url
@@ -112,7 +230,7 @@ static FWTRequesterManager *sharedRequesterManager;
     return [self initWithURL:url
                     accessId:accessId
                    secretKey:secretKey
-                  urlSession:[NSURLSession sharedSession]
+                  urlSession:[FWTURLSessionFactory sharedSession]
             didRegisterBlock:registerBlock
         andNotificationBlock:notificationBlock];
 }
@@ -135,7 +253,7 @@ static FWTRequesterManager *sharedRequesterManager;
 - (instancetype)initWithDidRegisterBlock:(_Nullable FWTNotifiableDidRegisterBlock)registerBlock
                     andNotificationBlock:(_Nullable FWTNotifiableDidReceiveNotificationBlock)notificationBlock
 {
-    return [self initWithURLSession:[NSURLSession sharedSession]
+    return [self initWithURLSession:[FWTURLSessionFactory sharedSession]
                    didRegisterBlock:registerBlock
                andNotificationBlock:notificationBlock];
 }
@@ -155,7 +273,7 @@ static FWTRequesterManager *sharedRequesterManager;
            andNotificationBlock:(_Nullable FWTNotifiableDidReceiveNotificationBlock)notificationBlock
 {
     return [self initWithGroupId:group
-                      urlSession:[NSURLSession sharedSession]
+                      urlSession:[FWTURLSessionFactory sharedSession]
                 didRegisterBlock:registerBlock
             andNotificationBlock:notificationBlock];
 }
@@ -172,57 +290,63 @@ static FWTRequesterManager *sharedRequesterManager;
         self->_groupId = group;
         self->_urlSession = urlSession;
         self->_deviceTokenData = tokenDataBuffer;
+        self->_callbackQueue = dispatch_get_main_queue();
+        self->_pendingOperations = [NSHashTable weakObjectsHashTable];
+        
+        // send the events that could not be delivered on previous sessions
+        [FWTNotifiableManager drainOutboxWithGroupId:group andSession:urlSession];
         
         // register self as listener
-        [FWTNotifiableManager operateOnListenerTableOnBackground:^(NSHashTable *table, NSHashTable *managerTable) {
-            [managerTable addObject:self];
-        }];
+        [[FWTNotifiableManager managerListenerRegistry] addListener:self queue:nil];
     }
     return self;
 }
 
-+ (NSHashTable *)listenerTable
++ (FWTListenerRegistry *)listenerRegistry
 {
-    __block NSHashTable* table;
-    @synchronized(self) {
-        if (listeners == nil) {
-            listeners = [NSHashTable weakObjectsHashTable];
-        }
-        table = listeners;
-    }
-    return table;
+    static FWTListenerRegistry *registry;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        registry = [[FWTListenerRegistry alloc] init];
+    });
+    return registry;
 }
 
-+ (NSHashTable *)managerListenerTable
++ (FWTListenerRegistry *)managerListenerRegistry
 {
-    __block NSHashTable* table;
-    @synchronized(self) {
-        if (managerListeners == nil) {
-            managerListeners = [NSHashTable weakObjectsHashTable];
-        }
-        table = managerListeners;
-    }
-    return table;
+    static FWTListenerRegistry *registry;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        registry = [[FWTListenerRegistry alloc] init];
+    });
+    return registry;
 }
 
-+ (void) operateOnListenerTableOnBackground:(void(^)(NSHashTable *table, NSHashTable *managerTable))block
++ (dispatch_queue_t)managerListenerQueue
 {
-    NSHashTable *table = [FWTNotifiableManager listenerTable];
-    NSHashTable *managerTable = [FWTNotifiableManager managerListenerTable];
-    
-    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
-        @synchronized(table) {
-            block(table, managerTable);
-        }
+    static dispatch_queue_t queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = dispatch_queue_create([FWTNotifiableManagerListenerQueue UTF8String], DISPATCH_QUEUE_SERIAL);
+    });
+    return queue;
+}
+
+// The managers handle each event, one after the other on a serial queue, before it is sent to the
+// other listeners, so they see the manager already updated. The queue also keeps the events in order.
++ (void) notifyListenersWithCapability:(FWTListenerCapability)capability
+                            usingBlock:(void(^)(id<FWTNotifiableManagerListener> listener))block
+{
+    dispatch_async([FWTNotifiableManager managerListenerQueue], ^{
+        [[FWTNotifiableManager managerListenerRegistry] notifyListenersInlineWithCapability:capability usingBlock:block];
+        [[FWTNotifiableManager listenerRegistry] notifyListenersWithCapability:capability usingBlock:block];
     });
 }
 
 + (void) cleanUp
 {
-    [FWTNotifiableManager operateOnListenerTableOnBackground:^(NSHashTable *table, NSHashTable *managerTable) {
-        [table removeAllObjects];
-        [managerTable removeAllObjects];
-    }];
+    [[FWTNotifiableManager listenerRegistry] removeAllListeners];
+    [[FWTNotifiableManager managerListenerRegistry] removeAllListeners];
 }
 
 - (NSNotificationCenter *)notificationCenter
@@ -233,129 +357,199 @@ static FWTRequesterManager *sharedRequesterManager;
     return self->_notificationCenter;
 }
 
-- (NSUserDefaults *)userDefaults {
-    if (self->_userDefaults == nil) {
-        self->_userDefaults = [NSUserDefaults userDefaultsWithGroupId:self.groupId];
+- (FWTNotifiableStateStore *)stateStore {
+    if (self->_stateStore == nil) {
+        self->_stateStore = [FWTNotifiableStateStore storeWithGroupId:self.groupId];
     }
-    return self->_userDefaults;
+    return self->_stateStore;
 }
 
-- (FWTNotifiableDevice *)currentDevice
+- (FWTDeviceStateMachine *)deviceState
 {
     @synchronized(self) {
-        if (!self->_currentDevice) {
-            NSUserDefaults *userDefaults = self.userDefaults;
-            self->_currentDevice = [userDefaults storedDevice];
+        if (self->_deviceState == nil) {
+            self->_deviceState = [[FWTDeviceStateMachine alloc] initWithStateStore:self.stateStore];
         }
-        return self->_currentDevice;
+        return self->_deviceState;
     }
 }
 
-- (void)setCurrentDevice:(FWTNotifiableDevice *)currentDevice
+- (FWTNotifiableDevice *)currentDevice
+{
+    return self.deviceState.device;
+}
+
+- (FWTRequesterManager *)requestManager
+{
+    return [FWTNotifiableManager requestManagerWithGroupId:self.groupId session:self.urlSession settings:self.requesterSettings];
+}
+
+- (FWTRequesterSettings *)requesterSettings
 {
     @synchronized(self) {
-        self->_currentDevice = currentDevice;
-        self->_deviceTokenData = self->_currentDevice.token;
-        if (self->_currentDevice) {
-            [self.userDefaults storeDevice:self->_currentDevice];
-        } else {
-            [self.userDefaults clearStoredDevice];
+        if (self->_requesterSettings == nil) {
+            self->_requesterSettings = [[FWTRequesterSettings alloc] init];
         }
+        return [self->_requesterSettings copy];
+    }
+}
+
+- (void)setRequesterSettings:(FWTRequesterSettings *)requesterSettings
+{
+    @synchronized(self) {
+        self->_requesterSettings = [requesterSettings copy];
+    }
+}
+
+- (void)_updateRequesterSettings:(void(^)(FWTRequesterSettings *settings))block
+{
+    @synchronized(self) {
+        FWTRequesterSettings *settings = self.requesterSettings;
+        block(settings);
+        self.requesterSettings = settings;
     }
 }
 
 - (NSInteger)retryAttempts
 {
-    return [FWTNotifiableManager requestManagerWithUserDefaults:self.userDefaults andSession:self.urlSession].retryAttempts;
+    return self.requesterSettings.retryAttempts;
 }
 
 - (void)setRetryAttempts:(NSInteger)retryAttempts
 {
-    [FWTNotifiableManager requestManagerWithUserDefaults:self.userDefaults andSession:self.urlSession].retryAttempts = retryAttempts;
+    [self _updateRequesterSettings:^(FWTRequesterSettings *settings) {
+        settings.retryAttempts = retryAttempts;
+    }];
 }
 
 -(NSTimeInterval)retryDelay
 {
-    return [FWTNotifiableManager requestManagerWithUserDefaults:self.userDefaults andSession:self.urlSession].retryDelay;
+    return self.requesterSettings.retryDelay;
 }
 
 - (void)setRetryDelay:(NSTimeInterval)retryDelay
 {
-    [FWTNotifiableManager requestManagerWithUserDefaults:self.userDefaults andSession:self.urlSession].retryDelay = retryDelay;
+    [self _updateRequesterSettings:^(FWTRequesterSettings *settings) {
+        settings.retryDelay = retryDelay;
+    }];
 }
 
 - (id<FWTNotifiableLogger>)logger
 {
-    return [FWTNotifiableManager requestManagerWithUserDefaults:self.userDefaults andSession:self.urlSession].logger;
+    return self.requesterSettings.logger ?: [self requestManager].logger;
 }
 
 - (void)setLogger:(id<FWTNotifiableLogger>)logger
 {
-    [FWTNotifiableManager requestManagerWithUserDefaults:self.userDefaults andSession:self.urlSession].logger = logger;
+    [self _updateRequesterSettings:^(FWTRequesterSettings *settings) {
+        settings.logger = logger;
+    }];
+}
+
+- (id<FWTNotifiableMetrics>)metrics
+{
+    return self.requesterSettings.metrics;
+}
+
+- (void)setMetrics:(id<FWTNotifiableMetrics>)metrics
+{
+    [self _updateRequesterSettings:^(FWTRequesterSettings *settings) {
+        settings.metrics = metrics;
+    }];
+}
+
+- (NSUInteger)requestCompressionThreshold
+{
+    return self.requesterSettings.requestCompressionThreshold;
+}
+
+- (void)setRequestCompressionThreshold:(NSUInteger)requestCompressionThreshold
+{
+    [self _updateRequesterSettings:^(FWTRequesterSettings *settings) {
+        settings.requestCompressionThreshold = requestCompressionThreshold;
+    }];
 }
 
 #pragma mark - Public static methods
 
 + (void) syncronizeDataWithGroupId:(NSString *)groupId
 {
-    [[NSUserDefaults standardUserDefaults] syncronizeToGroupId:groupId];
+    [[FWTNotifiableStateStore storeWithGroupId:nil] synchronizeToStore:[FWTNotifiableStateStore storeWithGroupId:groupId]];
 }
 
-+ (void)registerManagerListener:(id<FWTNotifiableManagerListener>)listener
++ (BOOL)backgroundReceiptUploads
 {
-    [FWTNotifiableManager operateOnListenerTableOnBackground:^(NSHashTable *table, NSHashTable *managerTable) {
-        if (![table containsObject:listener]) {
-            [table addObject:listener];
+    @synchronized(self) {
+        return backgroundReceiptUploads;
+    }
+}
+
++ (void)setBackgroundReceiptUploads:(BOOL)enabled
+{
+    @synchronized(self) {
+        if (backgroundReceiptUploads == enabled) {
+            return;
         }
-    }];
+        backgroundReceiptUploads = enabled;
+    }
+    // The requesters are built again with, or without, the background transport
+    [[FWTRequesterPool sharedPool] removeAllRequesterManagers];
+}
+
++ (BOOL)application:(UIApplication *)application handleEventsForBackgroundURLSession:(NSString *)identifier completionHandler:(void (^)(void))completionHandler
+{
+    FWTBackgroundUploadTransport *transport = [FWTBackgroundUploadTransport transportWithSessionIdentifier:identifier];
+    if (transport == nil) {
+        return NO;
+    }
+    [FWTNotifiableManager reconcileUploadsOfTransport:transport];
+    transport.backgroundEventsCompletionHandler = completionHandler;
+    return YES;
+}
+
++ (void)registerManagerListener:(id<FWTNotifiableManagerListener>)listener
+{
+    [self registerManagerListener:listener queue:nil];
+}
+
++ (void)registerManagerListener:(id<FWTNotifiableManagerListener>)listener queue:(dispatch_queue_t)queue
+{
+    [[FWTNotifiableManager listenerRegistry] addListener:listener queue:queue];
 }
 
 + (void)unregisterManagerListener:(id<FWTNotifiableManagerListener>)listener
 {
-    [FWTNotifiableManager operateOnListenerTableOnBackground:^(NSHashTable *table, NSHashTable *managerTable) {
-        if ([table containsObject:listener]) {
-            [table removeObject:listener];
-        }
-    }];
+    [[FWTNotifiableManager listenerRegistry] removeListener:listener];
 }
 
 + (void)application:(UIApplication *)application didRegisterForRemoteNotificationsWithDeviceToken:(nonnull NSData *)deviceToken
 {
     tokenDataBuffer = deviceToken;
-    [FWTNotifiableManager operateOnListenerTableOnBackground:^(NSHashTable *table, NSHashTable *managerTable) {
-        void (^performWithObject)(id) = ^(id object) {
-            if ([object conformsToProtocol:@protocol(FWTNotifiableManagerListener)] && [object respondsToSelector:@selector(applicationDidRegisterForRemoteNotificationsWithToken:)]) {
-                [object applicationDidRegisterForRemoteNotificationsWithToken:deviceToken];
-            }
-        };
-        for (id object in managerTable) {
-            performWithObject(object);
-        }
-        for (id object in table) {
-            performWithObject(object);
-        }
+    [FWTNotifiableManager notifyListenersWithCapability:FWTListenerCapabilityDidRegisterToken
+                                             usingBlock:^(id<FWTNotifiableManagerListener> listener) {
+        [listener applicationDidRegisterForRemoteNotificationsWithToken:deviceToken];
     }];
 }
 
 #pragma mark - Public methods
 
--(void)registerAnonymousDeviceWithName:(NSString *)name
-                                locale:(NSLocale *)locale
-                      customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-                  andCompletionHandler:(FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)registerAnonymousDeviceWithName:(NSString *)name
+                                                     locale:(NSLocale *)locale
+                                           customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                                       andCompletionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
-    [self registerAnonymousDeviceWithName:name
-                                   locale:locale
-                         customProperties:customProperties
-                       platformProperties:nil
-                     andCompletionHandler:handler];
+    return [self registerAnonymousDeviceWithName:name
+                                          locale:locale
+                                customProperties:customProperties
+                              platformProperties:nil
+                            andCompletionHandler:handler];
 }
 
--(void)registerAnonymousDeviceWithName:(NSString *)name
-                                locale:(NSLocale *)locale
-                      customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-                    platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-                  andCompletionHandler:(FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)registerAnonymousDeviceWithName:(NSString *)name
+                                                     locale:(NSLocale *)locale
+                                           customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                                         platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                                       andCompletionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
     NSData *token = self.deviceTokenData;
     
@@ -364,53 +558,62 @@ static FWTRequesterManager *sharedRequesterManager;
         if (handler) {
             handler(nil, [NSError fwt_invalidDeviceInformationError:nil]);
         }
-        return;
+        return [FWTNotifiableOperation finishedOperation];
     }
     
-    __weak FWTRequesterManager *requestManager = [FWTNotifiableManager requestManagerWithUserDefaults:self.userDefaults andSession:self.urlSession];
+    __weak FWTRequesterManager *requestManager = [self requestManager];
     [[requestManager logger] logMessage:@"Starting to register an anonymous device"];
     
     NSLocale *deviceLocale = locale ?: [NSLocale fwt_currentLocale];
+    dispatch_queue_t callbackQueue = self.callbackQueue;
+    FWTNotifiableOperation *operation = [self _startOperationWithCompletionHandler:handler registration:YES];
     __weak typeof(self) weakSelf = self;
-    [requestManager registerDeviceWithUserAlias:@""
-                                           token:token
-                                            name:name
-                                          locale:deviceLocale
-                                customProperties:customProperties
-                              platformProperties:platformProperties
-                               completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
-                                   [[requestManager logger] logMessage:[NSString stringWithFormat:@"Finish anonymous device registration with error %@", error]];
-                                   __strong typeof(weakSelf) sself = weakSelf;
-                                   sself.currentDevice = nil;
-                                   [sself _handleDeviceRegisterWithToken:token tokenId:deviceTokenId locale:deviceLocale name:name andError:error];
-                                   sself.currentDevice = [sself.currentDevice deviceWithCustomProperties:customProperties];
-                                   [sself _notifyNewDevice:sself.currentDevice withError:error];
-                                   if (handler) {
-                                       handler(sself.currentDevice, error);
+    FWTNotifiableOperation *request = [requestManager registerDeviceWithUserAlias:@""
+                                                                           token:token
+                                                                            name:name
+                                                                          locale:deviceLocale
+                                                                customProperties:customProperties
+                                                              platformProperties:platformProperties
+                                                               completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+                                   if (![operation finish]) {
+                                       return;
                                    }
+                                   FWTLogInformation([requestManager logger], @"Finish anonymous device registration with error %@", error);
+                                   __strong typeof(weakSelf) sself = weakSelf;
+                                   FWTNotifiableDevice *device = [sself _finishOperation:operation withTransition:^FWTNotifiableDevice *(FWTNotifiableDevice *currentDevice) {
+                                       if (error) {
+                                           return nil;
+                                       }
+                                       FWTNotifiableDevice *device = [FWTNotifiableManager _device:nil withToken:token tokenId:deviceTokenId locale:deviceLocale name:name];
+                                       return [device deviceWithCustomProperties:customProperties];
+                                   }];
+                                   [sself _notifyNewDevice:device withError:error];
+                                   FWTPerformOperationHandler(callbackQueue, handler, device, error);
                                }];
+    [self _operation:operation cancelsRequest:request];
+    return operation;
 }
 
-- (void)registerDeviceWithName:(NSString *)name
-                     userAlias:(NSString *)userAlias
-                        locale:(NSLocale *)locale
-              customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-          andCompletionHandler:(FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)registerDeviceWithName:(NSString *)name
+                                         userAlias:(NSString *)userAlias
+                                            locale:(NSLocale *)locale
+                                  customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                              andCompletionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
-    [self registerDeviceWithName:name
-                       userAlias:userAlias
-                          locale:locale
-                customProperties:customProperties
-              platformProperties:nil
-            andCompletionHandler:handler];
+    return [self registerDeviceWithName:name
+                              userAlias:userAlias
+                                 locale:locale
+                       customProperties:customProperties
+                     platformProperties:nil
+                   andCompletionHandler:handler];
 }
 
-- (void)registerDeviceWithName:(NSString *)name
-                     userAlias:(NSString *)userAlias
-                        locale:(NSLocale *)locale
-              customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-            platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-          andCompletionHandler:(FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)registerDeviceWithName:(NSString *)name
+                                         userAlias:(NSString *)userAlias
+                                            locale:(NSLocale *)locale
+                                  customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                                platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                              andCompletionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
     NSAssert(userAlias != nil && userAlias.length > 0, @"To register a non anonymous device, a user alias need to be provided!");
     NSData *token = self.deviceTokenData;
@@ -420,191 +623,233 @@ static FWTRequesterManager *sharedRequesterManager;
         if (handler) {
             handler(nil, [NSError fwt_invalidDeviceInformationError:nil]);
         }
-        return;
+        return [FWTNotifiableOperation finishedOperation];
     }
     
-    __weak FWTRequesterManager *requestManager = [FWTNotifiableManager requestManagerWithUserDefaults:self.userDefaults andSession:self.urlSession];
+    __weak FWTRequesterManager *requestManager = [self requestManager];
     [[requestManager logger] logMessage:@"Starting to register a device"];
     
     NSLocale *deviceLocale = locale ?: [NSLocale fwt_currentLocale];
+    dispatch_queue_t callbackQueue = self.callbackQueue;
+    FWTNotifiableOperation *operation = [self _startOperationWithCompletionHandler:handler registration:YES];
     __weak typeof(self) weakSelf = self;
-    [requestManager registerDeviceWithUserAlias:userAlias
-                                           token:token
-                                            name:name
-                                          locale:deviceLocale
-                                customProperties:customProperties
-                              platformProperties:platformProperties
-                               completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
-                                   __strong typeof(weakSelf) sself = weakSelf;
-                                   [[requestManager logger] logMessage:[NSString stringWithFormat:@"Finished registering device with error %@", error]];
-                                   sself.currentDevice = nil;
-                                   [sself _handleDeviceRegisterWithToken:token tokenId:deviceTokenId locale:deviceLocale name:name andError:error];
-                                   sself.currentDevice = [sself.currentDevice deviceWithUser:userAlias name:name customProperties:customProperties];
-                                   [sself _notifyNewDevice:sself.currentDevice withError:error];
-                                   if (handler) {
-                                       handler(sself.currentDevice, error);
+    FWTNotifiableOperation *request = [requestManager registerDeviceWithUserAlias:userAlias
+                                                                           token:token
+                                                                            name:name
+                                                                          locale:deviceLocale
+                                                                customProperties:customProperties
+                                                              platformProperties:platformProperties
+                                                               completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+                                   if (![operation finish]) {
+                                       return;
                                    }
+                                   __strong typeof(weakSelf) sself = weakSelf;
+                                   FWTLogInformation([requestManager logger], @"Finished registering device with error %@", error);
+                                   FWTNotifiableDevice *device = [sself _finishOperation:operation withTransition:^FWTNotifiableDevice *(FWTNotifiableDevice *currentDevice) {
+                                       if (error) {
+                                           return nil;
+                                       }
+                                       FWTNotifiableDevice *device = [FWTNotifiableManager _device:nil withToken:token tokenId:deviceTokenId locale:deviceLocale name:name];
+                                       return [device deviceWithUser:userAlias name:name customProperties:customProperties];
+                                   }];
+                                   [sself _notifyNewDevice:device withError:error];
+                                   FWTPerformOperationHandler(callbackQueue, handler, device, error);
                                }];
+    [self _operation:operation cancelsRequest:request];
+    return operation;
+}
+
+- (FWTNotifiableOperation *)updateDeviceLocale:(NSLocale *)locale completionHandler:(FWTNotifiableOperationCompletionHandler)handler
+{
+    return [self updateDeviceToken:nil
+                        deviceName:nil
+                         userAlias:self.currentDevice.user
+                            locale:locale
+                  customProperties:nil
+                platformProperties:nil
+                 completionHandler:handler];
 }
 
-- (void)updateDeviceLocale:(NSLocale *)locale completionHandler:(FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData *)token completionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
-    [self updateDeviceToken:nil
-                 deviceName:nil
-                  userAlias:self.currentDevice.user
-                     locale:locale
-           customProperties:nil
-         platformProperties:nil
-          completionHandler:handler];
+    return [self updateDeviceToken:token
+                        deviceName:nil
+                         userAlias:self.currentDevice.user
+                            locale:nil
+                  customProperties:nil
+                platformProperties:nil
+                 completionHandler:handler];
 }
 
-- (void)updateDeviceToken:(NSData *)token completionHandler:(FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData *)token andLocation:(NSLocale *)locale completionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
-    [self updateDeviceToken:token
-                 deviceName:nil
-                  userAlias:self.currentDevice.user
-                   locale:nil
-           customProperties:nil
-         platformProperties:nil
-          completionHandler:handler];
+    return [self updateDeviceToken:token
+                        deviceName:nil
+                         userAlias:self.currentDevice.user
+                            locale:locale
+                  customProperties:nil
+                platformProperties:nil
+                 completionHandler:handler];
 }
-
-- (void)updateDeviceToken:(NSData *)token andLocation:(NSLocale *)locale completionHandler:(FWTNotifiableOperationCompletionHandler)handler
+
+- (FWTNotifiableOperation *)updateDeviceName:(NSString *)name
+                           completionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
-    [self updateDeviceToken:token
-                 deviceName:nil
-                  userAlias:self.currentDevice.user
-                   locale:locale
-           customProperties:nil
-         platformProperties:nil
-          completionHandler:handler];
+    return [self updateDeviceToken:nil
+                        deviceName:name
+                         userAlias:self.currentDevice.user
+                            locale:nil
+                  customProperties:nil
+                platformProperties:nil
+                 completionHandler:handler];
 }
 
-- (void)updateDeviceName:(NSString *)name
-       completionHandler:(FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)updateCustomProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                                 completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler
 {
-    [self updateDeviceToken:nil
-                 deviceName:name
-                  userAlias:self.currentDevice.user
-                     locale:nil
-           customProperties:nil
-         platformProperties:nil
-          completionHandler:handler];
+    return [self updateDeviceToken:nil
+                        deviceName:nil
+                         userAlias:self.currentDevice.user
+                            locale:nil
+                  customProperties:customProperties
+                platformProperties:nil
+                 completionHandler:handler];
 }
 
-- (void)updateCustomProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-             completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)updatePlatformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                                   completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler
 {
-    [self updateDeviceToken:nil
-                 deviceName:nil
-                  userAlias:self.currentDevice.user
-                     locale:nil
-           customProperties:customProperties
-         platformProperties:nil
-          completionHandler:handler];
+    return [self updateDeviceToken:nil
+                        deviceName:nil
+                         userAlias:self.currentDevice.user
+                            locale:nil
+                  customProperties:nil
+                platformProperties:platformProperties
+                 completionHandler:handler];
 }
 
-- (void)updatePlatformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-                completionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData *)token
+                                   deviceName:(NSString *)name
+                                       locale:(NSLocale *)locale
+                             customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                            completionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
-    [self updateDeviceToken:nil
-                 deviceName:nil
-                  userAlias:self.currentDevice.user
-                     locale:nil
-           customProperties:nil
-         platformProperties:platformProperties
-          completionHandler:handler];
+    return [self updateDeviceToken: token
+                        deviceName:name
+                            locale:locale
+                  customProperties:customProperties
+                platformProperties:nil
+                 completionHandler:handler];
 }
 
-- (void)updateDeviceToken:(NSData *)token
-               deviceName:(NSString *)name
-                   locale:(NSLocale *)locale
-         customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-        completionHandler:(FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData *)token
+                                   deviceName:(NSString *)name
+                                       locale:(NSLocale *)locale
+                             customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                           platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                            completionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
-    [self updateDeviceToken: token
-                 deviceName:name
-                     locale:locale
-           customProperties:customProperties
-         platformProperties:nil
-          completionHandler:handler];
+    return [self updateDeviceToken:token
+                        deviceName:name
+                         userAlias:self.currentDevice.user
+                            locale:locale
+                  customProperties:customProperties
+                platformProperties:platformProperties
+                 completionHandler:handler];
 }
 
-- (void)updateDeviceToken:(NSData *)token
-               deviceName:(NSString *)name
-                 locale:(NSLocale *)locale
-         customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-       platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-        completionHandler:(FWTNotifiableOperationCompletionHandler)handler
+
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData *)token
+                                   deviceName:(NSString *)name
+                                    userAlias:(NSString *)userAlias
+                                       locale:(NSLocale *)locale
+                             customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                            completionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
-    [self updateDeviceToken:token
-                 deviceName:name
-                  userAlias:self.currentDevice.user
-                   locale:locale
-           customProperties:customProperties
-         platformProperties:platformProperties
-          completionHandler:handler];
+    return [self updateDeviceToken:token
+                        deviceName:name
+                            locale:locale
+                  customProperties:customProperties
+                platformProperties:nil
+                 completionHandler:handler];
 }
 
-
-- (void)updateDeviceToken:(NSData *)token
-               deviceName:(NSString *)name
-                userAlias:(NSString *)userAlias
-                   locale:(NSLocale *)locale
-         customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-        completionHandler:(FWTNotifiableOperationCompletionHandler)handler
-{
-    [self updateDeviceToken:token
-                 deviceName:name
-                     locale:locale
-           customProperties:customProperties
-         platformProperties:nil
-          completionHandler:handler];
-}
-
-- (void)updateDeviceToken:(NSData *)token
-               deviceName:(NSString *)name
-                userAlias:(NSString *)userAlias
-                 locale:(NSLocale *)locale
-         customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-       platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-        completionHandler:(FWTNotifiableOperationCompletionHandler)handler
-{
-    NSAssert(token != nil || name != nil || userAlias != nil || locale != nil || customProperties != nil, @"The update method was called without any information to update.");
+- (FWTNotifiableOperation *)updateDeviceToken:(NSData *)token
+                                   deviceName:(NSString *)name
+                                    userAlias:(NSString *)userAlias
+                                       locale:(NSLocale *)locale
+                             customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                           platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                            completionHandler:(FWTNotifiableOperationCompletionHandler)handler
+{
+    NSAssert(token != nil || name != nil || userAlias != nil || locale != nil || customProperties != nil || platformProperties != nil, @"The update method was called without any information to update.");
     NSAssert(self.currentDevice.tokenId != nil, @"This device is not registered, please use the method registerToken:withUserAlias:locale:customProperties:completionHandler: instead");
     
     __weak typeof(self) weakSelf = self;
-    __weak FWTRequesterManager *requestManager = [FWTNotifiableManager requestManagerWithUserDefaults:self.userDefaults andSession:self.urlSession];
-    [[requestManager logger] logMessage:[NSString stringWithFormat:@"Starting to update device %@", self.currentDevice.tokenId]];
-    [requestManager updateDevice:self.currentDevice.tokenId
-                   withUserAlias:userAlias
-                           token:token
-                            name:name
-                          locale:locale
-                customProperties:customProperties
-              platformProperties:platformProperties
-               completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+    __weak FWTRequesterManager *requestManager = [self requestManager];
+    
+    FWTNotifiableDeviceChanges *changes = [[FWTNotifiableDeviceChanges alloc] initWithDevice:self.currentDevice
+                                                                                       token:token
+                                                                                   userAlias:userAlias
+                                                                                        name:name
+                                                                                      locale:locale
+                                                                            customProperties:customProperties
+                                                                          platformProperties:platformProperties];
+    if (changes.isEmpty) {
+        @synchronized(self) {
+            self->_avoidedUpdateCount += 1;
+        }
+        FWTLogInformation([requestManager logger], @"Device %@ is up to date, update not sent", self.currentDevice.tokenId);
+        FWTPerformOperationHandler(self.callbackQueue, handler, self.currentDevice, nil);
+        return [FWTNotifiableOperation finishedOperation];
+    }
+    
+    dispatch_queue_t callbackQueue = self.callbackQueue;
+    FWTNotifiableOperation *operation = [self _startOperationWithCompletionHandler:handler registration:NO];
+    FWTLogInformation([requestManager logger], @"Starting to update device %@", self.currentDevice.tokenId);
+    FWTNotifiableOperation *request = [requestManager updateDevice:self.currentDevice.tokenId
+                                                    withUserAlias:changes.userAlias
+                                                            token:changes.token
+                                                             name:changes.name
+                                                           locale:changes.locale
+                                                 customProperties:changes.customProperties
+                                               platformProperties:changes.platformProperties
+                                                completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+                   if (![operation finish]) {
+                       return;
+                   }
                    __strong typeof(weakSelf) sself = weakSelf;
-                   [sself _handleDeviceRegisterWithToken:(token ? token : sself.currentDevice.token)
-                                                 tokenId:deviceTokenId
-                                                  locale:(locale ? locale : sself.currentDevice.locale)
-                                                    name:(name ? name : sself.currentDevice.name)
-                                                andError:error];
+                   // Applied on the device committed by the operations that finished meanwhile, so their changes are kept
+                   FWTNotifiableDevice *device = [sself _finishOperation:operation withTransition:^FWTNotifiableDevice *(FWTNotifiableDevice *currentDevice) {
+                       if (error) {
+                           return currentDevice;
+                       }
+                       FWTNotifiableDevice *device = [FWTNotifiableManager _device:currentDevice
+                                                                         withToken:(token ? token : currentDevice.token)
+                                                                           tokenId:deviceTokenId
+                                                                            locale:(locale ? locale : currentDevice.locale)
+                                                                              name:(name ? name : currentDevice.name)];
+                       device = [device deviceWithUser:(userAlias ? userAlias : device.user)
+                                                  name:device.name
+                                      customProperties:(customProperties ?: device.customProperties)];
+                       if (changes.platformProperties) {
+                           NSMutableDictionary *storedPlatformProperties = [device.platformProperties mutableCopy] ?: [[NSMutableDictionary alloc] init];
+                           [storedPlatformProperties addEntriesFromDictionary:changes.platformProperties];
+                           device = [device deviceWithPlatformProperties:storedPlatformProperties];
+                       }
+                       return device;
+                   }];
                    if (error == nil) {
-                       sself.currentDevice = [sself.currentDevice deviceWithUser:(userAlias ? userAlias : sself.currentDevice.user)
-                                                                            name:(name ? name : sself.currentDevice.name)
-                                                                customProperties:(customProperties ?: sself.currentDevice.customProperties)];
-                   } else {
-                       [[requestManager logger] logMessage:[NSString stringWithFormat:@"Updated device %@", deviceTokenId]];
+                       FWTLogInformation([requestManager logger], @"Updated device %@", deviceTokenId);
                    }
                    
-                   if (handler) {
-                       handler(sself.currentDevice, error);
-                   }
+                   FWTPerformOperationHandler(callbackQueue, handler, device, error);
                }];
+    [self _operation:operation cancelsRequest:request];
+    return operation;
 }
 
--(void)anonymiseTokenWithCompletionHandler:(FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)anonymiseTokenWithCompletionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
     NSAssert(self.currentDevice.token != nil, @"To anonymise the device, first, you need to register it.");
     
@@ -612,18 +857,18 @@ static FWTRequesterManager *sharedRequesterManager;
         if (handler) {
             handler(self.currentDevice, [NSError fwt_invalidDeviceInformationError:nil]);
         }
-        return;
+        return [FWTNotifiableOperation finishedOperation];
     }
     
-    [self registerAnonymousDeviceWithName:self.currentDevice.name
-                                   locale:nil
-                         customProperties:nil
-                       platformProperties:nil
-                    andCompletionHandler:handler];
+    return [self registerAnonymousDeviceWithName:self.currentDevice.name
+                                          locale:nil
+                                customProperties:nil
+                              platformProperties:nil
+                            andCompletionHandler:handler];
 }
 
-- (void)associateDeviceToUser:(NSString *)userAlias
-            completionHandler:(FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)associateDeviceToUser:(NSString *)userAlias
+                                completionHandler:(FWTNotifiableOperationCompletionHandler)handler
 {
     NSAssert(userAlias.length > 0, @"To associate a device, a user alias need to be provided");
     NSAssert(self.currentDevice.token != nil, @"This device is not registered, please use the method registerToken:withUserAlias:completionHandler: instead.");
@@ -632,30 +877,31 @@ static FWTRequesterManager *sharedRequesterManager;
         if (handler) {
             handler(self.currentDevice, [NSError fwt_invalidDeviceInformationError:nil]);
         }
-        return;
+        return [FWTNotifiableOperation finishedOperation];
     }
     
-    __weak typeof(self) weakSelf = self;
-    [self registerDeviceWithName:self.currentDevice.name
-                       userAlias:userAlias
-                          locale:self.currentDevice.locale
-                customProperties:self.currentDevice.customProperties
-              platformProperties:self.currentDevice.platformProperties
-            andCompletionHandler:^(FWTNotifiableDevice * _Nullable device, NSError * _Nullable error) {
-                   __strong typeof(weakSelf) sself = weakSelf;
-                   [sself _handleDeviceRegisterWithToken:sself.currentDevice.token
-                                                 tokenId:sself.currentDevice.tokenId
-                                                  locale:sself.currentDevice.locale
-                                                    name:sself.currentDevice.name
-                                                andError:error];
-                   if (error == nil && userAlias != nil) {
-                       sself.currentDevice = [sself.currentDevice deviceWithUser:userAlias];
-                   }
-                   handler(sself.currentDevice, error);
-               }];
+    // A registered device only needs the user alias, the rest of its state is already on the server
+    if (self.currentDevice.tokenId != nil) {
+        return [self updateDeviceToken:nil
+                            deviceName:nil
+                             userAlias:userAlias
+                                locale:nil
+                      customProperties:nil
+                    platformProperties:nil
+                     completionHandler:handler];
+    }
+    
+    // The registration commits the device with the user alias
+    FWTNotifiableDevice *device = self.currentDevice;
+    return [self registerDeviceWithName:device.name
+                              userAlias:userAlias
+                                 locale:device.locale
+                       customProperties:device.customProperties
+                     platformProperties:device.platformProperties
+                   andCompletionHandler:handler];
 }
 
-- (void)unregisterTokenWithCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler
+- (FWTNotifiableOperation *)unregisterTokenWithCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler
 {
     NSAssert(self.currentDevice.token, @"This device is not registered.");
     
@@ -663,10 +909,10 @@ static FWTRequesterManager *sharedRequesterManager;
         if (handler) {
             handler(self.currentDevice, [NSError fwt_invalidDeviceInformationError:nil]);
         }
-        return;
+        return [FWTNotifiableOperation finishedOperation];
     }
     
-    [self anonymiseTokenWithCompletionHandler:handler];
+    return [self anonymiseTokenWithCompletionHandler:handler];
 }
 
 + (BOOL)applicationDidReceiveRemoteNotification:(NSDictionary *)notificationInfo
@@ -690,7 +936,11 @@ static FWTRequesterManager *sharedRequesterManager;
            withCompletionHandler:(_Nullable FWTNotifiableOperationCompletionHandler)handler NS_SWIFT_NAME(markAsOpen(notification:completion:))
 {
     __weak typeof(self) weakSelf = self;
-    return [FWTNotifiableManager markNotificationAsOpened:notificationInfo withCompletionHandler:^(NSError * _Nullable error) {
+    return [FWTNotifiableManager markNotificationAsOpened:notificationInfo
+                                                  groupId:nil
+                                                   logger:nil
+                                            callbackQueue:self.callbackQueue
+                                    withCompletionHandler:^(NSError * _Nullable error) {
         if (handler) {
             handler(weakSelf.currentDevice, error);
         }
@@ -720,14 +970,28 @@ static FWTRequesterManager *sharedRequesterManager;
                           logger:(id<FWTNotifiableLogger>)logger
            withCompletionHandler:(void (^)(NSError * _Nullable))handler
 {
-    NSUserDefaults *userDefaults = [NSUserDefaults userDefaultsWithGroupId:groupId];
+    return [self markNotificationAsOpened:notificationInfo
+                                  groupId:groupId
+                                   logger:logger
+                            callbackQueue:dispatch_get_main_queue()
+                    withCompletionHandler:handler];
+}
+
++ (BOOL)markNotificationAsOpened:(NSDictionary *)notificationInfo
+                         groupId:(NSString *)groupId
+                          logger:(id<FWTNotifiableLogger>)logger
+                   callbackQueue:(dispatch_queue_t)callbackQueue
+           withCompletionHandler:(void (^)(NSError * _Nullable))handler
+{
     NSNumber *notificationID = notificationInfo[@"n_id"];
-    FWTNotifiableDevice *device = [self storedDeviceWithUserDefaults:userDefaults];
+    FWTNotifiableDevice *device = [self storedDeviceWithStateStore:[FWTNotifiableStateStore storeWithGroupId:groupId]];
     NSNumber *tokenId = device.tokenId;
     NSString *user = device.user;
-    NSURLSession *urlSession = [NSURLSession sharedSession];
+    NSURLSession *urlSession = [FWTURLSessionFactory sharedSession];
     
-    FWTRequesterManager *requestManager = [FWTNotifiableManager requestManagerWithUserDefaults:userDefaults andSession:urlSession];
+    FWTRequesterManager *requestManager = [FWTNotifiableManager requestManagerWithGroupId:groupId
+                                                                                  session:urlSession
+                                                                                 settings:[FWTNotifiableManager requesterSettingsWithLogger:logger]];
     [[requestManager logger] logNotificationEvent:FWTNotifiableNotificationEventLogReceived
                             forNotificationWithId:notificationID
                                             error: nil];
@@ -742,28 +1006,69 @@ static FWTRequesterManager *sharedRequesterManager;
         return NO;
     }
     
-    __weak typeof(requestManager) weakRequestManager = requestManager;
-    [requestManager markNotificationAsOpenedWithId:notificationID
-                                     deviceTokenId:tokenId
-                                              user:user
-                                 completionHandler:^(BOOL success, NSError * _Nullable error) {
-                                     if (success) {
-                                         [[weakRequestManager logger] logNotificationEvent:FWTNotifiableNotificationEventLogStatusUpdate
-                                                                     forNotificationWithId:notificationID
-                                                                                     error: nil];
-                                     } else {
-                                         [[weakRequestManager logger] logNotificationEvent:FWTNotifiableNotificationEventLogStatusFailure
-                                                                     forNotificationWithId:notificationID
-                                                                                     error:error];
-                                     }
-                                     
-                                     if (handler) {
-                                         handler(error);
-                                     }
-                                 }];
+    // The journal is written on the outbox queue, the caller is usually the main thread
+    FWTNotificationOutbox *outbox = [FWTNotificationOutbox outboxWithGroupId:groupId];
+    [outbox enqueueLeasedEventOfType:FWTNotificationOutboxEventTypeOpened
+                      notificationId:notificationID
+                       deviceTokenId:tokenId
+                                user:user
+                   completionHandler:^(FWTNotificationOutboxEvent * _Nullable event) {
+        __weak typeof(requestManager) weakRequestManager = requestManager;
+        [requestManager markNotificationAsOpenedWithId:notificationID
+                                         deviceTokenId:tokenId
+                                                  user:user
+                                               timeout:FWTNotifiableReceiptTimeout
+                                     completionHandler:^(BOOL success, NSError * _Nullable error) {
+                                         [FWTNotifiableManager finishSendingEvent:event
+                                                                         onOutbox:outbox
+                                                                          success:success
+                                                                 requesterManager:weakRequestManager];
+                                         if (success) {
+                                             [[weakRequestManager logger] logNotificationEvent:FWTNotifiableNotificationEventLogStatusUpdate
+                                                                         forNotificationWithId:notificationID
+                                                                                         error: nil];
+                                         } else {
+                                             [[weakRequestManager logger] logNotificationEvent:FWTNotifiableNotificationEventLogStatusFailure
+                                                                         forNotificationWithId:notificationID
+                                                                                         error:error];
+                                         }
+                                         
+                                         if (handler) {
+                                             dispatch_async(callbackQueue, ^{
+                                                 handler(error);
+                                             });
+                                         }
+                                     }];
+    }];
     return YES;
 }
 
++ (FWTRequesterSettings *)requesterSettingsWithLogger:(id<FWTNotifiableLogger>)logger
+{
+    FWTRequesterSettings *settings = [[FWTRequesterSettings alloc] init];
+    settings.logger = logger;
+    return settings;
+}
+
++ (void)finishSendingEvent:(FWTNotificationOutboxEvent *)event
+                  onOutbox:(FWTNotificationOutbox *)outbox
+                   success:(BOOL)success
+          requesterManager:(FWTRequesterManager *)requesterManager
+{
+    if (event == nil) {
+        return;
+    }
+    if (!success) {
+        // kept on the outbox, to be sent on the next drain
+        [outbox endSendingEvent:event];
+        return;
+    }
+    [outbox acknowledgeEvent:event];
+    if (requesterManager != nil && [outbox pendingEvents].count > 0) {
+        [outbox drainWithRequesterManager:requesterManager completionHandler:nil];
+    }
+}
+
 + (BOOL)markNotificationAsReceived:(NSDictionary *)notificationInfo
              withCompletionHandler:(nullable void(^)(NSError * _Nullable error))handler
 {
@@ -787,15 +1092,27 @@ static FWTRequesterManager *sharedRequesterManager;
                             logger:(id<FWTNotifiableLogger>)logger
              withCompletionHandler:(void (^)(NSError * _Nullable))handler
 {
-    NSUserDefaults *userDefaults = [NSUserDefaults userDefaultsWithGroupId:groupId];
-    NSURLSession *urlSession = [NSURLSession sharedSession];
+    return [self markNotificationAsReceived:notificationInfo
+                                    groupId:groupId
+                                     logger:logger
+                              callbackQueue:dispatch_get_main_queue()
+                      withCompletionHandler:handler];
+}
+
++ (BOOL)markNotificationAsReceived:(NSDictionary *)notificationInfo
+                           groupId:(NSString *)groupId
+                            logger:(id<FWTNotifiableLogger>)logger
+                     callbackQueue:(dispatch_queue_t)callbackQueue
+             withCompletionHandler:(void (^)(NSError * _Nullable))handler
+{
+    NSURLSession *urlSession = [FWTURLSessionFactory sharedSession];
     NSNumber *notificationID = notificationInfo[@"n_id"];
-    NSNumber *deviceTokenId = [self storedDeviceWithUserDefaults:userDefaults].tokenId;
+    NSNumber *deviceTokenId = [self storedDeviceWithStateStore:[FWTNotifiableStateStore storeWithGroupId:groupId]].tokenId;
     
-    FWTRequesterManager *requestManager = [FWTNotifiableManager requestManagerWithUserDefaults:userDefaults andSession:urlSession];
-    if (logger != nil) {
-        requestManager.logger = logger;
-    }
+    // The pooled managers are shared, so the logger of the call selects a manager built with it
+    FWTRequesterManager *requestManager = [FWTNotifiableManager requestManagerWithGroupId:groupId
+                                                                                  session:urlSession
+                                                                                 settings:[FWTNotifiableManager requesterSettingsWithLogger:logger]];
     [[requestManager logger] logNotificationEvent:FWTNotifiableNotificationEventLogReceived
                             forNotificationWithId:notificationID
                                             error:nil];
@@ -810,40 +1127,45 @@ static FWTRequesterManager *sharedRequesterManager;
         return NO;
     }
     
-    __weak typeof(requestManager) weakRequestManager = requestManager;
-    [requestManager markNotificationAsReceivedWithId:notificationID
-                                       deviceTokenId:deviceTokenId
-                                   completionHandler:^(BOOL success, NSError * _Nullable error) {
-                                       
-                                       if (success) {
-                                           [[weakRequestManager logger] logNotificationEvent:FWTNotifiableNotificationEventLogStatusUpdate
-                                                                       forNotificationWithId:notificationID
-                                                                                       error:nil];
-                                       } else {
-                                           [[weakRequestManager logger] logNotificationEvent:FWTNotifiableNotificationEventLogStatusFailure
-                                                                       forNotificationWithId:notificationID
-                                                                                       error:error];
-                                       }
-                                       
-                                       if (handler) {
-                                           handler(error);
-                                       }
-                                   }];
+    // The journal is written on the outbox queue, the caller is usually the main thread
+    FWTNotificationOutbox *outbox = [FWTNotificationOutbox outboxWithGroupId:groupId];
+    [outbox enqueueLeasedEventOfType:FWTNotificationOutboxEventTypeReceived
+                      notificationId:notificationID
+                       deviceTokenId:deviceTokenId
+                                user:nil
+                   completionHandler:^(FWTNotificationOutboxEvent * _Nullable event) {
+        __weak typeof(requestManager) weakRequestManager = requestManager;
+        [requestManager markNotificationAsReceivedWithId:notificationID
+                                           deviceTokenId:deviceTokenId
+                                                 timeout:FWTNotifiableReceiptTimeout
+                                       completionHandler:^(BOOL success, NSError * _Nullable error) {
+                                           [FWTNotifiableManager finishSendingEvent:event
+                                                                           onOutbox:outbox
+                                                                            success:success
+                                                                   requesterManager:weakRequestManager];
+                                           if (success) {
+                                               [[weakRequestManager logger] logNotificationEvent:FWTNotifiableNotificationEventLogStatusUpdate
+                                                                           forNotificationWithId:notificationID
+                                                                                           error:nil];
+                                           } else {
+                                               [[weakRequestManager logger] logNotificationEvent:FWTNotifiableNotificationEventLogStatusFailure
+                                                                           forNotificationWithId:notificationID
+                                                                                           error:error];
+                                           }
+                                           
+                                           if (handler) {
+                                               dispatch_async(callbackQueue, ^{
+                                                   handler(error);
+                                               });
+                                           }
+                                       }];
+    }];
     
     NSDictionary *notificationCopy = [notificationInfo copy];
     
-    [FWTNotifiableManager operateOnListenerTableOnBackground:^(NSHashTable *table, NSHashTable *managerTable) {
-        void (^performWithListener)(id) = ^(id listener) {
-            if ([listener conformsToProtocol:@protocol(FWTNotifiableManagerListener)] && [listener respondsToSelector:@selector(applicationDidReciveNotification:)]) {
-                [listener applicationDidReciveNotification:notificationCopy];
-            }
-        };
-        for (id listener in managerTable) {
-            performWithListener(listener);
-        }
-        for(id listener in table) {
-            performWithListener(listener);
-        }
+    [FWTNotifiableManager notifyListenersWithCapability:FWTListenerCapabilityDidReceiveNotification
+                                             usingBlock:^(id<FWTNotifiableManagerListener> listener) {
+        [listener applicationDidReciveNotification:notificationCopy];
     }];
     
     return YES;
@@ -853,6 +1175,8 @@ static FWTRequesterManager *sharedRequesterManager;
 - (void)applicationDidRegisterForRemoteNotificationsWithToken:(NSData *)token
 {
     self.deviceTokenData = token;
+    // The device is usually registered or updated right after receiving the token
+    [FWTURLSessionFactory prewarmSession:self.urlSession withURL:[self.stateStore configuration].serverURL];
     if (self.registerBlock) {
         self.registerBlock(self, token);
     }
@@ -869,47 +1193,87 @@ static FWTRequesterManager *sharedRequesterManager;
 
 #pragma mark - Private
 
-- (void) _handleDeviceRegisterWithToken:(NSData *)token
-                                tokenId:(NSNumber *)deviceTokenId
-                                 locale:(NSLocale *)locale
-                                   name:(NSString *)name
-                               andError:(NSError *)error
-{
-    if (error == nil) {
-        if (self.currentDevice == nil) {
-            self.currentDevice = [[FWTNotifiableDevice alloc] initWithToken:token tokenId:deviceTokenId andLocale:locale];
-        } else {
-            self.currentDevice = [self.currentDevice deviceWithToken:token locale:locale];
+// Cancelling the operation calls the handler with a FWTErrorCancelled error. Registrations
+// supersede the operations still running, so a late response doesn't override the device.
+// Updates only send their changes, so they don't supersede each other.
+- (FWTNotifiableOperation *) _startOperationWithCompletionHandler:(FWTNotifiableOperationCompletionHandler)handler
+                                                     registration:(BOOL)registration
+{
+    FWTNotifiableOperation *operation = [[FWTNotifiableOperation alloc] init];
+    NSArray<FWTNotifiableOperation *> *superseded = nil;
+    @synchronized(self.pendingOperations) {
+        if (registration) {
+            superseded = self.pendingOperations.allObjects;
+            [self.pendingOperations removeAllObjects];
         }
-        self.currentDevice = [self.currentDevice deviceWithName:name];
+        [self.pendingOperations addObject:operation];
     }
+    for (FWTNotifiableOperation *pendingOperation in superseded) {
+        [pendingOperation cancel];
+    }
+    [self.deviceState beginOperation:operation registration:registration];
+    
+    dispatch_queue_t callbackQueue = self.callbackQueue;
+    [operation addCancellationHandler:^{
+        FWTPerformOperationHandler(callbackQueue, handler, nil, [NSError fwt_cancelledError:nil]);
+    }];
+    return operation;
 }
 
-- (void) _notifyNewDevice:(FWTNotifiableDevice *)device withError:(NSError *)error
+- (void) _operation:(FWTNotifiableOperation *)operation cancelsRequest:(FWTNotifiableOperation *)request
 {
-    [FWTNotifiableManager operateOnListenerTableOnBackground:^(NSHashTable *table, NSHashTable *managerTable) {
-        void (^performWithListener)(id) = ^(id listener) {
-            if (![listener conformsToProtocol:@protocol(FWTNotifiableManagerListener)]) {
-                return;
-            }
-            
-            if (error) {
-                if ([listener respondsToSelector:@selector(notifiableManager:didFailToRegisterDeviceWithError:)]) {
-                    [listener notifiableManager:self didFailToRegisterDeviceWithError:error];
-                }
-            } else {
-                if ([listener respondsToSelector:@selector(notifiableManager:didRegisterDevice:)]) {
-                    [listener notifiableManager:self didRegisterDevice:device];
-                }
-            }
-        };
-        for (id listener in managerTable) {
-            performWithListener(listener);
-        }
-        for (id listener in table) {
-            performWithListener(listener);
-        }
+    if (request == nil) {
+        return;
+    }
+    [operation addCancellationHandler:^{
+        [request cancel];
+    }];
+}
+
+// The device is stored once, with all the changes of the operation
+- (FWTNotifiableDevice *) _finishOperation:(FWTNotifiableOperation *)operation withTransition:(FWTDeviceTransition)transition
+{
+    __block BOOL changed = NO;
+    FWTNotifiableDevice *device = [self.deviceState finishOperation:operation withTransition:^FWTNotifiableDevice *(FWTNotifiableDevice *currentDevice) {
+        FWTNotifiableDevice *nextDevice = transition(currentDevice);
+        changed = nextDevice != currentDevice;
+        return nextDevice;
     }];
+    if (changed) {
+        @synchronized(self) {
+            self->_deviceTokenData = device.token;
+        }
+    }
+    return device;
+}
+
++ (FWTNotifiableDevice *) _device:(FWTNotifiableDevice *)device
+                        withToken:(NSData *)token
+                          tokenId:(NSNumber *)deviceTokenId
+                           locale:(NSLocale *)locale
+                             name:(NSString *)name
+{
+    if (device == nil) {
+        device = [[FWTNotifiableDevice alloc] initWithToken:token tokenId:deviceTokenId andLocale:locale];
+    } else {
+        device = [device deviceWithToken:token locale:locale];
+    }
+    return [device deviceWithName:name];
+}
+
+- (void) _notifyNewDevice:(FWTNotifiableDevice *)device withError:(NSError *)error
+{
+    if (error) {
+        [FWTNotifiableManager notifyListenersWithCapability:FWTListenerCapabilityDidFailToRegisterDevice
+                                                 usingBlock:^(id<FWTNotifiableManagerListener> listener) {
+            [listener notifiableManager:self didFailToRegisterDeviceWithError:error];
+        }];
+    } else {
+        [FWTNotifiableManager notifyListenersWithCapability:FWTListenerCapabilityDidRegisterDevice
+                                                 usingBlock:^(id<FWTNotifiableManagerListener> listener) {
+            [listener notifiableManager:self didRegisterDevice:device];
+        }];
+    }
 }
 
 @end
@@ -0,0 +1,31 @@
+//
+//  FWTNotifiableOperation+Private.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTNotifiableOperation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface FWTNotifiableOperation ()
+
+/** Operation that already finished, for the operations that complete without a request. */
++ (instancetype)finishedOperation;
+
+/**
+ Block called once, if the operation is cancelled. If the operation was already cancelled, it is
+ called right away. The blocks are released when the operation finishes.
+ */
+- (void)addCancellationHandler:(dispatch_block_t)handler;
+
+/**
+ Mark the operation as finished.
+ 
+ @return YES on the first call, NO if the operation already finished or was cancelled.
+ */
+- (BOOL)finish;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,45 @@
+//
+//  FWTNotifiableOperation.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ State of an operation.
+ 
+ - FWTNotifiableOperationStateExecuting: The operation is waiting for the server, or for a retry.
+ - FWTNotifiableOperationStateFinished: The operation finished and its completion handler was called.
+ - FWTNotifiableOperationStateCancelled: The operation was cancelled before it finished.
+ */
+typedef NS_ENUM(NSInteger, FWTNotifiableOperationState) {
+    FWTNotifiableOperationStateExecuting,
+    FWTNotifiableOperationStateFinished,
+    FWTNotifiableOperationStateCancelled
+};
+
+/**
+ Handle of an operation started by FWTNotifiableManager.
+ 
+ Cancelling an operation stops its pending retries and the requests in flight, and calls its
+ completion handler with an FWTErrorCancelled error. The state is KVO compliant.
+ */
+NS_SWIFT_NAME(NotifiableOperation)
+@interface FWTNotifiableOperation : NSObject
+
+@property (atomic, assign, readonly) FWTNotifiableOperationState state;
+@property (nonatomic, assign, readonly, getter=isCancelled) BOOL cancelled;
+/** YES once the operation finished or was cancelled */
+@property (nonatomic, assign, readonly, getter=isFinished) BOOL finished;
+/** Progress of the operation. Cancelling the progress cancels the operation. */
+@property (nonatomic, strong, readonly) NSProgress *progress;
+
+/** Cancel the operation. Nothing is done if the operation already finished. */
+- (void)cancel;
+
+@end
+
+NS_ASSUME_NONNULL_END
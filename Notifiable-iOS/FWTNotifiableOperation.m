@@ -0,0 +1,104 @@
+//
+//  FWTNotifiableOperation.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTNotifiableOperation+Private.h"
+
+@interface FWTNotifiableOperation ()
+
+@property (atomic, assign, readwrite) FWTNotifiableOperationState state;
+@property (nonatomic, strong) NSMutableArray<dispatch_block_t> *cancellationHandlers;
+
+@end
+
+@implementation FWTNotifiableOperation
+
++ (instancetype)finishedOperation
+{
+    FWTNotifiableOperation *operation = [[FWTNotifiableOperation alloc] init];
+    [operation finish];
+    return operation;
+}
+
++ (NSSet<NSString *> *)keyPathsForValuesAffectingCancelled
+{
+    return [NSSet setWithObject:NSStringFromSelector(@selector(state))];
+}
+
++ (NSSet<NSString *> *)keyPathsForValuesAffectingFinished
+{
+    return [NSSet setWithObject:NSStringFromSelector(@selector(state))];
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self->_state = FWTNotifiableOperationStateExecuting;
+        self->_cancellationHandlers = [[NSMutableArray alloc] init];
+        self->_progress = [NSProgress progressWithTotalUnitCount:1];
+        self->_progress.cancellable = YES;
+        __weak typeof(self) weakSelf = self;
+        self->_progress.cancellationHandler = ^{
+            [weakSelf cancel];
+        };
+    }
+    return self;
+}
+
+- (BOOL)isCancelled
+{
+    return self.state == FWTNotifiableOperationStateCancelled;
+}
+
+- (BOOL)isFinished
+{
+    return self.state != FWTNotifiableOperationStateExecuting;
+}
+
+- (void)cancel
+{
+    NSArray<dispatch_block_t> *handlers;
+    @synchronized(self) {
+        if (self.state != FWTNotifiableOperationStateExecuting) {
+            return;
+        }
+        self.state = FWTNotifiableOperationStateCancelled;
+        handlers = self.cancellationHandlers;
+        self.cancellationHandlers = nil;
+    }
+    [self.progress cancel];
+    for (dispatch_block_t handler in handlers) {
+        handler();
+    }
+}
+
+- (BOOL)finish
+{
+    @synchronized(self) {
+        if (self.state != FWTNotifiableOperationStateExecuting) {
+            return NO;
+        }
+        self.state = FWTNotifiableOperationStateFinished;
+        self.cancellationHandlers = nil;
+    }
+    self.progress.completedUnitCount = self.progress.totalUnitCount;
+    return YES;
+}
+
+- (void)addCancellationHandler:(dispatch_block_t)handler
+{
+    @synchronized(self) {
+        if (self.state == FWTNotifiableOperationStateExecuting) {
+            [self.cancellationHandlers addObject:[handler copy]];
+            return;
+        }
+    }
+    if (self.isCancelled) {
+        handler();
+    }
+}
+
+@end
@@ -7,6 +7,43 @@
 #import <Foundation/Foundation.h>
 #import "FWTNotifiableLogger.h"
 
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Logger used by the SDK unless the manager is given another one.
+
+ The messages are queued in a lock-free buffer and written on a background queue, so logging
+ never blocks the caller. They are printed on the console in debug builds and, if the logger has
+ a log file, appended to it. If the messages are logged faster than they can be written and the
+ buffer is full, they are dropped and the number of dropped messages is logged.
+ */
+NS_SWIFT_NAME(DefaultNotifiableLogger)
 @interface FWTDefaultNotifiableLogger : NSObject <FWTNotifiableLogger>
 
+/** File the messages are appended to, if any */
+@property (nonatomic, strong, readonly, nullable) NSURL *logFileURL;
+/**
+ Max size of the log file, 256KB by default. When the file grows over it, it is moved to
+ a single backup file, replacing the previous one, and a new file is started.
+ */
+@property (nonatomic, assign) unsigned long long maxLogFileSize;
+
+/**
+ Log file in the SDK directory. Loggers created with the same group id, in the app and
+ in its extensions, write to the same file, so their messages can be collected together.
+
+ @param groupId Group id of the shared container. If nil, the app container is used.
+ */
++ (NSURL *)logFileURLWithGroupId:(NSString * _Nullable)groupId NS_SWIFT_NAME(logFileURL(groupId:));
+
+/** Logger that only prints on the console, in debug builds */
+- (instancetype)init;
+/** Logger that appends the messages to a file, see logFileURLWithGroupId: */
+- (instancetype)initWithLogFileURL:(NSURL * _Nullable)logFileURL NS_DESIGNATED_INITIALIZER;
+
+/** Wait until the messages logged so far are written */
+- (void)flush;
+
 @end
+
+NS_ASSUME_NONNULL_END
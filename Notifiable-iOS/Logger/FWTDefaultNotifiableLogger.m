@@ -5,37 +5,215 @@
 //
 
 #import "FWTDefaultNotifiableLogger.h"
+#import "FWTLogRingBuffer.h"
 #import "NSError+FWTNotifiable.h"
+#import "NSFileManager+FWTNotifiable.h"
+#import <stdatomic.h>
+#import <sys/file.h>
+#import <sys/stat.h>
+
+NSString * const FWTDefaultNotifiableLoggerQueue = @"com.futureworkshops.notifiable.FWTDefaultNotifiableLogger";
+NSString * const FWTLogsDirectoryName = @"Logs";
+NSString * const FWTLogFileName = @"notifiable.log";
+NSUInteger const FWTLogBufferCapacity = 1024;
+unsigned long long const FWTDefaultMaxLogFileSize = 256 * 1024;
+
+/** Message waiting in the buffer, with the time it was logged */
+@interface FWTLogEntry : NSObject
+
+@property (nonatomic, strong, readonly) NSDate *date;
+@property (nonatomic, copy, readonly) NSString *message;
+
+@end
+
+@implementation FWTLogEntry
+
+- (instancetype)initWithMessage:(NSString *)message
+{
+    self = [super init];
+    if (self) {
+        self->_date = [NSDate date];
+        self->_message = [message copy];
+    }
+    return self;
+}
+
+@end
+
+@interface FWTDefaultNotifiableLogger ()
+{
+    atomic_bool *_drainScheduled;
+}
+
+@property (nonatomic, strong, readonly) FWTLogRingBuffer *buffer;
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+@property (nonatomic, strong) NSDateFormatter *dateFormatter;
+@property (nonatomic, copy, readonly) NSString *processName;
+
+@end
 
 @implementation FWTDefaultNotifiableLogger
 
 @synthesize logLevel = _logLevel;
 
-- (void)logError:(NSError *)error
++ (NSURL *)logFileURLWithGroupId:(NSString *)groupId
 {
-#if DEBUG
-    if (self.logLevel >= FWTNotifiableLogLevelError) {
-        NSLog(@"%@", [error fwt_localizedMessage]);
+    NSURL *directory = [[[NSFileManager defaultManager] fwt_notifiableDirectoryWithGroupId:groupId] URLByAppendingPathComponent:FWTLogsDirectoryName
+                                                                                                                   isDirectory:YES];
+    return [directory URLByAppendingPathComponent:FWTLogFileName];
+}
+
+- (instancetype)init
+{
+    return [self initWithLogFileURL:nil];
+}
+
+- (instancetype)initWithLogFileURL:(NSURL *)logFileURL
+{
+    self = [super init];
+    if (self) {
+        self->_logFileURL = logFileURL;
+        self->_maxLogFileSize = FWTDefaultMaxLogFileSize;
+        self->_buffer = [[FWTLogRingBuffer alloc] initWithCapacity:FWTLogBufferCapacity];
+        self->_queue = dispatch_queue_create([FWTDefaultNotifiableLoggerQueue UTF8String], dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_BACKGROUND, 0));
+        self->_processName = [NSBundle mainBundle].bundleIdentifier ?: [NSProcessInfo processInfo].processName;
+        self->_drainScheduled = calloc(1, sizeof(atomic_bool));
+        atomic_init(self->_drainScheduled, false);
     }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(self->_drainScheduled);
+}
+
+- (BOOL)_hasOutput
+{
+#if DEBUG
+    return YES;
+#else
+    return self.logFileURL != nil;
 #endif
 }
 
+#pragma mark - FWTNotifiableLogger
+
+- (void)logError:(NSError *)error
+{
+    if (self.logLevel >= FWTNotifiableLogLevelError && [self _hasOutput]) {
+        [self _enqueueMessage:[error fwt_localizedMessage]];
+    }
+}
+
 - (void)logMessage:(NSString *)message
 {
-#if DEBUG
-    if (self.logLevel >= FWTNotifiableLogLevelInformation) {
-        NSLog(@"%@",message);
+    if (self.logLevel >= FWTNotifiableLogLevelInformation && [self _hasOutput]) {
+        [self _enqueueMessage:message];
     }
-#endif
 }
 
 - (void)logNotificationEvent:(FWTNotifiableNotificationEventLog)event forNotificationWithId:(NSNumber *)notificationId error:(NSError * _Nullable)error {
+    if (self.logLevel >= FWTNotifiableLogLevelInformation && [self _hasOutput]) {
+        [self _enqueueMessage:[NSString stringWithFormat:@"Event %lu on notification %@", (unsigned long)event, notificationId]];
+    }
+}
+
+- (void)flush
+{
+    dispatch_sync(self.queue, ^{
+        [self _drain];
+    });
+}
+
+#pragma mark - Private
+
+- (void)_enqueueMessage:(NSString *)message
+{
+    [self.buffer push:[[FWTLogEntry alloc] initWithMessage:message]];
+    if (atomic_exchange(self->_drainScheduled, true)) {
+        return;
+    }
+    __weak typeof(self) weakSelf = self;
+    dispatch_async(self.queue, ^{
+        [weakSelf _drain];
+    });
+}
+
+- (void)_drain
+{
+    atomic_store(self->_drainScheduled, false);
+
+    NSMutableString *lines = [[NSMutableString alloc] init];
+    FWTLogEntry *entry;
+    while ((entry = [self.buffer pop]) != nil) {
 #if DEBUG
-    if (self.logLevel >= FWTNotifiableLogLevelInformation) {
-        NSLog(@"Event %lu on notification %@", event, notificationId);
+        NSLog(@"%@", entry.message);
+#endif
+        [lines appendFormat:@"%@ [%@] %@\n", [self.dateFormatter stringFromDate:entry.date], self.processName, entry.message];
     }
+    NSUInteger dropped = [self.buffer takeDroppedCount];
+    if (dropped > 0) {
+        NSString *message = [NSString stringWithFormat:@"%lu log messages dropped", (unsigned long)dropped];
+#if DEBUG
+        NSLog(@"%@", message);
 #endif
+        [lines appendFormat:@"%@ [%@] %@\n", [self.dateFormatter stringFromDate:[NSDate date]], self.processName, message];
+    }
+
+    if (lines.length > 0 && self.logFileURL != nil) {
+        [self _appendToLogFile:[lines dataUsingEncoding:NSUTF8StringEncoding]];
+    }
 }
 
+- (void)_appendToLogFile:(NSData *)data
+{
+    NSString *path = self.logFileURL.path;
+    [[NSFileManager defaultManager] createDirectoryAtURL:self.logFileURL.URLByDeletingLastPathComponent
+                             withIntermediateDirectories:YES
+                                              attributes:nil
+                                                   error:nil];
+    // The file can be shared with the extensions, so the write and the rotation are done
+    // under a lock of the file, on this background queue only. If another process rotated
+    // the file while waiting for the lock, the new file is opened instead.
+    int file = -1;
+    while (YES) {
+        file = open(path.fileSystemRepresentation, O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (file < 0) {
+            return;
+        }
+        flock(file, LOCK_EX);
+        struct stat opened, current;
+        if (fstat(file, &opened) == 0 && stat(path.fileSystemRepresentation, &current) == 0 && opened.st_ino == current.st_ino) {
+            break;
+        }
+        flock(file, LOCK_UN);
+        close(file);
+    }
+
+    write(file, data.bytes, data.length);
+    struct stat status;
+    if (fstat(file, &status) == 0 && (unsigned long long)status.st_size > self.maxLogFileSize) {
+        rename(path.fileSystemRepresentation, [FWTDefaultNotifiableLogger _backupPathOfPath:path].fileSystemRepresentation);
+    }
+    flock(file, LOCK_UN);
+    close(file);
+}
+
++ (NSString *)_backupPathOfPath:(NSString *)path
+{
+    return [[path stringByDeletingPathExtension] stringByAppendingPathExtension:@"1.log"];
+}
+
+- (NSDateFormatter *)dateFormatter
+{
+    if (self->_dateFormatter == nil) {
+        self->_dateFormatter = [[NSDateFormatter alloc] init];
+        self->_dateFormatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+        self->_dateFormatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+        self->_dateFormatter.dateFormat = @"yyyy-MM-dd'T'HH:mm:ss.SSS'Z'";
+    }
+    return self->_dateFormatter;
+}
 
 @end
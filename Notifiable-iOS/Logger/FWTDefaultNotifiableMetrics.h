@@ -0,0 +1,51 @@
+//
+//  FWTDefaultNotifiableMetrics.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "FWTNotifiableMetrics.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Metrics kept in memory, per endpoint, with atomic counters, so recording never takes a lock.
+
+ The snapshot is a dictionary keyed by endpoint name (`register_device`, `update_device`, ...).
+ Each endpoint has the `succeeded`, `failed` and `retries` counts, the `bytes_sent` and
+ `bytes_received`, the `serialization_ms` and `signing_ms` spent, and a `latency_histogram` with
+ the number of responses under each bound of `latency_bucket_bounds_ms`. The last bucket counts
+ the responses slower than all the bounds.
+ */
+NS_SWIFT_NAME(DefaultNotifiableMetrics)
+@interface FWTDefaultNotifiableMetrics : NSObject <FWTNotifiableMetrics>
+
+/** Metrics used by the requests of the SDK, unless the manager is given others */
+@property (class, nonatomic, strong, readonly) FWTDefaultNotifiableMetrics *sharedMetrics NS_SWIFT_NAME(shared);
+/** Upper bounds of the latency histogram buckets, in milliseconds */
+@property (class, nonatomic, copy, readonly) NSArray<NSNumber *> *latencyBucketBounds;
+
+/** Current values of the counters. Counters recorded while it is read may or may not be included. */
+- (NSDictionary<NSString *, NSDictionary<NSString *, id> *> *)snapshot;
+
+/** Set all the counters to zero */
+- (void)reset;
+
+/**
+ Write the snapshot to the SDK directory, in a file of this process, so the snapshot of a
+ notification service extension can be read by the app.
+
+ @param groupId Group id of the shared container. If nil, the app container is used.
+ */
+- (BOOL)exportSnapshotWithGroupId:(NSString * _Nullable)groupId error:(NSError * _Nullable * _Nullable)error NS_SWIFT_NAME(exportSnapshot(groupId:));
+
+/**
+ Snapshots exported by exportSnapshotWithGroupId:error:, keyed by the bundle identifier of the
+ process that exported them. Each one has the `date` of the export and its `endpoints`.
+ */
++ (NSDictionary<NSString *, NSDictionary<NSString *, id> *> *)exportedSnapshotsWithGroupId:(NSString * _Nullable)groupId NS_SWIFT_NAME(exportedSnapshots(groupId:));
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,237 @@
+//
+//  FWTDefaultNotifiableMetrics.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTDefaultNotifiableMetrics.h"
+#import "NSFileManager+FWTNotifiable.h"
+#import <stdatomic.h>
+
+NSString * const FWTMetricsDirectoryName = @"Metrics";
+
+#define FWTLatencyBoundCount 10
+#define FWTLatencyBucketCount (FWTLatencyBoundCount + 1)
+
+static uint64_t const FWTLatencyBounds[FWTLatencyBoundCount] = {10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+
+typedef struct {
+    atomic_uint_fast64_t succeeded;
+    atomic_uint_fast64_t failed;
+    atomic_uint_fast64_t retries;
+    atomic_uint_fast64_t bytesSent;
+    atomic_uint_fast64_t bytesReceived;
+    atomic_uint_fast64_t serializationMicroseconds;
+    atomic_uint_fast64_t signingMicroseconds;
+    atomic_uint_fast64_t latencyHistogram[FWTLatencyBucketCount];
+} FWTEndpointCounters;
+
+static NSString *FWTEndpointName(FWTNotifiableMetricsEndpoint endpoint)
+{
+    switch (endpoint) {
+        case FWTNotifiableMetricsEndpointRegisterDevice:
+            return @"register_device";
+        case FWTNotifiableMetricsEndpointUpdateDevice:
+            return @"update_device";
+        case FWTNotifiableMetricsEndpointUnregisterDevice:
+            return @"unregister_device";
+        case FWTNotifiableMetricsEndpointListDevices:
+            return @"list_devices";
+        case FWTNotifiableMetricsEndpointNotificationOpened:
+            return @"notification_opened";
+        case FWTNotifiableMetricsEndpointNotificationReceived:
+            return @"notification_received";
+        case FWTNotifiableMetricsEndpointOther:
+            return @"other";
+    }
+    return @"other";
+}
+
+static uint64_t FWTMicroseconds(NSTimeInterval time)
+{
+    return time > 0 ? (uint64_t)llround(time * 1e6) : 0;
+}
+
+static void FWTAdd(atomic_uint_fast64_t *counter, uint64_t value)
+{
+    atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+}
+
+static uint64_t FWTLoad(atomic_uint_fast64_t *counter)
+{
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+@interface FWTDefaultNotifiableMetrics ()
+{
+    FWTEndpointCounters *_counters;
+}
+
+@end
+
+@implementation FWTDefaultNotifiableMetrics
+
++ (FWTDefaultNotifiableMetrics *)sharedMetrics
+{
+    static FWTDefaultNotifiableMetrics *sharedMetrics;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedMetrics = [[FWTDefaultNotifiableMetrics alloc] init];
+    });
+    return sharedMetrics;
+}
+
++ (NSArray<NSNumber *> *)latencyBucketBounds
+{
+    NSMutableArray<NSNumber *> *bounds = [[NSMutableArray alloc] initWithCapacity:FWTLatencyBoundCount];
+    for (NSUInteger index = 0; index < FWTLatencyBoundCount; index++) {
+        [bounds addObject:@(FWTLatencyBounds[index])];
+    }
+    return bounds;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self->_counters = calloc(FWTNotifiableMetricsEndpointCount, sizeof(FWTEndpointCounters));
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(self->_counters);
+}
+
+#pragma mark - FWTNotifiableMetrics
+
+- (void)recordResponseFromEndpoint:(FWTNotifiableMetricsEndpoint)endpoint
+                           latency:(NSTimeInterval)latency
+                         bytesSent:(NSUInteger)bytesSent
+                     bytesReceived:(NSUInteger)bytesReceived
+                           success:(BOOL)success
+{
+    FWTEndpointCounters *counters = [self _countersOfEndpoint:endpoint];
+    FWTAdd(success ? &counters->succeeded : &counters->failed, 1);
+    FWTAdd(&counters->bytesSent, bytesSent);
+    FWTAdd(&counters->bytesReceived, bytesReceived);
+
+    uint64_t milliseconds = FWTMicroseconds(latency) / 1000;
+    NSUInteger bucket = 0;
+    while (bucket < FWTLatencyBoundCount && milliseconds > FWTLatencyBounds[bucket]) {
+        bucket += 1;
+    }
+    FWTAdd(&counters->latencyHistogram[bucket], 1);
+}
+
+- (void)recordRetryOfEndpoint:(FWTNotifiableMetricsEndpoint)endpoint
+{
+    FWTAdd(&[self _countersOfEndpoint:endpoint]->retries, 1);
+}
+
+- (void)recordSerializationTime:(NSTimeInterval)time ofEndpoint:(FWTNotifiableMetricsEndpoint)endpoint
+{
+    FWTAdd(&[self _countersOfEndpoint:endpoint]->serializationMicroseconds, FWTMicroseconds(time));
+}
+
+- (void)recordSigningTime:(NSTimeInterval)time ofEndpoint:(FWTNotifiableMetricsEndpoint)endpoint
+{
+    FWTAdd(&[self _countersOfEndpoint:endpoint]->signingMicroseconds, FWTMicroseconds(time));
+}
+
+#pragma mark - Snapshot
+
+- (NSDictionary<NSString *,NSDictionary<NSString *,id> *> *)snapshot
+{
+    NSMutableDictionary *snapshot = [[NSMutableDictionary alloc] initWithCapacity:FWTNotifiableMetricsEndpointCount];
+    for (NSUInteger endpoint = 0; endpoint < FWTNotifiableMetricsEndpointCount; endpoint++) {
+        FWTEndpointCounters *counters = &self->_counters[endpoint];
+        NSMutableArray<NSNumber *> *histogram = [[NSMutableArray alloc] initWithCapacity:FWTLatencyBucketCount];
+        for (NSUInteger bucket = 0; bucket < FWTLatencyBucketCount; bucket++) {
+            [histogram addObject:@(FWTLoad(&counters->latencyHistogram[bucket]))];
+        }
+        snapshot[FWTEndpointName(endpoint)] = @{@"succeeded": @(FWTLoad(&counters->succeeded)),
+                                                @"failed": @(FWTLoad(&counters->failed)),
+                                                @"retries": @(FWTLoad(&counters->retries)),
+                                                @"bytes_sent": @(FWTLoad(&counters->bytesSent)),
+                                                @"bytes_received": @(FWTLoad(&counters->bytesReceived)),
+                                                @"serialization_ms": @(FWTLoad(&counters->serializationMicroseconds) / 1000.0),
+                                                @"signing_ms": @(FWTLoad(&counters->signingMicroseconds) / 1000.0),
+                                                @"latency_histogram": histogram,
+                                                @"latency_bucket_bounds_ms": [FWTDefaultNotifiableMetrics latencyBucketBounds]};
+    }
+    return snapshot;
+}
+
+- (void)reset
+{
+    for (NSUInteger endpoint = 0; endpoint < FWTNotifiableMetricsEndpointCount; endpoint++) {
+        FWTEndpointCounters *counters = &self->_counters[endpoint];
+        atomic_store(&counters->succeeded, 0);
+        atomic_store(&counters->failed, 0);
+        atomic_store(&counters->retries, 0);
+        atomic_store(&counters->bytesSent, 0);
+        atomic_store(&counters->bytesReceived, 0);
+        atomic_store(&counters->serializationMicroseconds, 0);
+        atomic_store(&counters->signingMicroseconds, 0);
+        for (NSUInteger bucket = 0; bucket < FWTLatencyBucketCount; bucket++) {
+            atomic_store(&counters->latencyHistogram[bucket], 0);
+        }
+    }
+}
+
+#pragma mark - Export
+
+- (BOOL)exportSnapshotWithGroupId:(NSString *)groupId error:(NSError * _Nullable __autoreleasing *)error
+{
+    NSURL *directory = [FWTDefaultNotifiableMetrics _directoryWithGroupId:groupId];
+    if (![[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:error]) {
+        return NO;
+    }
+
+    NSDictionary *export = @{@"date": @([[NSDate date] timeIntervalSince1970]),
+                             @"endpoints": [self snapshot]};
+    NSData *data = [NSJSONSerialization dataWithJSONObject:export options:0 error:error];
+    if (data == nil) {
+        return NO;
+    }
+    NSString *processName = [NSBundle mainBundle].bundleIdentifier ?: [NSProcessInfo processInfo].processName;
+    NSURL *fileURL = [directory URLByAppendingPathComponent:[processName stringByAppendingPathExtension:@"json"]];
+    return [data writeToURL:fileURL options:NSDataWritingAtomic error:error];
+}
+
++ (NSDictionary<NSString *,NSDictionary<NSString *,id> *> *)exportedSnapshotsWithGroupId:(NSString *)groupId
+{
+    NSURL *directory = [FWTDefaultNotifiableMetrics _directoryWithGroupId:groupId];
+    NSArray<NSURL *> *files = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:directory
+                                                            includingPropertiesForKeys:nil
+                                                                               options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                                                 error:nil];
+    NSMutableDictionary *snapshots = [[NSMutableDictionary alloc] init];
+    for (NSURL *file in files) {
+        if (![file.pathExtension isEqualToString:@"json"]) {
+            continue;
+        }
+        NSData *data = [NSData dataWithContentsOfURL:file];
+        id snapshot = data ? [NSJSONSerialization JSONObjectWithData:data options:0 error:nil] : nil;
+        if ([snapshot isKindOfClass:[NSDictionary class]]) {
+            snapshots[file.URLByDeletingPathExtension.lastPathComponent] = snapshot;
+        }
+    }
+    return snapshots;
+}
+
+#pragma mark - Private
+
+- (FWTEndpointCounters *)_countersOfEndpoint:(FWTNotifiableMetricsEndpoint)endpoint
+{
+    return &self->_counters[MIN(endpoint, FWTNotifiableMetricsEndpointOther)];
+}
+
++ (NSURL *)_directoryWithGroupId:(NSString *)groupId
+{
+    return [[[NSFileManager defaultManager] fwt_notifiableDirectoryWithGroupId:groupId] URLByAppendingPathComponent:FWTMetricsDirectoryName isDirectory:YES];
+}
+
+@end
@@ -0,0 +1,36 @@
+//
+//  FWTLogRingBuffer.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Bounded queue of objects that any number of threads can push to and pop from without a lock.
+ When the buffer is full, the objects pushed are dropped and counted, so a slow consumer never
+ blocks the producers.
+ */
+@interface FWTLogRingBuffer : NSObject
+
+/** Max number of objects in the buffer */
+@property (nonatomic, assign, readonly) NSUInteger capacity;
+
+- (instancetype)init NS_UNAVAILABLE;
+/** @param capacity Rounded up to a power of two. */
+- (instancetype)initWithCapacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+
+/** @return NO if the buffer was full, so the object was dropped. */
+- (BOOL)push:(id)object;
+
+/** Oldest object of the buffer, or nil if it is empty */
+- (nullable id)pop;
+
+/** Number of objects dropped since the last call */
+- (NSUInteger)takeDroppedCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,118 @@
+//
+//  FWTLogRingBuffer.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTLogRingBuffer.h"
+#import <stdatomic.h>
+
+typedef struct {
+    atomic_size_t sequence;
+    void *value;
+} FWTRingCell;
+
+// Bounded MPMC queue by Dmitry Vyukov. The sequence of each cell tells whether it is ready
+// to be written (sequence == position) or read (sequence == position + 1) at a position.
+typedef struct {
+    atomic_size_t head;
+    atomic_size_t tail;
+    atomic_size_t dropped;
+    size_t mask;
+    FWTRingCell *cells;
+} FWTRing;
+
+@interface FWTLogRingBuffer ()
+{
+    FWTRing *_ring;
+}
+
+@end
+
+@implementation FWTLogRingBuffer
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+{
+    self = [super init];
+    if (self) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        self->_capacity = size;
+        self->_ring = calloc(1, sizeof(FWTRing));
+        self->_ring->mask = size - 1;
+        self->_ring->cells = calloc(size, sizeof(FWTRingCell));
+        for (size_t index = 0; index < size; index++) {
+            atomic_init(&self->_ring->cells[index].sequence, index);
+        }
+        atomic_init(&self->_ring->head, 0);
+        atomic_init(&self->_ring->tail, 0);
+        atomic_init(&self->_ring->dropped, 0);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    while ([self pop] != nil) {}
+    free(self->_ring->cells);
+    free(self->_ring);
+}
+
+- (BOOL)push:(id)object
+{
+    FWTRing *ring = self->_ring;
+    size_t position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    FWTRingCell *cell;
+    while (YES) {
+        cell = &ring->cells[position & ring->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->tail, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return NO;
+        } else {
+            position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        }
+    }
+    cell->value = (void *)CFBridgingRetain(object);
+    atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+    return YES;
+}
+
+- (id)pop
+{
+    FWTRing *ring = self->_ring;
+    size_t position = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    FWTRingCell *cell;
+    while (YES) {
+        cell = &ring->cells[position & ring->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return nil;
+        } else {
+            position = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+    id object = CFBridgingRelease(cell->value);
+    cell->value = NULL;
+    atomic_store_explicit(&cell->sequence, position + ring->mask + 1, memory_order_release);
+    return object;
+}
+
+- (NSUInteger)takeDroppedCount
+{
+    return atomic_exchange_explicit(&self->_ring->dropped, 0, memory_order_relaxed);
+}
+
+@end
@@ -0,0 +1,27 @@
+//
+//  FWTNotifiableLogging.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTNotifiableLogger.h"
+
+/**
+ Log a formatted message if the level of the logger allows it. The logger is evaluated once and
+ the format arguments are only evaluated, and the message only built, when the level is enabled,
+ so a disabled level costs no allocation.
+ */
+#define FWTLogInformation(logger, format, ...) do { \
+    id<FWTNotifiableLogger> fwt_logger = (logger); \
+    if (fwt_logger != nil && fwt_logger.logLevel >= FWTNotifiableLogLevelInformation) { \
+        [fwt_logger logMessage:[NSString stringWithFormat:(format), ##__VA_ARGS__]]; \
+    } \
+} while (0)
+
+/** Log an error if the level of the logger allows it, see FWTLogInformation */
+#define FWTLogError(logger, error) do { \
+    id<FWTNotifiableLogger> fwt_logger = (logger); \
+    if (fwt_logger != nil && fwt_logger.logLevel >= FWTNotifiableLogLevelError) { \
+        [fwt_logger logError:(error)]; \
+    } \
+} while (0)
@@ -0,0 +1,52 @@
+//
+//  FWTNotifiableMetrics.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+typedef NS_ENUM(NSUInteger, FWTNotifiableMetricsEndpoint) {
+    FWTNotifiableMetricsEndpointRegisterDevice = 0,
+    FWTNotifiableMetricsEndpointUpdateDevice,
+    FWTNotifiableMetricsEndpointUnregisterDevice,
+    FWTNotifiableMetricsEndpointListDevices,
+    FWTNotifiableMetricsEndpointNotificationOpened,
+    FWTNotifiableMetricsEndpointNotificationReceived,
+    FWTNotifiableMetricsEndpointOther
+} NS_SWIFT_NAME(MetricsEndpoint);
+
+/** Number of values of FWTNotifiableMetricsEndpoint */
+#define FWTNotifiableMetricsEndpointCount 7
+
+/**
+ Receives the measures of the requests sent by the SDK. The methods are called from any thread,
+ on the path of every request, so they must be cheap.
+ */
+NS_SWIFT_NAME(NotifiableMetrics)
+@protocol FWTNotifiableMetrics <NSObject>
+
+/**
+ A response, or a transport error, was received from an endpoint. Cancelled requests are not recorded.
+
+ @param latency       Time between sending the request and receiving the response.
+ @param bytesSent     Size of the request body.
+ @param bytesReceived Size of the response body.
+ @param success       YES if the server answered with a 2xx status code.
+ */
+- (void)recordResponseFromEndpoint:(FWTNotifiableMetricsEndpoint)endpoint
+                           latency:(NSTimeInterval)latency
+                         bytesSent:(NSUInteger)bytesSent
+                     bytesReceived:(NSUInteger)bytesReceived
+                           success:(BOOL)success NS_SWIFT_NAME(recordResponse(from:latency:bytesSent:bytesReceived:success:));
+
+/** A failed request to the endpoint was scheduled to be sent again */
+- (void)recordRetryOfEndpoint:(FWTNotifiableMetricsEndpoint)endpoint NS_SWIFT_NAME(recordRetry(of:));
+
+/** Time spent building the request, including its body */
+- (void)recordSerializationTime:(NSTimeInterval)time ofEndpoint:(FWTNotifiableMetricsEndpoint)endpoint NS_SWIFT_NAME(recordSerialization(time:of:));
+
+/** Time spent signing the request */
+- (void)recordSigningTime:(NSTimeInterval)time ofEndpoint:(FWTNotifiableMetricsEndpoint)endpoint NS_SWIFT_NAME(recordSigning(time:of:));
+
+@end
@@ -0,0 +1,74 @@
+//
+//  FWTDeviceStateMachine.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FWTNotifiableDevice;
+@class FWTNotifiableStateStore;
+@class FWTNotifiableOperation;
+
+/**
+ Lifecycle of the device.
+
+ - FWTDeviceLifecycleStateUnregistered: No device is stored.
+ - FWTDeviceLifecycleStateRegistering: A registration is waiting for the server.
+ - FWTDeviceLifecycleStateRegistered: The device is registered and associated to a user.
+ - FWTDeviceLifecycleStateAnonymous: The device is registered without a user.
+ - FWTDeviceLifecycleStateUpdating: An update is waiting for the server.
+ */
+typedef NS_ENUM(NSInteger, FWTDeviceLifecycleState) {
+    FWTDeviceLifecycleStateUnregistered,
+    FWTDeviceLifecycleStateRegistering,
+    FWTDeviceLifecycleStateRegistered,
+    FWTDeviceLifecycleStateAnonymous,
+    FWTDeviceLifecycleStateUpdating
+};
+
+/** Builds the next device from the committed one. Returning nil removes the device. */
+typedef FWTNotifiableDevice * _Nullable (^FWTDeviceTransition)(FWTNotifiableDevice * _Nullable device);
+
+/**
+ Owner of the current device. The transitions run one at a time on a serial queue, each one
+ reading the device committed by the previous one, so concurrent operations merge their changes
+ instead of overriding each other. A transition stores the device once, and only if it returned
+ a different one.
+ */
+@interface FWTDeviceStateMachine : NSObject
+
+@property (nonatomic, assign, readonly) FWTDeviceLifecycleState state;
+/** Committed device, which is immutable. Loaded from the state store the first time it is needed. */
+@property (nonatomic, strong, readonly, nullable) FWTNotifiableDevice *device;
+/** Number of times the device was written to the state store */
+@property (nonatomic, assign, readonly) NSUInteger storeCount;
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithStateStore:(FWTNotifiableStateStore *)stateStore NS_DESIGNATED_INITIALIZER;
+
+/**
+ Track an operation started on the device. While it runs, the state is registering or updating.
+ The operation stops being tracked when it is finished by this machine, cancelled or released.
+
+ @param registration YES for registrations, NO for updates.
+ */
+- (void)beginOperation:(FWTNotifiableOperation *)operation registration:(BOOL)registration;
+
+/**
+ Commit the result of a tracked operation, which stops being tracked.
+
+ @param transition Next device. Nil keeps the committed device.
+ @return Committed device.
+ */
+- (FWTNotifiableDevice * _Nullable)finishOperation:(FWTNotifiableOperation *)operation
+                                    withTransition:(FWTDeviceTransition _Nullable)transition;
+
+/** Commit a change that doesn't belong to an operation. */
+- (FWTNotifiableDevice * _Nullable)commitTransition:(FWTDeviceTransition)transition;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,165 @@
+//
+//  FWTDeviceStateMachine.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTDeviceStateMachine.h"
+#import "FWTNotifiableDevice.h"
+#import "FWTNotifiableStateStore.h"
+#import "FWTNotifiableOperation+Private.h"
+
+NSString * const FWTDeviceStateMachineQueue = @"com.futureworkshops.notifiable.FWTDeviceStateMachine";
+
+static void *FWTDeviceStateMachineQueueKey = &FWTDeviceStateMachineQueueKey;
+
+@interface FWTDeviceStateMachine ()
+
+@property (nonatomic, strong, readonly) FWTNotifiableStateStore *stateStore;
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+@property (nonatomic, strong, readonly) NSHashTable<FWTNotifiableOperation *> *registrations;
+@property (nonatomic, strong, readonly) NSHashTable<FWTNotifiableOperation *> *updates;
+@property (nonatomic, assign) BOOL loaded;
+
+@end
+
+@implementation FWTDeviceStateMachine
+
+@synthesize device = _device;
+@synthesize storeCount = _storeCount;
+
+- (instancetype)initWithStateStore:(FWTNotifiableStateStore *)stateStore
+{
+    self = [super init];
+    if (self) {
+        self->_stateStore = stateStore;
+        self->_queue = dispatch_queue_create([FWTDeviceStateMachineQueue UTF8String], DISPATCH_QUEUE_SERIAL);
+        dispatch_queue_set_specific(self->_queue, FWTDeviceStateMachineQueueKey, (__bridge void *)self, NULL);
+        self->_registrations = [NSHashTable weakObjectsHashTable];
+        self->_updates = [NSHashTable weakObjectsHashTable];
+    }
+    return self;
+}
+
+- (FWTNotifiableDevice *)device
+{
+    __block FWTNotifiableDevice *device;
+    [self _performSync:^{
+        device = [self _loadedDevice];
+    }];
+    return device;
+}
+
+- (NSUInteger)storeCount
+{
+    __block NSUInteger storeCount;
+    [self _performSync:^{
+        storeCount = self->_storeCount;
+    }];
+    return storeCount;
+}
+
+- (FWTDeviceLifecycleState)state
+{
+    __block FWTDeviceLifecycleState state;
+    [self _performSync:^{
+        if (self.registrations.anyObject != nil) {
+            state = FWTDeviceLifecycleStateRegistering;
+        } else if (self.updates.anyObject != nil) {
+            state = FWTDeviceLifecycleStateUpdating;
+        } else {
+            FWTNotifiableDevice *device = [self _loadedDevice];
+            if (device == nil) {
+                state = FWTDeviceLifecycleStateUnregistered;
+            } else if (device.user.length > 0) {
+                state = FWTDeviceLifecycleStateRegistered;
+            } else {
+                state = FWTDeviceLifecycleStateAnonymous;
+            }
+        }
+    }];
+    return state;
+}
+
+- (void)beginOperation:(FWTNotifiableOperation *)operation registration:(BOOL)registration
+{
+    [self _performSync:^{
+        [(registration ? self.registrations : self.updates) addObject:operation];
+    }];
+
+    __weak typeof(self) weakSelf = self;
+    __weak FWTNotifiableOperation *weakOperation = operation;
+    [operation addCancellationHandler:^{
+        [weakSelf _performSync:^{
+            [weakSelf _stopTrackingOperation:weakOperation];
+        }];
+    }];
+}
+
+- (FWTNotifiableDevice *)finishOperation:(FWTNotifiableOperation *)operation
+                          withTransition:(FWTDeviceTransition)transition
+{
+    __block FWTNotifiableDevice *device;
+    [self _performSync:^{
+        [self _stopTrackingOperation:operation];
+        device = [self _commitTransition:transition];
+    }];
+    return device;
+}
+
+- (FWTNotifiableDevice *)commitTransition:(FWTDeviceTransition)transition
+{
+    __block FWTNotifiableDevice *device;
+    [self _performSync:^{
+        device = [self _commitTransition:transition];
+    }];
+    return device;
+}
+
+#pragma mark - Private
+
+// Reading the device from a transition runs inline, instead of waiting for the transition itself
+- (void)_performSync:(dispatch_block_t)block
+{
+    if (dispatch_get_specific(FWTDeviceStateMachineQueueKey) == (__bridge void *)self) {
+        block();
+    } else {
+        dispatch_sync(self.queue, block);
+    }
+}
+
+- (FWTNotifiableDevice *)_loadedDevice
+{
+    if (!self.loaded) {
+        self->_device = [self.stateStore device];
+        self.loaded = YES;
+    }
+    return self->_device;
+}
+
+- (FWTNotifiableDevice *)_commitTransition:(FWTDeviceTransition)transition
+{
+    FWTNotifiableDevice *device = [self _loadedDevice];
+    if (transition == nil) {
+        return device;
+    }
+
+    FWTNotifiableDevice *nextDevice = transition(device);
+    if (nextDevice != device) {
+        self->_device = nextDevice;
+        self->_storeCount += 1;
+        [self.stateStore storeDevice:self->_device];
+    }
+    return self->_device;
+}
+
+- (void)_stopTrackingOperation:(FWTNotifiableOperation *)operation
+{
+    if (operation == nil) {
+        return;
+    }
+    [self.registrations removeObject:operation];
+    [self.updates removeObject:operation];
+}
+
+@end
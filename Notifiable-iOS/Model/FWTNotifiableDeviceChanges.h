@@ -0,0 +1,47 @@
+//
+//  FWTNotifiableDeviceChanges.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FWTNotifiableDevice;
+
+/**
+ Fields of a device update that differ from the stored device.
+ Unchanged fields are nil, so only the changes are sent to the server.
+ */
+@interface FWTNotifiableDeviceChanges : NSObject
+
+@property (nonatomic, copy, readonly, nullable) NSData *token;
+@property (nonatomic, copy, readonly, nullable) NSString *userAlias;
+@property (nonatomic, copy, readonly, nullable) NSString *name;
+@property (nonatomic, copy, readonly, nullable) NSLocale *locale;
+/** Complete custom properties, set when at least one key changed */
+@property (nonatomic, copy, readonly, nullable) NSDictionary<NSString *, id> *customProperties;
+/** Keys of the custom properties that were added, changed or removed */
+@property (nonatomic, copy, readonly) NSSet<NSString *> *changedCustomPropertyKeys;
+/** Only the platform properties whose values changed */
+@property (nonatomic, copy, readonly, nullable) NSDictionary<NSString *, id> *platformProperties;
+/** YES when the update doesn't change anything */
+@property (nonatomic, readonly, assign, getter=isEmpty) BOOL empty;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Compare the requested values with the device. Nil values are not part of the update.
+ */
+- (instancetype)initWithDevice:(FWTNotifiableDevice * _Nullable)device
+                         token:(NSData * _Nullable)token
+                     userAlias:(NSString * _Nullable)userAlias
+                          name:(NSString * _Nullable)name
+                        locale:(NSLocale * _Nullable)locale
+              customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+            platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,99 @@
+//
+//  FWTNotifiableDeviceChanges.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTNotifiableDeviceChanges.h"
+#import "FWTNotifiableDevice.h"
+#import "NSLocale+FWTNotifiable.h"
+
+@implementation FWTNotifiableDeviceChanges
+
+- (instancetype)initWithDevice:(FWTNotifiableDevice *)device
+                         token:(NSData *)token
+                     userAlias:(NSString *)userAlias
+                          name:(NSString *)name
+                        locale:(NSLocale *)locale
+              customProperties:(NSDictionary<NSString *,id> *)customProperties
+            platformProperties:(NSDictionary<NSString *,id> *)platformProperties
+{
+    self = [super init];
+    if (self) {
+        if (token && ![token isEqualToData:device.token]) {
+            self->_token = [token copy];
+        }
+        if (userAlias && ![userAlias isEqualToString:(device.user ?: @"")]) {
+            self->_userAlias = [userAlias copy];
+        }
+        if (name && ![name isEqualToString:device.name]) {
+            self->_name = [name copy];
+        }
+        if (locale && ![FWTNotifiableDeviceChanges _locale:locale isEquivalentTo:device.locale]) {
+            self->_locale = [locale copy];
+        }
+        
+        self->_changedCustomPropertyKeys = [FWTNotifiableDeviceChanges _changedKeysFrom:device.customProperties
+                                                                                     to:customProperties];
+        if (self->_changedCustomPropertyKeys.count > 0) {
+            self->_customProperties = [customProperties copy];
+        }
+        
+        NSMutableDictionary *changedPlatformProperties = [[NSMutableDictionary alloc] init];
+        for (NSString *key in platformProperties) {
+            id value = platformProperties[key];
+            if (![value isEqual:device.platformProperties[key]]) {
+                changedPlatformProperties[key] = value;
+            }
+        }
+        if (changedPlatformProperties.count > 0) {
+            self->_platformProperties = [changedPlatformProperties copy];
+        }
+    }
+    return self;
+}
+
+- (BOOL)isEmpty
+{
+    return self.token == nil &&
+        self.userAlias == nil &&
+        self.name == nil &&
+        self.locale == nil &&
+        self.customProperties == nil &&
+        self.platformProperties == nil;
+}
+
+#pragma mark - Private
+
+// The server only stores the language and the region of the locale
++ (BOOL)_locale:(NSLocale *)locale isEquivalentTo:(NSLocale *)storedLocale
+{
+    if (storedLocale == nil) {
+        return NO;
+    }
+    return [[locale fwt_languageCode] isEqualToString:[storedLocale fwt_languageCode]] &&
+        [[locale fwt_countryCode] isEqualToString:[storedLocale fwt_countryCode]];
+}
+
++ (NSSet<NSString *> *)_changedKeysFrom:(NSDictionary<NSString *, id> *)original
+                                     to:(NSDictionary<NSString *, id> *)updated
+{
+    if (updated == nil) {
+        return [NSSet set];
+    }
+    
+    NSMutableSet<NSString *> *changedKeys = [[NSMutableSet alloc] init];
+    for (NSString *key in updated) {
+        if (![updated[key] isEqual:original[key]]) {
+            [changedKeys addObject:key];
+        }
+    }
+    for (NSString *key in original) {
+        if (updated[key] == nil) {
+            [changedKeys addObject:key];
+        }
+    }
+    return [changedKeys copy];
+}
+
+@end
@@ -0,0 +1,69 @@
+//
+//  FWTNotifiableStateStore.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FWTServerConfiguration;
+@class FWTNotifiableDevice;
+
+/**
+ Compact, versioned binary file that holds the server configuration and the current device.
+
+ The file lives in the app group container, so the app and its extensions share it. Reads map
+ the file and decode the fields directly, without a keyed archiver. Writes rebuild the whole
+ file and replace it with an atomic rename, under a file lock shared between the processes.
+
+ The decoded content is kept in memory and returned until the file is replaced, so reading the
+ state several times only checks the file attributes.
+ */
+@interface FWTNotifiableStateStore : NSObject
+
+/** Location of the state file */
+@property (nonatomic, strong, readonly) NSURL *fileURL;
+/** Incremented every time a new version of the file is loaded or written. */
+@property (nonatomic, assign, readonly) NSUInteger changeCount;
+
+/**
+ Shared store for a specific group. The first time a group is used, the configuration and
+ device stored on the user defaults by previous versions of the SDK are migrated to the store.
+
+ @param groupId Group used to share the data with extensions. If nil, the app container is used.
+ */
++ (instancetype)storeWithGroupId:(NSString * _Nullable)groupId;
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithFileURL:(NSURL *)fileURL NS_DESIGNATED_INITIALIZER;
+
+- (FWTServerConfiguration * _Nullable)configuration;
+- (void)storeConfiguration:(FWTServerConfiguration *)configuration;
+
+- (FWTNotifiableDevice * _Nullable)device;
+/** Store the device. A nil device removes the stored one. */
+- (void)storeDevice:(FWTNotifiableDevice * _Nullable)device;
+
+/** Read the configuration and the device from the same version of the file. */
+- (void)readConfiguration:(FWTServerConfiguration * _Nullable * _Nullable)configuration
+                   device:(FWTNotifiableDevice * _Nullable * _Nullable)device;
+
+/**
+ Move the configuration and device archived on the user defaults into the store. Nothing is
+ done if the state file already exists. The migrated keys are removed from the user defaults.
+
+ @return YES if any data was migrated.
+ */
+- (BOOL)migrateFromUserDefaults:(NSUserDefaults *)userDefaults;
+
+/** Copy the configuration and device of this store into another one. */
+- (void)synchronizeToStore:(FWTNotifiableStateStore *)store;
+
+/** Remove the state file. */
+- (void)clear;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,565 @@
+//
+//  FWTNotifiableStateStore.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTNotifiableStateStore.h"
+#import "FWTServerConfiguration.h"
+#import "FWTNotifiableDevice.h"
+#import "NSFileManager+FWTNotifiable.h"
+#import "NSUserDefaults+FWTNotifiable.h"
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <libkern/OSByteOrder.h>
+
+NSString * const FWTNotifiableStateFileName = @"state.bin";
+NSString * const FWTNotifiableStateQueue = @"com.futureworkshops.notifiable.FWTNotifiableStateStore";
+
+/*
+ File layout, all the integers are little endian:
+
+ header         'F' 'W' 'T' 'S', uint16 version, uint16 reserved
+ configuration  uint8 present, [string url, string access id, string secret key, uint8 signature]
+ device         uint8 present, [bytes token, uint8 has id, int64 token id, string locale,
+                string user, string name, bytes custom properties json, bytes platform properties json]
+
+ Strings and bytes are stored as a uint32 length followed by the content. A length of
+ FWTStateNullLength represents a nil value.
+
+ Properties that aren't valid JSON (dates, data...) are stored as a keyed archive in the same
+ field. An archive is a binary property list, so it never starts with the '{' of a JSON object.
+ */
+static const uint8_t FWTStateMagic[4] = {'F', 'W', 'T', 'S'};
+static const uint16_t FWTStateVersion = 1;
+static const uint32_t FWTStateNullLength = UINT32_MAX;
+static const uint8_t FWTStateJSONObjectStart = '{';
+
+static NSMutableDictionary<NSString *, FWTNotifiableStateStore *> *sharedStores;
+
+#pragma mark - Writer
+
+static void FWTStateAppendUInt8(NSMutableData *data, uint8_t value)
+{
+    [data appendBytes:&value length:sizeof(value)];
+}
+
+static void FWTStateAppendUInt16(NSMutableData *data, uint16_t value)
+{
+    uint16_t encoded = OSSwapHostToLittleInt16(value);
+    [data appendBytes:&encoded length:sizeof(encoded)];
+}
+
+static void FWTStateAppendUInt32(NSMutableData *data, uint32_t value)
+{
+    uint32_t encoded = OSSwapHostToLittleInt32(value);
+    [data appendBytes:&encoded length:sizeof(encoded)];
+}
+
+static void FWTStateAppendInt64(NSMutableData *data, int64_t value)
+{
+    uint64_t encoded = OSSwapHostToLittleInt64((uint64_t)value);
+    [data appendBytes:&encoded length:sizeof(encoded)];
+}
+
+static void FWTStateAppendBytes(NSMutableData *data, NSData * _Nullable bytes)
+{
+    if (bytes == nil) {
+        FWTStateAppendUInt32(data, FWTStateNullLength);
+        return;
+    }
+    FWTStateAppendUInt32(data, (uint32_t)bytes.length);
+    [data appendData:bytes];
+}
+
+static void FWTStateAppendString(NSMutableData *data, NSString * _Nullable string)
+{
+    FWTStateAppendBytes(data, [string dataUsingEncoding:NSUTF8StringEncoding]);
+}
+
+/** Property list types, plus NSNull and NSURL, accepted when decoding archived properties. */
+static NSSet<Class> *FWTStateArchivedPropertyClasses(void)
+{
+    static NSSet<Class> *classes;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        classes = [NSSet setWithObjects:[NSDictionary class], [NSArray class], [NSString class], [NSNumber class],
+                                        [NSDate class], [NSData class], [NSNull class], [NSURL class], nil];
+    });
+    return classes;
+}
+
+static NSData * _Nullable FWTStateArchivedProperties(NSDictionary *dictionary)
+{
+    NSMutableData *archive = [[NSMutableData alloc] init];
+    NSKeyedArchiver *archiver = [[NSKeyedArchiver alloc] initForWritingWithMutableData:archive];
+    archiver.requiresSecureCoding = YES;
+    @try {
+        [archiver encodeObject:dictionary forKey:NSKeyedArchiveRootObjectKey];
+        [archiver finishEncoding];
+    } @catch (NSException *exception) {
+        NSLog(@"Properties not stored, they can't be archived: %@", exception.reason);
+        return nil;
+    }
+    return archive;
+}
+
+static void FWTStateAppendJSON(NSMutableData *data, NSDictionary * _Nullable dictionary)
+{
+    NSData *bytes = nil;
+    if (dictionary != nil && [NSJSONSerialization isValidJSONObject:dictionary]) {
+        bytes = [NSJSONSerialization dataWithJSONObject:dictionary options:0 error:nil];
+    } else if (dictionary != nil) {
+        bytes = FWTStateArchivedProperties(dictionary);
+    }
+    FWTStateAppendBytes(data, bytes);
+}
+
+#pragma mark - Reader
+
+typedef struct {
+    const uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger offset;
+    BOOL failed;
+} FWTStateReader;
+
+static const uint8_t *FWTStateReadRaw(FWTStateReader *reader, NSUInteger length)
+{
+    if (reader->failed || reader->length - reader->offset < length) {
+        reader->failed = YES;
+        return NULL;
+    }
+    const uint8_t *bytes = reader->bytes + reader->offset;
+    reader->offset += length;
+    return bytes;
+}
+
+static uint8_t FWTStateReadUInt8(FWTStateReader *reader)
+{
+    const uint8_t *bytes = FWTStateReadRaw(reader, sizeof(uint8_t));
+    return bytes ? bytes[0] : 0;
+}
+
+static uint16_t FWTStateReadUInt16(FWTStateReader *reader)
+{
+    const uint8_t *bytes = FWTStateReadRaw(reader, sizeof(uint16_t));
+    return bytes ? OSReadLittleInt16(bytes, 0) : 0;
+}
+
+static uint32_t FWTStateReadUInt32(FWTStateReader *reader)
+{
+    const uint8_t *bytes = FWTStateReadRaw(reader, sizeof(uint32_t));
+    return bytes ? OSReadLittleInt32(bytes, 0) : 0;
+}
+
+static int64_t FWTStateReadInt64(FWTStateReader *reader)
+{
+    const uint8_t *bytes = FWTStateReadRaw(reader, sizeof(uint64_t));
+    return bytes ? (int64_t)OSReadLittleInt64(bytes, 0) : 0;
+}
+
+/** Returns the content of a bytes field. `isNull` is set when the field holds a nil value. */
+static const uint8_t *FWTStateReadField(FWTStateReader *reader, NSUInteger *length, BOOL *isNull)
+{
+    uint32_t fieldLength = FWTStateReadUInt32(reader);
+    *isNull = fieldLength == FWTStateNullLength;
+    *length = *isNull ? 0 : fieldLength;
+    if (reader->failed || *isNull) {
+        return NULL;
+    }
+    return FWTStateReadRaw(reader, *length);
+}
+
+static NSData * _Nullable FWTStateReadBytes(FWTStateReader *reader)
+{
+    NSUInteger length = 0;
+    BOOL isNull = NO;
+    const uint8_t *bytes = FWTStateReadField(reader, &length, &isNull);
+    if (reader->failed || isNull) {
+        return nil;
+    }
+    // Copied, so the object doesn't keep the file mapped
+    return [NSData dataWithBytes:bytes length:length];
+}
+
+static NSString * _Nullable FWTStateReadString(FWTStateReader *reader)
+{
+    NSUInteger length = 0;
+    BOOL isNull = NO;
+    const uint8_t *bytes = FWTStateReadField(reader, &length, &isNull);
+    if (reader->failed || isNull) {
+        return nil;
+    }
+    return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+}
+
+static NSDictionary * _Nullable FWTStateReadJSON(FWTStateReader *reader)
+{
+    NSUInteger length = 0;
+    BOOL isNull = NO;
+    const uint8_t *bytes = FWTStateReadField(reader, &length, &isNull);
+    if (reader->failed || isNull) {
+        return nil;
+    }
+    NSData *content = [NSData dataWithBytesNoCopy:(void *)bytes length:length freeWhenDone:NO];
+    id dictionary = nil;
+    if (length > 0 && bytes[0] == FWTStateJSONObjectStart) {
+        dictionary = [NSJSONSerialization JSONObjectWithData:content options:0 error:nil];
+    } else if (length > 0) {
+        NSKeyedUnarchiver *unarchiver = [[NSKeyedUnarchiver alloc] initForReadingWithData:content];
+        unarchiver.requiresSecureCoding = YES;
+        @try {
+            dictionary = [unarchiver decodeObjectOfClasses:FWTStateArchivedPropertyClasses() forKey:NSKeyedArchiveRootObjectKey];
+        } @catch (NSException *exception) {
+            dictionary = nil;
+        }
+        [unarchiver finishDecoding];
+    }
+    return [dictionary isKindOfClass:[NSDictionary class]] ? dictionary : nil;
+}
+
+#pragma mark - Store
+
+/** Identifies a version of the state file. Writers replace the file, so any change produces a new identity. */
+typedef struct {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    struct timespec modification;
+} FWTStateFileIdentity;
+
+static FWTStateFileIdentity FWTStateFileIdentityForPath(NSString *path)
+{
+    FWTStateFileIdentity identity;
+    memset(&identity, 0, sizeof(identity));
+    struct stat info;
+    if (stat([path fileSystemRepresentation], &info) == 0) {
+        identity.device = info.st_dev;
+        identity.inode = info.st_ino;
+        identity.size = info.st_size;
+        identity.modification = info.st_mtimespec;
+    }
+    return identity;
+}
+
+static BOOL FWTStateFileIdentityEqual(FWTStateFileIdentity lhs, FWTStateFileIdentity rhs)
+{
+    return lhs.device == rhs.device &&
+           lhs.inode == rhs.inode &&
+           lhs.size == rhs.size &&
+           lhs.modification.tv_sec == rhs.modification.tv_sec &&
+           lhs.modification.tv_nsec == rhs.modification.tv_nsec;
+}
+
+@interface FWTNotifiableStateStore ()
+
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, assign, readwrite) NSUInteger changeCount;
+
+// Decoded content of the file, only accessed on the queue
+@property (nonatomic, strong, nullable) FWTServerConfiguration *snapshotConfiguration;
+@property (nonatomic, strong, nullable) FWTNotifiableDevice *snapshotDevice;
+@property (nonatomic, assign) FWTStateFileIdentity snapshotIdentity;
+@property (nonatomic, assign) BOOL hasSnapshot;
+
+@end
+
+@implementation FWTNotifiableStateStore
+
++ (instancetype)storeWithGroupId:(NSString *)groupId
+{
+    NSString *key = groupId ?: @"";
+    @synchronized(self) {
+        if (sharedStores == nil) {
+            sharedStores = [[NSMutableDictionary alloc] init];
+        }
+        FWTNotifiableStateStore *store = sharedStores[key];
+        if (store == nil) {
+            NSURL *directory = [[NSFileManager defaultManager] fwt_notifiableDirectoryWithGroupId:groupId];
+            store = [[FWTNotifiableStateStore alloc] initWithFileURL:[directory URLByAppendingPathComponent:FWTNotifiableStateFileName]];
+            [store migrateFromUserDefaults:[NSUserDefaults userDefaultsWithGroupId:groupId]];
+            sharedStores[key] = store;
+        }
+        return store;
+    }
+}
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL
+{
+    self = [super init];
+    if (self) {
+        self->_fileURL = fileURL;
+        self->_queue = dispatch_queue_create([FWTNotifiableStateQueue UTF8String], DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+
+#pragma mark - Public methods
+
+- (FWTServerConfiguration *)configuration
+{
+    __block FWTServerConfiguration *configuration = nil;
+    dispatch_sync(self.queue, ^{
+        [self _refreshSnapshot];
+        configuration = self.snapshotConfiguration;
+    });
+    return configuration;
+}
+
+- (void)storeConfiguration:(FWTServerConfiguration *)configuration
+{
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            [self _refreshSnapshot];
+            [self _writeConfiguration:configuration device:self.snapshotDevice];
+        }];
+    });
+}
+
+- (FWTNotifiableDevice *)device
+{
+    __block FWTNotifiableDevice *device = nil;
+    dispatch_sync(self.queue, ^{
+        [self _refreshSnapshot];
+        device = self.snapshotDevice;
+    });
+    return device;
+}
+
+- (void)storeDevice:(FWTNotifiableDevice *)device
+{
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            [self _refreshSnapshot];
+            [self _writeConfiguration:self.snapshotConfiguration device:device];
+        }];
+    });
+}
+
+- (void)readConfiguration:(FWTServerConfiguration * _Nullable __autoreleasing *)configuration
+                   device:(FWTNotifiableDevice * _Nullable __autoreleasing *)device
+{
+    __block FWTServerConfiguration *storedConfiguration = nil;
+    __block FWTNotifiableDevice *storedDevice = nil;
+    dispatch_sync(self.queue, ^{
+        [self _refreshSnapshot];
+        storedConfiguration = self.snapshotConfiguration;
+        storedDevice = self.snapshotDevice;
+    });
+    if (configuration != NULL) {
+        *configuration = storedConfiguration;
+    }
+    if (device != NULL) {
+        *device = storedDevice;
+    }
+}
+
+- (BOOL)migrateFromUserDefaults:(NSUserDefaults *)userDefaults
+{
+    __block BOOL migrated = NO;
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            if ([[NSFileManager defaultManager] fileExistsAtPath:self.fileURL.path]) {
+                return;
+            }
+            FWTServerConfiguration *configuration = [userDefaults storedConfiguration];
+            FWTNotifiableDevice *device = [userDefaults storedDevice];
+            if (configuration == nil && device == nil) {
+                return;
+            }
+            migrated = [self _writeConfiguration:configuration device:device];
+            if (migrated) {
+                [userDefaults clearStoredConfiguration];
+                [userDefaults clearStoredDevice];
+            }
+        }];
+    });
+    return migrated;
+}
+
+- (void)synchronizeToStore:(FWTNotifiableStateStore *)store
+{
+    if (store == self || [store.fileURL isEqual:self.fileURL]) {
+        return;
+    }
+
+    FWTServerConfiguration *configuration = nil;
+    FWTNotifiableDevice *device = nil;
+    [self readConfiguration:&configuration device:&device];
+
+    if (configuration == nil && device == nil) {
+        return;
+    }
+    dispatch_sync(store.queue, ^{
+        [store _performWithFileLock:^{
+            [store _writeConfiguration:configuration device:device];
+        }];
+    });
+}
+
+- (void)clear
+{
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            [[NSFileManager defaultManager] removeItemAtURL:self.fileURL error:nil];
+            [self _refreshSnapshot];
+        }];
+    });
+}
+
+#pragma mark - Private methods
+
+- (void)_performWithFileLock:(void(^)(void))block
+{
+    NSString *lockPath = [self.fileURL.path stringByAppendingPathExtension:@"lock"];
+    int descriptor = open([lockPath fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+    if (descriptor >= 0) {
+        flock(descriptor, LOCK_EX);
+    }
+    block();
+    if (descriptor >= 0) {
+        flock(descriptor, LOCK_UN);
+        close(descriptor);
+    }
+}
+
+// Only decodes the file when it was replaced since the last read, by this process or by an extension
+- (void)_refreshSnapshot
+{
+    FWTStateFileIdentity identity = FWTStateFileIdentityForPath(self.fileURL.path);
+    if (self.hasSnapshot && FWTStateFileIdentityEqual(identity, self.snapshotIdentity)) {
+        return;
+    }
+
+    FWTServerConfiguration *configuration = nil;
+    FWTNotifiableDevice *device = nil;
+    [self _readConfiguration:&configuration device:&device];
+    [self _updateSnapshotWithConfiguration:configuration device:device identity:identity];
+}
+
+- (void)_updateSnapshotWithConfiguration:(FWTServerConfiguration *)configuration
+                                  device:(FWTNotifiableDevice *)device
+                                identity:(FWTStateFileIdentity)identity
+{
+    self.snapshotConfiguration = configuration;
+    self.snapshotDevice = device;
+    self.snapshotIdentity = identity;
+    self.hasSnapshot = YES;
+    self.changeCount += 1;
+}
+
+// Writers replace the file with a rename, so the readers never see a partial file and don't need the lock.
+- (BOOL)_readConfiguration:(FWTServerConfiguration * __autoreleasing *)configuration
+                    device:(FWTNotifiableDevice * __autoreleasing *)device
+{
+    NSData *data = [NSData dataWithContentsOfURL:self.fileURL options:NSDataReadingMappedIfSafe error:nil];
+    if (data.length == 0) {
+        return NO;
+    }
+
+    FWTStateReader reader = {data.bytes, data.length, 0, NO};
+    const uint8_t *magic = FWTStateReadRaw(&reader, sizeof(FWTStateMagic));
+    uint16_t version = FWTStateReadUInt16(&reader);
+    FWTStateReadUInt16(&reader);
+    if (reader.failed || memcmp(magic, FWTStateMagic, sizeof(FWTStateMagic)) != 0 || version > FWTStateVersion) {
+        return NO;
+    }
+
+    FWTServerConfiguration *storedConfiguration = [self _readConfigurationWithReader:&reader];
+    FWTNotifiableDevice *storedDevice = [self _readDeviceWithReader:&reader];
+    if (reader.failed) {
+        return NO;
+    }
+    *configuration = storedConfiguration;
+    *device = storedDevice;
+    return YES;
+}
+
+- (FWTServerConfiguration *)_readConfigurationWithReader:(FWTStateReader *)reader
+{
+    if (FWTStateReadUInt8(reader) == 0) {
+        return nil;
+    }
+
+    NSString *url = FWTStateReadString(reader);
+    NSString *accessId = FWTStateReadString(reader);
+    NSString *secretKey = FWTStateReadString(reader);
+    FWTNotifiableSignature signature = (FWTNotifiableSignature)FWTStateReadUInt8(reader);
+    if (reader->failed || url == nil) {
+        return nil;
+    }
+    return [[FWTServerConfiguration alloc] initWithServerURL:[NSURL URLWithString:url]
+                                                    accessId:accessId
+                                                   secretKey:secretKey
+                                                andSignature:signature];
+}
+
+- (FWTNotifiableDevice *)_readDeviceWithReader:(FWTStateReader *)reader
+{
+    if (FWTStateReadUInt8(reader) == 0) {
+        return nil;
+    }
+
+    NSData *token = FWTStateReadBytes(reader);
+    BOOL hasTokenId = FWTStateReadUInt8(reader) != 0;
+    int64_t tokenId = FWTStateReadInt64(reader);
+    NSString *localeIdentifier = FWTStateReadString(reader);
+    NSString *user = FWTStateReadString(reader);
+    NSString *name = FWTStateReadString(reader);
+    NSDictionary *customProperties = FWTStateReadJSON(reader);
+    NSDictionary *platformProperties = FWTStateReadJSON(reader);
+
+    if (reader->failed || token == nil || !hasTokenId) {
+        return nil;
+    }
+    NSLocale *locale = localeIdentifier ? [NSLocale localeWithLocaleIdentifier:localeIdentifier] : [NSLocale autoupdatingCurrentLocale];
+    return [[FWTNotifiableDevice alloc] initWithToken:token
+                                              tokenId:@(tokenId)
+                                               locale:locale
+                                                 user:user
+                                                 name:name
+                                     customProperties:customProperties
+                                   platformProperties:platformProperties];
+}
+
+- (BOOL)_writeConfiguration:(FWTServerConfiguration *)configuration device:(FWTNotifiableDevice *)device
+{
+    NSMutableData *data = [[NSMutableData alloc] initWithCapacity:256];
+    [data appendBytes:FWTStateMagic length:sizeof(FWTStateMagic)];
+    FWTStateAppendUInt16(data, FWTStateVersion);
+    FWTStateAppendUInt16(data, 0);
+
+    FWTStateAppendUInt8(data, configuration != nil);
+    if (configuration) {
+        FWTStateAppendString(data, configuration.serverURL.absoluteString);
+        FWTStateAppendString(data, configuration.serverAccessId);
+        FWTStateAppendString(data, configuration.serverSecretKey);
+        FWTStateAppendUInt8(data, (uint8_t)configuration.signature);
+    }
+
+    FWTStateAppendUInt8(data, device != nil);
+    if (device) {
+        FWTStateAppendBytes(data, device.token);
+        FWTStateAppendUInt8(data, device.tokenId != nil);
+        FWTStateAppendInt64(data, [device.tokenId longLongValue]);
+        FWTStateAppendString(data, device.locale.localeIdentifier);
+        FWTStateAppendString(data, device.user);
+        FWTStateAppendString(data, device.name);
+        FWTStateAppendJSON(data, device.customProperties);
+        FWTStateAppendJSON(data, device.platformProperties);
+    }
+
+    // NSDataWritingAtomic writes to a temporary file and renames it over the state file
+    if (![data writeToURL:self.fileURL options:NSDataWritingAtomic error:nil]) {
+        return NO;
+    }
+    [self _updateSnapshotWithConfiguration:configuration
+                                    device:device
+                                  identity:FWTStateFileIdentityForPath(self.fileURL.path)];
+    return YES;
+}
+
+@end
@@ -7,6 +7,7 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "FWTNotifiableManager.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -15,11 +16,16 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, strong, readonly) NSURL *serverURL;
 @property (nonatomic, strong, readonly) NSString *serverAccessId;
 @property (nonatomic, strong, readonly) NSString *serverSecretKey;
+@property (nonatomic, assign, readonly) FWTNotifiableSignature signature;
 
 - (instancetype)init NS_UNAVAILABLE;
 - (instancetype) initWithServerURL:(NSURL *)url
                           accessId:(NSString *)accessId
-                      andSecretKey:(NSString *)secretKey NS_DESIGNATED_INITIALIZER;
+                      andSecretKey:(NSString *)secretKey;
+- (instancetype) initWithServerURL:(NSURL *)url
+                          accessId:(NSString *)accessId
+                         secretKey:(NSString *)secretKey
+                      andSignature:(FWTNotifiableSignature)signature NS_DESIGNATED_INITIALIZER;
 
 @end
 
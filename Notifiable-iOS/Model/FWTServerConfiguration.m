@@ -11,6 +11,7 @@
 #define kFWTServerURLKey @"kFWTServerURLKey"
 #define kFWTServerAccessIdKey @"kFWTServerAccessIdKey"
 #define kFWTServerSecretKeyKey @"kFWTServerSecretKeyKey"
+#define kFWTServerSignatureKey @"kFWTServerSignatureKey"
 
 @interface FWTServerConfiguration () <NSSecureCoding>
 @end
@@ -24,11 +25,22 @@
 - (instancetype) initWithServerURL:(NSURL *)url
                           accessId:(NSString *)accessId
                       andSecretKey:(NSString *)secretKey {
+    return [self initWithServerURL:url
+                          accessId:accessId
+                         secretKey:secretKey
+                      andSignature:FWTNotifiableSignatureHMACSHA1];
+}
+
+- (instancetype) initWithServerURL:(NSURL *)url
+                          accessId:(NSString *)accessId
+                         secretKey:(NSString *)secretKey
+                      andSignature:(FWTNotifiableSignature)signature {
     self = [super init];
     if (self) {
         self->_serverURL = url;
         self->_serverAccessId = accessId;
         self->_serverSecretKey = secretKey;
+        self->_signature = signature;
     }
     return self;
 }
@@ -37,13 +49,16 @@
     [aCoder encodeObject:self.serverURL forKey:kFWTServerURLKey];
     [aCoder encodeObject:self.serverAccessId forKey:kFWTServerAccessIdKey];
     [aCoder encodeObject:self.serverSecretKey forKey:kFWTServerSecretKeyKey];
+    [aCoder encodeInteger:self.signature forKey:kFWTServerSignatureKey];
 }
 
 - (nullable instancetype)initWithCoder:(nonnull NSCoder *)aDecoder {
     NSURL *serverURL = (NSURL *)[aDecoder decodeObjectOfClass:[NSURL class] forKey:kFWTServerURLKey];
     NSString *serverAccessId = (NSString *)[aDecoder decodeObjectOfClass:[NSString class] forKey:kFWTServerAccessIdKey];
     NSString *serverSecretKey = (NSString *)[aDecoder decodeObjectOfClass:[NSString class] forKey:kFWTServerSecretKeyKey];
-    return [self initWithServerURL:serverURL accessId:serverAccessId andSecretKey:serverSecretKey];
+    // Configurations stored by older versions don't have the signature and decode as HMAC-SHA1
+    FWTNotifiableSignature signature = (FWTNotifiableSignature)[aDecoder decodeIntegerForKey:kFWTServerSignatureKey];
+    return [self initWithServerURL:serverURL accessId:serverAccessId secretKey:serverSecretKey andSignature:signature];
 }
 
 @end
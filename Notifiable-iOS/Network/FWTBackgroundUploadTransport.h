@@ -0,0 +1,61 @@
+//
+//  FWTBackgroundUploadTransport.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "FWTHTTPTransport.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Called when an upload finishes and nobody in this process is waiting for it, e.g. when the
+ upload was started before the app was suspended or killed.
+
+ @param request  Request that was uploaded.
+ @param body     Body of the request.
+ @param response Response of the server, if any.
+ @param error    Error of the upload, if any.
+ */
+typedef void (^FWTBackgroundUploadReconciliationHandler)(NSURLRequest *request, NSData * _Nullable body, NSHTTPURLResponse * _Nullable response, NSError * _Nullable error);
+
+/**
+ Transport that writes the body of each request to a file and uploads it on a background URL
+ session, so the upload continues while the app is suspended.
+
+ The file name is derived from the method, path and body, so the same request sent again while the
+ upload is in flight, from this process or after it is relaunched, joins the existing upload instead of
+ starting a new one. The file is removed once the upload finishes.
+ */
+@interface FWTBackgroundUploadTransport : NSObject <FWTHTTPTransport>
+
+@property (nonatomic, copy, readonly) NSString *identifier;
+/** Group of the shared transport, nil for the app container */
+@property (nonatomic, copy, readonly, nullable) NSString *groupId;
+/** Directory that holds the bodies being uploaded */
+@property (nonatomic, strong, readonly) NSURL *directory;
+/** Called on the transport queue. Uploads that finish before it is set are kept until then. */
+@property (nonatomic, copy, nullable) FWTBackgroundUploadReconciliationHandler reconciliationHandler;
+/** Handler given by the app when the system relaunches it for the session events. Called on the main queue once they were delivered. */
+@property (nonatomic, copy, nullable) void (^backgroundEventsCompletionHandler)(void);
+
+/**
+ Shared transport for a specific group. Each process (the app or an extension) has its own
+ background session and directory, suffixed with its bundle identifier.
+
+ @param groupId Group used to share the data with extensions. If nil, the app container is used.
+ */
++ (instancetype)transportWithGroupId:(NSString * _Nullable)groupId;
+
+/** Shared transport of a background session identifier, or nil if the identifier wasn't created by the SDK for this process. */
++ (nullable instancetype)transportWithSessionIdentifier:(NSString *)identifier;
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithIdentifier:(NSString *)identifier
+                         directory:(NSURL *)directory
+              sessionConfiguration:(NSURLSessionConfiguration *)configuration NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
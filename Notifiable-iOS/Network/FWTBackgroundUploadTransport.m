@@ -0,0 +1,321 @@
+//
+//  FWTBackgroundUploadTransport.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTBackgroundUploadTransport.h"
+#import "NSFileManager+FWTNotifiable.h"
+#import <CommonCrypto/CommonCrypto.h>
+
+NSString * const FWTBackgroundUploadSessionIdentifier = @"com.futureworkshops.notifiable.background";
+NSString * const FWTBackgroundUploadDirectoryName = @"uploads";
+NSString * const FWTBackgroundUploadFileExtension = @"body";
+
+static NSMutableDictionary<NSString *, FWTBackgroundUploadTransport *> *sharedTransports;
+
+static NSString *FWTBackgroundUploadKey(NSURLRequest *request)
+{
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    NSData *body = request.HTTPBody ?: [NSData data];
+    CC_SHA256(body.bytes, (CC_LONG)body.length, digest);
+
+    NSMutableString *key = [NSMutableString stringWithFormat:@"%@%@_", request.HTTPMethod, request.URL.path];
+    [key replaceOccurrencesOfString:@"/" withString:@"_" options:0 range:NSMakeRange(0, key.length)];
+    // Half of the digest is enough to tell apart the bodies sent to the same path
+    for (NSUInteger index = 0; index < CC_SHA256_DIGEST_LENGTH / 2; index++) {
+        [key appendFormat:@"%02x", digest[index]];
+    }
+    return key;
+}
+
+@interface FWTBackgroundUploadTransport () <NSURLSessionDataDelegate>
+
+@property (nonatomic, copy, readwrite, nullable) NSString *groupId;
+@property (nonatomic, strong) NSURLSession *session;
+@property (nonatomic, strong) NSOperationQueue *delegateQueue;
+// Only accessed on the delegate queue
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableArray<FWTHTTPTransportCompletionHandler> *> *handlers;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSMutableData *> *responses;
+@property (nonatomic, strong) NSMutableArray<void (^)(FWTBackgroundUploadReconciliationHandler)> *pendingReconciliations;
+@property (nonatomic, assign) BOOL finishedBackgroundEvents;
+
+@end
+
+@implementation FWTBackgroundUploadTransport
+
+@synthesize reconciliationHandler = _reconciliationHandler;
+@synthesize backgroundEventsCompletionHandler = _backgroundEventsCompletionHandler;
+
+// A background session can only be owned by one process, so the app and each extension of the
+// group use their own session and directory. The outbox lease and the receipt dedup keep them
+// from sending the same events twice.
+static NSString *FWTBackgroundUploadProcessIdentifier(void)
+{
+    return [NSBundle mainBundle].bundleIdentifier ?: [NSProcessInfo processInfo].processName;
+}
+
+static NSString *FWTBackgroundUploadProcessPrefix(void)
+{
+    return [NSString stringWithFormat:@"%@.%@", FWTBackgroundUploadSessionIdentifier, FWTBackgroundUploadProcessIdentifier()];
+}
+
++ (instancetype)transportWithGroupId:(NSString *)groupId
+{
+    NSString *identifier = FWTBackgroundUploadProcessPrefix();
+    if (groupId.length > 0) {
+        identifier = [NSString stringWithFormat:@"%@.%@", identifier, groupId];
+    }
+
+    @synchronized(self) {
+        if (sharedTransports == nil) {
+            sharedTransports = [[NSMutableDictionary alloc] init];
+        }
+        FWTBackgroundUploadTransport *transport = sharedTransports[identifier];
+        if (transport == nil) {
+            NSURL *directory = [[[[NSFileManager defaultManager] fwt_notifiableDirectoryWithGroupId:groupId] URLByAppendingPathComponent:FWTBackgroundUploadDirectoryName
+                                                                                                                                isDirectory:YES] URLByAppendingPathComponent:FWTBackgroundUploadProcessIdentifier()
+                                                                                                                                                                  isDirectory:YES];
+            NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration backgroundSessionConfigurationWithIdentifier:identifier];
+            configuration.sharedContainerIdentifier = groupId;
+            configuration.HTTPShouldSetCookies = NO;
+            configuration.HTTPCookieAcceptPolicy = NSHTTPCookieAcceptPolicyNever;
+            configuration.URLCache = nil;
+            transport = [[FWTBackgroundUploadTransport alloc] initWithIdentifier:identifier
+                                                                       directory:directory
+                                                            sessionConfiguration:configuration];
+            transport.groupId = groupId;
+            sharedTransports[identifier] = transport;
+        }
+        return transport;
+    }
+}
+
++ (instancetype)transportWithSessionIdentifier:(NSString *)identifier
+{
+    // Only the sessions of this process are delivered to it
+    NSString *prefix = FWTBackgroundUploadProcessPrefix();
+    if ([identifier isEqualToString:prefix]) {
+        return [self transportWithGroupId:nil];
+    }
+    prefix = [prefix stringByAppendingString:@"."];
+    if ([identifier hasPrefix:prefix] && identifier.length > prefix.length) {
+        return [self transportWithGroupId:[identifier substringFromIndex:prefix.length]];
+    }
+    return nil;
+}
+
+- (instancetype)initWithIdentifier:(NSString *)identifier
+                         directory:(NSURL *)directory
+              sessionConfiguration:(NSURLSessionConfiguration *)configuration
+{
+    self = [super init];
+    if (self) {
+        self->_identifier = [identifier copy];
+        self->_directory = directory;
+        self->_handlers = [[NSMutableDictionary alloc] init];
+        self->_responses = [[NSMutableDictionary alloc] init];
+        self->_pendingReconciliations = [[NSMutableArray alloc] init];
+        self->_delegateQueue = [[NSOperationQueue alloc] init];
+        self->_delegateQueue.name = identifier;
+        self->_delegateQueue.maxConcurrentOperationCount = 1;
+        [[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil];
+        self->_session = [NSURLSession sessionWithConfiguration:configuration
+                                                       delegate:self
+                                                  delegateQueue:self->_delegateQueue];
+        [self _restoreUploads];
+    }
+    return self;
+}
+
+#pragma mark - Class properties
+
+// The handlers are only accessed on the delegate queue, so the session events delivered
+// right after the transport is created are not lost
+
+- (FWTBackgroundUploadReconciliationHandler)reconciliationHandler
+{
+    __block FWTBackgroundUploadReconciliationHandler handler = nil;
+    [self _performOnDelegateQueueAndWait:^{
+        handler = self->_reconciliationHandler;
+    }];
+    return handler;
+}
+
+- (void)setReconciliationHandler:(FWTBackgroundUploadReconciliationHandler)reconciliationHandler
+{
+    FWTBackgroundUploadReconciliationHandler handler = [reconciliationHandler copy];
+    [self.delegateQueue addOperationWithBlock:^{
+        self->_reconciliationHandler = handler;
+        if (handler == nil) {
+            return;
+        }
+        NSArray<void (^)(FWTBackgroundUploadReconciliationHandler)> *reconciliations = [self.pendingReconciliations copy];
+        [self.pendingReconciliations removeAllObjects];
+        for (void (^reconciliation)(FWTBackgroundUploadReconciliationHandler) in reconciliations) {
+            reconciliation(handler);
+        }
+    }];
+}
+
+- (void (^)(void))backgroundEventsCompletionHandler
+{
+    __block void (^handler)(void) = nil;
+    [self _performOnDelegateQueueAndWait:^{
+        handler = self->_backgroundEventsCompletionHandler;
+    }];
+    return handler;
+}
+
+- (void)setBackgroundEventsCompletionHandler:(void (^)(void))backgroundEventsCompletionHandler
+{
+    void (^handler)(void) = [backgroundEventsCompletionHandler copy];
+    [self.delegateQueue addOperationWithBlock:^{
+        if (handler && self.finishedBackgroundEvents) {
+            self.finishedBackgroundEvents = NO;
+            dispatch_async(dispatch_get_main_queue(), handler);
+            return;
+        }
+        self->_backgroundEventsCompletionHandler = handler;
+    }];
+}
+
+#pragma mark - FWTHTTPTransport
+
+// The uploads are shared by identical requests and must outlive the app, so they are never cancelled
+- (NSURLSessionTask *)sendRequest:(NSURLRequest *)request completionHandler:(FWTHTTPTransportCompletionHandler)handler
+{
+    [self.delegateQueue addOperationWithBlock:^{
+        NSString *key = FWTBackgroundUploadKey(request);
+        NSMutableArray<FWTHTTPTransportCompletionHandler> *handlers = self.handlers[key];
+        if (handlers) {
+            // Same request already being uploaded
+            [handlers addObject:[handler copy]];
+            return;
+        }
+
+        NSError *error;
+        NSURL *fileURL = [self _fileURLForKey:key];
+        if (![request.HTTPBody ?: [NSData data] writeToURL:fileURL options:NSDataWritingAtomic error:&error]) {
+            handler(nil, nil, error);
+            return;
+        }
+
+        NSMutableURLRequest *uploadRequest = [request mutableCopy];
+        uploadRequest.HTTPBody = nil;
+        NSURLSessionUploadTask *task = [self.session uploadTaskWithRequest:uploadRequest fromFile:fileURL];
+        task.taskDescription = key;
+        self.handlers[key] = [NSMutableArray arrayWithObject:[handler copy]];
+        [task resume];
+    }];
+    return nil;
+}
+
+#pragma mark - NSURLSessionDataDelegate
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data
+{
+    NSMutableData *response = self.responses[@(dataTask.taskIdentifier)];
+    if (response == nil) {
+        response = [[NSMutableData alloc] init];
+        self.responses[@(dataTask.taskIdentifier)] = response;
+    }
+    [response appendData:data];
+}
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didCompleteWithError:(NSError *)error
+{
+    NSString *key = task.taskDescription;
+    NSData *data = self.responses[@(task.taskIdentifier)];
+    [self.responses removeObjectForKey:@(task.taskIdentifier)];
+    if (key.length == 0) {
+        return;
+    }
+
+    NSArray<FWTHTTPTransportCompletionHandler> *handlers = self.handlers[key];
+    [self.handlers removeObjectForKey:key];
+
+    NSURL *fileURL = [self _fileURLForKey:key];
+    NSData *body = handlers.count == 0 ? [NSData dataWithContentsOfURL:fileURL] : nil;
+    [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+
+    if (handlers.count > 0) {
+        for (FWTHTTPTransportCompletionHandler handler in handlers) {
+            handler(data, task.response, error);
+        }
+        return;
+    }
+
+    NSURLRequest *request = task.originalRequest;
+    if (request == nil) {
+        return;
+    }
+    NSHTTPURLResponse *response = [task.response isKindOfClass:[NSHTTPURLResponse class]] ? (NSHTTPURLResponse *)task.response : nil;
+    void (^reconciliation)(FWTBackgroundUploadReconciliationHandler) = ^(FWTBackgroundUploadReconciliationHandler handler) {
+        handler(request, body, response, error);
+    };
+    if (self->_reconciliationHandler) {
+        reconciliation(self->_reconciliationHandler);
+    } else {
+        [self.pendingReconciliations addObject:reconciliation];
+    }
+}
+
+- (void)URLSessionDidFinishEventsForBackgroundURLSession:(NSURLSession *)session
+{
+    void (^completionHandler)(void) = self->_backgroundEventsCompletionHandler;
+    self->_backgroundEventsCompletionHandler = nil;
+    if (completionHandler) {
+        dispatch_async(dispatch_get_main_queue(), completionHandler);
+    } else {
+        // The app gives the handler after the session was recreated
+        self.finishedBackgroundEvents = YES;
+    }
+}
+
+#pragma mark - Private methods
+
+- (void)_performOnDelegateQueueAndWait:(void(^)(void))block
+{
+    if ([NSOperationQueue currentQueue] == self.delegateQueue) {
+        block();
+    } else {
+        [self.delegateQueue addOperations:@[[NSBlockOperation blockOperationWithBlock:block]] waitUntilFinished:YES];
+    }
+}
+
+- (NSURL *)_fileURLForKey:(NSString *)key
+{
+    return [[self.directory URLByAppendingPathComponent:key] URLByAppendingPathExtension:FWTBackgroundUploadFileExtension];
+}
+
+// Uploads started by a previous process keep running on the session. They are registered, so the same
+// request joins them, and the files left without an upload are removed.
+- (void)_restoreUploads
+{
+    [self.session getTasksWithCompletionHandler:^(NSArray<NSURLSessionDataTask *> *dataTasks,
+                                                  NSArray<NSURLSessionUploadTask *> *uploadTasks,
+                                                  NSArray<NSURLSessionDownloadTask *> *downloadTasks) {
+        [self.delegateQueue addOperationWithBlock:^{
+            for (NSURLSessionUploadTask *task in uploadTasks) {
+                NSString *key = task.taskDescription;
+                if (key.length > 0 && self.handlers[key] == nil && task.state != NSURLSessionTaskStateCompleted) {
+                    self.handlers[key] = [[NSMutableArray alloc] init];
+                }
+            }
+
+            NSArray<NSURL *> *files = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:self.directory
+                                                                    includingPropertiesForKeys:nil
+                                                                                       options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                                                         error:nil];
+            for (NSURL *file in files) {
+                NSString *key = [file.lastPathComponent stringByDeletingPathExtension];
+                if ([file.pathExtension isEqualToString:FWTBackgroundUploadFileExtension] && self.handlers[key] == nil) {
+                    [[NSFileManager defaultManager] removeItemAtURL:file error:nil];
+                }
+            }
+        }];
+    }];
+}
+
+@end
@@ -0,0 +1,84 @@
+//
+//  FWTCircuitBreaker.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ States of the circuit breaker.
+ 
+ - FWTCircuitBreakerStateClosed: The server is healthy and the requests are sent.
+ - FWTCircuitBreakerStateOpen: The server is failing and the requests fail without being sent.
+ - FWTCircuitBreakerStateHalfOpen: The open interval expired and a single probe request is allowed.
+ */
+typedef NS_ENUM(NSInteger, FWTCircuitBreakerState) {
+    FWTCircuitBreakerStateClosed = 0,
+    FWTCircuitBreakerStateOpen,
+    FWTCircuitBreakerStateHalfOpen
+};
+
+/**
+ Per host circuit breaker. The breaker opens after a number of consecutive failures, or when
+ the rate of server errors inside the sampling window is too high.
+ 
+ The state is stored in the user defaults, so, when a group user defaults is used, the app and its
+ extensions share the knowledge about the server health. Inside a process, use one breaker per host,
+ from breakerWithHost:groupId:. The updates of all the breakers are serialized by a lock of the process.
+ The user defaults have no lock across processes, so when the app and an extension record a response at
+ the same time, one of the updates can be lost. At worst that delays opening or closing the breaker by one
+ response, which doesn't justify a file lock on every request.
+ */
+@interface FWTCircuitBreaker : NSObject
+
+@property (nonatomic, copy, readonly) NSString *host;
+@property (nonatomic, assign, readonly) FWTCircuitBreakerState state;
+
+/** Consecutive failures that open the breaker. Default: 5 */
+@property (atomic, assign) NSUInteger failureThreshold;
+/** Rate of server errors (0 to 1) that opens the breaker. Default: 0.5 */
+@property (atomic, assign) double errorRateThreshold;
+/** Min number of responses on the window before the error rate is considered. Default: 10 */
+@property (atomic, assign) NSUInteger minimumRequests;
+/** Time window used to calculate the error rate. Default: 60 seconds */
+@property (atomic, assign) NSTimeInterval samplingWindow;
+/** Time that the breaker stays open before allowing a probe. Default: 30 seconds */
+@property (atomic, assign) NSTimeInterval openInterval;
+
+/**
+ Shared breaker of a host, stored in the user defaults of the group.
+
+ @param host    Host of the server.
+ @param groupId Group used to share the state with extensions. If nil, the standard user defaults are used.
+ */
++ (instancetype)breakerWithHost:(NSString *)host groupId:(NSString * _Nullable)groupId;
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithHost:(NSString *)host
+                userDefaults:(NSUserDefaults *)userDefaults NS_DESIGNATED_INITIALIZER;
+
+/**
+ Check if a request can be sent. When the breaker is half open, only the first caller is allowed
+ to probe the server.
+ */
+- (BOOL)allowRequest;
+
+/** Register a response that was not a server error. */
+- (void)recordSuccess;
+
+/**
+ Register a failed request.
+ 
+ @param statusCode HTTP status code of the response, or 0 if the request failed without a response.
+ */
+- (void)recordFailureWithStatusCode:(NSInteger)statusCode;
+
+/** Close the breaker and clear the stored state. */
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
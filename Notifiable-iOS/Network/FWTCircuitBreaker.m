@@ -0,0 +1,198 @@
+//
+//  FWTCircuitBreaker.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTCircuitBreaker.h"
+#import "NSUserDefaults+FWTNotifiable.h"
+
+NSString * const FWTCircuitBreakerKeyPrefix             = @"FWTNotifiableCircuitBreaker.";
+
+NSString * const FWTCircuitBreakerStateKey              = @"state";
+NSString * const FWTCircuitBreakerFailuresKey           = @"failures";
+NSString * const FWTCircuitBreakerOpenedAtKey           = @"opened_at";
+NSString * const FWTCircuitBreakerProbeStartedAtKey     = @"probe_started_at";
+NSString * const FWTCircuitBreakerWindowStartKey        = @"window_start";
+NSString * const FWTCircuitBreakerWindowRequestsKey     = @"window_requests";
+NSString * const FWTCircuitBreakerWindowErrorsKey       = @"window_errors";
+
+static NSMutableDictionary<NSString *, FWTCircuitBreaker *> *sharedBreakers;
+
+@interface FWTCircuitBreaker ()
+
+@property (nonatomic, strong) NSUserDefaults *userDefaults;
+@property (nonatomic, copy) NSString *storageKey;
+
+@end
+
+@implementation FWTCircuitBreaker
+
++ (instancetype)breakerWithHost:(NSString *)host groupId:(NSString *)groupId
+{
+    NSString *key = [NSString stringWithFormat:@"%@|%@", groupId ?: @"", host];
+    @synchronized(self) {
+        if (sharedBreakers == nil) {
+            sharedBreakers = [[NSMutableDictionary alloc] init];
+        }
+        FWTCircuitBreaker *breaker = sharedBreakers[key];
+        if (breaker == nil) {
+            breaker = [[FWTCircuitBreaker alloc] initWithHost:host userDefaults:[NSUserDefaults userDefaultsWithGroupId:groupId]];
+            sharedBreakers[key] = breaker;
+        }
+        return breaker;
+    }
+}
+
+// Breakers created for the same host share the stored state, so their updates are serialized together
++ (id)_stateLock
+{
+    static NSObject *lock;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        lock = [[NSObject alloc] init];
+    });
+    return lock;
+}
+
+- (instancetype)initWithHost:(NSString *)host userDefaults:(NSUserDefaults *)userDefaults
+{
+    self = [super init];
+    if (self) {
+        self->_host = [host copy];
+        self->_userDefaults = userDefaults;
+        self->_storageKey = [FWTCircuitBreakerKeyPrefix stringByAppendingString:host];
+        self->_failureThreshold = 5;
+        self->_errorRateThreshold = 0.5;
+        self->_minimumRequests = 10;
+        self->_samplingWindow = 60;
+        self->_openInterval = 30;
+    }
+    return self;
+}
+
+- (FWTCircuitBreakerState)state
+{
+    @synchronized([FWTCircuitBreaker _stateLock]) {
+        return [[self _storedState][FWTCircuitBreakerStateKey] integerValue];
+    }
+}
+
+- (BOOL)allowRequest
+{
+    @synchronized([FWTCircuitBreaker _stateLock]) {
+        NSMutableDictionary *state = [self _storedState];
+        NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+        
+        switch ([state[FWTCircuitBreakerStateKey] integerValue]) {
+            case FWTCircuitBreakerStateOpen:
+                if (now - [state[FWTCircuitBreakerOpenedAtKey] doubleValue] < self.openInterval) {
+                    return NO;
+                }
+                state[FWTCircuitBreakerStateKey] = @(FWTCircuitBreakerStateHalfOpen);
+                state[FWTCircuitBreakerProbeStartedAtKey] = @(now);
+                [self _storeState:state];
+                return YES;
+            case FWTCircuitBreakerStateHalfOpen:
+                // A probe that never reported back (e.g. the extension was killed) doesn't block forever
+                if (now - [state[FWTCircuitBreakerProbeStartedAtKey] doubleValue] < self.openInterval) {
+                    return NO;
+                }
+                state[FWTCircuitBreakerProbeStartedAtKey] = @(now);
+                [self _storeState:state];
+                return YES;
+            case FWTCircuitBreakerStateClosed:
+            default:
+                return YES;
+        }
+    }
+}
+
+- (void)recordSuccess
+{
+    @synchronized([FWTCircuitBreaker _stateLock]) {
+        NSMutableDictionary *state = [self _storedState];
+        BOOL changed = [state[FWTCircuitBreakerStateKey] integerValue] != FWTCircuitBreakerStateClosed ||
+                       [state[FWTCircuitBreakerFailuresKey] integerValue] != 0;
+        if ([state[FWTCircuitBreakerStateKey] integerValue] != FWTCircuitBreakerStateClosed) {
+            // The probe succeeded, the server is back
+            [state removeAllObjects];
+        }
+        state[FWTCircuitBreakerFailuresKey] = @0;
+        changed = [self _sampleResponseWithError:NO onState:state] || changed;
+        if (changed) {
+            [self _storeState:state];
+        }
+    }
+}
+
+- (void)recordFailureWithStatusCode:(NSInteger)statusCode
+{
+    @synchronized([FWTCircuitBreaker _stateLock]) {
+        NSMutableDictionary *state = [self _storedState];
+        NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+        NSUInteger failures = [state[FWTCircuitBreakerFailuresKey] unsignedIntegerValue] + 1;
+        state[FWTCircuitBreakerFailuresKey] = @(failures);
+        [self _sampleResponseWithError:(statusCode == 0 || statusCode >= 500) onState:state];
+        
+        NSUInteger requests = [state[FWTCircuitBreakerWindowRequestsKey] unsignedIntegerValue];
+        NSUInteger errors = [state[FWTCircuitBreakerWindowErrorsKey] unsignedIntegerValue];
+        BOOL highErrorRate = requests >= self.minimumRequests && requests > 0 &&
+                             ((double)errors / (double)requests) >= self.errorRateThreshold;
+        BOOL failedProbe = [state[FWTCircuitBreakerStateKey] integerValue] == FWTCircuitBreakerStateHalfOpen;
+        
+        if (failedProbe || failures >= self.failureThreshold || highErrorRate) {
+            state[FWTCircuitBreakerStateKey] = @(FWTCircuitBreakerStateOpen);
+            state[FWTCircuitBreakerOpenedAtKey] = @(now);
+            [state removeObjectForKey:FWTCircuitBreakerProbeStartedAtKey];
+        }
+        [self _storeState:state];
+    }
+}
+
+- (void)reset
+{
+    @synchronized([FWTCircuitBreaker _stateLock]) {
+        [self.userDefaults removeObjectForKey:self.storageKey];
+    }
+}
+
+#pragma mark - Private
+
+- (NSMutableDictionary *)_storedState
+{
+    NSDictionary *stored = [self.userDefaults dictionaryForKey:self.storageKey];
+    return stored ? [stored mutableCopy] : [[NSMutableDictionary alloc] init];
+}
+
+- (void)_storeState:(NSDictionary *)state
+{
+    [self.userDefaults setObject:[state copy] forKey:self.storageKey];
+}
+
+- (BOOL)_sampleResponseWithError:(BOOL)isError onState:(NSMutableDictionary *)state
+{
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+    NSTimeInterval windowStart = [state[FWTCircuitBreakerWindowStartKey] doubleValue];
+    NSUInteger requests = [state[FWTCircuitBreakerWindowRequestsKey] unsignedIntegerValue];
+    NSUInteger errors = [state[FWTCircuitBreakerWindowErrorsKey] unsignedIntegerValue];
+    
+    if (now - windowStart > self.samplingWindow) {
+        if (!isError && requests == 0) {
+            // Nothing to track while the server is healthy
+            return NO;
+        }
+        windowStart = now;
+        requests = 0;
+        errors = 0;
+    } else if (!isError && errors == 0) {
+        return NO;
+    }
+    
+    state[FWTCircuitBreakerWindowStartKey] = @(windowStart);
+    state[FWTCircuitBreakerWindowRequestsKey] = @(requests + 1);
+    state[FWTCircuitBreakerWindowErrorsKey] = @(errors + (isError ? 1 : 0));
+    return YES;
+}
+
+@end
@@ -11,13 +11,33 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class FWTRequestTemplate;
+@protocol FWTNotifiableLogger;
+
 @interface FWTHTTPRequestSerializer : NSObject
 
+/** Timeout of the requests. Default: 30 seconds */
+@property (nonatomic, assign) NSTimeInterval timeoutInterval;
+/** Bodies with at least this number of bytes are sent with `Content-Encoding: gzip`. Zero (default) disables the compression. */
+@property (nonatomic, assign) NSUInteger compressionThreshold;
+/** Receives the number of bytes saved by the compression */
+@property (nonatomic, strong, nullable) id<FWTNotifiableLogger> logger;
+
 - (NSURLRequest *) buildRequestWithBaseURL:(NSURL *)baseURL
                                 parameters:(NSDictionary *)parameters
                                 andHeaders:(NSDictionary<NSString *, NSString *> *)headers
                                  forMethod:(FWTHTTPMethod)method;
 
+/**
+ Request of a compiled endpoint, see FWTRequestTemplate.
+ 
+ @param url URL of the request, built by the template.
+ */
+- (NSURLRequest *) buildRequestWithTemplate:(FWTRequestTemplate *)requestTemplate
+                                        URL:(NSURL *)url
+                                 parameters:(nullable NSDictionary *)parameters
+                                 andHeaders:(NSDictionary<NSString *, NSString *> *)headers;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -7,11 +7,24 @@
 //
 
 #import "FWTHTTPRequestSerializer.h"
+#import "FWTRequestTemplate.h"
+#import "FWTNotifiableLogging.h"
+#import "NSData+FWTNotifiable.h"
 
 NSString * const FWHTTPRequestSerializerQueryRegex = @"\\?([\\w-]+(=[\\w-]*)?(&[\\w-]+(=[\\w-]*)?)*)?$";
 
 @implementation FWTHTTPRequestSerializer
 
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self->_timeoutInterval = 30;
+        self->_compressionThreshold = 0;
+    }
+    return self;
+}
+
 - (NSURLRequest *) buildRequestWithBaseURL:(NSURL *)baseURL
                                 parameters:(NSDictionary *)parameters
                                 andHeaders:(NSDictionary<NSString *, NSString *> *)headers
@@ -19,9 +32,11 @@ NSString * const FWHTTPRequestSerializerQueryRegex = @"\\?([\\w-]+(=[\\w-]*)?(&[
 {
     NSURL *finalURL = method == FWTHTTPMethodGET ? [self _getCompleteURL:baseURL withParameters:parameters] : baseURL;
     
+    // Only reads can use the cache, the mutating calls always reach the server
+    NSURLRequestCachePolicy cachePolicy = method == FWTHTTPMethodGET ? NSURLRequestUseProtocolCachePolicy : NSURLRequestReloadIgnoringLocalCacheData;
     NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:finalURL
-                                                                cachePolicy:NSURLRequestReturnCacheDataElseLoad
-                                                            timeoutInterval:10000];
+                                                                cachePolicy:cachePolicy
+                                                            timeoutInterval:self.timeoutInterval];
     [request setHTTPMethod:FWTHTTPMethodString(method)];
     [request setAllHTTPHeaderFields:headers];
     
@@ -33,19 +48,60 @@ NSString * const FWHTTPRequestSerializerQueryRegex = @"\\?([\\w-]+(=[\\w-]*)?(&[
         if (![request valueForHTTPHeaderField:@"Content-Type"]) {
             [request setValue:@"application/json; charset=utf-8" forHTTPHeaderField:@"Content-Type"];
         }
-        
-        NSData *parameterData = [self _bodyDataForParameters:parameters];
-        [request setHTTPBody:parameterData];
+        [self _setBodyWithParameters:parameters toRequest:request];
+    }
+    
+    return [request copy];
+}
+
+- (NSURLRequest *) buildRequestWithTemplate:(FWTRequestTemplate *)requestTemplate
+                                        URL:(NSURL *)url
+                                 parameters:(NSDictionary *)parameters
+                                 andHeaders:(NSDictionary<NSString *, NSString *> *)headers
+{
+    FWTHTTPMethod method = requestTemplate.method;
+    NSURL *finalURL = method == FWTHTTPMethodGET ? [self _getCompleteURL:url withParameters:parameters] : url;
+    
+    NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:finalURL
+                                                                cachePolicy:requestTemplate.cachePolicy
+                                                            timeoutInterval:self.timeoutInterval];
+    [request setHTTPMethod:requestTemplate.HTTPMethod];
+    [request setAllHTTPHeaderFields:headers];
+    [self _setHeaders:requestTemplate.staticHeaders missingFromRequest:request];
+    
+    if (parameters && parameters.allKeys.count > 0 && method != FWTHTTPMethodGET) {
+        [self _setHeaders:requestTemplate.bodyHeaders missingFromRequest:request];
+        [self _setBodyWithParameters:parameters toRequest:request];
     }
     
     return [request copy];
 }
 
+- (void) _setHeaders:(NSDictionary<NSString *, NSString *> *)headers missingFromRequest:(NSMutableURLRequest *)request
+{
+    for (NSString *field in headers) {
+        if (![request valueForHTTPHeaderField:field]) {
+            [request setValue:headers[field] forHTTPHeaderField:field];
+        }
+    }
+}
+
+- (void) _setBodyWithParameters:(NSDictionary *)parameters toRequest:(NSMutableURLRequest *)request
+{
+    NSData *parameterData = [self _bodyDataForParameters:parameters];
+    NSData *compressedData = [self _compressedBodyData:parameterData];
+    if (compressedData) {
+        [request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+        parameterData = compressedData;
+    }
+    [request setHTTPBody:parameterData];
+}
+
 - (nullable NSData *) _bodyDataForParameters:(NSDictionary *)parameters
 {
     NSError *error = nil;
     NSData *data = [NSJSONSerialization dataWithJSONObject:parameters
-                                                   options:NSJSONWritingPrettyPrinted
+                                                   options:0
                                                      error:&error];
     
     if (error) {
@@ -55,6 +111,25 @@ NSString * const FWHTTPRequestSerializerQueryRegex = @"\\?([\\w-]+(=[\\w-]*)?(&[
     }
 }
 
+- (nullable NSData *) _compressedBodyData:(NSData *)data
+{
+    NSUInteger threshold = self.compressionThreshold;
+    if (threshold == 0 || data.length < threshold) {
+        return nil;
+    }
+    
+    NSData *compressedData = [data fwt_gzipCompressedData];
+    if (compressedData == nil || compressedData.length >= data.length) {
+        return nil;
+    }
+    
+    FWTLogInformation(self.logger, @"Compressed request body from %lu to %lu bytes, %lu bytes saved",
+                      (unsigned long)data.length,
+                      (unsigned long)compressedData.length,
+                      (unsigned long)(data.length - compressedData.length));
+    return compressedData;
+}
+
 - (nonnull NSURL *) _getCompleteURL:(nonnull NSURL *)baseURL withParameters:(NSDictionary *)parameters
 {
     NSString *queryString = [self _buildQueryStringParameter:parameters];
@@ -72,12 +147,16 @@ NSString * const FWHTTPRequestSerializerQueryRegex = @"\\?([\\w-]+(=[\\w-]*)?(&[
 
 - (nonnull NSString *) _junctionStringForURL:(nonnull NSString *)url
 {
-    NSError *error = nil;
-    NSRegularExpression *regex = [[NSRegularExpression alloc] initWithPattern:FWHTTPRequestSerializerQueryRegex
-                                                                      options:NSRegularExpressionCaseInsensitive
-                                                                        error:&error];
+    // The expression is compiled once, matching is thread safe
+    static NSRegularExpression *regex;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        regex = [[NSRegularExpression alloc] initWithPattern:FWHTTPRequestSerializerQueryRegex
+                                                     options:NSRegularExpressionCaseInsensitive
+                                                       error:nil];
+    });
     
-    if (error) {
+    if (regex == nil) {
         return @"?";
     }
     
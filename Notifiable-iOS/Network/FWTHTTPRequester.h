@@ -13,25 +13,54 @@ typedef void(^FWTRequestManagerArraySuccessBlock)(NSArray* response);
 typedef void(^FWTRequestManagerFailureBlock)(NSInteger responseCode, NSError * error);
 
 @class FWTNotifiableAuthenticator;
+@class FWTCircuitBreaker;
+@protocol FWTNotifiableLogger;
+@protocol FWTNotifiableMetrics;
+@protocol FWTHTTPTransport;
 
 @interface FWTHTTPRequester : NSObject
 
 @property (nonatomic, readonly, strong) NSURL* baseUrl;
+/** Breaker used to stop sending requests while the server is failing */
+@property (nonatomic, strong, nullable) FWTCircuitBreaker *circuitBreaker;
+/** Timeout of each request. Default: 30 seconds */
+@property (nonatomic, assign) NSTimeInterval timeoutInterval;
+/** Max time waiting for the response headers of each request. Zero (default) disables it. */
+@property (nonatomic, assign) NSTimeInterval connectTimeout;
+/** Minimum body size sent gzip compressed. Zero (default) disables the compression. */
+@property (nonatomic, assign) NSUInteger compressionThreshold;
+@property (nonatomic, strong, nullable) id<FWTNotifiableLogger> logger;
+@property (nonatomic, strong, nullable) id<FWTNotifiableMetrics> metrics;
+/** When set, the notification receipts are uploaded through this transport */
+@property (nonatomic, strong, nullable) id<FWTHTTPTransport> backgroundTransport;
+
+/**
+ Notification ids of a receipt request sent by the requester.
+
+ @param request Request sent.
+ @param body    Body of the request.
+ @param opened  Set to YES if the receipt marks the notifications as opened, NO if as received.
+ @return The notification ids, or nil if the request is not a receipt.
+ */
++ (nullable NSArray<NSNumber *> *)notificationIdsOfReceiptRequest:(NSURLRequest *)request
+                                                             body:(nullable NSData *)body
+                                                           opened:(BOOL * _Nullable)opened;
 
 - (instancetype)init NS_UNAVAILABLE;
 - (instancetype)initWithBaseURL:(NSURL *)baseUrl
                         session:(NSURLSession *)session
                andAuthenticator:(FWTNotifiableAuthenticator*)authenticator NS_DESIGNATED_INITIALIZER;
-- (void)registerDeviceWithParams:(NSDictionary *)params
-                         success:(_Nullable FWTRequestManagerSuccessBlock)success
-                         failure:(_Nullable FWTRequestManagerFailureBlock)failure;
-- (void)updateDeviceWithTokenId:(NSNumber *)tokenId
-                         params:(NSDictionary *)params
-                        success:(_Nullable FWTRequestManagerSuccessBlock)success
-                        failure:(_Nullable FWTRequestManagerFailureBlock)failure;
-- (void)unregisterTokenId:(NSNumber *)tokenId
-                  success:(FWTRequestManagerSuccessBlock)success
-                  failure:(FWTRequestManagerFailureBlock)failure;
+/** The device requests return the task sending them, so they can be cancelled. Nil if the request was not sent. */
+- (nullable NSURLSessionTask *)registerDeviceWithParams:(NSDictionary *)params
+                                                success:(_Nullable FWTRequestManagerSuccessBlock)success
+                                                failure:(_Nullable FWTRequestManagerFailureBlock)failure;
+- (nullable NSURLSessionTask *)updateDeviceWithTokenId:(NSNumber *)tokenId
+                                                params:(NSDictionary *)params
+                                               success:(_Nullable FWTRequestManagerSuccessBlock)success
+                                               failure:(_Nullable FWTRequestManagerFailureBlock)failure;
+- (nullable NSURLSessionTask *)unregisterTokenId:(NSNumber *)tokenId
+                                         success:(FWTRequestManagerSuccessBlock)success
+                                         failure:(FWTRequestManagerFailureBlock)failure;
 - (void)markNotificationAsOpenedWithId:(NSString *)notificationId
                          deviceTokenId:(NSString *)deviceTokenId
                                   user:(NSString *)user
@@ -41,6 +70,10 @@ typedef void(^FWTRequestManagerFailureBlock)(NSInteger responseCode, NSError * e
                            deviceTokenId:(NSString *)deviceTokenId
                                  success:(FWTRequestManagerSuccessBlock)success
                                  failure:(FWTRequestManagerFailureBlock)failure;
+- (void)markNotificationsAsReceivedWithIds:(NSArray<NSString *> *)notificationIds
+                             deviceTokenId:(NSString *)deviceTokenId
+                                   success:(FWTRequestManagerSuccessBlock)success
+                                   failure:(FWTRequestManagerFailureBlock)failure;
 
 @end
 
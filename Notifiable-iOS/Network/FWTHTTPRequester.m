@@ -8,13 +8,16 @@
 #import "FWTNotifiableAuthenticator.h"
 #import "NSError+FWTNotifiable.h"
 #import "FWTHTTPSessionManager.h"
+#import "NSData+FWTNotifiable.h"
 
 typedef void(^FWTAFNetworkingSuccessBlock)(id  _Nullable responseObject);
 typedef void(^FWTAFNetworkingFailureBlock)(NSInteger responseCode, NSError * _Nonnull error);
 
 NSString * const FWTDeviceTokensPath = @"api/v1/device_tokens";
+NSString * const FWTDeviceTokenPath = @"api/v1/device_tokens/%@";
 NSString * const FWTNotificationOpenPath = @"api/v1/notifications/%@/opened";
 NSString * const FWTNotificationReceivedPath = @"api/v1/notifications/%@/delivered";
+NSString * const FWTNotificationBulkReceivedPath = @"api/v1/notifications/delivered";
 NSString * const FWTListDevicesPath = @"api/v1/device_tokens.json";
 
 @interface FWTHTTPRequester ()
@@ -35,57 +38,126 @@ NSString * const FWTListDevicesPath = @"api/v1/device_tokens.json";
         self->_baseUrl = baseUrl;
         self->_authenticator = authenticator;
         self->_urlSession = session;
+        self->_timeoutInterval = 30;
     }
     return self;
 }
 
 - (FWTHTTPSessionManager *)httpSessionManager
 {
-    if (!self->_httpSessionManager) {
-        self->_httpSessionManager = [[FWTHTTPSessionManager alloc] initWithBaseURL:self.baseUrl
-                                                                           session:self.urlSession];
+    @synchronized(self) {
+        if (!self->_httpSessionManager) {
+            self->_httpSessionManager = [[FWTHTTPSessionManager alloc] initWithBaseURL:self.baseUrl
+                                                                               session:self.urlSession];
+            self->_httpSessionManager.authenticator = self.authenticator;
+            self->_httpSessionManager.circuitBreaker = self.circuitBreaker;
+            self->_httpSessionManager.timeoutInterval = self.timeoutInterval;
+            self->_httpSessionManager.connectTimeout = self.connectTimeout;
+            self->_httpSessionManager.compressionThreshold = self.compressionThreshold;
+            self->_httpSessionManager.logger = self.logger;
+            self->_httpSessionManager.metrics = self.metrics;
+            self->_httpSessionManager.backgroundTransport = self.backgroundTransport;
+        }
+        return self->_httpSessionManager;
+    }
+}
+
+- (void)setTimeoutInterval:(NSTimeInterval)timeoutInterval
+{
+    @synchronized(self) {
+        self->_timeoutInterval = timeoutInterval;
+        self->_httpSessionManager.timeoutInterval = timeoutInterval;
+    }
+}
+
+- (void)setConnectTimeout:(NSTimeInterval)connectTimeout
+{
+    @synchronized(self) {
+        self->_connectTimeout = connectTimeout;
+        self->_httpSessionManager.connectTimeout = connectTimeout;
+    }
+}
+
+- (void)setCompressionThreshold:(NSUInteger)compressionThreshold
+{
+    @synchronized(self) {
+        self->_compressionThreshold = compressionThreshold;
+        self->_httpSessionManager.compressionThreshold = compressionThreshold;
+    }
+}
+
+- (void)setLogger:(id<FWTNotifiableLogger>)logger
+{
+    @synchronized(self) {
+        self->_logger = logger;
+        self->_httpSessionManager.logger = logger;
+    }
+}
+
+- (void)setMetrics:(id<FWTNotifiableMetrics>)metrics
+{
+    @synchronized(self) {
+        self->_metrics = metrics;
+        self->_httpSessionManager.metrics = metrics;
+    }
+}
+
+- (void)setBackgroundTransport:(id<FWTHTTPTransport>)backgroundTransport
+{
+    @synchronized(self) {
+        self->_backgroundTransport = backgroundTransport;
+        self->_httpSessionManager.backgroundTransport = backgroundTransport;
+    }
+}
+
+- (void)setCircuitBreaker:(FWTCircuitBreaker *)circuitBreaker
+{
+    @synchronized(self) {
+        self->_circuitBreaker = circuitBreaker;
+        self->_httpSessionManager.circuitBreaker = circuitBreaker;
     }
-    return self->_httpSessionManager;
 }
 
-- (void)registerDeviceWithParams:(NSDictionary *)params
-                         success:(FWTRequestManagerSuccessBlock)success
-                         failure:(FWTRequestManagerFailureBlock)failure
+- (NSURLSessionTask *)registerDeviceWithParams:(NSDictionary *)params
+                                       success:(FWTRequestManagerSuccessBlock)success
+                                       failure:(FWTRequestManagerFailureBlock)failure
 {
     NSAssert(params != nil, @"You need provide, at least, the device token that will be registered");
     
-    [self _updateAuthenticationForPath:FWTDeviceTokensPath httpMethod:@"POST"];
-    
-    [self.httpSessionManager POST:FWTDeviceTokensPath
-                       parameters:params
-                          success:[self _defaultSuccessHandler:success]
-                          failure:[self _defaultFailureHandler:failure success:success]];
+    return [self.httpSessionManager sendRequestWithMethod:FWTHTTPMethodPOST
+                                             pathTemplate:FWTDeviceTokensPath
+                                               identifier:nil
+                                               parameters:params
+                                               background:NO
+                                                  success:[self _defaultSuccessHandler:success]
+                                                  failure:[self _defaultFailureHandler:failure success:success]];
 }
 
-- (void)updateDeviceWithTokenId:(NSNumber *)tokenId
-                         params:(NSDictionary *)params
-                        success:(FWTRequestManagerSuccessBlock)success
-                        failure:(FWTRequestManagerFailureBlock)failure
+- (NSURLSessionTask *)updateDeviceWithTokenId:(NSNumber *)tokenId
+                                       params:(NSDictionary *)params
+                                      success:(FWTRequestManagerSuccessBlock)success
+                                      failure:(FWTRequestManagerFailureBlock)failure
 {
     NSAssert(params != nil, @"You need provide some information to update");
     NSAssert(tokenId != nil, @"Device token id missing");
     
-    NSString *path = [NSString stringWithFormat:@"%@/%@",FWTDeviceTokensPath, [tokenId stringValue]];
-    [self _updateAuthenticationForPath:path httpMethod:@"PATCH"];
-    [self.httpSessionManager PATCH:path
-                        parameters:params
-                           success:[self _defaultSuccessHandler:success]
-                           failure:[self _defaultFailureHandler:failure success:success]];
+    return [self.httpSessionManager sendRequestWithMethod:FWTHTTPMethodPATCH
+                                             pathTemplate:FWTDeviceTokenPath
+                                               identifier:[tokenId stringValue]
+                                               parameters:params
+                                               background:NO
+                                                  success:[self _defaultSuccessHandler:success]
+                                                  failure:[self _defaultFailureHandler:failure success:success]];
 }
 
-- (void)unregisterTokenId:(NSNumber *)tokenId
-                  success:(FWTRequestManagerSuccessBlock)success
-                  failure:(FWTRequestManagerFailureBlock)failure
+- (NSURLSessionTask *)unregisterTokenId:(NSNumber *)tokenId
+                                success:(FWTRequestManagerSuccessBlock)success
+                                failure:(FWTRequestManagerFailureBlock)failure
 {
-    [self updateDeviceWithTokenId:tokenId
-                           params:@{@"device_token": @{@"user_alias": @""}}
-                          success:success
-                          failure:failure];
+    return [self updateDeviceWithTokenId:tokenId
+                                  params:@{@"device_token": @{@"user_alias": @""}}
+                                 success:success
+                                 failure:failure];
 }
 
 - (void)markNotificationAsOpenedWithId:(NSString *)notificationId
@@ -105,13 +177,14 @@ NSString * const FWTListDevicesPath = @"api/v1/device_tokens.json";
         return;
     }
     
-    NSString *path = [NSString stringWithFormat:FWTNotificationOpenPath, notificationId];
-    [self _updateAuthenticationForPath:path httpMethod:@"POST"];
-    [self.httpSessionManager POST:path
-                      parameters:@{@"device_token_id": deviceTokenId,
-                                   @"user": @{@"alias":user}}
-                         success:[self _defaultSuccessHandler:success]
-                         failure:[self _defaultFailureHandler:failure success:success]];
+    [self.httpSessionManager sendRequestWithMethod:FWTHTTPMethodPOST
+                                      pathTemplate:FWTNotificationOpenPath
+                                        identifier:notificationId
+                                        parameters:@{@"device_token_id": deviceTokenId,
+                                                     @"user": @{@"alias":user}}
+                                        background:YES
+                                           success:[self _defaultSuccessHandler:success]
+                                           failure:[self _defaultFailureHandler:failure success:success]];
 }
 
 - (void)markNotificationAsReceivedWithId:(NSString *)notificationId
@@ -128,12 +201,80 @@ NSString * const FWTListDevicesPath = @"api/v1/device_tokens.json";
         return;
     }
     
-    NSString *path = [NSString stringWithFormat:FWTNotificationReceivedPath, notificationId];
-    [self _updateAuthenticationForPath:path httpMethod:@"POST"];
-    [self.httpSessionManager POST:path
-                       parameters:@{@"device_token_id": deviceTokenId}
-                          success:[self _defaultSuccessHandler:success]
-                          failure:[self _defaultFailureHandler:failure success:success]];
+    [self.httpSessionManager sendRequestWithMethod:FWTHTTPMethodPOST
+                                      pathTemplate:FWTNotificationReceivedPath
+                                        identifier:notificationId
+                                        parameters:@{@"device_token_id": deviceTokenId}
+                                        background:YES
+                                           success:[self _defaultSuccessHandler:success]
+                                           failure:[self _defaultFailureHandler:failure success:success]];
+}
+
+- (void)markNotificationsAsReceivedWithIds:(NSArray<NSString *> *)notificationIds
+                             deviceTokenId:(NSString *)deviceTokenId
+                                   success:(FWTRequestManagerSuccessBlock)success
+                                   failure:(FWTRequestManagerFailureBlock)failure
+{
+    NSAssert(deviceTokenId != nil, @"Device token id missing");
+    NSAssert(notificationIds.count > 0, @"Notification ids missing");
+    
+    if (notificationIds.count == 0 || deviceTokenId.length == 0) {
+        if (failure) {
+            failure(404,[NSError fwt_invalidOperationErrorWithUnderlyingError:nil]);
+        }
+        return;
+    }
+    
+    [self.httpSessionManager sendRequestWithMethod:FWTHTTPMethodPOST
+                                      pathTemplate:FWTNotificationBulkReceivedPath
+                                        identifier:nil
+                                        parameters:@{@"device_token_id": deviceTokenId,
+                                                     @"notification_ids": notificationIds}
+                                        background:YES
+                                           success:[self _defaultSuccessHandler:success]
+                                           failure:[self _defaultFailureHandler:failure success:success]];
+}
+
++ (NSArray<NSNumber *> *)notificationIdsOfReceiptRequest:(NSURLRequest *)request
+                                                     body:(NSData *)body
+                                                   opened:(BOOL *)opened
+{
+    NSString *path = request.URL.path;
+    if ([path hasSuffix:FWTNotificationBulkReceivedPath]) {
+        // Large bulk bodies are sent compressed
+        if ([[request valueForHTTPHeaderField:@"Content-Encoding"] isEqualToString:@"gzip"]) {
+            body = [body fwt_gzipDecompressedData];
+        }
+        NSDictionary *parameters = body.length > 0 ? [NSJSONSerialization JSONObjectWithData:body options:0 error:nil] : nil;
+        NSArray *identifiers = [parameters isKindOfClass:[NSDictionary class]] ? parameters[@"notification_ids"] : nil;
+        if (![identifiers isKindOfClass:[NSArray class]]) {
+            return nil;
+        }
+        NSMutableArray<NSNumber *> *notificationIds = [[NSMutableArray alloc] initWithCapacity:identifiers.count];
+        for (id identifier in identifiers) {
+            if ([identifier respondsToSelector:@selector(longLongValue)]) {
+                [notificationIds addObject:@([identifier longLongValue])];
+            }
+        }
+        if (opened) {
+            *opened = NO;
+        }
+        return notificationIds;
+    }
+
+    NSArray<NSString *> *components = path.pathComponents;
+    if (components.count < 3 || ![components[components.count - 3] isEqualToString:@"notifications"]) {
+        return nil;
+    }
+    NSString *action = components.lastObject;
+    BOOL isOpened = [action isEqualToString:[FWTNotificationOpenPath lastPathComponent]];
+    if (!isOpened && ![action isEqualToString:[FWTNotificationReceivedPath lastPathComponent]]) {
+        return nil;
+    }
+    if (opened) {
+        *opened = isOpened;
+    }
+    return @[@([components[components.count - 2] longLongValue])];
 }
 
 #pragma mark - Private Methods
@@ -161,18 +302,6 @@ NSString * const FWTListDevicesPath = @"api/v1/device_tokens.json";
     };
 }
 
-- (void) _updateAuthenticationForPath:(NSString *)path
-                           httpMethod:(NSString *)httpMethod
-{
-    NSDictionary *headers = [self.authenticator authHeadersForPath:path
-                                                        httpMethod:httpMethod
-                                                        andHeaders:self.httpSessionManager.HTTPRequestHeaders];
-    for (NSString *header in headers.keyEnumerator) {
-        [self.httpSessionManager setValue:headers[header]
-                       forHTTPHeaderField:header];
-    }
-}
-
 - (NSError *) _errorForStatusCode:(NSInteger)statusCode withUnderlyingError:(NSError *)underlyingError
 {
     switch (statusCode) {
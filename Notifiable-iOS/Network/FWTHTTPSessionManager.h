@@ -7,43 +7,102 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "FWTHTTPTransport.h"
+#import "FWTHTTPMethod.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class FWTCircuitBreaker;
+@class FWTNotifiableAuthenticator;
+@class FWTRequestTemplate;
+@protocol FWTNotifiableLogger;
+@protocol FWTNotifiableMetrics;
+
+/** Key of the error user info with the number of seconds requested by the server `Retry-After` header */
+extern NSString * const FWTHTTPRetryAfterErrorKey;
+
 typedef void(^FWTHTTPSessionManagerSuccessBlock)(id _Nullable responseObject);
 typedef void(^FWTHTTPSessionManagerFailureBlock)(NSInteger responseCode, NSError *error);
 
+/**
+ Builds, signs and sends the requests to the server. Each request method returns the task sending
+ the request, so it can be cancelled, or nil if the request was not sent or can't be cancelled.
+ */
 @interface FWTHTTPSessionManager : NSObject
 
 @property (nonatomic, strong, readonly) NSDictionary<NSString *, NSString *> *HTTPRequestHeaders;
+/** When set, requests fail without being sent while the breaker is open */
+@property (nonatomic, strong, nullable) FWTCircuitBreaker *circuitBreaker;
+/** Signs each request once it is serialized, so the signature can cover the body */
+@property (nonatomic, strong, nullable) FWTNotifiableAuthenticator *authenticator;
+/** Timeout of each request */
+@property (nonatomic, assign) NSTimeInterval timeoutInterval;
+/** Max time waiting for the response headers, applied by the default transport. Zero disables it. */
+@property (nonatomic, assign) NSTimeInterval connectTimeout;
+/** Minimum body size sent gzip compressed. Zero disables the compression. */
+@property (nonatomic, assign) NSUInteger compressionThreshold;
+@property (nonatomic, strong, nullable) id<FWTNotifiableLogger> logger;
+/** Receives the latency, size, serialization and signing time of each request */
+@property (nonatomic, strong, nullable) id<FWTNotifiableMetrics> metrics;
+/** Sends the requests. Default: data tasks of the session given on the init */
+@property (nonatomic, strong) id<FWTHTTPTransport> transport;
+/** Transport used by backgroundPOST. When nil, those requests use the default transport */
+@property (nonatomic, strong, nullable) id<FWTHTTPTransport> backgroundTransport;
 
 - (instancetype) init NS_UNAVAILABLE;
 - (instancetype) initWithBaseURL:(NSURL *)baseUrl session:(NSURLSession *)session NS_DESIGNATED_INITIALIZER;
 
-- (void)GET:(NSString *)URLString
- parameters:(nullable NSDictionary<NSString *, NSString *> *)parameters
-    success:(nullable FWTHTTPSessionManagerSuccessBlock)success
-    failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
-
-- (void)PATCH:(NSString *)URLString
-   parameters:(nullable NSDictionary *)parameters
-      success:(nullable FWTHTTPSessionManagerSuccessBlock)success
-      failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
-
-- (void)DELETE:(NSString *)URLString
-    parameters:(nullable NSDictionary *)parameters
-       success:(nullable FWTHTTPSessionManagerSuccessBlock)success
-       failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
-
-- (void)PUT:(NSString *)URLString
- parameters:(nullable NSDictionary *)parameters
-    success:(nullable FWTHTTPSessionManagerSuccessBlock)success
-    failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
-
-- (void)POST:(NSString *)URLString
-  parameters:(nullable NSDictionary *)parameters
-     success:(nullable FWTHTTPSessionManagerSuccessBlock)success
-     failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
+- (nullable NSURLSessionTask *)GET:(NSString *)URLString
+                        parameters:(nullable NSDictionary<NSString *, NSString *> *)parameters
+                           success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                           failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
+
+- (nullable NSURLSessionTask *)PATCH:(NSString *)URLString
+                          parameters:(nullable NSDictionary *)parameters
+                             success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                             failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
+
+- (nullable NSURLSessionTask *)DELETE:(NSString *)URLString
+                           parameters:(nullable NSDictionary *)parameters
+                              success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                              failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
+
+- (nullable NSURLSessionTask *)PUT:(NSString *)URLString
+                        parameters:(nullable NSDictionary *)parameters
+                           success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                           failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
+
+- (nullable NSURLSessionTask *)POST:(NSString *)URLString
+                         parameters:(nullable NSDictionary *)parameters
+                            success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                            failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
+
+/**
+ Same as POST, but sent through the background transport, if any, so the request can complete
+ while the app is suspended.
+ */
+- (nullable NSURLSessionTask *)backgroundPOST:(NSString *)URLString
+                                   parameters:(nullable NSDictionary *)parameters
+                                      success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                                      failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
+
+/**
+ Sends a request to an endpoint of the API, such as `api/v1/notifications/%@/opened`, with the
+ identifier in the placeholder of the path. The endpoint is compiled on the first request and
+ reused by the following ones, so each request only substitutes the identifier.
+ 
+ @param background If YES, the request is sent through the background transport, if any.
+ */
+- (nullable NSURLSessionTask *)sendRequestWithMethod:(FWTHTTPMethod)method
+                                        pathTemplate:(NSString *)pathTemplate
+                                          identifier:(nullable NSString *)identifier
+                                          parameters:(nullable NSDictionary *)parameters
+                                          background:(BOOL)background
+                                             success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                                             failure:(nullable FWTHTTPSessionManagerFailureBlock)failure;
+
+/** Template of the endpoint for the base URL, compiled once and cached */
+- (FWTRequestTemplate *)requestTemplateForPath:(NSString *)pathTemplate method:(FWTHTTPMethod)method;
 
 - (void) setValue:(NSString *)value forHTTPHeaderField:(NSString *)field;
 
@@ -8,6 +8,11 @@
 
 #import "FWTHTTPSessionManager.h"
 #import "FWTHTTPRequestSerializer.h"
+#import "FWTRequestTemplate.h"
+#import "FWTCircuitBreaker.h"
+#import "FWTNotifiableAuthenticator.h"
+#import "NSError+FWTNotifiable.h"
+#import "FWTNotifiableMetrics.h"
 
 #ifdef DEBUG
 #define NSLog(...) NSLog(__VA_ARGS__)
@@ -16,14 +21,21 @@
 #endif
 
 NSString *const FWTHTTPSessionManagerIdentifier = @"com.futureworkshops.notifiable.FWTHTTPSessionManager";
+NSString *const FWTHTTPRetryAfterErrorKey = @"FWTHTTPRetryAfterErrorKey";
+
+static NSTimeInterval FWTSecondsSince(uint64_t start)
+{
+    return (clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start) / (double)NSEC_PER_SEC;
+}
 
 @interface FWTHTTPSessionManager ()
 
 @property (nonatomic, strong) NSOperationQueue *sessionOperationQueue;
 @property (nonatomic, strong) FWTHTTPRequestSerializer *requestSerializer;
 @property (nonatomic, strong) NSURL *baseURL;
-@property (nonatomic, strong) NSMutableDictionary<NSString *, NSString *> *mutableHeaders;
+@property (nonatomic, copy) NSDictionary<NSString *, NSString *> *defaultHeaders;
 @property (nonatomic, strong) NSURLSession *urlSession;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSMutableDictionary<NSString *, FWTRequestTemplate *> *> *requestTemplates;
 
 @end
 
@@ -35,6 +47,12 @@ NSString *const FWTHTTPSessionManagerIdentifier = @"com.futureworkshops.notifiab
     if (self) {
         self->_baseURL = baseUrl;
         self->_urlSession = session;
+        self->_transport = [[FWTURLSessionTransport alloc] initWithSession:session];
+        self->_timeoutInterval = 30;
+        self->_defaultHeaders = @{};
+        self->_requestTemplates = [[NSMutableDictionary alloc] init];
+        self->_requestSerializer = [[FWTHTTPRequestSerializer alloc] init];
+        self->_requestSerializer.timeoutInterval = self->_timeoutInterval;
     }
     return self;
 }
@@ -52,119 +70,233 @@ NSString *const FWTHTTPSessionManagerIdentifier = @"com.futureworkshops.notifiab
     return self->_sessionOperationQueue;
 }
 
-- (NSMutableDictionary *)mutableHeaders
+- (NSDictionary<NSString *,NSString *> *)HTTPRequestHeaders
 {
-    if (self->_mutableHeaders == nil) {
-        self->_mutableHeaders = [[NSMutableDictionary alloc] init];
+    @synchronized(self) {
+        return self.defaultHeaders;
     }
-    return self->_mutableHeaders;
 }
 
-- (NSDictionary<NSString *,NSString *> *)HTTPRequestHeaders
+- (void)setTimeoutInterval:(NSTimeInterval)timeoutInterval
 {
-    return [NSDictionary dictionaryWithDictionary: self.mutableHeaders];
+    self->_timeoutInterval = timeoutInterval;
+    self->_requestSerializer.timeoutInterval = timeoutInterval;
 }
 
-- (FWTHTTPRequestSerializer *)requestSerializer
+- (void)setConnectTimeout:(NSTimeInterval)connectTimeout
 {
-    if (self->_requestSerializer == nil) {
-        self->_requestSerializer = [[FWTHTTPRequestSerializer alloc] init];
+    self->_connectTimeout = connectTimeout;
+    if ([self->_transport isKindOfClass:[FWTURLSessionTransport class]]) {
+        ((FWTURLSessionTransport *)self->_transport).connectTimeout = connectTimeout;
     }
-    return self->_requestSerializer;
+}
+
+- (void)setCompressionThreshold:(NSUInteger)compressionThreshold
+{
+    self->_compressionThreshold = compressionThreshold;
+    self->_requestSerializer.compressionThreshold = compressionThreshold;
+}
+
+- (void)setLogger:(id<FWTNotifiableLogger>)logger
+{
+    self->_logger = logger;
+    self->_requestSerializer.logger = logger;
 }
 
 #pragma mark - Public methods
 
-- (void)GET:(NSString *)URLString
- parameters:(nullable NSDictionary<NSString *, NSString *> *)parameters
-    success:(nullable FWTHTTPSessionManagerSuccessBlock)success
-    failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
+- (NSURLSessionTask *)GET:(NSString *)URLString
+               parameters:(nullable NSDictionary<NSString *, NSString *> *)parameters
+                  success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                  failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
+{
+    return [self _buildTaskWithTemplate:[self _requestTemplateForURLString:URLString method:FWTHTTPMethodGET]
+                                   path:URLString
+                             parameters:parameters
+                              transport:self.transport
+                                success:success
+                             andFailure:failure];
+}
+
+- (NSURLSessionTask *)PATCH:(NSString *)URLString
+                 parameters:(nullable NSDictionary *)parameters
+                    success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                    failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
 {
-    [self _buildTaskForPath:URLString
-                     method:FWTHTTPMethodGET
-                 parameters:parameters
-                    success:success
-                 andFailure:failure];
+    return [self _buildTaskWithTemplate:[self _requestTemplateForURLString:URLString method:FWTHTTPMethodPATCH]
+                                   path:URLString
+                             parameters:parameters
+                              transport:self.transport
+                                success:success
+                             andFailure:failure];
 }
 
-- (void)PATCH:(NSString *)URLString
-   parameters:(nullable NSDictionary *)parameters
-      success:(nullable FWTHTTPSessionManagerSuccessBlock)success
-      failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
+- (NSURLSessionTask *)DELETE:(NSString *)URLString
+                  parameters:(nullable NSDictionary *)parameters
+                     success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                     failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
 {
-    [self _buildTaskForPath:URLString
-                     method:FWTHTTPMethodPATCH
-                 parameters:parameters
-                    success:success
-                 andFailure:failure];
+    return [self _buildTaskWithTemplate:[self _requestTemplateForURLString:URLString method:FWTHTTPMethodDELETE]
+                                   path:URLString
+                             parameters:parameters
+                              transport:self.transport
+                                success:success
+                             andFailure:failure];
 }
 
-- (void)DELETE:(NSString *)URLString
-    parameters:(nullable NSDictionary *)parameters
-       success:(nullable FWTHTTPSessionManagerSuccessBlock)success
-       failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
+- (NSURLSessionTask *)PUT:(NSString *)URLString
+               parameters:(nullable NSDictionary *)parameters
+                  success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                  failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
 {
-    [self _buildTaskForPath:URLString
-                     method:FWTHTTPMethodDELETE
-                 parameters:parameters
-                    success:success
-                 andFailure:failure];
+    return [self _buildTaskWithTemplate:[self _requestTemplateForURLString:URLString method:FWTHTTPMethodPUT]
+                                   path:URLString
+                             parameters:parameters
+                              transport:self.transport
+                                success:success
+                             andFailure:failure];
 }
 
-- (void)PUT:(NSString *)URLString
- parameters:(nullable NSDictionary *)parameters
-    success:(nullable FWTHTTPSessionManagerSuccessBlock)success
-    failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
+- (NSURLSessionTask *)POST:(NSString *)URLString
+                parameters:(nullable NSDictionary *)parameters
+                   success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                   failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
 {
-    [self _buildTaskForPath:URLString
-                     method:FWTHTTPMethodPUT
-                 parameters:parameters
-                    success:success
-                 andFailure:failure];
+    return [self _buildTaskWithTemplate:[self _requestTemplateForURLString:URLString method:FWTHTTPMethodPOST]
+                                   path:URLString
+                             parameters:parameters
+                              transport:self.transport
+                                success:success
+                             andFailure:failure];
 }
 
-- (void)POST:(NSString *)URLString
-  parameters:(nullable NSDictionary *)parameters
-     success:(nullable FWTHTTPSessionManagerSuccessBlock)success
-     failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
+- (NSURLSessionTask *)backgroundPOST:(NSString *)URLString
+                          parameters:(nullable NSDictionary *)parameters
+                             success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                             failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
 {
-    [self _buildTaskForPath:URLString
-                     method:FWTHTTPMethodPOST
-                 parameters:parameters
-                    success:success
-                 andFailure:failure];
+    return [self _buildTaskWithTemplate:[self _requestTemplateForURLString:URLString method:FWTHTTPMethodPOST]
+                                   path:URLString
+                             parameters:parameters
+                              transport:self.backgroundTransport ?: self.transport
+                                success:success
+                             andFailure:failure];
+}
+
+- (NSURLSessionTask *)sendRequestWithMethod:(FWTHTTPMethod)method
+                               pathTemplate:(NSString *)pathTemplate
+                                 identifier:(nullable NSString *)identifier
+                                 parameters:(nullable NSDictionary *)parameters
+                                 background:(BOOL)background
+                                    success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                                    failure:(nullable FWTHTTPSessionManagerFailureBlock)failure
+{
+    FWTRequestTemplate *requestTemplate = [self requestTemplateForPath:pathTemplate method:method];
+    id<FWTHTTPTransport> transport = background ? (self.backgroundTransport ?: self.transport) : self.transport;
+    return [self _buildTaskWithTemplate:requestTemplate
+                                   path:[requestTemplate pathWithIdentifier:identifier]
+                             parameters:parameters
+                              transport:transport
+                                success:success
+                             andFailure:failure];
+}
+
+- (FWTRequestTemplate *)requestTemplateForPath:(NSString *)pathTemplate method:(FWTHTTPMethod)method
+{
+    @synchronized(self) {
+        NSMutableDictionary<NSString *, FWTRequestTemplate *> *templates = self.requestTemplates[@(method)];
+        if (templates == nil) {
+            templates = [[NSMutableDictionary alloc] init];
+            self.requestTemplates[@(method)] = templates;
+        }
+        FWTRequestTemplate *requestTemplate = templates[pathTemplate];
+        if (requestTemplate == nil) {
+            requestTemplate = [[FWTRequestTemplate alloc] initWithBaseURL:self.baseURL
+                                                             pathTemplate:pathTemplate
+                                                                   method:method];
+            templates[pathTemplate] = requestTemplate;
+        }
+        return requestTemplate;
+    }
 }
 
 - (void) setValue:(NSString *)value forHTTPHeaderField:(NSString *)field
 {
-    [self.mutableHeaders setValue:value
-                           forKey:field];
+    // The headers are replaced, never mutated, so a request always sees a consistent set
+    @synchronized(self) {
+        NSMutableDictionary *headers = [self.defaultHeaders mutableCopy];
+        [headers setValue:value forKey:field];
+        self.defaultHeaders = headers;
+    }
 }
 
 #pragma mark - Private methods
 
-- (void) _buildTaskForPath:(NSString *)path
-                    method:(FWTHTTPMethod)method
-                parameters:(NSDictionary*)parameters
-                   success:(nullable FWTHTTPSessionManagerSuccessBlock)success
-                andFailure:(nullable FWTHTTPSessionManagerFailureBlock)failure
+// Paths given to the HTTP verbs are already concrete, so their templates are not cached
+- (FWTRequestTemplate *) _requestTemplateForURLString:(NSString *)URLString method:(FWTHTTPMethod)method
 {
-    NSURLRequest *request = [self _buildRequestWithPath:path method:method andParameters:parameters];
+    return [[FWTRequestTemplate alloc] initWithBaseURL:self.baseURL pathTemplate:URLString method:method];
+}
+
+- (NSURLSessionTask *) _buildTaskWithTemplate:(FWTRequestTemplate *)requestTemplate
+                                         path:(NSString *)path
+                                   parameters:(NSDictionary*)parameters
+                                    transport:(id<FWTHTTPTransport>)transport
+                                      success:(nullable FWTHTTPSessionManagerSuccessBlock)success
+                                   andFailure:(nullable FWTHTTPSessionManagerFailureBlock)failure
+{
+    FWTCircuitBreaker *circuitBreaker = self.circuitBreaker;
+    if (circuitBreaker && ![circuitBreaker allowRequest]) {
+        NSLog(@"Request to %@ not sent, the server is unavailable", path);
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            if (failure) {
+                failure(503, [NSError fwt_serviceUnavailableError:nil]);
+            }
+        });
+        return nil;
+    }
+    
+    id<FWTNotifiableMetrics> metrics = self.metrics;
+    FWTNotifiableMetricsEndpoint endpoint = requestTemplate.endpoint;
+    NSURLRequest *request = [self _buildRequestWithTemplate:requestTemplate path:path parameters:parameters];
+    NSUInteger bytesSent = request.HTTPBody.length;
+    uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
 
     __weak typeof(self) weakSelf = self;
-    NSURLSessionDataTask *task = [self.urlSession dataTaskWithRequest:request completionHandler:^(NSData * _Nullable data, NSURLResponse * _Nullable response, NSError * _Nullable error) {
+    return [transport sendRequest:request completionHandler:^(NSData * _Nullable data, NSURLResponse * _Nullable response, NSError * _Nullable error) {
         NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *)response;
+        if (error.code != NSURLErrorCancelled) {
+            BOOL success = error == nil && httpResponse.statusCode >= 200 && httpResponse.statusCode < 300;
+            [metrics recordResponseFromEndpoint:endpoint
+                                        latency:FWTSecondsSince(start)
+                                      bytesSent:bytesSent
+                                  bytesReceived:data.length
+                                        success:success];
+        }
         
         if (error) {
+            if (error.code != NSURLErrorCancelled) {
+                [circuitBreaker recordFailureWithStatusCode:httpResponse.statusCode];
+            }
             failure(httpResponse.statusCode, error);
             NSLog(@"Response with Error: %@", error);
             return;
         }
         
+        if (httpResponse.statusCode >= 500) {
+            [circuitBreaker recordFailureWithStatusCode:httpResponse.statusCode];
+        } else {
+            [circuitBreaker recordSuccess];
+        }
+        
         id responseData = [weakSelf _jsonFromData:data];
         
         if (httpResponse && (httpResponse.statusCode < 200 || httpResponse.statusCode >= 300)) {
-            NSDictionary *userInfo = [responseData isKindOfClass:[NSDictionary class]] ? (NSDictionary *)responseData : @{};
+            NSMutableDictionary *userInfo = [responseData isKindOfClass:[NSDictionary class]] ? [(NSDictionary *)responseData mutableCopy] : [[NSMutableDictionary alloc] init];
+            NSNumber *retryAfter = [weakSelf _retryAfterFromResponse:httpResponse];
+            if (retryAfter) {
+                userInfo[FWTHTTPRetryAfterErrorKey] = retryAfter;
+            }
             NSError *error = [NSError errorWithDomain:@"FWTNotifiableError" code:httpResponse.statusCode userInfo:userInfo];
             NSLog(@"Response with Error: %@", error);
             failure(404, error);
@@ -173,19 +305,64 @@ NSString *const FWTHTTPSessionManagerIdentifier = @"com.futureworkshops.notifiab
         
         success(responseData);
     }];
-    [task resume];
 }
 
-- (NSURLRequest *) _buildRequestWithPath:(NSString *)path
-                                  method:(FWTHTTPMethod)method
-                           andParameters:(NSDictionary *)paramters
+// Each request gets its own copy of the headers and is signed here, so requests
+// can be built concurrently from any thread
+- (NSURLRequest *) _buildRequestWithTemplate:(FWTRequestTemplate *)requestTemplate
+                                        path:(NSString *)path
+                                  parameters:(NSDictionary *)paramters
+{
+    id<FWTNotifiableMetrics> metrics = self.metrics;
+    FWTNotifiableMetricsEndpoint endpoint = requestTemplate.endpoint;
+    uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    NSURLRequest *request = [self.requestSerializer buildRequestWithTemplate:requestTemplate
+                                                                         URL:[requestTemplate URLWithPath:path]
+                                                                  parameters:paramters
+                                                                  andHeaders:self.HTTPRequestHeaders];
+    [metrics recordSerializationTime:FWTSecondsSince(start) ofEndpoint:endpoint];
+    
+    FWTNotifiableAuthenticator *authenticator = self.authenticator;
+    if (authenticator == nil) {
+        return request;
+    }
+    
+    start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    NSDictionary *authHeaders = [authenticator authHeadersForPath:path
+                                                       httpMethod:requestTemplate.HTTPMethod
+                                                          headers:request.allHTTPHeaderFields
+                                                             body:request.HTTPBody];
+    NSMutableURLRequest *signedRequest = [request mutableCopy];
+    for (NSString *header in authHeaders.keyEnumerator) {
+        [signedRequest setValue:authHeaders[header] forHTTPHeaderField:header];
+    }
+    [metrics recordSigningTime:FWTSecondsSince(start) ofEndpoint:endpoint];
+    return [signedRequest copy];
+}
+
+- (NSNumber *) _retryAfterFromResponse:(NSHTTPURLResponse *)response
 {
-    NSURL* url = [self.baseURL URLByAppendingPathComponent:path];
-    NSURLRequest *request = [self.requestSerializer buildRequestWithBaseURL:url
-                                                                 parameters:paramters
-                                                                 andHeaders:self.HTTPRequestHeaders
-                                                                  forMethod:method];
-    return request;
+    NSString *value = response.allHeaderFields[@"Retry-After"];
+    if (![value isKindOfClass:[NSString class]] || value.length == 0) {
+        return nil;
+    }
+    
+    NSScanner *scanner = [NSScanner scannerWithString:value];
+    NSInteger seconds = 0;
+    if ([scanner scanInteger:&seconds] && scanner.isAtEnd) {
+        return @(MAX(seconds, 0));
+    }
+    
+    // Retry-After can also be an HTTP date
+    NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+    formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+    formatter.timeZone = [NSTimeZone timeZoneWithAbbreviation:@"GMT"];
+    formatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss zzz";
+    NSDate *date = [formatter dateFromString:value];
+    if (date == nil) {
+        return nil;
+    }
+    return @(MAX([date timeIntervalSinceNow], 0));
 }
 
 - (id) _jsonFromData:(NSData *)data
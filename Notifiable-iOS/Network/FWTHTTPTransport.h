@@ -0,0 +1,44 @@
+//
+//  FWTHTTPTransport.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void (^FWTHTTPTransportCompletionHandler)(NSData * _Nullable data, NSURLResponse * _Nullable response, NSError * _Nullable error);
+
+/**
+ Sends the requests built, and signed, by FWTHTTPSessionManager.
+ */
+@protocol FWTHTTPTransport <NSObject>
+
+/**
+ Send a request.
+ 
+ @return Task sending the request, used to cancel it. Nil if the request can't be cancelled.
+ */
+- (nullable NSURLSessionTask *)sendRequest:(NSURLRequest *)request completionHandler:(FWTHTTPTransportCompletionHandler)handler;
+
+@end
+
+/**
+ Transport that sends each request on a data task of a URL session.
+ */
+@interface FWTURLSessionTransport : NSObject <FWTHTTPTransport>
+
+@property (nonatomic, strong, readonly) NSURLSession *session;
+/**
+ Max time that a request waits for the response headers. When it runs out, the task is cancelled and
+ fails with NSURLErrorTimedOut. Zero (default) leaves the request to the timeout of the URL request.
+ */
+@property (atomic, assign) NSTimeInterval connectTimeout;
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithSession:(NSURLSession *)session NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
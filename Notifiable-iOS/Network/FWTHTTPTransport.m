@@ -0,0 +1,61 @@
+//
+//  FWTHTTPTransport.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTHTTPTransport.h"
+
+@interface FWTURLSessionConnectBudget : NSObject
+
+@property (atomic, assign) BOOL expired;
+
+@end
+
+@implementation FWTURLSessionConnectBudget
+@end
+
+@implementation FWTURLSessionTransport
+
+- (instancetype)initWithSession:(NSURLSession *)session
+{
+    self = [super init];
+    if (self) {
+        self->_session = session;
+    }
+    return self;
+}
+
+- (NSURLSessionTask *)sendRequest:(NSURLRequest *)request completionHandler:(FWTHTTPTransportCompletionHandler)handler
+{
+    NSTimeInterval connectTimeout = self.connectTimeout;
+    if (connectTimeout <= 0) {
+        NSURLSessionDataTask *task = [self.session dataTaskWithRequest:request completionHandler:handler];
+        [task resume];
+        return task;
+    }
+
+    FWTURLSessionConnectBudget *budget = [[FWTURLSessionConnectBudget alloc] init];
+    NSURLSessionDataTask *task = [self.session dataTaskWithRequest:request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+        if (budget.expired && [error.domain isEqualToString:NSURLErrorDomain] && error.code == NSURLErrorCancelled) {
+            error = [NSError errorWithDomain:NSURLErrorDomain
+                                        code:NSURLErrorTimedOut
+                                    userInfo:@{NSLocalizedDescriptionKey: @"The server didn't respond before the connect timeout"}];
+        }
+        handler(data, response, error);
+    }];
+    [task resume];
+
+    // The budget stops counting once the response headers arrive, the body is bound by the request timeout
+    __weak NSURLSessionDataTask *weakTask = task;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(connectTimeout * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        NSURLSessionDataTask *runningTask = weakTask;
+        if (runningTask.state == NSURLSessionTaskStateRunning && runningTask.response == nil) {
+            budget.expired = YES;
+            [runningTask cancel];
+        }
+    });
+    return task;
+}
+
+@end
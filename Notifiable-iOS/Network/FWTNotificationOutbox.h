@@ -0,0 +1,126 @@
+//
+//  FWTNotificationOutbox.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FWTRequesterManager;
+
+typedef NS_ENUM(NSUInteger, FWTNotificationOutboxEventType) {
+    FWTNotificationOutboxEventTypeReceived = 0,
+    FWTNotificationOutboxEventTypeOpened,
+};
+
+typedef void (^FWTNotificationOutboxDrainHandler)(NSUInteger sentEvents, NSUInteger pendingEvents);
+
+@interface FWTNotificationOutboxEvent : NSObject
+
+@property (nonatomic, assign, readonly) unsigned long long sequence;
+@property (nonatomic, assign, readonly) FWTNotificationOutboxEventType type;
+@property (nonatomic, copy, readonly) NSNumber *notificationId;
+@property (nonatomic, copy, readonly) NSNumber *deviceTokenId;
+@property (nonatomic, copy, readonly, nullable) NSString *user;
+@property (nonatomic, copy, readonly) NSDate *createdAt;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+/**
+ Append-only, crash-safe journal of notification events that still need to reach the server.
+
+ Each event is appended (and synced) to a file in the app group container before the
+ request is sent, and acknowledged once the server accepts it. Events that were not
+ acknowledged, because the request failed or the process was killed, are sent again in FIFO order
+ the next time the outbox is drained. The file is shared between the app and its extensions.
+
+ An event being sent holds a lease recorded in the journal, so the app and its extensions don't
+ send it at the same time. The lease expires after sendLeaseDuration, so the events of a process
+ killed while sending are sent again later. An event can still be sent twice if its request
+ outlives the lease, so the server must handle duplicated receipts and opens idempotently.
+ */
+@interface FWTNotificationOutbox : NSObject
+
+/** Location of the journal file */
+@property (nonatomic, strong, readonly) NSURL *fileURL;
+/** Max number of pending events. Once reached, the oldest events are discarded. */
+@property (nonatomic, assign) NSUInteger maxEvents;
+/** Number of journal records that triggers a compaction of the file. */
+@property (nonatomic, assign) NSUInteger compactionThreshold;
+/** Time an event being sent is reserved for the process sending it. Default: 300 seconds */
+@property (nonatomic, assign) NSTimeInterval sendLeaseDuration;
+
+/**
+ Shared outbox for a specific group.
+
+ @param groupId Group used to share the data with extensions. If nil, the app container is used.
+ */
++ (instancetype)outboxWithGroupId:(NSString * _Nullable)groupId;
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithFileURL:(NSURL *)fileURL NS_DESIGNATED_INITIALIZER;
+
+- (FWTNotificationOutboxEvent * _Nullable)enqueueEventOfType:(FWTNotificationOutboxEventType)type
+                                              notificationId:(NSNumber *)notificationId
+                                               deviceTokenId:(NSNumber *)deviceTokenId
+                                                        user:(NSString * _Nullable)user;
+
+/**
+ Enqueue an event already leased to this process, so it can be sent right away. The journal is
+ written on the outbox queue, without blocking the caller.
+
+ @param handler Called on a background queue with the event, or nil if it wasn't enqueued.
+ */
+- (void)enqueueLeasedEventOfType:(FWTNotificationOutboxEventType)type
+                  notificationId:(NSNumber *)notificationId
+                   deviceTokenId:(NSNumber *)deviceTokenId
+                            user:(NSString * _Nullable)user
+               completionHandler:(void (^)(FWTNotificationOutboxEvent * _Nullable event))handler;
+
+/** Mark the event as delivered, so it is not sent again. */
+- (void)acknowledgeEvent:(FWTNotificationOutboxEvent *)event;
+
+/**
+ Acknowledge the pending events of a type for the given notifications. Used when the events were
+ delivered outside of the outbox, e.g. by a background upload that finished after a relaunch.
+
+ @return Number of events acknowledged.
+ */
+- (NSUInteger)acknowledgeEventsOfType:(FWTNotificationOutboxEventType)type
+                      notificationIds:(NSArray<NSNumber *> *)notificationIds;
+
+/**
+ Lease the event to this process while it is sent, so no drain of any process sends it twice.
+
+ @return NO if another caller holds a lease of the event, so it must not be sent.
+ */
+- (BOOL)beginSendingEvent:(FWTNotificationOutboxEvent *)event;
+/** Release the lease of an event being sent, without acknowledging it. */
+- (void)endSendingEvent:(FWTNotificationOutboxEvent *)event;
+
+/** Events not acknowledged yet, in FIFO order. */
+- (NSArray<FWTNotificationOutboxEvent *> *)pendingEvents;
+
+/** Rewrite the journal keeping only the pending events. */
+- (void)compact;
+
+/** Remove all the events. */
+- (void)clear;
+
+/**
+ Send the pending events, one at a time, in FIFO order. The drain stops at the first failure,
+ so the order is kept on the next attempt.
+
+ @param requesterManager Manager used to perform the requests.
+ @param handler          Called once the drain finishes.
+ */
+- (void)drainWithRequesterManager:(FWTRequesterManager *)requesterManager
+                completionHandler:(_Nullable FWTNotificationOutboxDrainHandler)handler;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,702 @@
+//
+//  FWTNotificationOutbox.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTNotificationOutbox.h"
+#import "FWTRequesterManager.h"
+#import "NSFileManager+FWTNotifiable.h"
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+NSString * const FWTNotificationOutboxFileName = @"outbox.journal";
+NSString * const FWTNotificationOutboxQueue = @"com.futureworkshops.notifiable.FWTNotificationOutbox";
+
+NSString * const FWTOutboxOperationKey      = @"op";
+NSString * const FWTOutboxSequenceKey       = @"seq";
+NSString * const FWTOutboxTypeKey           = @"type";
+NSString * const FWTOutboxNotificationKey   = @"n_id";
+NSString * const FWTOutboxDeviceTokenKey    = @"device";
+NSString * const FWTOutboxUserKey           = @"user";
+NSString * const FWTOutboxTimestampKey      = @"ts";
+NSString * const FWTOutboxLeaseExpiryKey    = @"until";
+
+NSString * const FWTOutboxAddOperation      = @"add";
+NSString * const FWTOutboxAckOperation      = @"ack";
+NSString * const FWTOutboxSequenceOperation = @"seq";
+NSString * const FWTOutboxLeaseOperation    = @"lease";
+
+static NSMutableDictionary<NSString *, FWTNotificationOutbox *> *sharedOutboxes;
+
+/** Identifies a version of the journal file. Appends change its size and compactions replace it. */
+typedef struct {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    struct timespec modification;
+} FWTOutboxFileIdentity;
+
+static FWTOutboxFileIdentity FWTOutboxFileIdentityForPath(NSString *path)
+{
+    FWTOutboxFileIdentity identity;
+    memset(&identity, 0, sizeof(identity));
+    struct stat info;
+    if (stat([path fileSystemRepresentation], &info) == 0) {
+        identity.device = info.st_dev;
+        identity.inode = info.st_ino;
+        identity.size = info.st_size;
+        identity.modification = info.st_mtimespec;
+    }
+    return identity;
+}
+
+static BOOL FWTOutboxFileIdentityEqual(FWTOutboxFileIdentity lhs, FWTOutboxFileIdentity rhs)
+{
+    return lhs.device == rhs.device &&
+           lhs.inode == rhs.inode &&
+           lhs.size == rhs.size &&
+           lhs.modification.tv_sec == rhs.modification.tv_sec &&
+           lhs.modification.tv_nsec == rhs.modification.tv_nsec;
+}
+
+@interface FWTNotificationOutboxEvent ()
+
+- (instancetype)initWithSequence:(unsigned long long)sequence
+                            type:(FWTNotificationOutboxEventType)type
+                  notificationId:(NSNumber *)notificationId
+                   deviceTokenId:(NSNumber *)deviceTokenId
+                            user:(NSString * _Nullable)user
+                       createdAt:(NSDate *)createdAt NS_DESIGNATED_INITIALIZER;
+
++ (nullable instancetype)eventWithJournalRecord:(NSDictionary *)record;
+- (NSDictionary *)journalRecord;
+
+@end
+
+@implementation FWTNotificationOutboxEvent
+
+- (instancetype)initWithSequence:(unsigned long long)sequence
+                            type:(FWTNotificationOutboxEventType)type
+                  notificationId:(NSNumber *)notificationId
+                   deviceTokenId:(NSNumber *)deviceTokenId
+                            user:(NSString *)user
+                       createdAt:(NSDate *)createdAt
+{
+    self = [super init];
+    if (self) {
+        self->_sequence = sequence;
+        self->_type = type;
+        self->_notificationId = [notificationId copy];
+        self->_deviceTokenId = [deviceTokenId copy];
+        self->_user = [user copy];
+        self->_createdAt = [createdAt copy];
+    }
+    return self;
+}
+
++ (instancetype)eventWithJournalRecord:(NSDictionary *)record
+{
+    NSNumber *sequence = record[FWTOutboxSequenceKey];
+    NSNumber *type = record[FWTOutboxTypeKey];
+    NSNumber *notificationId = record[FWTOutboxNotificationKey];
+    NSNumber *deviceTokenId = record[FWTOutboxDeviceTokenKey];
+    NSString *user = record[FWTOutboxUserKey];
+    NSNumber *timestamp = record[FWTOutboxTimestampKey];
+
+    if (![sequence isKindOfClass:[NSNumber class]] ||
+        ![notificationId isKindOfClass:[NSNumber class]] ||
+        ![deviceTokenId isKindOfClass:[NSNumber class]]) {
+        return nil;
+    }
+
+    return [[FWTNotificationOutboxEvent alloc] initWithSequence:[sequence unsignedLongLongValue]
+                                                           type:[type unsignedIntegerValue]
+                                                 notificationId:notificationId
+                                                  deviceTokenId:deviceTokenId
+                                                           user:[user isKindOfClass:[NSString class]] ? user : nil
+                                                      createdAt:[NSDate dateWithTimeIntervalSince1970:[timestamp doubleValue]]];
+}
+
+- (NSDictionary *)journalRecord
+{
+    NSMutableDictionary *record = [@{FWTOutboxOperationKey: FWTOutboxAddOperation,
+                                     FWTOutboxSequenceKey: @(self.sequence),
+                                     FWTOutboxTypeKey: @(self.type),
+                                     FWTOutboxNotificationKey: self.notificationId,
+                                     FWTOutboxDeviceTokenKey: self.deviceTokenId,
+                                     FWTOutboxTimestampKey: @([self.createdAt timeIntervalSince1970])} mutableCopy];
+    if (self.user) {
+        record[FWTOutboxUserKey] = self.user;
+    }
+    return [record copy];
+}
+
+@end
+
+@interface FWTNotificationOutboxJournal : NSObject
+
+@property (nonatomic, strong) NSMutableArray<FWTNotificationOutboxEvent *> *pendingEvents;
+/** Expiry of the leases of the events being sent, by any process. Keyed by sequence. */
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSNumber *> *leases;
+@property (nonatomic, assign) unsigned long long lastSequence;
+@property (nonatomic, assign) NSUInteger recordCount;
+@property (nonatomic, assign) BOOL needsRepair;
+
+- (BOOL)isEventLeased:(FWTNotificationOutboxEvent *)event;
+
+@end
+
+@implementation FWTNotificationOutboxJournal
+
+- (BOOL)isEventLeased:(FWTNotificationOutboxEvent *)event
+{
+    return [self.leases[@(event.sequence)] doubleValue] > [[NSDate date] timeIntervalSince1970];
+}
+
+@end
+
+@interface FWTNotificationOutbox ()
+
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, assign) BOOL draining;
+
+// Parsed content of the file, only accessed on the queue under the file lock
+@property (nonatomic, strong, nullable) FWTNotificationOutboxJournal *journal;
+@property (nonatomic, assign) FWTOutboxFileIdentity journalIdentity;
+
+@end
+
+@implementation FWTNotificationOutbox
+
++ (instancetype)outboxWithGroupId:(NSString *)groupId
+{
+    NSURL *directory = [[NSFileManager defaultManager] fwt_notifiableDirectoryWithGroupId:groupId];
+    NSURL *fileURL = [directory URLByAppendingPathComponent:FWTNotificationOutboxFileName];
+
+    @synchronized(self) {
+        if (sharedOutboxes == nil) {
+            sharedOutboxes = [[NSMutableDictionary alloc] init];
+        }
+        FWTNotificationOutbox *outbox = sharedOutboxes[fileURL.path];
+        if (outbox == nil) {
+            outbox = [[FWTNotificationOutbox alloc] initWithFileURL:fileURL];
+            sharedOutboxes[fileURL.path] = outbox;
+        }
+        return outbox;
+    }
+}
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL
+{
+    self = [super init];
+    if (self) {
+        self->_fileURL = fileURL;
+        self->_maxEvents = 500;
+        self->_compactionThreshold = 256;
+        self->_sendLeaseDuration = 300;
+        self->_queue = dispatch_queue_create([FWTNotificationOutboxQueue UTF8String], DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+
+#pragma mark - Public methods
+
+- (FWTNotificationOutboxEvent *)enqueueEventOfType:(FWTNotificationOutboxEventType)type
+                                    notificationId:(NSNumber *)notificationId
+                                     deviceTokenId:(NSNumber *)deviceTokenId
+                                              user:(NSString *)user
+{
+    NSAssert(notificationId != nil, @"Notification id missing");
+    NSAssert(deviceTokenId != nil, @"Device token id missing");
+
+    if (notificationId == nil || deviceTokenId == nil) {
+        return nil;
+    }
+
+    __block FWTNotificationOutboxEvent *event = nil;
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            event = [self _appendEventOfType:type
+                              notificationId:notificationId
+                               deviceTokenId:deviceTokenId
+                                        user:user
+                                      leased:NO];
+        }];
+    });
+    return event;
+}
+
+- (void)enqueueLeasedEventOfType:(FWTNotificationOutboxEventType)type
+                  notificationId:(NSNumber *)notificationId
+                   deviceTokenId:(NSNumber *)deviceTokenId
+                            user:(NSString *)user
+               completionHandler:(void (^)(FWTNotificationOutboxEvent * _Nullable))handler
+{
+    NSAssert(notificationId != nil, @"Notification id missing");
+    NSAssert(deviceTokenId != nil, @"Device token id missing");
+
+    dispatch_async(self.queue, ^{
+        __block FWTNotificationOutboxEvent *event = nil;
+        if (notificationId != nil && deviceTokenId != nil) {
+            [self _performWithFileLock:^{
+                event = [self _appendEventOfType:type
+                                  notificationId:notificationId
+                                   deviceTokenId:deviceTokenId
+                                            user:user
+                                          leased:YES];
+            }];
+        }
+        // Called off the outbox queue, so the handler can use the outbox
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            handler(event);
+        });
+    });
+}
+
+- (void)acknowledgeEvent:(FWTNotificationOutboxEvent *)event
+{
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            FWTNotificationOutboxJournal *journal = [self _loadJournal];
+            [journal.leases removeObjectForKey:@(event.sequence)];
+            NSUInteger index = [journal.pendingEvents indexOfObjectPassingTest:^BOOL(FWTNotificationOutboxEvent * _Nonnull pendingEvent, NSUInteger idx, BOOL * _Nonnull stop) {
+                return pendingEvent.sequence == event.sequence;
+            }];
+            if (index != NSNotFound) {
+                [journal.pendingEvents removeObjectAtIndex:index];
+            }
+            [self _appendRecords:@[[self _ackRecordForSequence:event.sequence]] toJournal:journal];
+        }];
+    });
+}
+
+- (NSUInteger)acknowledgeEventsOfType:(FWTNotificationOutboxEventType)type
+                      notificationIds:(NSArray<NSNumber *> *)notificationIds
+{
+    NSSet<NSNumber *> *identifiers = [NSSet setWithArray:notificationIds];
+    __block NSUInteger acknowledged = 0;
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            FWTNotificationOutboxJournal *journal = [self _loadJournal];
+            NSMutableArray<NSDictionary *> *records = [[NSMutableArray alloc] init];
+            NSMutableIndexSet *indexes = [[NSMutableIndexSet alloc] init];
+            [journal.pendingEvents enumerateObjectsUsingBlock:^(FWTNotificationOutboxEvent * _Nonnull event, NSUInteger idx, BOOL * _Nonnull stop) {
+                if (event.type != type || ![identifiers containsObject:event.notificationId]) {
+                    return;
+                }
+                [journal.leases removeObjectForKey:@(event.sequence)];
+                [records addObject:[self _ackRecordForSequence:event.sequence]];
+                [indexes addIndex:idx];
+            }];
+            if (records.count > 0) {
+                [journal.pendingEvents removeObjectsAtIndexes:indexes];
+                [self _appendRecords:records toJournal:journal];
+            }
+            acknowledged = records.count;
+        }];
+    });
+    return acknowledged;
+}
+
+- (BOOL)beginSendingEvent:(FWTNotificationOutboxEvent *)event
+{
+    __block BOOL leased = NO;
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            FWTNotificationOutboxJournal *journal = [self _loadJournal];
+            if ([journal isEventLeased:event]) {
+                return;
+            }
+            NSTimeInterval expiry = [[NSDate date] timeIntervalSince1970] + MAX(self.sendLeaseDuration, 0);
+            journal.leases[@(event.sequence)] = @(expiry);
+            [self _appendRecords:@[[self _leaseRecordForSequence:event.sequence expiry:expiry]] toJournal:journal];
+            leased = YES;
+        }];
+    });
+    return leased;
+}
+
+- (void)endSendingEvent:(FWTNotificationOutboxEvent *)event
+{
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            FWTNotificationOutboxJournal *journal = [self _loadJournal];
+            if (journal.leases[@(event.sequence)] == nil) {
+                return;
+            }
+            [journal.leases removeObjectForKey:@(event.sequence)];
+            [self _appendRecords:@[[self _leaseRecordForSequence:event.sequence expiry:0]] toJournal:journal];
+        }];
+    });
+}
+
+- (NSArray<FWTNotificationOutboxEvent *> *)pendingEvents
+{
+    __block NSArray<FWTNotificationOutboxEvent *> *events = nil;
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            events = [[self _loadJournal].pendingEvents copy];
+        }];
+    });
+    return events;
+}
+
+- (void)compact
+{
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            [self _rewriteJournal:[self _loadJournal]];
+        }];
+    });
+}
+
+- (void)clear
+{
+    dispatch_sync(self.queue, ^{
+        [self _performWithFileLock:^{
+            [[NSFileManager defaultManager] removeItemAtURL:self.fileURL error:nil];
+            self.journal = nil;
+        }];
+    });
+}
+
+- (void)drainWithRequesterManager:(FWTRequesterManager *)requesterManager
+                completionHandler:(FWTNotificationOutboxDrainHandler)handler
+{
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        @synchronized(self) {
+            if (self.draining) {
+                if (handler) {
+                    handler(0, [self pendingEvents].count);
+                }
+                return;
+            }
+            self.draining = YES;
+        }
+
+        __block NSArray<FWTNotificationOutboxEvent *> *events = nil;
+        dispatch_sync(self.queue, ^{
+            [self _performWithFileLock:^{
+                FWTNotificationOutboxJournal *journal = [self _loadJournal];
+                [self _compactJournalIfNeeded:journal];
+                NSPredicate *notSending = [NSPredicate predicateWithBlock:^BOOL(FWTNotificationOutboxEvent *event, NSDictionary *bindings) {
+                    return ![journal isEventLeased:event];
+                }];
+                events = [journal.pendingEvents filteredArrayUsingPredicate:notSending];
+            }];
+        });
+
+        [self _sendEvents:events
+                  atIndex:0
+              sentEvents:0
+         requesterManager:requesterManager
+        completionHandler:handler];
+    });
+}
+
+#pragma mark - Journal
+
+// Must be called on the queue, holding the file lock. A leased event is appended together with its
+// lease, so no drain can see it before the lease.
+- (FWTNotificationOutboxEvent *)_appendEventOfType:(FWTNotificationOutboxEventType)type
+                                    notificationId:(NSNumber *)notificationId
+                                     deviceTokenId:(NSNumber *)deviceTokenId
+                                              user:(NSString *)user
+                                            leased:(BOOL)leased
+{
+    FWTNotificationOutboxJournal *journal = [self _loadJournal];
+    if (journal.needsRepair) {
+        [self _rewriteJournal:journal];
+    }
+
+    NSMutableArray<NSDictionary *> *records = [[NSMutableArray alloc] init];
+    NSUInteger maxEvents = MAX(self.maxEvents, 1);
+    while (journal.pendingEvents.count >= maxEvents) {
+        FWTNotificationOutboxEvent *oldest = journal.pendingEvents.firstObject;
+        [records addObject:[self _ackRecordForSequence:oldest.sequence]];
+        [journal.leases removeObjectForKey:@(oldest.sequence)];
+        [journal.pendingEvents removeObjectAtIndex:0];
+    }
+
+    FWTNotificationOutboxEvent *event = [[FWTNotificationOutboxEvent alloc] initWithSequence:journal.lastSequence + 1
+                                                                                         type:type
+                                                                               notificationId:notificationId
+                                                                                deviceTokenId:deviceTokenId
+                                                                                         user:user
+                                                                                    createdAt:[NSDate date]];
+    [records addObject:[event journalRecord]];
+    [journal.pendingEvents addObject:event];
+    journal.lastSequence = event.sequence;
+    if (leased) {
+        NSTimeInterval expiry = [[NSDate date] timeIntervalSince1970] + MAX(self.sendLeaseDuration, 0);
+        journal.leases[@(event.sequence)] = @(expiry);
+        [records addObject:[self _leaseRecordForSequence:event.sequence expiry:expiry]];
+    }
+
+    [self _appendRecords:records toJournal:journal];
+    [self _compactJournalIfNeeded:journal];
+    return event;
+}
+
+#pragma mark - Drain
+
+- (void)_sendEvents:(NSArray<FWTNotificationOutboxEvent *> *)events
+            atIndex:(NSUInteger)index
+        sentEvents:(NSUInteger)sentEvents
+   requesterManager:(FWTRequesterManager *)requesterManager
+  completionHandler:(FWTNotificationOutboxDrainHandler)handler
+{
+    if (index >= events.count) {
+        [self _finishDrainWithSentEvents:sentEvents pendingEvents:0 completionHandler:handler];
+        return;
+    }
+
+    FWTNotificationOutboxEvent *event = events[index];
+    if (![self beginSendingEvent:event]) {
+        // Another process started sending it, the rest of the events wait for it to keep the order
+        [self _finishDrainWithSentEvents:sentEvents pendingEvents:events.count - index completionHandler:handler];
+        return;
+    }
+
+    __weak typeof(self) weakSelf = self;
+    FWTSimpleRequestResponse completion = ^(BOOL success, NSError * _Nullable error) {
+        __strong typeof(weakSelf) sself = weakSelf;
+        if (!success) {
+            [sself endSendingEvent:event];
+            [sself _finishDrainWithSentEvents:sentEvents pendingEvents:events.count - index completionHandler:handler];
+            return;
+        }
+        [sself acknowledgeEvent:event];
+        [sself _sendEvents:events
+                   atIndex:index + 1
+               sentEvents:sentEvents + 1
+          requesterManager:requesterManager
+         completionHandler:handler];
+    };
+
+    switch (event.type) {
+        case FWTNotificationOutboxEventTypeOpened:
+            [requesterManager markNotificationAsOpenedWithId:event.notificationId
+                                               deviceTokenId:event.deviceTokenId
+                                                        user:event.user ?: @""
+                                           completionHandler:completion];
+            break;
+        case FWTNotificationOutboxEventTypeReceived:
+        default:
+            [requesterManager markNotificationAsReceivedWithId:event.notificationId
+                                                 deviceTokenId:event.deviceTokenId
+                                             completionHandler:completion];
+            break;
+    }
+}
+
+- (void)_finishDrainWithSentEvents:(NSUInteger)sentEvents
+                     pendingEvents:(NSUInteger)pendingEvents
+                 completionHandler:(FWTNotificationOutboxDrainHandler)handler
+{
+    @synchronized(self) {
+        self.draining = NO;
+    }
+    if (handler) {
+        handler(sentEvents, pendingEvents);
+    }
+}
+
+#pragma mark - Journal
+
+- (void)_performWithFileLock:(void(^)(void))block
+{
+    NSString *lockPath = [self.fileURL.path stringByAppendingString:@".lock"];
+    int descriptor = open([lockPath fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+    if (descriptor >= 0) {
+        flock(descriptor, LOCK_EX);
+    }
+    block();
+    if (descriptor >= 0) {
+        flock(descriptor, LOCK_UN);
+        close(descriptor);
+    }
+}
+
+// Only parses the file when it changed since the last read, by this process or by an extension.
+// Must be called under the file lock, so the file doesn't change while it is read.
+- (FWTNotificationOutboxJournal *)_loadJournal
+{
+    FWTOutboxFileIdentity identity = FWTOutboxFileIdentityForPath(self.fileURL.path);
+    if (self.journal != nil && FWTOutboxFileIdentityEqual(identity, self.journalIdentity)) {
+        return self.journal;
+    }
+    self.journal = [self _readJournal];
+    self.journalIdentity = identity;
+    return self.journal;
+}
+
+- (FWTNotificationOutboxJournal *)_readJournal
+{
+    FWTNotificationOutboxJournal *journal = [[FWTNotificationOutboxJournal alloc] init];
+    journal.pendingEvents = [[NSMutableArray alloc] init];
+    journal.leases = [[NSMutableDictionary alloc] init];
+
+    NSData *data = [NSData dataWithContentsOfURL:self.fileURL options:NSDataReadingUncached error:nil];
+    if (data.length == 0) {
+        return journal;
+    }
+
+    const char *bytes = data.bytes;
+    // A record without the line terminator was interrupted while being written
+    journal.needsRepair = bytes[data.length - 1] != '\n';
+
+    NSMutableDictionary<NSNumber *, FWTNotificationOutboxEvent *> *events = [[NSMutableDictionary alloc] init];
+    NSUInteger lineStart = 0;
+    for (NSUInteger index = 0; index < data.length; index++) {
+        if (bytes[index] != '\n') {
+            continue;
+        }
+        NSData *line = [data subdataWithRange:NSMakeRange(lineStart, index - lineStart)];
+        lineStart = index + 1;
+
+        NSDictionary *record = line.length > 0 ? [NSJSONSerialization JSONObjectWithData:line options:0 error:nil] : nil;
+        if (![record isKindOfClass:[NSDictionary class]]) {
+            journal.needsRepair = YES;
+            continue;
+        }
+        journal.recordCount += 1;
+
+        NSString *operation = record[FWTOutboxOperationKey];
+        unsigned long long sequence = [record[FWTOutboxSequenceKey] unsignedLongLongValue];
+        journal.lastSequence = MAX(journal.lastSequence, sequence);
+
+        if ([operation isEqualToString:FWTOutboxAddOperation]) {
+            FWTNotificationOutboxEvent *event = [FWTNotificationOutboxEvent eventWithJournalRecord:record];
+            if (event) {
+                events[@(sequence)] = event;
+            }
+        } else if ([operation isEqualToString:FWTOutboxAckOperation]) {
+            [events removeObjectForKey:@(sequence)];
+            [journal.leases removeObjectForKey:@(sequence)];
+        } else if ([operation isEqualToString:FWTOutboxLeaseOperation]) {
+            NSTimeInterval expiry = [record[FWTOutboxLeaseExpiryKey] doubleValue];
+            if (expiry > 0) {
+                journal.leases[@(sequence)] = @(expiry);
+            } else {
+                [journal.leases removeObjectForKey:@(sequence)];
+            }
+        }
+    }
+
+    NSArray<NSNumber *> *sequences = [[events allKeys] sortedArrayUsingSelector:@selector(compare:)];
+    for (NSNumber *sequence in sequences) {
+        [journal.pendingEvents addObject:events[sequence]];
+    }
+    return journal;
+}
+
+- (NSDictionary *)_ackRecordForSequence:(unsigned long long)sequence
+{
+    return @{FWTOutboxOperationKey: FWTOutboxAckOperation,
+             FWTOutboxSequenceKey: @(sequence)};
+}
+
+// A lease with a zero expiry releases the event
+- (NSDictionary *)_leaseRecordForSequence:(unsigned long long)sequence expiry:(NSTimeInterval)expiry
+{
+    return @{FWTOutboxOperationKey: FWTOutboxLeaseOperation,
+             FWTOutboxSequenceKey: @(sequence),
+             FWTOutboxLeaseExpiryKey: @(expiry)};
+}
+
+- (NSData *)_dataForRecords:(NSArray<NSDictionary *> *)records
+{
+    NSMutableData *data = [[NSMutableData alloc] init];
+    for (NSDictionary *record in records) {
+        NSData *line = [NSJSONSerialization dataWithJSONObject:record options:0 error:nil];
+        if (line) {
+            [data appendData:line];
+            [data appendBytes:"\n" length:1];
+        }
+    }
+    return data;
+}
+
+// Appends the records to the file and to the journal loaded from it, so the journal stays cached
+- (void)_appendRecords:(NSArray<NSDictionary *> *)records toJournal:(FWTNotificationOutboxJournal *)journal
+{
+    if ([self _appendRecords:records]) {
+        journal.recordCount += records.count;
+        [self _journalDidChange:journal];
+    } else {
+        // The file may hold part of the records, it is parsed again on the next read
+        self.journal = nil;
+    }
+}
+
+- (BOOL)_appendRecords:(NSArray<NSDictionary *> *)records
+{
+    NSData *data = [self _dataForRecords:records];
+    int descriptor = open([self.fileURL.path fileSystemRepresentation], O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (descriptor < 0) {
+        return NO;
+    }
+
+    const char *bytes = data.bytes;
+    NSUInteger written = 0;
+    while (written < data.length) {
+        ssize_t result = write(descriptor, bytes + written, data.length - written);
+        if (result <= 0) {
+            break;
+        }
+        written += (NSUInteger)result;
+    }
+    fsync(descriptor);
+    close(descriptor);
+    return written == data.length;
+}
+
+- (void)_journalDidChange:(FWTNotificationOutboxJournal *)journal
+{
+    self.journal = journal;
+    self.journalIdentity = FWTOutboxFileIdentityForPath(self.fileURL.path);
+}
+
+- (void)_compactJournalIfNeeded:(FWTNotificationOutboxJournal *)journal
+{
+    if (journal.recordCount - MIN(journal.recordCount, journal.pendingEvents.count) >= self.compactionThreshold) {
+        [self _rewriteJournal:journal];
+    }
+}
+
+- (void)_rewriteJournal:(FWTNotificationOutboxJournal *)journal
+{
+    // The sequence record keeps the counter growing, even if all the events were acknowledged
+    NSMutableArray<NSDictionary *> *records = [@[@{FWTOutboxOperationKey: FWTOutboxSequenceOperation,
+                                                   FWTOutboxSequenceKey: @(journal.lastSequence)}] mutableCopy];
+    for (FWTNotificationOutboxEvent *event in journal.pendingEvents) {
+        [records addObject:[event journalRecord]];
+    }
+    // Only the leases still held are kept
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+    for (FWTNotificationOutboxEvent *event in journal.pendingEvents) {
+        NSNumber *expiry = journal.leases[@(event.sequence)];
+        if ([expiry doubleValue] > now) {
+            [records addObject:[self _leaseRecordForSequence:event.sequence expiry:[expiry doubleValue]]];
+        } else {
+            [journal.leases removeObjectForKey:@(event.sequence)];
+        }
+    }
+
+    BOOL written = [[self _dataForRecords:records] writeToURL:self.fileURL
+                                                      options:NSDataWritingAtomic | NSDataWritingFileProtectionCompleteUntilFirstUserAuthentication
+                                                        error:nil];
+    if (!written) {
+        self.journal = nil;
+        return;
+    }
+    journal.recordCount = records.count;
+    journal.needsRepair = NO;
+    [self _journalDidChange:journal];
+}
+
+@end
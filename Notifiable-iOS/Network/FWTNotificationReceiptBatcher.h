@@ -0,0 +1,51 @@
+//
+//  FWTNotificationReceiptBatcher.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "FWTRequesterManager.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FWTRequestDeadline;
+
+/**
+ Block used to send a batch of receipts. All the notifications in the batch belong to the same device.
+ The handlers and deadlines arrays are index aligned with the notification ids array. A receipt
+ without a deadline has NSNull in the deadlines array.
+ */
+typedef void (^FWTNotificationReceiptFlushHandler)(NSString *deviceTokenId,
+                                                   NSArray<NSString *> *notificationIds,
+                                                   NSArray<FWTSimpleRequestResponse> *handlers,
+                                                   NSArray *deadlines);
+
+/**
+ Coalesces the delivery receipts received inside a time window into batches,
+ so a burst of notifications costs one request instead of one request per notification.
+ */
+@interface FWTNotificationReceiptBatcher : NSObject
+
+/** Time that the batcher waits for more receipts after the first one of a batch arrives */
+@property (nonatomic, assign, readonly) NSTimeInterval window;
+/** Number of receipts that forces the batch to be sent before the window expires */
+@property (nonatomic, assign, readonly) NSUInteger maxBatchSize;
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithWindow:(NSTimeInterval)window
+                  maxBatchSize:(NSUInteger)maxBatchSize
+                  flushHandler:(FWTNotificationReceiptFlushHandler)flushHandler NS_DESIGNATED_INITIALIZER;
+
+/** @param deadline Time budget of the receipt, kept by the requests sending it. */
+- (void)addNotificationId:(NSString *)notificationId
+            deviceTokenId:(NSString *)deviceTokenId
+                 deadline:(FWTRequestDeadline * _Nullable)deadline
+        completionHandler:(_Nullable FWTSimpleRequestResponse)handler;
+
+/** Send all the pending receipts, without waiting for the window to expire */
+- (void)flush;
+
+@end
+
+NS_ASSUME_NONNULL_END
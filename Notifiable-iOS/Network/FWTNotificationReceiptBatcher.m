@@ -0,0 +1,122 @@
+//
+//  FWTNotificationReceiptBatcher.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTNotificationReceiptBatcher.h"
+
+NSString * const FWTNotificationReceiptBatcherQueue = @"com.futureworkshops.notifiable.FWTNotificationReceiptBatcher";
+
+@interface FWTNotificationReceiptBatch : NSObject
+
+@property (nonatomic, strong) NSMutableArray<NSString *> *notificationIds;
+@property (nonatomic, strong) NSMutableArray<FWTSimpleRequestResponse> *handlers;
+@property (nonatomic, strong) NSMutableArray *deadlines;
+@property (nonatomic, assign) NSUInteger generation;
+
+@end
+
+@implementation FWTNotificationReceiptBatch
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self->_notificationIds = [[NSMutableArray alloc] init];
+        self->_handlers = [[NSMutableArray alloc] init];
+        self->_deadlines = [[NSMutableArray alloc] init];
+    }
+    return self;
+}
+
+@end
+
+@interface FWTNotificationReceiptBatcher ()
+
+@property (nonatomic, copy) FWTNotificationReceiptFlushHandler flushHandler;
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, FWTNotificationReceiptBatch *> *batches;
+@property (nonatomic, assign) NSUInteger generation;
+
+@end
+
+@implementation FWTNotificationReceiptBatcher
+
+- (instancetype)initWithWindow:(NSTimeInterval)window
+                  maxBatchSize:(NSUInteger)maxBatchSize
+                  flushHandler:(FWTNotificationReceiptFlushHandler)flushHandler
+{
+    NSAssert(flushHandler != nil, @"The batcher needs a flush handler");
+    self = [super init];
+    if (self) {
+        self->_window = window;
+        self->_maxBatchSize = MAX(maxBatchSize, 1);
+        self->_flushHandler = flushHandler;
+        self->_batches = [[NSMutableDictionary alloc] init];
+        self->_queue = dispatch_queue_create([FWTNotificationReceiptBatcherQueue UTF8String], DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+
+- (void)addNotificationId:(NSString *)notificationId
+            deviceTokenId:(NSString *)deviceTokenId
+                 deadline:(FWTRequestDeadline *)deadline
+        completionHandler:(FWTSimpleRequestResponse)handler
+{
+    FWTSimpleRequestResponse itemHandler = handler ?: ^(BOOL success, NSError * _Nullable error) {};
+    dispatch_async(self.queue, ^{
+        FWTNotificationReceiptBatch *batch = self.batches[deviceTokenId];
+        if (batch == nil) {
+            batch = [[FWTNotificationReceiptBatch alloc] init];
+            batch.generation = ++self.generation;
+            self.batches[deviceTokenId] = batch;
+            [self _scheduleFlushForDeviceTokenId:deviceTokenId generation:batch.generation];
+        }
+        [batch.notificationIds addObject:notificationId];
+        [batch.handlers addObject:[itemHandler copy]];
+        [batch.deadlines addObject:deadline ?: [NSNull null]];
+
+        if (batch.notificationIds.count >= self.maxBatchSize) {
+            [self _flushBatchForDeviceTokenId:deviceTokenId];
+        }
+    });
+}
+
+- (void)flush
+{
+    dispatch_async(self.queue, ^{
+        for (NSString *deviceTokenId in [self.batches allKeys]) {
+            [self _flushBatchForDeviceTokenId:deviceTokenId];
+        }
+    });
+}
+
+#pragma mark - Private
+
+- (void)_scheduleFlushForDeviceTokenId:(NSString *)deviceTokenId generation:(NSUInteger)generation
+{
+    __weak typeof(self) weakSelf = self;
+    dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.window * NSEC_PER_SEC));
+    dispatch_after(popTime, self.queue, ^{
+        __strong typeof(weakSelf) sself = weakSelf;
+        FWTNotificationReceiptBatch *batch = sself.batches[deviceTokenId];
+        // The batch may already have been sent because it reached the max size
+        if (batch == nil || batch.generation != generation) {
+            return;
+        }
+        [sself _flushBatchForDeviceTokenId:deviceTokenId];
+    });
+}
+
+- (void)_flushBatchForDeviceTokenId:(NSString *)deviceTokenId
+{
+    FWTNotificationReceiptBatch *batch = self.batches[deviceTokenId];
+    if (batch == nil) {
+        return;
+    }
+    [self.batches removeObjectForKey:deviceTokenId];
+    self.flushHandler(deviceTokenId, [batch.notificationIds copy], [batch.handlers copy], [batch.deadlines copy]);
+}
+
+@end
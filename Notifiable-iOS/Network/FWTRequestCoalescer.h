@@ -0,0 +1,88 @@
+//
+//  FWTRequestCoalescer.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FWTNotifiableOperation;
+
+/**
+ Table of the requests in flight, keyed by operation. Identical requests started while one is in
+ flight join it instead of sending their own, and get the same result once it finishes.
+
+ Each request in flight has an operation, shared by the callers that joined it. The request is
+ cancelled once all its callers left it.
+
+ Keys that finished successfully can be remembered for a while, so late duplicates are dropped.
+ */
+@interface FWTRequestCoalescer : NSObject
+
+/** Time that a successful request is remembered by completeRequestWithKey:remember:. Default: 300 seconds */
+@property (nonatomic, assign) NSTimeInterval completedRequestLifetime;
+/** Number of requests in flight */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ Add a handler for the request of a key.
+
+ @param handler Handler of the caller, returned by completeRequestWithKey:remember:.
+ @param key     Key of the operation.
+ @return YES if no request was in flight, so the caller needs to send it. NO if it joined one.
+ */
+- (BOOL)addHandler:(id)handler forKey:(NSString *)key;
+
+/**
+ Add a handler for the request of a key.
+
+ @param handler Handler of the caller, returned by completeRequestWithKey:remember:.
+ @param key     Key of the operation.
+ @param request Set to the operation of the request in flight, shared by all its callers.
+ @return YES if no request was in flight, so the caller needs to send it. NO if it joined one.
+ */
+- (BOOL)addHandler:(id)handler forKey:(NSString *)key request:(FWTNotifiableOperation * _Nullable * _Nullable)request;
+
+/**
+ Remove the handler of a caller that is no longer interested in the request. When the last
+ handler is removed, the request is forgotten and its operation cancelled.
+
+ @return YES if the request was cancelled.
+ */
+- (BOOL)removeHandler:(id)handler forKey:(NSString *)key;
+
+/**
+ Finish the request of a key.
+
+ @param key      Key of the operation.
+ @param remember When YES, the key is remembered during the completedRequestLifetime.
+ @return Handlers of all the callers that joined the request, in order.
+ */
+- (NSArray *)completeRequestWithKey:(NSString *)key remember:(BOOL)remember;
+
+/**
+ Finish a request, only if it is still the one in flight for its key. A request that was cancelled
+ finds no handlers, even if an identical request started after it.
+
+ @param request  Operation of the request, given by addHandler:forKey:request:.
+ @param key      Key of the operation.
+ @param remember When YES, the key is remembered during the completedRequestLifetime.
+ @return Handlers of all the callers that joined the request, in order.
+ */
+- (NSArray *)completeRequest:(FWTNotifiableOperation *)request withKey:(NSString *)key remember:(BOOL)remember;
+
+/** YES if a request of this key finished successfully during the completedRequestLifetime. */
+- (BOOL)didRecentlyCompleteRequestWithKey:(NSString *)key;
+
+/**
+ Key made of the given components. Every value is written with its type and length, so different
+ components never share a key, and dictionaries are written with their entries sorted, so equal
+ dictionaries always produce the same key. Missing components are passed as NSNull.
+ */
++ (NSString *)keyWithComponents:(NSArray *)components;
+
+@end
+
+NS_ASSUME_NONNULL_END
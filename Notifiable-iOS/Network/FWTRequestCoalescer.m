@@ -0,0 +1,197 @@
+//
+//  FWTRequestCoalescer.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTRequestCoalescer.h"
+#import "FWTNotifiableOperation+Private.h"
+
+// Each value is written with a tag of its type and, for the leaf values, the length of its text,
+// so values that describe themselves alike (@1 and @"1", NSNull and @"<null>") or that contain
+// the separators never produce the same key.
+static void FWTAppendKeyValue(NSMutableString *key, NSString *tag, NSString *value)
+{
+    [key appendFormat:@"%@%lu:%@", tag, (unsigned long)value.length, value];
+}
+
+static void FWTAppendKeyComponent(NSMutableString *key, id component)
+{
+    if (component == nil || [component isKindOfClass:[NSNull class]]) {
+        [key appendString:@"0"];
+    } else if ([component isKindOfClass:[NSString class]]) {
+        FWTAppendKeyValue(key, @"s", component);
+    } else if ([component isKindOfClass:[NSNumber class]]) {
+        FWTAppendKeyValue(key, @"n", [component stringValue]);
+    } else if ([component isKindOfClass:[NSDictionary class]]) {
+        NSDictionary *dictionary = component;
+        NSMutableArray<NSString *> *entries = [[NSMutableArray alloc] initWithCapacity:dictionary.count];
+        [dictionary enumerateKeysAndObjectsUsingBlock:^(id dictionaryKey, id value, BOOL * _Nonnull stop) {
+            NSMutableString *entry = [[NSMutableString alloc] init];
+            FWTAppendKeyComponent(entry, dictionaryKey);
+            FWTAppendKeyComponent(entry, value);
+            [entries addObject:entry];
+        }];
+        // The entries are sorted by their encoded key, which is unique in the dictionary
+        [entries sortUsingSelector:@selector(compare:)];
+        [key appendFormat:@"{%lu:", (unsigned long)entries.count];
+        for (NSString *entry in entries) {
+            [key appendString:entry];
+        }
+        [key appendString:@"}"];
+    } else if ([component isKindOfClass:[NSArray class]]) {
+        [key appendFormat:@"[%lu:", (unsigned long)[(NSArray *)component count]];
+        for (id element in (NSArray *)component) {
+            FWTAppendKeyComponent(key, element);
+        }
+        [key appendString:@"]"];
+    } else if ([component isKindOfClass:[NSDate class]]) {
+        FWTAppendKeyValue(key, @"t", [@([(NSDate *)component timeIntervalSinceReferenceDate]) stringValue]);
+    } else {
+        FWTAppendKeyValue(key, @"o", NSStringFromClass([component class]));
+        FWTAppendKeyValue(key, @"", [component description]);
+    }
+}
+
+static NSString *FWTKeyOfComponent(id component)
+{
+    NSMutableString *key = [[NSMutableString alloc] init];
+    FWTAppendKeyComponent(key, component);
+    return key;
+}
+
+@interface FWTRequestCoalescer ()
+
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableArray *> *handlers;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, FWTNotifiableOperation *> *requests;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *completedRequests;
+
+@end
+
+@implementation FWTRequestCoalescer
+
++ (NSString *)keyWithComponents:(NSArray *)components
+{
+    return FWTKeyOfComponent(components);
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self->_completedRequestLifetime = 300;
+        self->_handlers = [[NSMutableDictionary alloc] init];
+        self->_requests = [[NSMutableDictionary alloc] init];
+        self->_completedRequests = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (NSUInteger)count
+{
+    @synchronized(self) {
+        return self.handlers.count;
+    }
+}
+
+- (BOOL)addHandler:(id)handler forKey:(NSString *)key
+{
+    return [self addHandler:handler forKey:key request:NULL];
+}
+
+- (BOOL)addHandler:(id)handler forKey:(NSString *)key request:(FWTNotifiableOperation **)request
+{
+    @synchronized(self) {
+        NSMutableArray *handlers = self.handlers[key];
+        BOOL send = handlers == nil;
+        if (send) {
+            self.handlers[key] = [NSMutableArray arrayWithObject:[handler copy]];
+            self.requests[key] = [[FWTNotifiableOperation alloc] init];
+        } else {
+            [handlers addObject:[handler copy]];
+        }
+        if (request) {
+            *request = self.requests[key];
+        }
+        return send;
+    }
+}
+
+- (BOOL)removeHandler:(id)handler forKey:(NSString *)key
+{
+    @synchronized(self) {
+        NSMutableArray *handlers = self.handlers[key];
+        NSUInteger index = [handlers indexOfObjectIdenticalTo:handler];
+        if (index == NSNotFound) {
+            return NO;
+        }
+        [handlers removeObjectAtIndex:index];
+        if (handlers.count > 0) {
+            return NO;
+        }
+        // Cancelled while locked, so an identical request can't start before this one is cancelled
+        FWTNotifiableOperation *request = self.requests[key];
+        [self.handlers removeObjectForKey:key];
+        [self.requests removeObjectForKey:key];
+        [request cancel];
+        return YES;
+    }
+}
+
+- (NSArray *)completeRequestWithKey:(NSString *)key remember:(BOOL)remember
+{
+    @synchronized(self) {
+        return [self _completeRequestWithKey:key remember:remember];
+    }
+}
+
+- (NSArray *)completeRequest:(FWTNotifiableOperation *)request withKey:(NSString *)key remember:(BOOL)remember
+{
+    @synchronized(self) {
+        if (self.requests[key] != request) {
+            return @[];
+        }
+        return [self _completeRequestWithKey:key remember:remember];
+    }
+}
+
+- (BOOL)didRecentlyCompleteRequestWithKey:(NSString *)key
+{
+    @synchronized(self) {
+        NSNumber *completedAt = self.completedRequests[key];
+        if (completedAt == nil) {
+            return NO;
+        }
+        if ([[NSProcessInfo processInfo] systemUptime] - [completedAt doubleValue] < self.completedRequestLifetime) {
+            return YES;
+        }
+        [self.completedRequests removeObjectForKey:key];
+        return NO;
+    }
+}
+
+#pragma mark - Private methods
+
+- (NSArray *)_completeRequestWithKey:(NSString *)key remember:(BOOL)remember
+{
+    NSArray *handlers = [self.handlers[key] copy] ?: @[];
+    [self.requests[key] finish];
+    [self.handlers removeObjectForKey:key];
+    [self.requests removeObjectForKey:key];
+    if (remember && self.completedRequestLifetime > 0) {
+        NSTimeInterval now = [[NSProcessInfo processInfo] systemUptime];
+        [self _removeCompletedRequestsBefore:now - self.completedRequestLifetime];
+        self.completedRequests[key] = @(now);
+    }
+    return handlers;
+}
+
+- (void)_removeCompletedRequestsBefore:(NSTimeInterval)uptime
+{
+    NSSet<NSString *> *expired = [self.completedRequests keysOfEntriesPassingTest:^BOOL(NSString *key, NSNumber *completedAt, BOOL *stop) {
+        return [completedAt doubleValue] < uptime;
+    }];
+    [self.completedRequests removeObjectsForKeys:[expired allObjects]];
+}
+
+@end
@@ -0,0 +1,60 @@
+//
+//  FWTRequestDeadline.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Total time budget of an operation, shared by all its attempts.
+ 
+ The operation must call `finish` before reporting its result. Only the first call succeeds,
+ so a result that arrives after the deadline expired is discarded.
+ */
+@interface FWTRequestDeadline : NSObject
+
+@property (nonatomic, strong, readonly) NSDate *startDate;
+@property (nonatomic, assign, readonly) NSTimeInterval timeout;
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithTimeout:(NSTimeInterval)timeout NS_DESIGNATED_INITIALIZER;
+
+/**
+ Deadline for an operation.
+ 
+ @param timeout Total time budget. If zero or negative, nil is returned and the operation has no deadline.
+ */
++ (nullable instancetype)deadlineWithTimeout:(NSTimeInterval)timeout;
+
+/** Time left before the deadline expires. Never negative. */
+- (NSTimeInterval)remainingTime;
+- (BOOL)isExpired;
+
+/**
+ Mark the operation as finished.
+ 
+ @return YES on the first call, NO if the operation already finished or expired.
+ */
+- (BOOL)finish;
+
+/**
+ Block called on a background queue when the deadline expires before the operation finishes.
+ */
+- (void)setExpirationHandler:(dispatch_block_t)handler;
+
+/**
+ Add a block called when the deadline expires before the operation finishes, e.g. to cancel the
+ work scheduled for it. It is called right away if the deadline already expired, and never if the
+ operation finished first.
+ */
+- (void)addExpirationHandler:(dispatch_block_t)handler;
+
+/** Expire the deadline before its time, calling the expiration handlers if the operation didn't finish. */
+- (void)expire;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,107 @@
+//
+//  FWTRequestDeadline.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTRequestDeadline.h"
+
+@interface FWTRequestDeadline ()
+
+@property (nonatomic, assign) BOOL finished;
+@property (nonatomic, assign) BOOL expired;
+@property (nonatomic, copy) dispatch_block_t expirationHandler;
+@property (nonatomic, strong) NSMutableArray<dispatch_block_t> *expirationHandlers;
+
+@end
+
+@implementation FWTRequestDeadline
+
++ (instancetype)deadlineWithTimeout:(NSTimeInterval)timeout
+{
+    if (timeout <= 0) {
+        return nil;
+    }
+    return [[FWTRequestDeadline alloc] initWithTimeout:timeout];
+}
+
+- (instancetype)initWithTimeout:(NSTimeInterval)timeout
+{
+    self = [super init];
+    if (self) {
+        self->_startDate = [NSDate date];
+        self->_timeout = timeout;
+        self->_expirationHandlers = [[NSMutableArray alloc] init];
+    }
+    return self;
+}
+
+- (NSTimeInterval)remainingTime
+{
+    return MAX(self.timeout + [self.startDate timeIntervalSinceNow], 0);
+}
+
+- (BOOL)isExpired
+{
+    return [self remainingTime] <= 0;
+}
+
+- (BOOL)finish
+{
+    @synchronized(self) {
+        if (self.finished) {
+            return NO;
+        }
+        self.finished = YES;
+        [self.expirationHandlers removeAllObjects];
+        return YES;
+    }
+}
+
+- (void)setExpirationHandler:(dispatch_block_t)handler
+{
+    self->_expirationHandler = [handler copy];
+    
+    __weak typeof(self) weakSelf = self;
+    dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)([self remainingTime] * NSEC_PER_SEC));
+    dispatch_after(popTime, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        [weakSelf expire];
+    });
+}
+
+- (void)addExpirationHandler:(dispatch_block_t)handler
+{
+    @synchronized(self) {
+        if (!self.finished) {
+            [self.expirationHandlers addObject:[handler copy]];
+            return;
+        }
+        if (!self.expired) {
+            return;
+        }
+    }
+    handler();
+}
+
+- (void)expire
+{
+    NSArray<dispatch_block_t> *handlers;
+    @synchronized(self) {
+        if (self.finished) {
+            return;
+        }
+        self.finished = YES;
+        self.expired = YES;
+        handlers = [self.expirationHandlers copy];
+        [self.expirationHandlers removeAllObjects];
+    }
+    dispatch_block_t handler = self.expirationHandler;
+    if (handler) {
+        handler();
+    }
+    for (dispatch_block_t expirationHandler in handlers) {
+        expirationHandler();
+    }
+}
+
+@end
@@ -0,0 +1,47 @@
+//
+//  FWTRequestTemplate.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "FWTHTTPMethod.h"
+#import "FWTNotifiableMetrics.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Endpoint of the API compiled for a base URL, so building a request to it only substitutes
+ the identifier of the path.
+
+ The path template has at most one `%@` placeholder, such as `api/v1/notifications/%@/opened`.
+ The URL prefix, method name, cache policy, static headers and metrics endpoint are computed
+ when the template is created. Templates are immutable and can be used from any thread.
+ */
+@interface FWTRequestTemplate : NSObject
+
+@property (nonatomic, assign, readonly) FWTHTTPMethod method;
+/** Name of the method, as sent and signed */
+@property (nonatomic, copy, readonly) NSString *HTTPMethod;
+@property (nonatomic, copy, readonly) NSString *pathTemplate;
+@property (nonatomic, assign, readonly) NSURLRequestCachePolicy cachePolicy;
+/** Headers added to the requests when they are not set by the caller */
+@property (nonatomic, copy, readonly) NSDictionary<NSString *, NSString *> *staticHeaders;
+/** Headers added to the requests with a body when they are not set by the caller */
+@property (nonatomic, copy, readonly) NSDictionary<NSString *, NSString *> *bodyHeaders;
+@property (nonatomic, assign, readonly) FWTNotifiableMetricsEndpoint endpoint;
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithBaseURL:(NSURL *)baseURL
+                   pathTemplate:(NSString *)pathTemplate
+                         method:(FWTHTTPMethod)method NS_DESIGNATED_INITIALIZER;
+
+/** Path of the request, without the leading slash, with the identifier in the placeholder */
+- (NSString *)pathWithIdentifier:(nullable NSString *)identifier;
+
+/** URL of the path, the same as appending the path to the base URL */
+- (NSURL *)URLWithPath:(NSString *)path;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,97 @@
+//
+//  FWTRequestTemplate.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTRequestTemplate.h"
+
+NSString * const FWTRequestTemplatePlaceholder = @"%@";
+
+static FWTNotifiableMetricsEndpoint FWTMetricsEndpointOfPath(NSString *path, FWTHTTPMethod method)
+{
+    if ([path hasPrefix:@"api/v1/notifications/"]) {
+        return [path hasSuffix:@"/opened"] ? FWTNotifiableMetricsEndpointNotificationOpened : FWTNotifiableMetricsEndpointNotificationReceived;
+    }
+    if (![path hasPrefix:@"api/v1/device_tokens"]) {
+        return FWTNotifiableMetricsEndpointOther;
+    }
+    switch (method) {
+        case FWTHTTPMethodPOST:
+            return FWTNotifiableMetricsEndpointRegisterDevice;
+        case FWTHTTPMethodPATCH:
+        case FWTHTTPMethodPUT:
+            return FWTNotifiableMetricsEndpointUpdateDevice;
+        case FWTHTTPMethodDELETE:
+            return FWTNotifiableMetricsEndpointUnregisterDevice;
+        case FWTHTTPMethodGET:
+            return FWTNotifiableMetricsEndpointListDevices;
+    }
+    return FWTNotifiableMetricsEndpointOther;
+}
+
+@interface FWTRequestTemplate ()
+
+@property (nonatomic, strong, readonly) NSURL *baseURL;
+@property (nonatomic, copy, readonly) NSString *URLPrefix;
+@property (nonatomic, copy, readonly) NSString *pathPrefix;
+@property (nonatomic, copy, readonly, nullable) NSString *pathSuffix;
+
+@end
+
+@implementation FWTRequestTemplate
+
+- (instancetype)initWithBaseURL:(NSURL *)baseURL
+                   pathTemplate:(NSString *)pathTemplate
+                         method:(FWTHTTPMethod)method
+{
+    self = [super init];
+    if (self) {
+        self->_baseURL = baseURL;
+        self->_pathTemplate = [pathTemplate copy];
+        self->_method = method;
+        self->_HTTPMethod = FWTHTTPMethodString(method);
+        // Only reads can use the cache, the mutating calls always reach the server
+        self->_cachePolicy = method == FWTHTTPMethodGET ? NSURLRequestUseProtocolCachePolicy : NSURLRequestReloadIgnoringLocalCacheData;
+        self->_staticHeaders = @{@"Accept": @"application/json"};
+        self->_bodyHeaders = method == FWTHTTPMethodGET ? @{} : @{@"Content-Type": @"application/json; charset=utf-8"};
+        self->_endpoint = FWTMetricsEndpointOfPath(pathTemplate, method);
+
+        NSRange placeholder = [pathTemplate rangeOfString:FWTRequestTemplatePlaceholder];
+        if (placeholder.location == NSNotFound) {
+            self->_pathPrefix = self->_pathTemplate;
+        } else {
+            self->_pathPrefix = [pathTemplate substringToIndex:placeholder.location];
+            self->_pathSuffix = [pathTemplate substringFromIndex:NSMaxRange(placeholder)];
+        }
+
+        NSString *baseString = baseURL.absoluteString;
+        self->_URLPrefix = [baseString hasSuffix:@"/"] ? baseString : [baseString stringByAppendingString:@"/"];
+    }
+    return self;
+}
+
+- (NSString *)pathWithIdentifier:(NSString *)identifier
+{
+    NSString *pathSuffix = self.pathSuffix;
+    if (pathSuffix == nil) {
+        return self.pathPrefix;
+    }
+
+    NSString *pathPrefix = self.pathPrefix;
+    identifier = identifier ?: @"";
+    NSMutableString *path = [[NSMutableString alloc] initWithCapacity:pathPrefix.length + identifier.length + pathSuffix.length];
+    [path appendString:pathPrefix];
+    [path appendString:identifier];
+    [path appendString:pathSuffix];
+    return path;
+}
+
+- (NSURL *)URLWithPath:(NSString *)path
+{
+    NSURL *url = [NSURL URLWithString:[self.URLPrefix stringByAppendingString:path]];
+    // Paths that are not valid URL strings are percent encoded by the URL API
+    return url ?: [self.baseURL URLByAppendingPathComponent:path];
+}
+
+@end
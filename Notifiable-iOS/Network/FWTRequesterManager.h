@@ -10,7 +10,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 @class FWTHTTPRequester;
 @class FWTNotifiableDevice;
+@class FWTRetryScheduler;
+@class FWTNotifiableOperation;
 @protocol FWTNotifiableLogger;
+@protocol FWTNotifiableMetrics;
 
 typedef void (^FWTSimpleRequestResponse)(BOOL success, NSError * _Nullable error);
 typedef void (^FWTDeviceTokenIdResponse)(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error);
@@ -19,8 +22,41 @@ typedef void (^FWTDeviceListResponse)(NSArray<FWTNotifiableDevice *> *devices, N
 @interface FWTRequesterManager : NSObject
 
 @property (nonatomic, assign) NSInteger retryAttempts;
+/** Base delay of the exponential backoff applied between attempts */
 @property (nonatomic, assign) NSTimeInterval retryDelay;
+/** Max delay between two attempts */
+@property (nonatomic, assign) NSTimeInterval maxRetryDelay;
+/**
+ Max time that a request waits for data from the server, the timeout interval of the URL request.
+ It restarts every time data arrives, so it doesn't bound the total time of a request; operationTimeout
+ does. Default: 15 seconds
+ */
+@property (nonatomic, assign) NSTimeInterval requestIdleTimeout;
+/**
+ Max time that a request waits for the response headers, covering the connection and the server
+ processing. When it runs out the request fails with a timeout and can be retried. Zero disables it.
+ Default: 10 seconds
+ */
+@property (nonatomic, assign) NSTimeInterval connectTimeout;
+/** Total time budget of an operation, including its retries. Zero (default) means no deadline. */
+@property (nonatomic, assign) NSTimeInterval operationTimeout;
+/** Scheduler of the retries, with the number of pending and in-flight retries */
+@property (nonatomic, strong, readonly) FWTRetryScheduler *retryScheduler;
 @property (nonatomic, strong) id<FWTNotifiableLogger> logger;
+/** Receives the measures of the requests and retries. Default: FWTDefaultNotifiableMetrics sharedMetrics */
+@property (nonatomic, strong, nullable) id<FWTNotifiableMetrics> metrics;
+/** Request bodies with at least this number of bytes are sent gzip compressed. Zero (default) disables the compression. */
+@property (nonatomic, assign) NSUInteger requestCompressionThreshold;
+/** Time window used to coalesce delivery receipts into a single request. Zero (default) disables batching. */
+@property (nonatomic, assign) NSTimeInterval receiptBatchWindow;
+/** Max number of delivery receipts sent in a single batch. */
+@property (nonatomic, assign) NSUInteger receiptBatchSize;
+/** Queue where the completion handlers are called. Default: main queue */
+@property (nonatomic, strong) dispatch_queue_t callbackQueue;
+/** Serial queue where the manager handles the responses and schedules the retries */
+@property (nonatomic, strong, readonly) dispatch_queue_t workQueue;
+/** Receipts already delivered for the same notification during this interval are not sent again. Zero disables it. Default: 300 seconds */
+@property (nonatomic, assign) NSTimeInterval receiptDeduplicationInterval;
 
 - (instancetype)init NS_UNAVAILABLE;
 - (instancetype)initWithRequester:(FWTHTTPRequester *)requester;
@@ -28,34 +64,65 @@ typedef void (^FWTDeviceListResponse)(NSArray<FWTNotifiableDevice *> *devices, N
                     retryAttempts:(NSInteger)attempts
                     andRetryDelay:(NSTimeInterval)delay NS_DESIGNATED_INITIALIZER;
 
-- (void)registerDeviceWithUserAlias:(NSString * _Nullable)userAlias
-                              token:(NSData *)token
-                               name:(NSString * _Nullable)name
-                             locale:(NSLocale * _Nullable)locale
-                   customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-                 platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-                  completionHandler:(_Nullable FWTDeviceTokenIdResponse)handler;
-
-- (void)updateDevice:(NSNumber *)deviceTokenId
-       withUserAlias:(NSString * _Nullable)alias
-               token:(NSData * _Nullable)token
-                name:(NSString * _Nullable)name
-              locale:(NSLocale * _Nullable)locale
-    customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-  platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-   completionHandler:(_Nullable FWTDeviceTokenIdResponse)handler;
+/**
+ Register the device on the server.
+ 
+ @return Operation of this caller. Cancelling it calls the handler with a FWTErrorCancelled error,
+ and stops the request and its retries if no other caller is waiting for the same request.
+ */
+- (FWTNotifiableOperation *)registerDeviceWithUserAlias:(NSString * _Nullable)userAlias
+                                                 token:(NSData *)token
+                                                  name:(NSString * _Nullable)name
+                                                locale:(NSLocale * _Nullable)locale
+                                      customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                                    platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                                     completionHandler:(_Nullable FWTDeviceTokenIdResponse)handler;
 
+/** Update the device on the server. The operation is cancelled like the one of registerDeviceWithUserAlias:token:name:locale:customProperties:platformProperties:completionHandler: */
+- (FWTNotifiableOperation *)updateDevice:(NSNumber *)deviceTokenId
+                          withUserAlias:(NSString * _Nullable)alias
+                                  token:(NSData * _Nullable)token
+                                   name:(NSString * _Nullable)name
+                                 locale:(NSLocale * _Nullable)locale
+                       customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                     platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                      completionHandler:(_Nullable FWTDeviceTokenIdResponse)handler;
+
+- (void)markNotificationAsOpenedWithId:(NSNumber *)notificationId
+                         deviceTokenId:(NSNumber *)deviceTokenId
+                                  user:(NSString *)user
+                     completionHandler:(_Nullable FWTSimpleRequestResponse)handler;
+
+- (void)markNotificationAsReceivedWithId:(NSNumber *)notificationId
+                           deviceTokenId:(NSNumber *)deviceTokenId
+                       completionHandler:(_Nullable FWTSimpleRequestResponse)handler;
+
+/**
+ Same as markNotificationAsOpenedWithId:deviceTokenId:user:completionHandler:, with a total time budget.
+ Retries are only scheduled if they can start before the deadline.
+ 
+ @param timeout Total time budget of the operation. Zero means no deadline.
+ */
 - (void)markNotificationAsOpenedWithId:(NSNumber *)notificationId
                          deviceTokenId:(NSNumber *)deviceTokenId
                                   user:(NSString *)user
+                               timeout:(NSTimeInterval)timeout
                      completionHandler:(_Nullable FWTSimpleRequestResponse)handler;
 
+/**
+ Same as markNotificationAsReceivedWithId:deviceTokenId:completionHandler:, with a total time budget.
+ Retries are only scheduled if they can start before the deadline.
+ 
+ @param timeout Total time budget of the operation. Zero means no deadline.
+ */
 - (void)markNotificationAsReceivedWithId:(NSNumber *)notificationId
                            deviceTokenId:(NSNumber *)deviceTokenId
+                                 timeout:(NSTimeInterval)timeout
                        completionHandler:(_Nullable FWTSimpleRequestResponse)handler;
 
-- (void)unregisterTokenId:(NSNumber *)tokenId
-        completionHandler:(_Nullable FWTSimpleRequestResponse)handler;
+/** Remove the device from the server. The operation is cancelled like the one of registerDeviceWithUserAlias:token:name:locale:customProperties:platformProperties:completionHandler: */
+- (FWTNotifiableOperation *)unregisterTokenId:(NSNumber *)tokenId
+                           completionHandler:(_Nullable FWTSimpleRequestResponse)handler;
 
 @end
 
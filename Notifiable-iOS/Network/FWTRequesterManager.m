@@ -8,9 +8,16 @@
 #import "FWTHTTPRequester.h"
 #import "NSError+FWTNotifiable.h"
 #import "FWTDefaultNotifiableLogger.h"
+#import "FWTNotifiableLogging.h"
+#import "FWTDefaultNotifiableMetrics.h"
 #import "NSData+FWTNotifiable.h"
 #import "FWTNotifiableDevice+Parser.h"
 #import "NSLocale+FWTNotifiable.h"
+#import "FWTNotificationReceiptBatcher.h"
+#import "FWTRetryScheduler.h"
+#import "FWTRequestDeadline.h"
+#import "FWTRequestCoalescer.h"
+#import "FWTNotifiableOperation+Private.h"
 
 typedef void (^FWTLoggedErrorHandler)(NSError * _Nullable error);
 typedef void (^FWTLoggedTokenErrorHandler)(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error);
@@ -25,9 +32,22 @@ NSString * const FWTNotifiableCustomPropertiesKey  = @"custom_properties";
 
 NSString * const FWTNotifiableProvider             = @"apns";
 
+NSString * const FWTNotifiableBulkResultsKey       = @"results";
+
+NSString * const FWTRequesterManagerWorkQueue       = @"com.futureworkshops.notifiable.FWTRequesterManager";
+
+NSString * const FWTRegisterOperationKey           = @"register";
+NSString * const FWTUpdateOperationKey             = @"update";
+NSString * const FWTUnregisterOperationKey         = @"unregister";
+NSString * const FWTOpenedOperationKey             = @"opened";
+NSString * const FWTReceivedOperationKey           = @"received";
+
 @interface FWTRequesterManager ()
 
 @property (nonatomic, strong, readonly) FWTHTTPRequester *requester;
+@property (nonatomic, strong) FWTNotificationReceiptBatcher *receiptBatcher;
+@property (nonatomic, strong, readonly) FWTRequestCoalescer *requestCoalescer;
+@property (atomic, assign) BOOL bulkReceiptsUnsupported;
 
 @end
 
@@ -45,20 +65,153 @@ NSString * const FWTNotifiableProvider             = @"apns";
     if (self) {
         self->_requester = requester;
         self->_retryAttempts = attempts;
-        self->_retryDelay = delay;
+        self->_retryScheduler = [[FWTRetryScheduler alloc] initWithBaseDelay:delay maxDelay:MAX(delay * 15, 900)];
         self->_logger = [[FWTDefaultNotifiableLogger alloc] init];
+        self->_requester.logger = self->_logger;
+        self->_metrics = [FWTDefaultNotifiableMetrics sharedMetrics];
+        self->_requester.metrics = self->_metrics;
+        self->_requestIdleTimeout = 15;
+        self->_requester.timeoutInterval = self->_requestIdleTimeout;
+        self->_connectTimeout = 10;
+        self->_requester.connectTimeout = self->_connectTimeout;
+        self->_operationTimeout = 0;
+        self->_receiptBatchWindow = 0;
+        self->_receiptBatchSize = 50;
+        self->_requestCoalescer = [[FWTRequestCoalescer alloc] init];
+        self->_callbackQueue = dispatch_get_main_queue();
+        self->_workQueue = dispatch_queue_create([FWTRequesterManagerWorkQueue UTF8String], DISPATCH_QUEUE_SERIAL);
+        dispatch_set_target_queue(self->_workQueue, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
     }
     return self;
 }
 
-- (void)registerDeviceWithUserAlias:(NSString *)userAlias
-                              token:(NSData *)token
-                               name:(NSString *)name
-                             locale:(NSLocale *)locale
-                   customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-                 platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-                  completionHandler:(FWTDeviceTokenIdResponse)handler
+- (NSTimeInterval)retryDelay
+{
+    return self.retryScheduler.baseDelay;
+}
+
+- (void)setRetryDelay:(NSTimeInterval)retryDelay
+{
+    self.retryScheduler.baseDelay = retryDelay;
+}
+
+- (NSTimeInterval)maxRetryDelay
+{
+    return self.retryScheduler.maxDelay;
+}
+
+- (void)setMaxRetryDelay:(NSTimeInterval)maxRetryDelay
+{
+    self.retryScheduler.maxDelay = maxRetryDelay;
+}
+
+- (void)setRequestIdleTimeout:(NSTimeInterval)requestIdleTimeout
+{
+    self->_requestIdleTimeout = requestIdleTimeout;
+    self.requester.timeoutInterval = requestIdleTimeout;
+}
+
+- (void)setConnectTimeout:(NSTimeInterval)connectTimeout
+{
+    self->_connectTimeout = connectTimeout;
+    self.requester.connectTimeout = connectTimeout;
+}
+
+- (void)setLogger:(id<FWTNotifiableLogger>)logger
+{
+    self->_logger = logger;
+    self.requester.logger = logger;
+}
+
+- (void)setMetrics:(id<FWTNotifiableMetrics>)metrics
+{
+    self->_metrics = metrics;
+    self.requester.metrics = metrics;
+}
+
+- (NSUInteger)requestCompressionThreshold
+{
+    return self.requester.compressionThreshold;
+}
+
+- (void)setRequestCompressionThreshold:(NSUInteger)requestCompressionThreshold
+{
+    self.requester.compressionThreshold = requestCompressionThreshold;
+}
+
+- (NSTimeInterval)receiptDeduplicationInterval
 {
+    return self.requestCoalescer.completedRequestLifetime;
+}
+
+- (void)setReceiptDeduplicationInterval:(NSTimeInterval)receiptDeduplicationInterval
+{
+    self.requestCoalescer.completedRequestLifetime = receiptDeduplicationInterval;
+}
+
+- (void)setReceiptBatchWindow:(NSTimeInterval)receiptBatchWindow
+{
+    @synchronized(self) {
+        self->_receiptBatchWindow = receiptBatchWindow;
+        [self _resetReceiptBatcher];
+    }
+}
+
+- (void)setReceiptBatchSize:(NSUInteger)receiptBatchSize
+{
+    @synchronized(self) {
+        self->_receiptBatchSize = receiptBatchSize;
+        [self _resetReceiptBatcher];
+    }
+}
+
+- (FWTNotificationReceiptBatcher *)receiptBatcher
+{
+    @synchronized(self) {
+        if (self->_receiptBatcher == nil && self->_receiptBatchWindow > 0) {
+            __weak typeof(self) weakSelf = self;
+            self->_receiptBatcher = [[FWTNotificationReceiptBatcher alloc] initWithWindow:self->_receiptBatchWindow
+                                                                             maxBatchSize:self->_receiptBatchSize
+                                                                             flushHandler:^(NSString *deviceTokenId, NSArray<NSString *> *notificationIds, NSArray<FWTSimpleRequestResponse> *handlers, NSArray *deadlines) {
+                __strong typeof(weakSelf) sself = weakSelf;
+                [sself _markNotificationsAsReceivedWithIds:notificationIds
+                                             deviceTokenId:deviceTokenId
+                                                  handlers:handlers
+                                                 deadlines:deadlines
+                                                  attempts:sself.retryAttempts + 1
+                                             previousError:nil];
+            }];
+        }
+        return self->_receiptBatcher;
+    }
+}
+
+- (FWTNotifiableOperation *)registerDeviceWithUserAlias:(NSString *)userAlias
+                                                 token:(NSData *)token
+                                                  name:(NSString *)name
+                                                locale:(NSLocale *)locale
+                                      customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                                    platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                                     completionHandler:(FWTDeviceTokenIdResponse)handler
+{
+    NSString *key = [FWTRequestCoalescer keyWithComponents:@[FWTRegisterOperationKey,
+                                                             [token fwt_notificationTokenString] ?: [NSNull null],
+                                                             userAlias ?: [NSNull null],
+                                                             name ?: [NSNull null],
+                                                             locale.localeIdentifier ?: [NSNull null],
+                                                             customProperties ?: [NSNull null],
+                                                             platformProperties ?: [NSNull null]]];
+    FWTNotifiableOperation *operation = [[FWTNotifiableOperation alloc] init];
+    FWTNotifiableOperation *request = nil;
+    if (![self _joinRequestWithKey:key
+                           handler:[self _tokenIdResponse:handler ofOperation:operation]
+                         operation:operation
+                           request:&request]) {
+        return operation;
+    }
+    
+    FWTRequestDeadline *deadline = [self _deadlineWithTimeout:self.operationTimeout ofRequest:request];
+    handler = [self _tokenIdResponse:[self _sharedTokenIdResponseForKey:key request:request] withDeadline:deadline];
     [self _registerDeviceWithUserAlias:userAlias
                                  token:token
                                   name:name
@@ -67,18 +220,40 @@ NSString * const FWTNotifiableProvider             = @"apns";
                     platformProperties:platformProperties
                               attempts:self.retryAttempts + 1
                          previousError:nil
+                              deadline:deadline
+                               request:request
                      completionHandler:handler];
+    return operation;
 }
 
-- (void)updateDevice:(NSNumber *)deviceTokenId
-        withUserAlias:(NSString *)alias
-               token:(NSData *)token
-                name:(NSString *)name
-               locale:(NSLocale *)locale
-    customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
-  platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
-    completionHandler:(FWTDeviceTokenIdResponse)handler
+- (FWTNotifiableOperation *)updateDevice:(NSNumber *)deviceTokenId
+                          withUserAlias:(NSString *)alias
+                                  token:(NSData *)token
+                                   name:(NSString *)name
+                                 locale:(NSLocale *)locale
+                       customProperties:(NSDictionary<NSString *, id> * _Nullable)customProperties
+                     platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
+                      completionHandler:(FWTDeviceTokenIdResponse)handler
 {
+    NSString *key = [FWTRequestCoalescer keyWithComponents:@[FWTUpdateOperationKey,
+                                                             deviceTokenId ?: [NSNull null],
+                                                             [token fwt_notificationTokenString] ?: [NSNull null],
+                                                             alias ?: [NSNull null],
+                                                             name ?: [NSNull null],
+                                                             locale.localeIdentifier ?: [NSNull null],
+                                                             customProperties ?: [NSNull null],
+                                                             platformProperties ?: [NSNull null]]];
+    FWTNotifiableOperation *operation = [[FWTNotifiableOperation alloc] init];
+    FWTNotifiableOperation *request = nil;
+    if (![self _joinRequestWithKey:key
+                           handler:[self _tokenIdResponse:handler ofOperation:operation]
+                         operation:operation
+                           request:&request]) {
+        return operation;
+    }
+    
+    FWTRequestDeadline *deadline = [self _deadlineWithTimeout:self.operationTimeout ofRequest:request];
+    handler = [self _tokenIdResponse:[self _sharedTokenIdResponseForKey:key request:request] withDeadline:deadline];
     [self _updateDevice:deviceTokenId
           withUserAlias:alias
                   token:token
@@ -88,16 +263,34 @@ NSString * const FWTNotifiableProvider             = @"apns";
      platformProperties:platformProperties
                attempts:self.retryAttempts + 1
           previousError:nil
+               deadline:deadline
+                request:request
       completionHandler:handler];
+    return operation;
 }
 
-- (void)unregisterTokenId:(NSNumber *)deviceTokenId
-        completionHandler:(FWTSimpleRequestResponse)handler
+- (FWTNotifiableOperation *)unregisterTokenId:(NSNumber *)deviceTokenId
+                           completionHandler:(FWTSimpleRequestResponse)handler
 {
+    NSString *key = [FWTRequestCoalescer keyWithComponents:@[FWTUnregisterOperationKey, deviceTokenId ?: [NSNull null]]];
+    FWTNotifiableOperation *operation = [[FWTNotifiableOperation alloc] init];
+    FWTNotifiableOperation *request = nil;
+    if (![self _joinRequestWithKey:key
+                           handler:[self _simpleResponse:handler ofOperation:operation]
+                         operation:operation
+                           request:&request]) {
+        return operation;
+    }
+    
+    FWTRequestDeadline *deadline = [self _deadlineWithTimeout:self.operationTimeout ofRequest:request];
+    handler = [self _simpleResponse:[self _sharedSimpleResponseForKey:key request:request remember:NO] withDeadline:deadline];
     [self _unregisterToken:deviceTokenId
               withAttempts:self.retryAttempts + 1
              previousError:nil
+                  deadline:deadline
+                   request:request
          completionHandler:handler];
+    return operation;
 }
 
 - (void)markNotificationAsOpenedWithId:(NSNumber *)notificationId
@@ -105,11 +298,32 @@ NSString * const FWTNotifiableProvider             = @"apns";
                                   user:(NSString *)user
                      completionHandler:(_Nullable FWTSimpleRequestResponse)handler
 {
+    [self markNotificationAsOpenedWithId:notificationId
+                           deviceTokenId:deviceTokenId
+                                    user:user
+                                 timeout:self.operationTimeout
+                       completionHandler:handler];
+}
+
+- (void)markNotificationAsOpenedWithId:(NSNumber *)notificationId
+                         deviceTokenId:(NSNumber *)deviceTokenId
+                                  user:(NSString *)user
+                               timeout:(NSTimeInterval)timeout
+                     completionHandler:(_Nullable FWTSimpleRequestResponse)handler
+{
+    NSString *key = [FWTRequestCoalescer keyWithComponents:@[FWTOpenedOperationKey, deviceTokenId ?: [NSNull null], notificationId ?: [NSNull null]]];
+    if (![self _joinReceiptWithKey:key handler:[self _simpleResponseOnCallbackQueue:handler]]) {
+        return;
+    }
+    
+    FWTRequestDeadline *deadline = [FWTRequestDeadline deadlineWithTimeout:timeout];
+    handler = [self _simpleResponse:[self _sharedSimpleResponseForKey:key request:nil remember:YES] withDeadline:deadline];
     [self _markNotificationAsOpenedWithId:[notificationId stringValue]
                             deviceTokenId:[deviceTokenId stringValue]
                                      user:user
                                  attempts:self.retryAttempts + 1
                                 previousError:nil
+                                     deadline:deadline
                             completionHandler:handler];
 }
 
@@ -117,10 +331,39 @@ NSString * const FWTNotifiableProvider             = @"apns";
                            deviceTokenId:(NSNumber *)deviceTokenId
                        completionHandler:(_Nullable FWTSimpleRequestResponse)handler
 {
+    [self markNotificationAsReceivedWithId:notificationId
+                             deviceTokenId:deviceTokenId
+                                   timeout:self.operationTimeout
+                         completionHandler:handler];
+}
+
+- (void)markNotificationAsReceivedWithId:(NSNumber *)notificationId
+                           deviceTokenId:(NSNumber *)deviceTokenId
+                                 timeout:(NSTimeInterval)timeout
+                       completionHandler:(_Nullable FWTSimpleRequestResponse)handler
+{
+    NSString *key = [FWTRequestCoalescer keyWithComponents:@[FWTReceivedOperationKey, deviceTokenId ?: [NSNull null], notificationId ?: [NSNull null]]];
+    if (![self _joinReceiptWithKey:key handler:[self _simpleResponseOnCallbackQueue:handler]]) {
+        return;
+    }
+    
+    FWTRequestDeadline *deadline = [FWTRequestDeadline deadlineWithTimeout:timeout];
+    handler = [self _simpleResponse:[self _sharedSimpleResponseForKey:key request:nil remember:YES] withDeadline:deadline];
+    
+    FWTNotificationReceiptBatcher *batcher = self.bulkReceiptsUnsupported ? nil : self.receiptBatcher;
+    if (batcher) {
+        [batcher addNotificationId:[notificationId stringValue]
+                     deviceTokenId:[deviceTokenId stringValue]
+                          deadline:deadline
+                 completionHandler:handler];
+        return;
+    }
+    
     [self _markNotificationAsReceivedWithId:[notificationId stringValue]
                               deviceTokenId:[deviceTokenId stringValue]
                                    attempts:self.retryAttempts + 1
                               previousError:nil
+                                   deadline:deadline
                           completionHandler:handler];
 }
 
@@ -145,8 +388,9 @@ NSString * const FWTNotifiableProvider             = @"apns";
     if (userAlias) {
         [params setObject:userAlias forKey:FWTNotifiableUserAliasKey];
     }
-    if (token) {
-        [params setObject:[token fwt_notificationTokenString] forKey:FWTNotifiableDeviceTokenKey];
+    NSString *tokenString = [token fwt_notificationTokenString];
+    if (tokenString) {
+        [params setObject:tokenString forKey:FWTNotifiableDeviceTokenKey];
     }
     if (locale) {
         [params setObject:[locale fwt_languageCode] forKey:FWTNotifiableLanguageKey];
@@ -174,6 +418,8 @@ NSString * const FWTNotifiableProvider             = @"apns";
                   platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
                             attempts:(NSUInteger)attempts
                        previousError:(NSError *)previousError
+                            deadline:(FWTRequestDeadline *)deadline
+                             request:(FWTNotifiableOperation *)request
                    completionHandler:(FWTDeviceTokenIdResponse)handler
 {
     NSAssert(token != nil, @"To register a device, a token need to be provided");
@@ -184,6 +430,11 @@ NSString * const FWTNotifiableProvider             = @"apns";
         errorHandler(nil, [NSError fwt_invalidDeviceInformationError:previousError]);
     }
     
+    if (request.isCancelled) {
+        errorHandler(nil, [NSError fwt_cancelledError:previousError]);
+        return;
+    }
+    
     if (attempts == 0){
         errorHandler(nil, [NSError fwt_errorWithUnderlyingError:previousError]);
         return;
@@ -198,7 +449,8 @@ NSString * const FWTNotifiableProvider             = @"apns";
                                             includingProvider:YES];
     
     __weak typeof(self) weakSelf = self;
-    [self.requester registerDeviceWithParams:params success:^(NSDictionary * _Nullable response) {
+    dispatch_queue_t workQueue = self.workQueue;
+    NSURLSessionTask *task = [self.requester registerDeviceWithParams:params success:^(NSDictionary * _Nullable response) {
         __strong typeof(weakSelf) sself = weakSelf;
         if (response == nil || ![response isKindOfClass:[NSDictionary class]]) {
             [sself _registerDeviceWithUserAlias:userAlias
@@ -209,22 +461,23 @@ NSString * const FWTNotifiableProvider             = @"apns";
                              platformProperties:platformProperties
                                        attempts:(attempts - 1)
                                   previousError:previousError
+                                       deadline:deadline
+                                        request:request
                               completionHandler:handler];
             return;
         }
         NSNumber *tokenId = response[@"id"];
-        [sself.logger logMessage:[NSString stringWithFormat:@"Did register for push notifications with token: %@ and tokenId: %@", token, tokenId]];
+        FWTLogInformation(sself.logger, @"Did register for push notifications with token: %@ and tokenId: %@", token, tokenId);
         
         if(handler){
-            dispatch_async(dispatch_get_main_queue(), ^{
+            dispatch_async(workQueue, ^{
                 handler(tokenId, nil);
             });
         }
     } failure:^(NSInteger responseCode, NSError * _Nonnull error) {
-        [weakSelf.logger logMessage:[NSString stringWithFormat:@"Failed to register device token: %@",error]];
+        FWTLogInformation(weakSelf.logger, @"Failed to register device token: %@",error);
         
-        dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(weakSelf.retryDelay * NSEC_PER_SEC));
-        dispatch_after(popTime, dispatch_get_main_queue(), ^(void){
+        [weakSelf _retryWithAttempts:attempts error:error deadline:deadline request:request endpoint:FWTNotifiableMetricsEndpointRegisterDevice operation:^(dispatch_block_t completion) {
             [weakSelf _registerDeviceWithUserAlias:userAlias
                                              token:token
                                               name:name
@@ -233,9 +486,17 @@ NSString * const FWTNotifiableProvider             = @"apns";
                                 platformProperties:platformProperties
                                           attempts:(attempts - 1)
                                      previousError:error
-                                 completionHandler:handler];
-        });
+                                          deadline:deadline
+                                           request:request
+                                 completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+                                     completion();
+                                     if (handler) {
+                                         handler(deviceTokenId, error);
+                                     }
+                                 }];
+        }];
     }];
+    [self _cancelTask:task withRequest:request];
 }
 
 - (void)_updateDevice:(NSNumber *)deviceTokenId
@@ -247,6 +508,8 @@ NSString * const FWTNotifiableProvider             = @"apns";
    platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
              attempts:(NSUInteger)attempts
         previousError:(NSError *)previousError
+             deadline:(FWTRequestDeadline *)deadline
+              request:(FWTNotifiableOperation *)request
     completionHandler:(FWTDeviceTokenIdResponse)handler
 {
     NSAssert(deviceTokenId != nil, @"To update a device, a device token in need to be provided.");
@@ -255,10 +518,16 @@ NSString * const FWTNotifiableProvider             = @"apns";
              token != nil ||
              name != nil ||
              locale != nil ||
-             customProperties != nil, @"You need provid at least one updated parameter.");
+             customProperties != nil ||
+             platformProperties != nil, @"You need provid at least one updated parameter.");
     
     FWTLoggedTokenErrorHandler errorHandler = [self _buildLoggedTokenIdErrorHandler: handler];
     
+    if (request.isCancelled) {
+        errorHandler(deviceTokenId, [NSError fwt_cancelledError:previousError]);
+        return;
+    }
+    
     if (attempts == 0){
         errorHandler(deviceTokenId, [NSError fwt_errorWithUnderlyingError:previousError]);
         return;
@@ -278,22 +547,22 @@ NSString * const FWTNotifiableProvider             = @"apns";
                                             includingProvider:NO];
     
     __weak typeof(self) weakSelf = self;
+    dispatch_queue_t workQueue = self.workQueue;
     NSNumber *tokenId = [deviceTokenId copy];
-    [self.requester updateDeviceWithTokenId:deviceTokenId params:params success:^(NSDictionary * _Nullable response) {
+    NSURLSessionTask *task = [self.requester updateDeviceWithTokenId:deviceTokenId params:params success:^(NSDictionary * _Nullable response) {
         __strong typeof(weakSelf) sself = weakSelf;
         [sself.logger logMessage:@"Did updated device"];
         if(handler){
-            dispatch_async(dispatch_get_main_queue(), ^{
+            dispatch_async(workQueue, ^{
                 handler(tokenId, nil);
             });
         }
     } failure:^(NSInteger responseCode, NSError * _Nonnull error) {
         
         __strong typeof(weakSelf) sself = weakSelf;
-        [sself.logger logMessage:[NSString stringWithFormat:@"Failed to update device with deviceTokenId %@: %@", deviceTokenId, error]];
+        FWTLogInformation(sself.logger, @"Failed to update device with deviceTokenId %@: %@", deviceTokenId, error);
         
-        dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(sself.retryDelay * NSEC_PER_SEC));
-        dispatch_after(popTime, dispatch_get_main_queue(), ^(void){
+        [sself _retryWithAttempts:attempts error:error deadline:deadline request:request endpoint:FWTNotifiableMetricsEndpointUpdateDevice operation:^(dispatch_block_t completion) {
             [weakSelf _updateDevice:deviceTokenId
                       withUserAlias:alias
                               token:token
@@ -303,19 +572,34 @@ NSString * const FWTNotifiableProvider             = @"apns";
                  platformProperties:platformProperties
                            attempts:(attempts - 1)
                       previousError:error
-                  completionHandler:handler];
-        });
+                           deadline:deadline
+                            request:request
+                  completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+                      completion();
+                      if (handler) {
+                          handler(deviceTokenId, error);
+                      }
+                  }];
+        }];
     }];
+    [self _cancelTask:task withRequest:request];
 }
 
 
 - (void)_unregisterToken:(NSNumber *)deviceTokenId
             withAttempts:(NSUInteger)attempts
            previousError:(NSError *)previousError
+                deadline:(FWTRequestDeadline *)deadline
+                 request:(FWTNotifiableOperation *)request
        completionHandler:(FWTSimpleRequestResponse)handler
 {
     FWTLoggedErrorHandler errorHandler = [self _buildLoggedErrorHandler:handler];
     
+    if (request.isCancelled) {
+        errorHandler([NSError fwt_cancelledError:previousError]);
+        return;
+    }
+    
     if (attempts == 0){
         errorHandler([NSError fwt_errorWithUnderlyingError:previousError]);
         return;
@@ -327,11 +611,12 @@ NSString * const FWTNotifiableProvider             = @"apns";
     }
     
     __weak typeof(self) weakSelf = self;
-    [self.requester unregisterTokenId:deviceTokenId success:^(NSDictionary * _Nullable response) {
+    dispatch_queue_t workQueue = self.workQueue;
+    NSURLSessionTask *task = [self.requester unregisterTokenId:deviceTokenId success:^(NSDictionary * _Nullable response) {
         __strong typeof(weakSelf) sself = weakSelf;
         [sself.logger logMessage:@"Did unregister for push notifications"];
         if(handler){
-            dispatch_async(dispatch_get_main_queue(), ^{
+            dispatch_async(workQueue, ^{
                 handler(YES, nil);
             });
         }
@@ -339,14 +624,16 @@ NSString * const FWTNotifiableProvider             = @"apns";
     } failure:^(NSInteger responseCode, NSError * _Nonnull error) {
         [weakSelf.logger logMessage:@"Failed to unregister for push notifications"];
         
-        dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(weakSelf.retryDelay * NSEC_PER_SEC));
-        dispatch_after(popTime, dispatch_get_main_queue(), ^(void){
+        [weakSelf _retryWithAttempts:attempts error:error deadline:deadline request:request endpoint:FWTNotifiableMetricsEndpointUnregisterDevice operation:^(dispatch_block_t completion) {
             [weakSelf _unregisterToken:deviceTokenId
                           withAttempts:(attempts - 1)
                          previousError:error
-                     completionHandler:handler];
-        });
+                              deadline:deadline
+                               request:request
+                     completionHandler:[weakSelf _simpleResponse:handler withCompletion:completion]];
+        }];
     }];
+    [self _cancelTask:task withRequest:request];
 }
 
 
@@ -355,6 +642,7 @@ NSString * const FWTNotifiableProvider             = @"apns";
                                    user:(NSString *)user
                                attempts:(NSUInteger)attempts
                           previousError:(NSError *)error
+                               deadline:(FWTRequestDeadline *)deadline
                       completionHandler:(FWTSimpleRequestResponse)handler
 {
     FWTLoggedErrorHandler errorHandler = [self _buildLoggedErrorHandler:handler];
@@ -374,15 +662,15 @@ NSString * const FWTNotifiableProvider             = @"apns";
         __strong typeof(weakSelf) sself = weakSelf;
         [sself.logger logMessage:@"Failed to mark notification as opened"];
         
-        dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(sself.retryDelay * NSEC_PER_SEC));
-        dispatch_after(popTime, dispatch_get_main_queue(), ^(void){
+        [sself _retryWithAttempts:attempts error:error deadline:deadline request:nil endpoint:FWTNotifiableMetricsEndpointNotificationOpened operation:^(dispatch_block_t completion) {
             [weakSelf _markNotificationAsOpenedWithId:notificationId
                                         deviceTokenId:deviceTokenId
                                                  user:user
                                              attempts:(attempts - 1)
                                         previousError:error
-                                    completionHandler:handler];
-        });
+                                             deadline:deadline
+                                    completionHandler:[weakSelf _simpleResponse:handler withCompletion:completion]];
+        }];
     }];
 }
 
@@ -390,6 +678,7 @@ NSString * const FWTNotifiableProvider             = @"apns";
                             deviceTokenId:(NSString *)deviceTokenId
                                  attempts:(NSUInteger)attempts
                             previousError:(NSError *)error
+                                 deadline:(FWTRequestDeadline *)deadline
                         completionHandler:(FWTSimpleRequestResponse)handler
 {
     FWTLoggedErrorHandler errorHandler = [self _buildLoggedErrorHandler:handler];
@@ -409,24 +698,385 @@ NSString * const FWTNotifiableProvider             = @"apns";
         __strong typeof(weakSelf) sself = weakSelf;
         [sself.logger logMessage:@"Failed to mark notification as received"];
         
-        dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(sself.retryDelay * NSEC_PER_SEC));
-        dispatch_after(popTime, dispatch_get_main_queue(), ^(void){
+        [sself _retryWithAttempts:attempts error:error deadline:deadline request:nil endpoint:FWTNotifiableMetricsEndpointNotificationReceived operation:^(dispatch_block_t completion) {
             [weakSelf _markNotificationAsReceivedWithId:notificationId
                                         deviceTokenId:deviceTokenId
                                              attempts:(attempts - 1)
                                         previousError:error
-                                    completionHandler:handler];
+                                             deadline:deadline
+                                    completionHandler:[weakSelf _simpleResponse:handler withCompletion:completion]];
+        }];
+    }];
+}
+
+- (void)_resetReceiptBatcher
+{
+    [self->_receiptBatcher flush];
+    self->_receiptBatcher = nil;
+}
+
+- (void)_markNotificationsAsReceivedWithIds:(NSArray<NSString *> *)notificationIds
+                              deviceTokenId:(NSString *)deviceTokenId
+                                   handlers:(NSArray<FWTSimpleRequestResponse> *)handlers
+                                  deadlines:(NSArray *)deadlines
+                                   attempts:(NSUInteger)attempts
+                              previousError:(NSError *)error
+{
+    // The receipts that expired while waiting for a retry already reported their timeout
+    NSIndexSet *pending = [deadlines indexesOfObjectsPassingTest:^BOOL(id deadline, NSUInteger idx, BOOL * _Nonnull stop) {
+        return ![deadline isKindOfClass:[FWTRequestDeadline class]] || ![(FWTRequestDeadline *)deadline isExpired];
+    }];
+    if (pending.count < notificationIds.count) {
+        notificationIds = [notificationIds objectsAtIndexes:pending];
+        handlers = [handlers objectsAtIndexes:pending];
+        deadlines = [deadlines objectsAtIndexes:pending];
+    }
+    if (notificationIds.count == 0) {
+        return;
+    }
+    
+    if (attempts == 0) {
+        NSError *underlyingError = [NSError fwt_errorWithUnderlyingError:error];
+        for (FWTSimpleRequestResponse handler in handlers) {
+            [self _buildLoggedErrorHandler:handler](underlyingError);
+        }
+        return;
+    }
+    
+    if (notificationIds.count == 1 || self.bulkReceiptsUnsupported) {
+        [self _fallbackReceiptsForIds:notificationIds deviceTokenId:deviceTokenId handlers:handlers deadlines:deadlines];
+        return;
+    }
+    
+    __weak typeof(self) weakSelf = self;
+    [self.requester markNotificationsAsReceivedWithIds:notificationIds deviceTokenId:deviceTokenId success:^(NSDictionary * _Nullable response) {
+        __strong typeof(weakSelf) sself = weakSelf;
+        FWTLogInformation(sself.logger, @"%lu notifications flagged as received", (unsigned long)notificationIds.count);
+        
+        NSDictionary *results = [response[FWTNotifiableBulkResultsKey] isKindOfClass:[NSDictionary class]] ? (NSDictionary *)response[FWTNotifiableBulkResultsKey] : @{};
+        [notificationIds enumerateObjectsUsingBlock:^(NSString * _Nonnull notificationId, NSUInteger idx, BOOL * _Nonnull stop) {
+            FWTSimpleRequestResponse handler = handlers[idx];
+            id status = results[notificationId];
+            NSInteger statusCode = [status respondsToSelector:@selector(integerValue)] ? [status integerValue] : 200;
+            if (statusCode >= 200 && statusCode < 300) {
+                handler(YES, nil);
+            } else {
+                NSError *error = [NSError fwt_errorWithCode:statusCode andUserInformation:nil];
+                [sself _buildLoggedErrorHandler:handler]([NSError fwt_errorWithUnderlyingError:error]);
+            }
+        }];
+    } failure:^(NSInteger responseCode, NSError * _Nonnull error) {
+        __strong typeof(weakSelf) sself = weakSelf;
+        if (error.code == 404 || error.code == 405 || error.code == 501) {
+            [sself.logger logMessage:@"Bulk delivery receipts are not supported by the server, falling back to single receipts"];
+            sself.bulkReceiptsUnsupported = YES;
+            [sself _fallbackReceiptsForIds:notificationIds deviceTokenId:deviceTokenId handlers:handlers deadlines:deadlines];
+            return;
+        }
+        
+        // Any other failure is retried as a whole, so an outage doesn't turn into one request per receipt
+        [sself.logger logMessage:@"Failed to mark notifications as received"];
+        [sself _retryWithAttempts:attempts error:error deadline:[FWTRequesterManager _batchDeadlineOfDeadlines:deadlines] request:nil endpoint:FWTNotifiableMetricsEndpointNotificationReceived operation:^(dispatch_block_t completion) {
+            NSMutableArray<FWTSimpleRequestResponse> *retryHandlers = [[NSMutableArray alloc] initWithCapacity:handlers.count];
+            for (FWTSimpleRequestResponse handler in handlers) {
+                [retryHandlers addObject:[weakSelf _simpleResponse:handler withCompletion:completion]];
+            }
+            [weakSelf _markNotificationsAsReceivedWithIds:notificationIds
+                                            deviceTokenId:deviceTokenId
+                                                 handlers:retryHandlers
+                                                deadlines:deadlines
+                                                 attempts:(attempts - 1)
+                                            previousError:error];
+        }];
+    }];
+}
+
+// The batch waits as long as its most patient receipt, each receipt expires on its own deadline
++ (FWTRequestDeadline *)_batchDeadlineOfDeadlines:(NSArray *)deadlines
+{
+    FWTRequestDeadline *batchDeadline = nil;
+    for (id deadline in deadlines) {
+        if (![deadline isKindOfClass:[FWTRequestDeadline class]]) {
+            return nil;
+        }
+        if (batchDeadline == nil || [(FWTRequestDeadline *)deadline remainingTime] > [batchDeadline remainingTime]) {
+            batchDeadline = deadline;
+        }
+    }
+    return batchDeadline;
+}
+
+- (void)_fallbackReceiptsForIds:(NSArray<NSString *> *)notificationIds
+                  deviceTokenId:(NSString *)deviceTokenId
+                       handlers:(NSArray<FWTSimpleRequestResponse> *)handlers
+                      deadlines:(NSArray *)deadlines
+{
+    [notificationIds enumerateObjectsUsingBlock:^(NSString * _Nonnull notificationId, NSUInteger idx, BOOL * _Nonnull stop) {
+        id deadline = deadlines[idx];
+        [self _markNotificationAsReceivedWithId:notificationId
+                                  deviceTokenId:deviceTokenId
+                                       attempts:self.retryAttempts + 1
+                                  previousError:nil
+                                       deadline:[deadline isKindOfClass:[FWTRequestDeadline class]] ? deadline : nil
+                              completionHandler:handlers[idx]];
+    }];
+}
+
+#pragma mark - In-flight requests
+
+// YES if the caller needs to send the request, NO if it joined an identical one in flight
+- (BOOL)_joinRequestWithKey:(NSString *)key handler:(id)handler
+{
+    // Callers without a handler still join, so they don't send the request again
+    if ([self.requestCoalescer addHandler:handler ?: [NSNull null] forKey:key]) {
+        return YES;
+    }
+    FWTLogInformation(self.logger, @"Joined the request in flight: %@", key);
+    return NO;
+}
+
+// YES if the caller needs to send the request. The caller leaves the request when its operation is cancelled.
+- (BOOL)_joinRequestWithKey:(NSString *)key
+                    handler:(id)handler
+                  operation:(FWTNotifiableOperation *)operation
+                    request:(FWTNotifiableOperation **)request
+{
+    FWTRequestCoalescer *coalescer = self.requestCoalescer;
+    BOOL send = [coalescer addHandler:handler forKey:key request:request];
+    __weak id weakHandler = handler;
+    [operation addCancellationHandler:^{
+        id handler = weakHandler;
+        if (handler) {
+            [coalescer removeHandler:handler forKey:key];
+        }
+    }];
+    if (!send) {
+        FWTLogInformation(self.logger, @"Joined the request in flight: %@", key);
+    }
+    return send;
+}
+
+- (BOOL)_joinReceiptWithKey:(NSString *)key handler:(FWTSimpleRequestResponse)handler
+{
+    if ([self.requestCoalescer didRecentlyCompleteRequestWithKey:key]) {
+        FWTLogInformation(self.logger, @"Receipt already delivered: %@", key);
+        if (handler) {
+            handler(YES, nil);
+        }
+        return NO;
+    }
+    return [self _joinRequestWithKey:key handler:handler];
+}
+
+// The request finishes on the work queue, the handlers of the callers hop to the callback queue
+- (FWTSimpleRequestResponse)_sharedSimpleResponseForKey:(NSString *)key request:(FWTNotifiableOperation *)request remember:(BOOL)remember
+{
+    FWTRequestCoalescer *coalescer = self.requestCoalescer;
+    dispatch_queue_t workQueue = self.workQueue;
+    return ^(BOOL success, NSError * _Nullable error) {
+        dispatch_async(workQueue, ^{
+            BOOL rememberKey = remember && success;
+            NSArray *handlers = request ? [coalescer completeRequest:request withKey:key remember:rememberKey] : [coalescer completeRequestWithKey:key remember:rememberKey];
+            for (id handler in handlers) {
+                if ([handler isKindOfClass:[NSNull class]]) {
+                    continue;
+                }
+                ((FWTSimpleRequestResponse)handler)(success, error);
+            }
         });
+    };
+}
+
+- (FWTDeviceTokenIdResponse)_sharedTokenIdResponseForKey:(NSString *)key request:(FWTNotifiableOperation *)request
+{
+    FWTRequestCoalescer *coalescer = self.requestCoalescer;
+    dispatch_queue_t workQueue = self.workQueue;
+    return ^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+        dispatch_async(workQueue, ^{
+            for (id handler in [coalescer completeRequest:request withKey:key remember:NO]) {
+                if ([handler isKindOfClass:[NSNull class]]) {
+                    continue;
+                }
+                ((FWTDeviceTokenIdResponse)handler)(deviceTokenId, error);
+            }
+        });
+    };
+}
+
+- (FWTSimpleRequestResponse)_simpleResponseOnCallbackQueue:(FWTSimpleRequestResponse)handler
+{
+    if (handler == nil) {
+        return nil;
+    }
+    dispatch_queue_t callbackQueue = self.callbackQueue;
+    return ^(BOOL success, NSError * _Nullable error) {
+        dispatch_async(callbackQueue, ^{
+            handler(success, error);
+        });
+    };
+}
+
+// Handler of a caller, called once on the callback queue. If the operation is cancelled first,
+// the caller gets a cancellation error instead.
+- (FWTSimpleRequestResponse)_simpleResponse:(FWTSimpleRequestResponse)handler ofOperation:(FWTNotifiableOperation *)operation
+{
+    FWTSimpleRequestResponse callbackHandler = [self _simpleResponseOnCallbackQueue:handler];
+    if (callbackHandler) {
+        [operation addCancellationHandler:^{
+            callbackHandler(NO, [NSError fwt_cancelledError:nil]);
+        }];
+    }
+    return ^(BOOL success, NSError * _Nullable error) {
+        if ([operation finish] && callbackHandler) {
+            callbackHandler(success, error);
+        }
+    };
+}
+
+- (FWTDeviceTokenIdResponse)_tokenIdResponse:(FWTDeviceTokenIdResponse)handler ofOperation:(FWTNotifiableOperation *)operation
+{
+    FWTDeviceTokenIdResponse callbackHandler = [self _tokenIdResponseOnCallbackQueue:handler];
+    if (callbackHandler) {
+        [operation addCancellationHandler:^{
+            callbackHandler(nil, [NSError fwt_cancelledError:nil]);
+        }];
+    }
+    return ^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+        if ([operation finish] && callbackHandler) {
+            callbackHandler(deviceTokenId, error);
+        }
+    };
+}
+
+- (FWTDeviceTokenIdResponse)_tokenIdResponseOnCallbackQueue:(FWTDeviceTokenIdResponse)handler
+{
+    if (handler == nil) {
+        return nil;
+    }
+    dispatch_queue_t callbackQueue = self.callbackQueue;
+    return ^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+        dispatch_async(callbackQueue, ^{
+            handler(deviceTokenId, error);
+        });
+    };
+}
+
+- (void)_retryWithAttempts:(NSUInteger)attempts
+                     error:(NSError *)error
+                  deadline:(FWTRequestDeadline *)deadline
+                   request:(FWTNotifiableOperation *)request
+                  endpoint:(FWTNotifiableMetricsEndpoint)endpoint
+                 operation:(FWTRetryOperation)operation
+{
+    if (attempts <= 1 || request.isCancelled) {
+        // No attempts left, or nobody waits for the request, the operation only reports the error
+        operation(^{});
+        return;
+    }
+    NSInteger retry = MAX(self.retryAttempts + 1 - (NSInteger)attempts, 0);
+    NSTimeInterval delay = [self.retryScheduler delayForRetry:(NSUInteger)retry error:error];
+    if (deadline && delay >= [deadline remainingTime]) {
+        // The retry would start after the deadline, so the operation expires right away
+        [deadline expire];
+        return;
+    }
+    [self.metrics recordRetryOfEndpoint:endpoint];
+    dispatch_queue_t workQueue = self.workQueue;
+    dispatch_block_t cancelRetry = [self.retryScheduler scheduleOperation:^(dispatch_block_t completion) {
+        dispatch_async(workQueue, ^{
+            if ([deadline isExpired]) {
+                completion();
+                return;
+            }
+            operation(completion);
+        });
+    } afterDelay:delay];
+    [request addCancellationHandler:cancelRetry];
+    // A retry that would start after the deadline is dropped, nobody waits for its result
+    [deadline addExpirationHandler:cancelRetry];
+}
+
+- (void)_cancelTask:(NSURLSessionTask *)task withRequest:(FWTNotifiableOperation *)request
+{
+    if (task == nil) {
+        return;
+    }
+    [request addCancellationHandler:^{
+        [task cancel];
     }];
 }
 
+- (FWTRequestDeadline *)_deadlineWithTimeout:(NSTimeInterval)timeout ofRequest:(FWTNotifiableOperation *)request
+{
+    FWTRequestDeadline *deadline = [FWTRequestDeadline deadlineWithTimeout:timeout];
+    if (deadline) {
+        // A cancelled request doesn't expire later
+        [request addCancellationHandler:^{
+            [deadline finish];
+        }];
+    }
+    return deadline;
+}
+
+- (FWTSimpleRequestResponse)_simpleResponse:(FWTSimpleRequestResponse)handler withDeadline:(FWTRequestDeadline *)deadline
+{
+    if (deadline == nil) {
+        return handler;
+    }
+    FWTLoggedErrorHandler errorHandler = [self _buildLoggedErrorHandler:handler];
+    NSError *timeoutError = [NSError fwt_errorWithUnderlyingError:[self _timeoutError]];
+    [deadline setExpirationHandler:^{
+        errorHandler(timeoutError);
+    }];
+    return ^(BOOL success, NSError * _Nullable error) {
+        if ([deadline finish] && handler) {
+            handler(success, error);
+        }
+    };
+}
+
+- (FWTDeviceTokenIdResponse)_tokenIdResponse:(FWTDeviceTokenIdResponse)handler withDeadline:(FWTRequestDeadline *)deadline
+{
+    if (deadline == nil) {
+        return handler;
+    }
+    FWTLoggedTokenErrorHandler errorHandler = [self _buildLoggedTokenIdErrorHandler:handler];
+    NSError *timeoutError = [NSError fwt_errorWithUnderlyingError:[self _timeoutError]];
+    [deadline setExpirationHandler:^{
+        errorHandler(nil, timeoutError);
+    }];
+    return ^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+        if ([deadline finish] && handler) {
+            handler(deviceTokenId, error);
+        }
+    };
+}
+
+- (NSError *)_timeoutError
+{
+    return [NSError errorWithDomain:NSURLErrorDomain
+                               code:NSURLErrorTimedOut
+                           userInfo:@{NSLocalizedDescriptionKey: @"The operation deadline expired."}];
+}
+
+- (FWTSimpleRequestResponse)_simpleResponse:(FWTSimpleRequestResponse)handler withCompletion:(dispatch_block_t)completion
+{
+    return ^(BOOL success, NSError * _Nullable error) {
+        completion();
+        if (handler) {
+            handler(success, error);
+        }
+    };
+}
+
 - (FWTLoggedErrorHandler) _buildLoggedErrorHandler:(FWTSimpleRequestResponse)handler {
     __weak typeof(self) weakSelf = self;
+    dispatch_queue_t workQueue = self.workQueue;
     return  ^(NSError *error) {
         __strong typeof(weakSelf) strongSelf = weakSelf;
         __weak typeof(strongSelf.logger) weakLogger = strongSelf.logger;
         if(handler){
-            dispatch_async(dispatch_get_main_queue(), ^{
+            dispatch_async(workQueue, ^{
                 [weakLogger logError:error];
                 handler(NO, error);
             });
@@ -436,11 +1086,12 @@ NSString * const FWTNotifiableProvider             = @"apns";
 
 - (FWTLoggedTokenErrorHandler) _buildLoggedTokenIdErrorHandler:(FWTDeviceTokenIdResponse)handler {
     __weak typeof(self) weakSelf = self;
+    dispatch_queue_t workQueue = self.workQueue;
     return  ^(NSNumber *tokenId, NSError *error) {
         __strong typeof(weakSelf) strongSelf = weakSelf;
         __weak typeof(strongSelf.logger) weakLogger = strongSelf.logger;
         if(handler){
-            dispatch_async(dispatch_get_main_queue(), ^{
+            dispatch_async(workQueue, ^{
                 [weakLogger logError:error];
                 handler(tokenId, error);
             });
@@ -0,0 +1,75 @@
+//
+//  FWTRequesterPool.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FWTRequesterManager;
+@class FWTServerConfiguration;
+@protocol FWTNotifiableLogger;
+@protocol FWTNotifiableMetrics;
+
+typedef FWTRequesterManager * _Nonnull (^FWTRequesterPoolBuilder)(void);
+
+/**
+ Settings of a pooled requester manager. They are part of the pool key, so managers with different
+ settings are never shared, and they are applied every time the manager is built.
+ */
+@interface FWTRequesterSettings : NSObject <NSCopying>
+
+/** Default: 3 */
+@property (nonatomic, assign) NSInteger retryAttempts;
+/** Default: 60 seconds */
+@property (nonatomic, assign) NSTimeInterval retryDelay;
+/** If nil (default), the manager keeps its own logger */
+@property (nonatomic, strong, nullable) id<FWTNotifiableLogger> logger;
+/** Default: FWTDefaultNotifiableMetrics sharedMetrics */
+@property (nonatomic, strong, nullable) id<FWTNotifiableMetrics> metrics;
+/** Default: 0, no compression */
+@property (nonatomic, assign) NSUInteger requestCompressionThreshold;
+
+- (void)applyToRequesterManager:(FWTRequesterManager *)requesterManager;
+
+@end
+
+/**
+ Requester managers shared between the SDK operations, one per server configuration, group and session.
+
+ A manager is reused while the configuration doesn't change. A new configuration gets its own manager, so
+ several servers can be used side by side, and the managers not used for `idleTimeout` are released.
+ */
+@interface FWTRequesterPool : NSObject
+
+/** Time a manager is kept in the pool without being used. Default: 5 minutes */
+@property (nonatomic, assign) NSTimeInterval idleTimeout;
+/** Number of managers on the pool */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
++ (instancetype)sharedPool;
+
+/**
+ Manager for the configuration, group, session and settings. The builder is called when the pool doesn't have one.
+
+ @param configuration Server configuration used by the manager.
+ @param groupId       Group of the stored configuration.
+ @param session       Session used to perform the requests.
+ @param settings      Settings applied to the manager when it is built. If nil, the default settings are used.
+ @param builder       Creates the manager, if needed.
+ */
+- (FWTRequesterManager *)requesterManagerForConfiguration:(FWTServerConfiguration * _Nullable)configuration
+                                                  groupId:(NSString * _Nullable)groupId
+                                                  session:(NSURLSession *)session
+                                                 settings:(FWTRequesterSettings * _Nullable)settings
+                                                  builder:(FWTRequesterPoolBuilder)builder;
+
+/** Release the managers of a group, so the next request uses a new one. */
+- (void)removeRequesterManagersForGroupId:(NSString * _Nullable)groupId;
+- (void)removeAllRequesterManagers;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,212 @@
+//
+//  FWTRequesterPool.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTRequesterPool.h"
+#import "FWTRequesterManager.h"
+#import "FWTRetryScheduler.h"
+#import "FWTServerConfiguration.h"
+#import "FWTDefaultNotifiableMetrics.h"
+#import <CommonCrypto/CommonCrypto.h>
+
+static NSTimeInterval const FWTRequesterPoolDefaultIdleTimeout = 300;
+// Group ids are never empty, so the app container can't collide with a group
+static NSString * const FWTRequesterPoolAppGroup = @"";
+
+@interface FWTRequesterSettings ()
+
+- (NSString *)_poolKey;
+
+@end
+
+@implementation FWTRequesterSettings
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self->_retryAttempts = 3;
+        self->_retryDelay = 60;
+        self->_metrics = [FWTDefaultNotifiableMetrics sharedMetrics];
+        self->_requestCompressionThreshold = 0;
+    }
+    return self;
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    FWTRequesterSettings *settings = [[FWTRequesterSettings allocWithZone:zone] init];
+    settings.retryAttempts = self.retryAttempts;
+    settings.retryDelay = self.retryDelay;
+    settings.logger = self.logger;
+    settings.metrics = self.metrics;
+    settings.requestCompressionThreshold = self.requestCompressionThreshold;
+    return settings;
+}
+
+- (void)applyToRequesterManager:(FWTRequesterManager *)requesterManager
+{
+    requesterManager.retryAttempts = self.retryAttempts;
+    requesterManager.retryDelay = self.retryDelay;
+    if (self.logger != nil) {
+        requesterManager.logger = self.logger;
+    }
+    requesterManager.metrics = self.metrics;
+    requesterManager.requestCompressionThreshold = self.requestCompressionThreshold;
+}
+
+// The pooled manager keeps the logger and the metrics alive, so their addresses aren't reused while it is on the pool
+- (NSString *)_poolKey
+{
+    return [NSString stringWithFormat:@"%ld|%f|%p|%p|%lu",
+            (long)self.retryAttempts,
+            self.retryDelay,
+            self.logger,
+            self.metrics,
+            (unsigned long)self.requestCompressionThreshold];
+}
+
+@end
+
+@interface FWTRequesterPoolEntry : NSObject
+
+@property (nonatomic, strong) FWTRequesterManager *requesterManager;
+@property (nonatomic, copy, nullable) NSString *groupId;
+@property (nonatomic, assign) NSTimeInterval lastUse;
+
+@end
+
+@implementation FWTRequesterPoolEntry
+@end
+
+@interface FWTRequesterPool ()
+
+@property (nonatomic, strong) NSMutableDictionary<NSString *, FWTRequesterPoolEntry *> *entries;
+
+@end
+
+@implementation FWTRequesterPool
+
++ (instancetype)sharedPool
+{
+    static FWTRequesterPool *sharedPool;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedPool = [[FWTRequesterPool alloc] init];
+    });
+    return sharedPool;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self->_idleTimeout = FWTRequesterPoolDefaultIdleTimeout;
+        self->_entries = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (NSUInteger)count
+{
+    @synchronized(self) {
+        return self.entries.count;
+    }
+}
+
+- (FWTRequesterManager *)requesterManagerForConfiguration:(FWTServerConfiguration *)configuration
+                                                  groupId:(NSString *)groupId
+                                                  session:(NSURLSession *)session
+                                                 settings:(FWTRequesterSettings *)settings
+                                                  builder:(FWTRequesterPoolBuilder)builder
+{
+    settings = [settings copy] ?: [[FWTRequesterSettings alloc] init];
+    NSString *key = [self _keyForConfiguration:configuration groupId:groupId session:session settings:settings];
+    NSTimeInterval now = [[NSProcessInfo processInfo] systemUptime];
+
+    @synchronized(self) {
+        [self _evictIdleEntriesAt:now];
+
+        FWTRequesterPoolEntry *entry = self.entries[key];
+        if (entry == nil) {
+            entry = [[FWTRequesterPoolEntry alloc] init];
+            entry.requesterManager = builder();
+            [settings applyToRequesterManager:entry.requesterManager];
+            entry.groupId = groupId;
+            self.entries[key] = entry;
+        }
+        entry.lastUse = now;
+        return entry.requesterManager;
+    }
+}
+
+- (void)removeRequesterManagersForGroupId:(NSString *)groupId
+{
+    @synchronized(self) {
+        NSSet<NSString *> *keys = [self.entries keysOfEntriesPassingTest:^BOOL(NSString *key, FWTRequesterPoolEntry *entry, BOOL *stop) {
+            return entry.groupId == groupId || [entry.groupId isEqualToString:groupId];
+        }];
+        [self.entries removeObjectsForKeys:keys.allObjects];
+    }
+}
+
+- (void)removeAllRequesterManagers
+{
+    @synchronized(self) {
+        [self.entries removeAllObjects];
+    }
+}
+
+#pragma mark - Private
+
+- (NSString *)_keyForConfiguration:(FWTServerConfiguration *)configuration
+                           groupId:(NSString *)groupId
+                           session:(NSURLSession *)session
+                          settings:(FWTRequesterSettings *)settings
+{
+    return [NSString stringWithFormat:@"%@|%@|%ld|%@|%p|%@",
+            configuration.serverURL.absoluteString,
+            [self _digestOfConfiguration:configuration],
+            (long)configuration.signature,
+            groupId.length > 0 ? groupId : FWTRequesterPoolAppGroup,
+            session,
+            [settings _poolKey]];
+}
+
+// The credentials are kept out of the key, only their digest tells the configurations apart
+- (NSString *)_digestOfConfiguration:(FWTServerConfiguration *)configuration
+{
+    if (configuration == nil) {
+        return @"";
+    }
+    NSString *credentials = [NSString stringWithFormat:@"%lu:%@%lu:%@",
+                             (unsigned long)configuration.serverAccessId.length, configuration.serverAccessId ?: @"",
+                             (unsigned long)configuration.serverSecretKey.length, configuration.serverSecretKey ?: @""];
+    NSData *data = [credentials dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(data.bytes, (CC_LONG)data.length, digest);
+
+    NSMutableString *hex = [[NSMutableString alloc] initWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+    for (NSUInteger index = 0; index < CC_SHA256_DIGEST_LENGTH; index++) {
+        [hex appendFormat:@"%02x", digest[index]];
+    }
+    return hex;
+}
+
+// The operations only keep weak references to their manager, so managers with retries waiting are kept
+- (void)_evictIdleEntriesAt:(NSTimeInterval)now
+{
+    NSTimeInterval idleTimeout = self.idleTimeout;
+    NSSet<NSString *> *keys = [self.entries keysOfEntriesPassingTest:^BOOL(NSString *key, FWTRequesterPoolEntry *entry, BOOL *stop) {
+        FWTRetryScheduler *retryScheduler = entry.requesterManager.retryScheduler;
+        BOOL busy = retryScheduler.pendingRetries > 0 || retryScheduler.inFlightRetries > 0;
+        return !busy && now - entry.lastUse > idleTimeout;
+    }];
+    if (keys.count > 0) {
+        [self.entries removeObjectsForKeys:keys.allObjects];
+    }
+}
+
+@end
@@ -0,0 +1,55 @@
+//
+//  FWTRetryScheduler.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** Block performing a retry. It must call the completion block once the retried request finishes. */
+typedef void (^FWTRetryOperation)(dispatch_block_t completion);
+
+/**
+ Schedules the retries of failed requests using exponential backoff with full jitter,
+ so the devices affected by the same server failure don't retry at the same time.
+ 
+ The delay of a retry is a random value between zero and `baseDelay * 2^retry`, limited by `maxDelay`.
+ When the server provides a `Retry-After` value, it is respected instead.
+ */
+@interface FWTRetryScheduler : NSObject
+
+/** Delay used as base for the exponential backoff */
+@property (atomic, assign) NSTimeInterval baseDelay;
+/** Max delay between two attempts */
+@property (atomic, assign) NSTimeInterval maxDelay;
+/** Retries waiting for their delay to expire */
+@property (atomic, assign, readonly) NSUInteger pendingRetries;
+/** Retries that were fired and didn't finish yet */
+@property (atomic, assign, readonly) NSUInteger inFlightRetries;
+
+- (instancetype)init;
+- (instancetype)initWithBaseDelay:(NSTimeInterval)baseDelay
+                         maxDelay:(NSTimeInterval)maxDelay NS_DESIGNATED_INITIALIZER;
+
+/**
+ Delay that will be applied to a retry.
+ 
+ @param retry Zero based index of the retry.
+ @param error Error that caused the retry. Used to read the `Retry-After` value.
+ */
+- (NSTimeInterval)delayForRetry:(NSUInteger)retry error:(NSError * _Nullable)error;
+
+/**
+ Schedule the operation on the scheduler background queue, with a delay given by delayForRetry:error:.
+ 
+ @param operation Block performing the retry.
+ @param delay     Delay before the operation starts.
+ @return Block that cancels the retry, if it didn't start yet.
+ */
+- (dispatch_block_t)scheduleOperation:(FWTRetryOperation)operation afterDelay:(NSTimeInterval)delay;
+
+@end
+
+NS_ASSUME_NONNULL_END
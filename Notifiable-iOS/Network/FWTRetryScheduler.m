@@ -0,0 +1,116 @@
+//
+//  FWTRetryScheduler.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTRetryScheduler.h"
+#import "FWTHTTPSessionManager.h"
+
+NSString * const FWTRetrySchedulerQueue = @"com.futureworkshops.notifiable.FWTRetryScheduler";
+
+/** State of a scheduled retry, also used as its lock */
+@interface FWTScheduledRetry : NSObject
+
+@property (nonatomic, assign) BOOL started;
+@property (nonatomic, assign) BOOL cancelled;
+@property (nonatomic, assign) BOOL finished;
+
+@end
+
+@implementation FWTScheduledRetry
+@end
+
+@interface FWTRetryScheduler ()
+
+@property (atomic, assign, readwrite) NSUInteger pendingRetries;
+@property (atomic, assign, readwrite) NSUInteger inFlightRetries;
+@property (nonatomic, strong) dispatch_queue_t queue;
+
+@end
+
+@implementation FWTRetryScheduler
+
+- (instancetype)init
+{
+    return [self initWithBaseDelay:60 maxDelay:900];
+}
+
+- (instancetype)initWithBaseDelay:(NSTimeInterval)baseDelay maxDelay:(NSTimeInterval)maxDelay
+{
+    self = [super init];
+    if (self) {
+        self->_baseDelay = baseDelay;
+        self->_maxDelay = maxDelay;
+        self->_queue = dispatch_queue_create([FWTRetrySchedulerQueue UTF8String], DISPATCH_QUEUE_CONCURRENT);
+        dispatch_set_target_queue(self->_queue, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+    }
+    return self;
+}
+
+- (NSTimeInterval)delayForRetry:(NSUInteger)retry error:(NSError *)error
+{
+    NSTimeInterval maxDelay = MAX(self.maxDelay, 0);
+    
+    NSNumber *retryAfter = error.userInfo[FWTHTTPRetryAfterErrorKey];
+    if ([retryAfter isKindOfClass:[NSNumber class]] && [retryAfter doubleValue] > 0) {
+        return MIN([retryAfter doubleValue], maxDelay);
+    }
+    
+    NSTimeInterval ceiling = MIN(MAX(self.baseDelay, 0) * pow(2, MIN(retry, 32)), maxDelay);
+    double random = (double)arc4random() / (double)UINT32_MAX;
+    return ceiling * random;
+}
+
+- (dispatch_block_t)scheduleOperation:(FWTRetryOperation)operation afterDelay:(NSTimeInterval)delay
+{
+    [self _updateCountersWithPending:1 inFlight:0];
+    
+    // Updated under the lock of the retry, so the operation either starts or is cancelled, never both.
+    // The blocks keep the retry alive, the scheduler may be gone by the time they run.
+    FWTScheduledRetry *retry = [[FWTScheduledRetry alloc] init];
+    
+    __weak typeof(self) weakSelf = self;
+    dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC));
+    dispatch_after(popTime, self.queue, ^{
+        @synchronized(retry) {
+            if (retry.cancelled) {
+                return;
+            }
+            retry.started = YES;
+        }
+        [weakSelf _updateCountersWithPending:-1 inFlight:1];
+        
+        operation(^{
+            @synchronized(retry) {
+                if (retry.finished) {
+                    return;
+                }
+                retry.finished = YES;
+            }
+            [weakSelf _updateCountersWithPending:0 inFlight:-1];
+        });
+    });
+    
+    return ^{
+        @synchronized(retry) {
+            if (retry.started || retry.cancelled) {
+                return;
+            }
+            retry.cancelled = YES;
+        }
+        [weakSelf _updateCountersWithPending:-1 inFlight:0];
+    };
+}
+
+#pragma mark - Private
+
+- (void)_updateCountersWithPending:(NSInteger)pending inFlight:(NSInteger)inFlight
+{
+    @synchronized(self) {
+        self.pendingRetries = (NSUInteger)MAX((NSInteger)self.pendingRetries + pending, 0);
+        self.inFlightRetries = (NSUInteger)MAX((NSInteger)self.inFlightRetries + inFlight, 0);
+    }
+}
+
+@end
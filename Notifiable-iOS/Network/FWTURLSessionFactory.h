@@ -0,0 +1,42 @@
+//
+//  FWTURLSessionFactory.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void (^FWTURLSessionMetricsHandler)(NSURLSessionTask *task, NSURLSessionTaskMetrics *metrics);
+
+/**
+ Session owned by the SDK, used when the app doesn't provide one.
+
+ The session is ephemeral, doesn't cache responses or store cookies, and keeps a small number of
+ connections per host, so the requests reuse the same keep-alive (or HTTP/2) connection instead of
+ competing with the app traffic on the shared session.
+ */
+@interface FWTURLSessionFactory : NSObject
+
+/** Session shared by all the managers and the static receipt methods */
+@property (class, nonatomic, strong, readonly) NSURLSession *sharedSession;
+
+/** Called, on a background queue, with the metrics of each task of the shared session */
+@property (class, nonatomic, copy, nullable) FWTURLSessionMetricsHandler metricsHandler;
+
+/** Configuration used by the shared session */
++ (NSURLSessionConfiguration *)sessionConfiguration;
+
+/**
+ Open the connection to the server ahead of the first request, with a `HEAD` request to the URL.
+ Each host is only warmed once per session.
+
+ @param session Session that will perform the requests.
+ @param url     Server URL. Nothing is done if nil.
+ */
++ (void)prewarmSession:(NSURLSession *)session withURL:(NSURL * _Nullable)url;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,109 @@
+//
+//  FWTURLSessionFactory.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTURLSessionFactory.h"
+#import <Security/SecureTransport.h>
+
+NSString * const FWTURLSessionDelegateQueue = @"com.futureworkshops.notifiable.FWTURLSessionFactory";
+
+// HTTP/2 multiplexes the requests on one connection, the second one covers HTTP/1.1 servers
+static NSInteger const FWTURLSessionMaximumConnectionsPerHost = 2;
+static NSTimeInterval const FWTURLSessionPrewarmTimeout = 10;
+
+static FWTURLSessionMetricsHandler metricsHandler;
+static NSMutableSet<NSString *> *prewarmedHosts;
+
+@interface FWTURLSessionFactory () <NSURLSessionTaskDelegate>
+
+@end
+
+@implementation FWTURLSessionFactory
+
++ (NSURLSession *)sharedSession
+{
+    static NSURLSession *sharedSession;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSOperationQueue *delegateQueue = [[NSOperationQueue alloc] init];
+        delegateQueue.name = FWTURLSessionDelegateQueue;
+        delegateQueue.maxConcurrentOperationCount = 1;
+        sharedSession = [NSURLSession sessionWithConfiguration:[self sessionConfiguration]
+                                                      delegate:[[FWTURLSessionFactory alloc] init]
+                                                 delegateQueue:delegateQueue];
+    });
+    return sharedSession;
+}
+
++ (FWTURLSessionMetricsHandler)metricsHandler
+{
+    @synchronized(self) {
+        return metricsHandler;
+    }
+}
+
++ (void)setMetricsHandler:(FWTURLSessionMetricsHandler)handler
+{
+    @synchronized(self) {
+        metricsHandler = [handler copy];
+    }
+}
+
++ (NSURLSessionConfiguration *)sessionConfiguration
+{
+    NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+    configuration.HTTPMaximumConnectionsPerHost = FWTURLSessionMaximumConnectionsPerHost;
+    configuration.HTTPShouldUsePipelining = YES;
+    configuration.HTTPShouldSetCookies = NO;
+    configuration.HTTPCookieAcceptPolicy = NSHTTPCookieAcceptPolicyNever;
+    configuration.URLCache = nil;
+    configuration.requestCachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+    // HTTP/2 is negotiated through ALPN, which needs TLS 1.2
+    configuration.TLSMinimumSupportedProtocol = kTLSProtocol12;
+    return configuration;
+}
+
++ (void)prewarmSession:(NSURLSession *)session withURL:(NSURL *)url
+{
+    if (url.host.length == 0) {
+        return;
+    }
+
+    NSString *key = [NSString stringWithFormat:@"%p|%@|%@", session, url.scheme, url.host];
+    @synchronized(self) {
+        if (prewarmedHosts == nil) {
+            prewarmedHosts = [[NSMutableSet alloc] init];
+        }
+        if ([prewarmedHosts containsObject:key]) {
+            return;
+        }
+        [prewarmedHosts addObject:key];
+    }
+
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:url
+                                                           cachePolicy:NSURLRequestReloadIgnoringLocalCacheData
+                                                       timeoutInterval:FWTURLSessionPrewarmTimeout];
+    request.HTTPMethod = @"HEAD";
+    [[session dataTaskWithRequest:request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+        if (error != nil) {
+            // Allow another attempt, the connection was not opened
+            @synchronized([FWTURLSessionFactory class]) {
+                [prewarmedHosts removeObject:key];
+            }
+        }
+    }] resume];
+}
+
+#pragma mark - NSURLSessionTaskDelegate
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didFinishCollectingMetrics:(NSURLSessionTaskMetrics *)metrics
+{
+    FWTURLSessionMetricsHandler handler = [FWTURLSessionFactory metricsHandler];
+    if (handler) {
+        handler(task, metrics);
+    }
+}
+
+@end
@@ -0,0 +1,23 @@
+//
+//  FWTHMACSHA1Signer.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "FWTRequestSigner.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `APIAuth` HMAC-SHA1 signature. The body is not part of the canonical string.
+ */
+@interface FWTHMACSHA1Signer : NSObject <FWTRequestSigner>
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithAccessId:(NSString *)accessId
+                       secretKey:(NSString *)secretKey NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
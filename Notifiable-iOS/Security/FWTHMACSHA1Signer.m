@@ -0,0 +1,49 @@
+//
+//  FWTHMACSHA1Signer.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTHMACSHA1Signer.h"
+#import "FWTHMACSigningContext.h"
+
+NSString * const FWTAuthFormat = @"APIAuth %@:%@";
+
+@interface FWTHMACSHA1Signer ()
+
+@property (nonatomic, strong) FWTHMACSigningContext *signingContext;
+@property (nonatomic, strong) NSString *accessId;
+
+@end
+
+@implementation FWTHMACSHA1Signer
+
+- (instancetype)initWithAccessId:(NSString *)accessId
+                       secretKey:(NSString *)secretKey
+{
+    self = [super init];
+    if (self) {
+        self->_accessId = accessId;
+        self->_signingContext = [[FWTHMACSigningContext alloc] initWithSecretKey:secretKey
+                                                                       algorithm:FWTHMACAlgorithmSHA1];
+    }
+    return self;
+}
+
+- (NSDictionary<NSString *,NSString *> *)headersForMethod:(NSString *)httpMethod
+                                                     path:(NSString *)path
+                                              contentType:(NSString *)contentType
+                                                     date:(NSDate *)date
+                                                     body:(NSData *)body
+{
+    NSString *timestampString = [self.signingContext dateStringForDate:date];
+    NSString *signature = [self.signingContext signatureForMethod:httpMethod
+                                                      contentType:contentType
+                                                             path:path
+                                                             date:timestampString];
+    
+    return @{FWTAuthHeader: [NSString stringWithFormat:FWTAuthFormat, self.accessId, signature],
+             FWTTimestampHeader: timestampString};
+}
+
+@end
@@ -0,0 +1,44 @@
+//
+//  FWTHMACSHA256Signer.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "FWTRequestSigner.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+extern NSString * const FWTContentMD5Header;
+extern NSString * const FWTContentSHA256Header;
+
+/**
+ Digest of the body that is added to the canonical string.
+ 
+ - FWTBodyDigestMD5: Sent on the `Content-MD5` header.
+ - FWTBodyDigestSHA256: Sent on the `X-Authorization-Content-SHA256` header.
+ */
+typedef NS_ENUM(NSInteger, FWTBodyDigest) {
+    FWTBodyDigestMD5,
+    FWTBodyDigestSHA256
+};
+
+/**
+ `APIAuth-HMAC-SHA256` signature. The digest of the body is sent as a header
+ and signed with the rest of the canonical string.
+ */
+@interface FWTHMACSHA256Signer : NSObject <FWTRequestSigner>
+
+@property (nonatomic, readonly, assign) FWTBodyDigest bodyDigest;
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithAccessId:(NSString *)accessId
+                       secretKey:(NSString *)secretKey
+                      bodyDigest:(FWTBodyDigest)bodyDigest NS_DESIGNATED_INITIALIZER;
+
+/** Base64 encoded digest of the data, hashed in place */
++ (NSString *)digestForBody:(NSData *)body withAlgorithm:(FWTBodyDigest)bodyDigest;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,88 @@
+//
+//  FWTHMACSHA256Signer.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTHMACSHA256Signer.h"
+#import "FWTHMACSigningContext.h"
+#import <CommonCrypto/CommonCrypto.h>
+
+NSString * const FWTSHA256AuthFormat = @"APIAuth-HMAC-SHA256 %@:%@";
+NSString * const FWTContentMD5Header = @"Content-MD5";
+NSString * const FWTContentSHA256Header = @"X-Authorization-Content-SHA256";
+
+@interface FWTHMACSHA256Signer ()
+
+@property (nonatomic, strong) FWTHMACSigningContext *signingContext;
+@property (nonatomic, strong) NSString *accessId;
+
+@end
+
+@implementation FWTHMACSHA256Signer
+
+- (instancetype)initWithAccessId:(NSString *)accessId
+                       secretKey:(NSString *)secretKey
+                      bodyDigest:(FWTBodyDigest)bodyDigest
+{
+    self = [super init];
+    if (self) {
+        self->_accessId = accessId;
+        self->_bodyDigest = bodyDigest;
+        self->_signingContext = [[FWTHMACSigningContext alloc] initWithSecretKey:secretKey
+                                                                       algorithm:FWTHMACAlgorithmSHA256];
+    }
+    return self;
+}
+
+- (NSDictionary<NSString *,NSString *> *)headersForMethod:(NSString *)httpMethod
+                                                     path:(NSString *)path
+                                              contentType:(NSString *)contentType
+                                                     date:(NSDate *)date
+                                                     body:(NSData *)body
+{
+    NSString *timestampString = [self.signingContext dateStringForDate:date];
+    NSString *contentHash = body.length > 0 ? [FWTHMACSHA256Signer digestForBody:body withAlgorithm:self.bodyDigest] : nil;
+    NSString *signature = [self.signingContext signatureForMethod:httpMethod
+                                                      contentType:contentType
+                                                      contentHash:contentHash
+                                                             path:path
+                                                             date:timestampString];
+    
+    NSMutableDictionary *headers = [[NSMutableDictionary alloc] initWithCapacity:3];
+    headers[FWTAuthHeader] = [NSString stringWithFormat:FWTSHA256AuthFormat, self.accessId, signature];
+    headers[FWTTimestampHeader] = timestampString;
+    if (contentHash) {
+        headers[self.bodyDigest == FWTBodyDigestMD5 ? FWTContentMD5Header : FWTContentSHA256Header] = contentHash;
+    }
+    return [headers copy];
+}
+
++ (NSString *)digestForBody:(NSData *)body withAlgorithm:(FWTBodyDigest)bodyDigest
+{
+    // The ranges are hashed where they are, so large or non contiguous bodies are not copied
+    if (bodyDigest == FWTBodyDigestMD5) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+        unsigned char digest[CC_MD5_DIGEST_LENGTH];
+        __block CC_MD5_CTX context;
+        CC_MD5_Init(&context);
+        [body enumerateByteRangesUsingBlock:^(const void * _Nonnull bytes, NSRange byteRange, BOOL * _Nonnull stop) {
+            CC_MD5_Update(&context, bytes, (CC_LONG)byteRange.length);
+        }];
+        CC_MD5_Final(digest, &context);
+#pragma clang diagnostic pop
+        return [FWTHMACSigningContext base64StringForBytes:digest length:CC_MD5_DIGEST_LENGTH];
+    }
+    
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    __block CC_SHA256_CTX context;
+    CC_SHA256_Init(&context);
+    [body enumerateByteRangesUsingBlock:^(const void * _Nonnull bytes, NSRange byteRange, BOOL * _Nonnull stop) {
+        CC_SHA256_Update(&context, bytes, (CC_LONG)byteRange.length);
+    }];
+    CC_SHA256_Final(digest, &context);
+    return [FWTHMACSigningContext base64StringForBytes:digest length:CC_SHA256_DIGEST_LENGTH];
+}
+
+@end
@@ -0,0 +1,67 @@
+//
+//  FWTHMACSigningContext.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, FWTHMACAlgorithm) {
+    FWTHMACAlgorithmSHA1,
+    FWTHMACAlgorithmSHA256
+};
+
+/**
+ Reusable HMAC signer for the API Auth canonical strings.
+ 
+ The inner and outer pads of the key are hashed once, when the context is created,
+ so every signature only hashes the message. The HTTP date is formatted once per second
+ and the canonical string is built on a reusable buffer. The context is thread safe.
+ */
+@interface FWTHMACSigningContext : NSObject
+
+@property (nonatomic, readonly, assign) FWTHMACAlgorithm algorithm;
+
+- (instancetype)init NS_UNAVAILABLE;
+/** HMAC-SHA1 context */
+- (instancetype)initWithSecretKey:(NSString *)secretKey;
+- (instancetype)initWithSecretKey:(NSString *)secretKey
+                        algorithm:(FWTHMACAlgorithm)algorithm NS_DESIGNATED_INITIALIZER;
+
+/**
+ HTTP date (RFC 1123) for the timestamp. The last formatted value is cached.
+ */
+- (NSString *)dateStringForDate:(NSDate *)date;
+
+/**
+ Base64 encoded HMAC of the canonical string `method,contentType,,/path,date`.
+ */
+- (NSString *)signatureForMethod:(NSString *)httpMethod
+                     contentType:(NSString *)contentType
+                            path:(NSString *)path
+                            date:(NSString *)date;
+
+/**
+ Base64 encoded HMAC of the canonical string `method,contentType,contentHash,/path,date`.
+ */
+- (NSString *)signatureForMethod:(NSString *)httpMethod
+                     contentType:(NSString *)contentType
+                     contentHash:(NSString * _Nullable)contentHash
+                            path:(NSString *)path
+                            date:(NSString *)date;
+
+/**
+ Base64 encoded HMAC of the bytes.
+ */
+- (NSString *)signatureForBytes:(const void *)bytes length:(size_t)length;
+
+/**
+ Base64 encoding of a digest, without the intermediate NSData.
+ */
++ (NSString *)base64StringForBytes:(const unsigned char *)bytes length:(size_t)length;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,229 @@
+//
+//  FWTHMACSigningContext.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTHMACSigningContext.h"
+#import <CommonCrypto/CommonCrypto.h>
+#include <time.h>
+
+static const char FWTBase64Table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char *FWTDayNames[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+static const char *FWTMonthNames[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+#define FWT_BASE64_LENGTH(length) ((((length) + 2) / 3) * 4)
+
+// SHA1 and SHA256 share the same block size
+#define FWT_HMAC_BLOCK_BYTES CC_SHA256_BLOCK_BYTES
+
+@interface FWTHMACSigningContext ()
+{
+    CC_SHA1_CTX _innerSHA1Context;
+    CC_SHA1_CTX _outerSHA1Context;
+    CC_SHA256_CTX _innerSHA256Context;
+    CC_SHA256_CTX _outerSHA256Context;
+}
+
+@property (nonatomic, strong) NSMutableData *canonicalBuffer;
+@property (nonatomic, assign) time_t cachedSeconds;
+@property (nonatomic, copy) NSString *cachedDateString;
+
+@end
+
+@implementation FWTHMACSigningContext
+
+- (instancetype)initWithSecretKey:(NSString *)secretKey
+{
+    return [self initWithSecretKey:secretKey algorithm:FWTHMACAlgorithmSHA1];
+}
+
+- (instancetype)initWithSecretKey:(NSString *)secretKey
+                        algorithm:(FWTHMACAlgorithm)algorithm
+{
+    self = [super init];
+    if (self) {
+        self->_algorithm = algorithm;
+        self->_canonicalBuffer = [[NSMutableData alloc] initWithCapacity:256];
+        self->_cachedSeconds = -1;
+        [self _prepareContextsWithKey:[secretKey dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    return self;
+}
+
+- (NSString *)dateStringForDate:(NSDate *)date
+{
+    time_t seconds = (time_t)floor([date timeIntervalSince1970]);
+    @synchronized(self) {
+        if (seconds == self.cachedSeconds && self.cachedDateString) {
+            return self.cachedDateString;
+        }
+        
+        struct tm components;
+        gmtime_r(&seconds, &components);
+        char buffer[32];
+        int length = snprintf(buffer, sizeof(buffer), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                              FWTDayNames[components.tm_wday],
+                              components.tm_mday,
+                              FWTMonthNames[components.tm_mon],
+                              components.tm_year + 1900,
+                              components.tm_hour,
+                              components.tm_min,
+                              components.tm_sec);
+        NSString *dateString = [[NSString alloc] initWithBytes:buffer
+                                                        length:(NSUInteger)MAX(length, 0)
+                                                      encoding:NSASCIIStringEncoding];
+        self.cachedSeconds = seconds;
+        self.cachedDateString = dateString;
+        return dateString;
+    }
+}
+
+- (NSString *)signatureForMethod:(NSString *)httpMethod
+                     contentType:(NSString *)contentType
+                            path:(NSString *)path
+                            date:(NSString *)date
+{
+    return [self signatureForMethod:httpMethod
+                        contentType:contentType
+                        contentHash:nil
+                               path:path
+                               date:date];
+}
+
+- (NSString *)signatureForMethod:(NSString *)httpMethod
+                     contentType:(NSString *)contentType
+                     contentHash:(NSString *)contentHash
+                            path:(NSString *)path
+                            date:(NSString *)date
+{
+    @synchronized(self) {
+        NSMutableData *buffer = self.canonicalBuffer;
+        [buffer setLength:0];
+        [self _appendString:httpMethod toBuffer:buffer];
+        [buffer appendBytes:"," length:1];
+        [self _appendString:contentType toBuffer:buffer];
+        [buffer appendBytes:"," length:1];
+        if (contentHash) {
+            [self _appendString:contentHash toBuffer:buffer];
+        }
+        [buffer appendBytes:",/" length:2];
+        [self _appendString:path toBuffer:buffer];
+        [buffer appendBytes:"," length:1];
+        [self _appendString:date toBuffer:buffer];
+        return [self signatureForBytes:buffer.bytes length:buffer.length];
+    }
+}
+
+- (NSString *)signatureForBytes:(const void *)bytes length:(size_t)length
+{
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    size_t digestLength;
+    
+    if (self.algorithm == FWTHMACAlgorithmSHA256) {
+        unsigned char innerDigest[CC_SHA256_DIGEST_LENGTH];
+        CC_SHA256_CTX context = self->_innerSHA256Context;
+        CC_SHA256_Update(&context, bytes, (CC_LONG)length);
+        CC_SHA256_Final(innerDigest, &context);
+        
+        context = self->_outerSHA256Context;
+        CC_SHA256_Update(&context, innerDigest, CC_SHA256_DIGEST_LENGTH);
+        CC_SHA256_Final(digest, &context);
+        digestLength = CC_SHA256_DIGEST_LENGTH;
+    } else {
+        unsigned char innerDigest[CC_SHA1_DIGEST_LENGTH];
+        CC_SHA1_CTX context = self->_innerSHA1Context;
+        CC_SHA1_Update(&context, bytes, (CC_LONG)length);
+        CC_SHA1_Final(innerDigest, &context);
+        
+        context = self->_outerSHA1Context;
+        CC_SHA1_Update(&context, innerDigest, CC_SHA1_DIGEST_LENGTH);
+        CC_SHA1_Final(digest, &context);
+        digestLength = CC_SHA1_DIGEST_LENGTH;
+    }
+    
+    return [FWTHMACSigningContext base64StringForBytes:digest length:digestLength];
+}
+
++ (NSString *)base64StringForBytes:(const unsigned char *)bytes length:(size_t)length
+{
+    // Digests are at most 64 bytes, so the encoded string fits on the stack
+    char encoded[FWT_BASE64_LENGTH(CC_SHA512_DIGEST_LENGTH)];
+    NSAssert(length <= CC_SHA512_DIGEST_LENGTH, @"Only digests can be encoded");
+    length = MIN(length, (size_t)CC_SHA512_DIGEST_LENGTH);
+    
+    size_t outputIndex = 0;
+    for (size_t index = 0; index < length; index += 3) {
+        uint32_t value = (uint32_t)bytes[index] << 16;
+        if (index + 1 < length) {
+            value |= (uint32_t)bytes[index + 1] << 8;
+        }
+        if (index + 2 < length) {
+            value |= bytes[index + 2];
+        }
+        encoded[outputIndex++] = FWTBase64Table[(value >> 18) & 0x3F];
+        encoded[outputIndex++] = FWTBase64Table[(value >> 12) & 0x3F];
+        encoded[outputIndex++] = index + 1 < length ? FWTBase64Table[(value >> 6) & 0x3F] : '=';
+        encoded[outputIndex++] = index + 2 < length ? FWTBase64Table[value & 0x3F] : '=';
+    }
+    return [[NSString alloc] initWithBytes:encoded length:outputIndex encoding:NSASCIIStringEncoding];
+}
+
+#pragma mark - Private
+
+- (void)_prepareContextsWithKey:(NSData *)key
+{
+    unsigned char block[FWT_HMAC_BLOCK_BYTES];
+    memset(block, 0, sizeof(block));
+    if (key.length > FWT_HMAC_BLOCK_BYTES) {
+        if (self.algorithm == FWTHMACAlgorithmSHA256) {
+            CC_SHA256(key.bytes, (CC_LONG)key.length, block);
+        } else {
+            CC_SHA1(key.bytes, (CC_LONG)key.length, block);
+        }
+    } else {
+        memcpy(block, key.bytes, key.length);
+    }
+    
+    unsigned char innerPad[FWT_HMAC_BLOCK_BYTES];
+    unsigned char outerPad[FWT_HMAC_BLOCK_BYTES];
+    for (NSUInteger index = 0; index < FWT_HMAC_BLOCK_BYTES; index++) {
+        innerPad[index] = block[index] ^ 0x36;
+        outerPad[index] = block[index] ^ 0x5c;
+    }
+    
+    if (self.algorithm == FWTHMACAlgorithmSHA256) {
+        CC_SHA256_Init(&self->_innerSHA256Context);
+        CC_SHA256_Update(&self->_innerSHA256Context, innerPad, FWT_HMAC_BLOCK_BYTES);
+        CC_SHA256_Init(&self->_outerSHA256Context);
+        CC_SHA256_Update(&self->_outerSHA256Context, outerPad, FWT_HMAC_BLOCK_BYTES);
+    } else {
+        CC_SHA1_Init(&self->_innerSHA1Context);
+        CC_SHA1_Update(&self->_innerSHA1Context, innerPad, FWT_HMAC_BLOCK_BYTES);
+        CC_SHA1_Init(&self->_outerSHA1Context);
+        CC_SHA1_Update(&self->_outerSHA1Context, outerPad, FWT_HMAC_BLOCK_BYTES);
+    }
+    
+    memset(block, 0, sizeof(block));
+    memset(innerPad, 0, sizeof(innerPad));
+    memset(outerPad, 0, sizeof(outerPad));
+}
+
+- (void)_appendString:(NSString *)string toBuffer:(NSMutableData *)buffer
+{
+    NSUInteger maxLength = [string maximumLengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    NSUInteger offset = buffer.length;
+    [buffer setLength:offset + maxLength];
+    
+    NSUInteger usedLength = 0;
+    [string getBytes:(char *)buffer.mutableBytes + offset
+           maxLength:maxLength
+          usedLength:&usedLength
+            encoding:NSUTF8StringEncoding
+             options:0
+               range:NSMakeRange(0, string.length)
+      remainingRange:NULL];
+    [buffer setLength:offset + usedLength];
+}
+
+@end
@@ -5,18 +5,32 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "FWTRequestSigner.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 @interface FWTNotifiableAuthenticator : NSObject
 
+@property (nonatomic, readonly, strong) id<FWTRequestSigner> signer;
+
 - (instancetype)init NS_UNAVAILABLE;
+/** Authenticator with the `APIAuth` HMAC-SHA1 signer */
 - (instancetype)initWithAccessId:(NSString *)accessId
-                    andSecretKey:(NSString *)secretKey NS_DESIGNATED_INITIALIZER;
+                    andSecretKey:(NSString *)secretKey;
+- (instancetype)initWithSigner:(id<FWTRequestSigner>)signer NS_DESIGNATED_INITIALIZER;
 
 - (NSDictionary *)authHeadersForPath:(NSString *)path
                           httpMethod:(NSString *)httpMethod
                           andHeaders:(NSDictionary <NSString *, NSString *>*)headers;
+
+/**
+ Authentication headers for a request with the serialized body, which is signed by the
+ signers that cover the content.
+ */
+- (NSDictionary *)authHeadersForPath:(NSString *)path
+                          httpMethod:(NSString *)httpMethod
+                             headers:(NSDictionary <NSString *, NSString *>*)headers
+                                body:(NSData * _Nullable)body;
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,36 @@
+//
+//  FWTRequestSigner.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+extern NSString * const FWTAuthHeader;
+extern NSString * const FWTTimestampHeader;
+
+/**
+ Algorithm that creates the authentication headers of a request.
+ */
+@protocol FWTRequestSigner <NSObject>
+
+/**
+ Authentication headers (`Authorization`, `Date` and, when the body is signed, its digest).
+ 
+ @param httpMethod  HTTP method of the request.
+ @param path        Path of the request, without the leading slash.
+ @param contentType Content type sent on the request.
+ @param date        Timestamp of the request.
+ @param body        Serialized body, as sent to the server. The data is read in place.
+ */
+- (NSDictionary<NSString *, NSString *> *)headersForMethod:(NSString *)httpMethod
+                                                      path:(NSString *)path
+                                               contentType:(NSString *)contentType
+                                                      date:(NSDate *)date
+                                                      body:(NSData * _Nullable)body;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -9,6 +9,7 @@
 #import <XCTest/XCTest.h>
 #import "FWTHTTPRequester.h"
 #import "FWTNotifiableAuthenticator.h"
+#import "FWTURLSessionFactory.h"
 
 NSString * const FWTTestServerURL = @"https://notifiable.futureworkshops.com";
 NSString * const FWTTestServerAccessId = @"9zzf-xy_nB8g58agSaw_";
@@ -18,6 +19,9 @@ NSString * const FWTToken = @"test";
 NSString * const FWTLocale = @"en";
 NSString * const FWTUser = @"test_user";
 
+// A request on a reused connection skips the DNS, TCP and TLS setup
+static NSTimeInterval const FWTReusedTimeToFirstByteBound = 1;
+
 @interface FWTRequestIntegrationTests : XCTestCase
 
 @property (nonatomic, strong) FWTHTTPRequester *requester;
@@ -45,6 +49,55 @@ NSString * const FWTUser = @"test_user";
     [super tearDown];
 }
 
+- (void) testTimeToFirstByteOnReusedConnection
+{
+    NSUInteger const requestCount = 5;
+    NSMutableArray<NSURLSessionTaskTransactionMetrics *> *transactions = [[NSMutableArray alloc] init];
+    FWTURLSessionFactory.metricsHandler = ^(NSURLSessionTask *task, NSURLSessionTaskMetrics *metrics) {
+        @synchronized(transactions) {
+            [transactions addObject:metrics.transactionMetrics.lastObject];
+        }
+    };
+    
+    NSURL *url = [NSURL URLWithString:FWTTestServerURL];
+    for (NSUInteger index = 0; index < requestCount; index++) {
+        XCTestExpectation *expectation = [self expectationWithDescription:@"Request"];
+        [[FWTURLSessionFactory.sharedSession dataTaskWithURL:url completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+            XCTAssertNil(error);
+            [expectation fulfill];
+        }] resume];
+        [self waitForExpectationsWithTimeout:10 handler:nil];
+    }
+    
+    // The metrics are delivered after the completion handler
+    XCTestExpectation *metricsExpectation = [self expectationWithDescription:@"Metrics"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [metricsExpectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    FWTURLSessionFactory.metricsHandler = nil;
+    
+    XCTAssertEqual(transactions.count, requestCount);
+    NSURLSessionTaskTransactionMetrics *first = transactions.firstObject;
+    NSTimeInterval firstTimeToFirstByte = [first.responseStartDate timeIntervalSinceDate:first.fetchStartDate];
+    NSTimeInterval reusedTimeToFirstByte = 0;
+    for (NSUInteger index = 1; index < transactions.count; index++) {
+        NSURLSessionTaskTransactionMetrics *transaction = transactions[index];
+        XCTAssertTrue(transaction.reusedConnection, @"Request %lu opened a new connection", (unsigned long)index);
+        NSTimeInterval timeToFirstByte = [transaction.responseStartDate timeIntervalSinceDate:transaction.fetchStartDate];
+        XCTAssertLessThan(timeToFirstByte, FWTReusedTimeToFirstByteBound, @"Request %lu was slow on the reused connection", (unsigned long)index);
+        reusedTimeToFirstByte += timeToFirstByte;
+    }
+    
+    NSDictionary *measures = @{@"first_ttfb_ms": @(firstTimeToFirstByte * 1000),
+                               @"first_protocol": first.networkProtocolName ?: @"unknown",
+                               @"reused_ttfb_average_ms": @(reusedTimeToFirstByte / MAX(transactions.count - 1, 1) * 1000)};
+    XCTAttachment *attachment = [XCTAttachment attachmentWithPlistObject:measures];
+    attachment.name = @"time_to_first_byte";
+    attachment.lifetime = XCTAttachmentLifetimeKeepAlways;
+    [self addAttachment:attachment];
+}
+
 - (void) testRegisterWithoutParameters
 {
 #pragma clang diagnostic push
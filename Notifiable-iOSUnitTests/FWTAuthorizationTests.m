@@ -8,6 +8,8 @@
 
 #import "FWTTestCase.h"
 #import "FWTNotifiableAuthenticator.h"
+#import "FWTHMACSHA1Signer.h"
+#import "FWTHMACSHA256Signer.h"
 #import <OCMock/OCMock.h>
 
 NSString * const FWTTestAccessId = @"access_id";
@@ -23,6 +25,10 @@ NSString * const FWTTestAuthResult = @"mirA07fJMiUDlMc0hmkUeqDdgSg=";
 
 NSString * const FWTTestDate = @"Thu, 21 Jan 2016 16:25:39 GMT";
 
+NSString * const FWTTestSignedPath = @"api/v1/notifications/1/delivered";
+NSString * const FWTTestSignedBody = @"{\"device_token_id\":\"42\"}";
+NSString * const FWTTestJSONContent = @"application/json; charset=utf-8";
+
 @interface FWTAuthorizationTests : FWTTestCase
 
 @property (nonatomic, strong) FWTNotifiableAuthenticator *authenticator;
@@ -69,4 +75,99 @@ NSString * const FWTTestDate = @"Thu, 21 Jan 2016 16:25:39 GMT";
     
 }
 
+- (void)testSHA1SignerIgnoresTheBody
+{
+    FWTHMACSHA1Signer *signer = [[FWTHMACSHA1Signer alloc] initWithAccessId:FWTTestAccessId secretKey:FWTTestSecretKey];
+    NSDictionary *headers = [signer headersForMethod:@"POST"
+                                                path:FWTTestSignedPath
+                                         contentType:FWTTestJSONContent
+                                                date:[NSDate dateWithTimeIntervalSince1970:FWTTestDateTimestamp]
+                                                body:[FWTTestSignedBody dataUsingEncoding:NSUTF8StringEncoding]];
+    
+    XCTAssertEqual(headers.count, 2);
+    XCTAssertEqualObjects(headers[@"Authorization"], @"APIAuth access_id:tn12gMfsOCQT73AJMSrwGbwbu/o=");
+    XCTAssertEqualObjects(headers[@"Date"], FWTTestDate);
+}
+
+- (void)testSHA256SignerWithContentMD5
+{
+    FWTHMACSHA256Signer *signer = [[FWTHMACSHA256Signer alloc] initWithAccessId:FWTTestAccessId
+                                                                      secretKey:FWTTestSecretKey
+                                                                     bodyDigest:FWTBodyDigestMD5];
+    NSDictionary *headers = [signer headersForMethod:@"POST"
+                                                path:FWTTestSignedPath
+                                         contentType:FWTTestJSONContent
+                                                date:[NSDate dateWithTimeIntervalSince1970:FWTTestDateTimestamp]
+                                                body:[FWTTestSignedBody dataUsingEncoding:NSUTF8StringEncoding]];
+    
+    XCTAssertEqual(headers.count, 3);
+    XCTAssertEqualObjects(headers[@"Authorization"], @"APIAuth-HMAC-SHA256 access_id:79ZJmR5qSpiixclgGHwk0rvspKBs6t9A8vKZKXLJ6TY=");
+    XCTAssertEqualObjects(headers[@"Content-MD5"], @"0thdlA1AUahaEFK1JpRmgA==");
+    XCTAssertEqualObjects(headers[@"Date"], FWTTestDate);
+}
+
+- (void)testSHA256SignerWithContentSHA256
+{
+    FWTHMACSHA256Signer *signer = [[FWTHMACSHA256Signer alloc] initWithAccessId:FWTTestAccessId
+                                                                      secretKey:FWTTestSecretKey
+                                                                     bodyDigest:FWTBodyDigestSHA256];
+    NSDictionary *headers = [signer headersForMethod:@"POST"
+                                                path:FWTTestSignedPath
+                                         contentType:FWTTestJSONContent
+                                                date:[NSDate dateWithTimeIntervalSince1970:FWTTestDateTimestamp]
+                                                body:[FWTTestSignedBody dataUsingEncoding:NSUTF8StringEncoding]];
+    
+    XCTAssertEqual(headers.count, 3);
+    XCTAssertEqualObjects(headers[@"Authorization"], @"APIAuth-HMAC-SHA256 access_id:yLnKYWQtVdQXvjrYSh9Osp6At54i3LeIWEDO9XihTVs=");
+    XCTAssertEqualObjects(headers[@"X-Authorization-Content-SHA256"], @"5lYY5VtoQN/c1jRc3cqDXSTVjdY3Kgu0HVjqmrqeV40=");
+    XCTAssertEqualObjects(headers[@"Date"], FWTTestDate);
+}
+
+- (void)testSHA256SignerWithoutBody
+{
+    FWTHMACSHA256Signer *signer = [[FWTHMACSHA256Signer alloc] initWithAccessId:FWTTestAccessId
+                                                                      secretKey:FWTTestSecretKey
+                                                                     bodyDigest:FWTBodyDigestSHA256];
+    NSDictionary *headers = [signer headersForMethod:@"GET"
+                                                path:@"api/v1/device_tokens.json"
+                                         contentType:FWTTestJSONContent
+                                                date:[NSDate dateWithTimeIntervalSince1970:FWTTestDateTimestamp]
+                                                body:nil];
+    
+    XCTAssertEqual(headers.count, 2);
+    XCTAssertEqualObjects(headers[@"Authorization"], @"APIAuth-HMAC-SHA256 access_id:EJjHMkDrRDmem9LwQHMpjKhT+DvX2tUw02VUwh4CvvI=");
+}
+
+- (void)testBodyDigestOfDiscontiguousData
+{
+    NSData *body = [FWTTestSignedBody dataUsingEncoding:NSUTF8StringEncoding];
+    dispatch_data_t head = dispatch_data_create(body.bytes, 10, NULL, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+    dispatch_data_t tail = dispatch_data_create((const char *)body.bytes + 10, body.length - 10, NULL, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+    NSData *discontiguousBody = (NSData *)dispatch_data_create_concat(head, tail);
+    
+    XCTAssertEqualObjects([FWTHMACSHA256Signer digestForBody:discontiguousBody withAlgorithm:FWTBodyDigestSHA256], @"5lYY5VtoQN/c1jRc3cqDXSTVjdY3Kgu0HVjqmrqeV40=");
+    XCTAssertEqualObjects([FWTHMACSHA256Signer digestForBody:discontiguousBody withAlgorithm:FWTBodyDigestMD5], @"0thdlA1AUahaEFK1JpRmgA==");
+}
+
+- (void)testAuthenticatorSignsTheBody
+{
+    id mock = OCMClassMock([NSDate class]);
+    OCMStub([mock date]).andReturn([NSDate dateWithTimeIntervalSince1970:FWTTestDateTimestamp]);
+    
+    FWTHMACSHA256Signer *signer = [[FWTHMACSHA256Signer alloc] initWithAccessId:FWTTestAccessId
+                                                                      secretKey:FWTTestSecretKey
+                                                                     bodyDigest:FWTBodyDigestMD5];
+    FWTNotifiableAuthenticator *authenticator = [[FWTNotifiableAuthenticator alloc] initWithSigner:signer];
+    NSDictionary *headers = [authenticator authHeadersForPath:FWTTestSignedPath
+                                                   httpMethod:@"POST"
+                                                      headers:@{}
+                                                         body:[FWTTestSignedBody dataUsingEncoding:NSUTF8StringEncoding]];
+    
+    XCTAssertEqual(headers.count, 4);
+    XCTAssertEqualObjects(headers[@"Authorization"], @"APIAuth-HMAC-SHA256 access_id:79ZJmR5qSpiixclgGHwk0rvspKBs6t9A8vKZKXLJ6TY=");
+    XCTAssertEqualObjects(headers[@"Content-Type"], FWTTestJSONContent);
+    
+    [mock stopMocking];
+}
+
 @end
@@ -0,0 +1,250 @@
+//
+//  FWTBackgroundUploadTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTStubURLProtocol.h"
+#import <OCMock/OCMock.h>
+#import "FWTHTTPSessionManager.h"
+#import "FWTHTTPRequester.h"
+#import "FWTBackgroundUploadTransport.h"
+#import "FWTNotifiableAuthenticator.h"
+#import "FWTNotifiableManager.h"
+#import "NSData+FWTNotifiable.h"
+
+@interface FWTNotifiableManager (Private)
+
++ (void)reconcileUploadsOfTransport:(FWTBackgroundUploadTransport *)transport;
++ (void)drainOutboxWithGroupId:(NSString *)groupId andSession:(NSURLSession *)session;
+
+@end
+
+/**
+ Transport that records the requests and answers them with a fixed status code, without a network.
+ */
+@interface FWTStandInTransport : NSObject <FWTHTTPTransport>
+
+@property (nonatomic, strong) NSMutableArray<NSURLRequest *> *requests;
+@property (nonatomic, assign) NSInteger statusCode;
+
+@end
+
+@implementation FWTStandInTransport
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self->_requests = [[NSMutableArray alloc] init];
+        self->_statusCode = 200;
+    }
+    return self;
+}
+
+- (NSURLSessionTask *)sendRequest:(NSURLRequest *)request completionHandler:(FWTHTTPTransportCompletionHandler)handler
+{
+    @synchronized(self) {
+        [self.requests addObject:request];
+    }
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:request.URL
+                                                              statusCode:self.statusCode
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:@{}];
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        handler([@"{}" dataUsingEncoding:NSUTF8StringEncoding], response, nil);
+    });
+    return nil;
+}
+
+@end
+
+@interface FWTBackgroundUploadTests : FWTTestCase
+
+@property (nonatomic, strong) FWTStandInTransport *transport;
+@property (nonatomic, strong) FWTStandInTransport *backgroundTransport;
+@property (nonatomic, strong) NSURL *directory;
+
+@end
+
+@implementation FWTBackgroundUploadTests
+
+- (void)setUp
+{
+    [super setUp];
+    [FWTStubURLProtocol reset];
+    self.transport = [[FWTStandInTransport alloc] init];
+    self.backgroundTransport = [[FWTStandInTransport alloc] init];
+    self.directory = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString] isDirectory:YES];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:self.directory error:nil];
+    [FWTStubURLProtocol reset];
+    [super tearDown];
+}
+
+- (void)testBackgroundPOSTUsesTheBackgroundTransport
+{
+    FWTHTTPSessionManager *sessionManager = [[FWTHTTPSessionManager alloc] initWithBaseURL:[NSURL URLWithString:@"https://notifiable.test"]
+                                                                                   session:[NSURLSession sharedSession]];
+    sessionManager.transport = self.transport;
+    sessionManager.backgroundTransport = self.backgroundTransport;
+
+    XCTestExpectation *post = [self expectationWithDescription:@"POST"];
+    XCTestExpectation *backgroundPost = [self expectationWithDescription:@"Background POST"];
+    [sessionManager POST:@"api/v1/device_tokens" parameters:@{@"name": @"iPhone"} success:^(id responseObject) {
+        [post fulfill];
+    } failure:nil];
+    [sessionManager backgroundPOST:@"api/v1/notifications/1/opened" parameters:@{@"device_token_id": @"42"} success:^(id responseObject) {
+        [backgroundPost fulfill];
+    } failure:nil];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+
+    XCTAssertEqual(self.transport.requests.count, 1);
+    XCTAssertEqual(self.backgroundTransport.requests.count, 1);
+    NSURLRequest *request = self.backgroundTransport.requests.firstObject;
+    XCTAssertEqualObjects(request.URL.path, @"/api/v1/notifications/1/opened");
+    XCTAssertEqualObjects(request.HTTPMethod, @"POST");
+    XCTAssertGreaterThan(request.HTTPBody.length, 0);
+}
+
+- (void)testBackgroundPOSTWithoutBackgroundTransport
+{
+    FWTHTTPSessionManager *sessionManager = [[FWTHTTPSessionManager alloc] initWithBaseURL:[NSURL URLWithString:@"https://notifiable.test"]
+                                                                                   session:[NSURLSession sharedSession]];
+    sessionManager.transport = self.transport;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Background POST"];
+    [sessionManager backgroundPOST:@"api/v1/notifications/1/opened" parameters:@{} success:^(id responseObject) {
+        [expectation fulfill];
+    } failure:nil];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+
+    XCTAssertEqual(self.transport.requests.count, 1);
+}
+
+- (void)testReceiptsAreSentThroughTheBackgroundTransport
+{
+    FWTHTTPRequester *requester = [[FWTHTTPRequester alloc] initWithBaseURL:[NSURL URLWithString:@"https://notifiable.test"]
+                                                                    session:[NSURLSession sharedSession]
+                                                           andAuthenticator:OCMClassMock([FWTNotifiableAuthenticator class])];
+    requester.backgroundTransport = self.backgroundTransport;
+
+    XCTestExpectation *opened = [self expectationWithDescription:@"Opened"];
+    XCTestExpectation *received = [self expectationWithDescription:@"Received"];
+    [requester markNotificationAsOpenedWithId:@"1" deviceTokenId:@"42" user:@"user" success:^(NSDictionary *response) {
+        [opened fulfill];
+    } failure:^(NSInteger responseCode, NSError *error) {
+        XCTFail(@"%@", error);
+    }];
+    [requester markNotificationsAsReceivedWithIds:@[@"2", @"3"] deviceTokenId:@"42" success:^(NSDictionary *response) {
+        [received fulfill];
+    } failure:^(NSInteger responseCode, NSError *error) {
+        XCTFail(@"%@", error);
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+
+    XCTAssertEqual(self.backgroundTransport.requests.count, 2);
+}
+
+- (void)testNotificationIdsOfReceiptRequests
+{
+    BOOL opened = NO;
+    NSURLRequest *request = [NSURLRequest requestWithURL:[NSURL URLWithString:@"https://notifiable.test/api/v1/notifications/12/opened"]];
+    XCTAssertEqualObjects([FWTHTTPRequester notificationIdsOfReceiptRequest:request body:nil opened:&opened], @[@12]);
+    XCTAssertTrue(opened);
+
+    request = [NSURLRequest requestWithURL:[NSURL URLWithString:@"https://notifiable.test/api/v1/notifications/13/delivered"]];
+    XCTAssertEqualObjects([FWTHTTPRequester notificationIdsOfReceiptRequest:request body:nil opened:&opened], @[@13]);
+    XCTAssertFalse(opened);
+
+    request = [NSURLRequest requestWithURL:[NSURL URLWithString:@"https://notifiable.test/api/v1/notifications/delivered"]];
+    NSData *body = [NSJSONSerialization dataWithJSONObject:@{@"device_token_id": @"42", @"notification_ids": @[@"14", @"15"]} options:0 error:nil];
+    XCTAssertEqualObjects([FWTHTTPRequester notificationIdsOfReceiptRequest:request body:body opened:&opened], (@[@14, @15]));
+    XCTAssertFalse(opened);
+
+    request = [NSURLRequest requestWithURL:[NSURL URLWithString:@"https://notifiable.test/api/v1/device_tokens/42"]];
+    XCTAssertNil([FWTHTTPRequester notificationIdsOfReceiptRequest:request body:nil opened:&opened]);
+}
+
+- (void)testNotificationIdsOfCompressedBulkReceipt
+{
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:[NSURL URLWithString:@"https://notifiable.test/api/v1/notifications/delivered"]];
+    [request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+    NSData *body = [NSJSONSerialization dataWithJSONObject:@{@"device_token_id": @"42", @"notification_ids": @[@"16", @"17"]} options:0 error:nil];
+    BOOL opened = YES;
+    XCTAssertEqualObjects([FWTHTTPRequester notificationIdsOfReceiptRequest:request body:[body fwt_gzipCompressedData] opened:&opened], (@[@16, @17]));
+    XCTAssertFalse(opened);
+}
+
+- (void)testSessionIdentifierIsOwnedByTheProcess
+{
+    NSString *bundleIdentifier = [NSBundle mainBundle].bundleIdentifier ?: [NSProcessInfo processInfo].processName;
+    FWTBackgroundUploadTransport *transport = [FWTBackgroundUploadTransport transportWithGroupId:@"group.com.futureworkshops.tests"];
+    NSString *expected = [NSString stringWithFormat:@"com.futureworkshops.notifiable.background.%@.group.com.futureworkshops.tests", bundleIdentifier];
+    XCTAssertEqualObjects(transport.identifier, expected);
+    XCTAssertEqual([FWTBackgroundUploadTransport transportWithSessionIdentifier:expected], transport);
+    XCTAssertNil([FWTBackgroundUploadTransport transportWithSessionIdentifier:@"com.futureworkshops.notifiable.background.com.other.extension.group.com.futureworkshops.tests"]);
+}
+
+- (void)testIdenticalUploadsAreCoalesced
+{
+    // The uploads are answered after a short delay, so the duplicates can join them
+    [FWTStubURLProtocol setResponseBlock:^FWTStubResponse *(NSURLRequest *request) {
+        FWTStubResponse *response = [FWTStubResponse responseWithStatusCode:200 body:[@"{}" dataUsingEncoding:NSUTF8StringEncoding]];
+        response.delay = 0.2;
+        return response;
+    }];
+    NSURLSessionConfiguration *configuration = [FWTStubURLProtocol stubbedConfiguration:[NSURLSessionConfiguration ephemeralSessionConfiguration]];
+    FWTBackgroundUploadTransport *transport = [[FWTBackgroundUploadTransport alloc] initWithIdentifier:@"com.futureworkshops.notifiable.tests"
+                                                                                             directory:self.directory
+                                                                                  sessionConfiguration:configuration];
+
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:[NSURL URLWithString:@"https://notifiable.test/api/v1/notifications/1/opened"]];
+    request.HTTPMethod = @"POST";
+    request.HTTPBody = [@"{\"device_token_id\":\"42\"}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableURLRequest *otherRequest = [request mutableCopy];
+    otherRequest.HTTPBody = [@"{\"device_token_id\":\"43\"}" dataUsingEncoding:NSUTF8StringEncoding];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Uploads"];
+    expectation.expectedFulfillmentCount = 3;
+    FWTHTTPTransportCompletionHandler handler = ^(NSData *data, NSURLResponse *response, NSError *error) {
+        XCTAssertNil(error);
+        XCTAssertEqual(((NSHTTPURLResponse *)response).statusCode, 200);
+        XCTAssertEqualObjects(data, [@"{}" dataUsingEncoding:NSUTF8StringEncoding]);
+        [expectation fulfill];
+    };
+    [transport sendRequest:request completionHandler:handler];
+    [transport sendRequest:[request copy] completionHandler:handler];
+    [transport sendRequest:otherRequest completionHandler:handler];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual(FWTStubURLProtocol.recordedRequests.count, 2);
+    NSArray *files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.directory.path error:nil];
+    XCTAssertEqual(files.count, 0);
+}
+
+- (void)testRejectedSignatureDrainsTheOutbox
+{
+    FWTBackgroundUploadTransport *transport = [[FWTBackgroundUploadTransport alloc] initWithIdentifier:@"com.futureworkshops.notifiable.tests"
+                                                                                             directory:self.directory
+                                                                                  sessionConfiguration:[NSURLSessionConfiguration ephemeralSessionConfiguration]];
+    id managerMock = OCMClassMock([FWTNotifiableManager class]);
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Drain"];
+    OCMStub([managerMock drainOutboxWithGroupId:OCMOCK_ANY andSession:OCMOCK_ANY]).andDo(^(NSInvocation *invocation) {
+        [expectation fulfill];
+    });
+    [FWTNotifiableManager reconcileUploadsOfTransport:transport];
+
+    NSURLRequest *request = [NSURLRequest requestWithURL:[NSURL URLWithString:@"https://notifiable.test/api/v1/notifications/1/opened"]];
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:request.URL statusCode:401 HTTPVersion:@"HTTP/1.1" headerFields:@{}];
+    transport.reconciliationHandler(request, nil, response, nil);
+
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    [managerMock stopMocking];
+}
+
+@end
@@ -0,0 +1,142 @@
+//
+//  FWTCircuitBreakerTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTCircuitBreaker.h"
+
+NSString * const FWTCircuitBreakerTestsSuite = @"FWTCircuitBreakerTests";
+
+@interface FWTCircuitBreakerTests : FWTTestCase
+
+@property (nonatomic, strong) NSUserDefaults *userDefaults;
+@property (nonatomic, strong) FWTCircuitBreaker *breaker;
+
+@end
+
+@implementation FWTCircuitBreakerTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.userDefaults = [[NSUserDefaults alloc] initWithSuiteName:FWTCircuitBreakerTestsSuite];
+    self.breaker = [[FWTCircuitBreaker alloc] initWithHost:@"notifiable.test" userDefaults:self.userDefaults];
+    [self.breaker reset];
+}
+
+- (void)tearDown
+{
+    [self.breaker reset];
+    [self.userDefaults removePersistentDomainForName:FWTCircuitBreakerTestsSuite];
+    [super tearDown];
+}
+
+- (void)testOpensAfterConsecutiveFailures
+{
+    self.breaker.failureThreshold = 3;
+    for (NSInteger index = 0; index < 2; index++) {
+        [self.breaker recordFailureWithStatusCode:0];
+    }
+    XCTAssertEqual(self.breaker.state, FWTCircuitBreakerStateClosed);
+    XCTAssertTrue([self.breaker allowRequest]);
+    
+    [self.breaker recordFailureWithStatusCode:502];
+    XCTAssertEqual(self.breaker.state, FWTCircuitBreakerStateOpen);
+    XCTAssertFalse([self.breaker allowRequest]);
+}
+
+- (void)testSuccessResetsConsecutiveFailures
+{
+    self.breaker.failureThreshold = 3;
+    [self.breaker recordFailureWithStatusCode:500];
+    [self.breaker recordFailureWithStatusCode:500];
+    [self.breaker recordSuccess];
+    [self.breaker recordFailureWithStatusCode:500];
+    XCTAssertEqual(self.breaker.state, FWTCircuitBreakerStateClosed);
+}
+
+- (void)testOpensOnHighErrorRate
+{
+    self.breaker.failureThreshold = 100;
+    self.breaker.minimumRequests = 6;
+    self.breaker.errorRateThreshold = 0.5;
+    for (NSInteger index = 0; index < 3; index++) {
+        [self.breaker recordFailureWithStatusCode:503];
+        [self.breaker recordSuccess];
+    }
+    XCTAssertEqual(self.breaker.state, FWTCircuitBreakerStateClosed);
+    
+    [self.breaker recordFailureWithStatusCode:503];
+    XCTAssertEqual(self.breaker.state, FWTCircuitBreakerStateOpen);
+}
+
+- (void)testHalfOpenAllowsASingleProbe
+{
+    self.breaker.failureThreshold = 1;
+    self.breaker.openInterval = 0;
+    [self.breaker recordFailureWithStatusCode:0];
+    
+    self.breaker.openInterval = 60;
+    XCTAssertFalse([self.breaker allowRequest]);
+    
+    self.breaker.openInterval = 0;
+    XCTAssertTrue([self.breaker allowRequest]);
+    XCTAssertEqual(self.breaker.state, FWTCircuitBreakerStateHalfOpen);
+    
+    self.breaker.openInterval = 60;
+    XCTAssertFalse([self.breaker allowRequest]);
+    
+    [self.breaker recordSuccess];
+    XCTAssertEqual(self.breaker.state, FWTCircuitBreakerStateClosed);
+    XCTAssertTrue([self.breaker allowRequest]);
+}
+
+- (void)testFailedProbeOpensAgain
+{
+    self.breaker.failureThreshold = 1;
+    self.breaker.openInterval = 0;
+    [self.breaker recordFailureWithStatusCode:0];
+    XCTAssertTrue([self.breaker allowRequest]);
+    
+    [self.breaker recordFailureWithStatusCode:500];
+    self.breaker.openInterval = 60;
+    XCTAssertEqual(self.breaker.state, FWTCircuitBreakerStateOpen);
+    XCTAssertFalse([self.breaker allowRequest]);
+}
+
+- (void)testStateIsSharedThroughTheUserDefaults
+{
+    self.breaker.failureThreshold = 1;
+    [self.breaker recordFailureWithStatusCode:0];
+    
+    FWTCircuitBreaker *extensionBreaker = [[FWTCircuitBreaker alloc] initWithHost:@"notifiable.test" userDefaults:self.userDefaults];
+    XCTAssertEqual(extensionBreaker.state, FWTCircuitBreakerStateOpen);
+    XCTAssertFalse([extensionBreaker allowRequest]);
+    
+    FWTCircuitBreaker *otherHostBreaker = [[FWTCircuitBreaker alloc] initWithHost:@"other.test" userDefaults:self.userDefaults];
+    XCTAssertTrue([otherHostBreaker allowRequest]);
+}
+
+- (void)testBreakerIsSharedPerHost
+{
+    FWTCircuitBreaker *breaker = [FWTCircuitBreaker breakerWithHost:@"notifiable.test" groupId:nil];
+    XCTAssertEqual([FWTCircuitBreaker breakerWithHost:@"notifiable.test" groupId:nil], breaker);
+    XCTAssertNotEqual([FWTCircuitBreaker breakerWithHost:@"other.test" groupId:nil], breaker);
+}
+
+- (void)testConcurrentFailuresAreAllRecorded
+{
+    self.breaker.failureThreshold = 1000;
+    FWTCircuitBreaker *otherBreaker = [[FWTCircuitBreaker alloc] initWithHost:@"notifiable.test" userDefaults:self.userDefaults];
+    otherBreaker.failureThreshold = 1000;
+    dispatch_apply(100, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        [(index % 2 == 0 ? self.breaker : otherBreaker) recordFailureWithStatusCode:400];
+    });
+
+    NSDictionary *state = [self.userDefaults dictionaryForKey:@"FWTNotifiableCircuitBreaker.notifiable.test"];
+    XCTAssertEqualObjects(state[@"failures"], @100);
+}
+
+@end
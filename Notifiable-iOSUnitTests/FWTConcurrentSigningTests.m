@@ -0,0 +1,95 @@
+//
+//  FWTConcurrentSigningTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTStubURLProtocol.h"
+#import "FWTHTTPRequester.h"
+#import "FWTNotifiableAuthenticator.h"
+#import <CommonCrypto/CommonCrypto.h>
+
+static NSString * const FWTStressAccessId = @"access_id";
+static NSString * const FWTStressSecretKey = @"secret_key";
+static NSUInteger const FWTStressRequestCount = 2000;
+
+// The server answers 200 only when the request carries its own signature
+static BOOL FWTHasValidSignature(NSURLRequest *request)
+{
+    NSString *canonicalString = [NSString stringWithFormat:@"%@,%@,,%@,%@",
+                                 request.HTTPMethod,
+                                 [request valueForHTTPHeaderField:@"Content-Type"],
+                                 request.URL.path,
+                                 [request valueForHTTPHeaderField:@"Date"]];
+    
+    unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+    const char *key = [FWTStressSecretKey UTF8String];
+    const char *message = [canonicalString UTF8String];
+    CCHmac(kCCHmacAlgSHA1, key, strlen(key), message, strlen(message), digest);
+    NSString *signature = [[NSData dataWithBytes:digest length:sizeof(digest)] base64EncodedStringWithOptions:0];
+    
+    NSString *expected = [NSString stringWithFormat:@"APIAuth %@:%@", FWTStressAccessId, signature];
+    return [[request valueForHTTPHeaderField:@"Authorization"] isEqualToString:expected];
+}
+
+@interface FWTConcurrentSigningTests : FWTTestCase
+
+@property (nonatomic, strong) FWTHTTPRequester *requester;
+
+@end
+
+@implementation FWTConcurrentSigningTests
+
+- (void)setUp
+{
+    [super setUp];
+    [FWTStubURLProtocol reset];
+    [FWTStubURLProtocol setResponseBlock:^FWTStubResponse *(NSURLRequest *request) {
+        return [FWTStubResponse responseWithStatusCode:FWTHasValidSignature(request) ? 200 : 401
+                                                  body:[@"{}" dataUsingEncoding:NSUTF8StringEncoding]];
+    }];
+    NSURLSessionConfiguration *configuration = [FWTStubURLProtocol stubbedConfiguration:[NSURLSessionConfiguration ephemeralSessionConfiguration]];
+    configuration.HTTPMaximumConnectionsPerHost = 16;
+    
+    FWTNotifiableAuthenticator *authenticator = [[FWTNotifiableAuthenticator alloc] initWithAccessId:FWTStressAccessId
+                                                                                        andSecretKey:FWTStressSecretKey];
+    self.requester = [[FWTHTTPRequester alloc] initWithBaseURL:[NSURL URLWithString:@"http://localhost:3000"]
+                                                       session:[NSURLSession sessionWithConfiguration:configuration]
+                                              andAuthenticator:authenticator];
+}
+
+- (void)tearDown
+{
+    self.requester = nil;
+    [FWTStubURLProtocol reset];
+    [super tearDown];
+}
+
+- (void)testConcurrentRequestsAreSignedIndependently
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"requests"];
+    expectation.expectedFulfillmentCount = FWTStressRequestCount;
+    
+    __block NSUInteger invalidSignatures = 0;
+    NSObject *lock = [[NSObject alloc] init];
+    
+    dispatch_apply(FWTStressRequestCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        // Every request has its own path, so a signature sent with the wrong request is rejected
+        [self.requester markNotificationAsReceivedWithId:[NSString stringWithFormat:@"%zu", index]
+                                           deviceTokenId:@"42"
+                                                 success:^(NSDictionary<NSString *,NSObject *> * _Nullable response) {
+            [expectation fulfill];
+        } failure:^(NSInteger responseCode, NSError * _Nonnull error) {
+            @synchronized(lock) {
+                invalidSignatures += 1;
+            }
+            [expectation fulfill];
+        }];
+    });
+    
+    [self waitForExpectationsWithTimeout:60 handler:nil];
+    XCTAssertEqual(invalidSignatures, 0);
+}
+
+@end
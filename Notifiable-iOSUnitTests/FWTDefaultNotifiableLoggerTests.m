@@ -0,0 +1,155 @@
+//
+//  FWTDefaultNotifiableLoggerTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTDefaultNotifiableLogger.h"
+#import "FWTNotifiableLogging.h"
+#import "FWTLogRingBuffer.h"
+
+static NSUInteger const FWTConcurrentMessages = 200;
+static NSUInteger const FWTConcurrentObjects = 10000;
+
+@interface FWTDefaultNotifiableLoggerTests : FWTTestCase
+
+@property (nonatomic, strong) NSURL *logFileURL;
+@property (nonatomic, assign) NSUInteger evaluatedArguments;
+
+@end
+
+@implementation FWTDefaultNotifiableLoggerTests
+
+- (void)setUp
+{
+    [super setUp];
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    self.logFileURL = [NSURL fileURLWithPath:[directory stringByAppendingPathComponent:@"notifiable.log"]];
+    self.evaluatedArguments = 0;
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:self.logFileURL.URLByDeletingLastPathComponent error:nil];
+    [super tearDown];
+}
+
+- (NSString *)_argument
+{
+    self.evaluatedArguments += 1;
+    return @"argument";
+}
+
+- (NSString *)_logFileContent
+{
+    return [NSString stringWithContentsOfURL:self.logFileURL encoding:NSUTF8StringEncoding error:nil];
+}
+
+- (void)testDisabledLevelDoesNotEvaluateTheMessage
+{
+    FWTDefaultNotifiableLogger *logger = [[FWTDefaultNotifiableLogger alloc] initWithLogFileURL:self.logFileURL];
+    logger.logLevel = FWTNotifiableLogLevelError;
+    FWTLogInformation(logger, @"Message with %@", [self _argument]);
+    FWTLogInformation(nil, @"Message with %@", [self _argument]);
+    XCTAssertEqual(self.evaluatedArguments, 0);
+
+    logger.logLevel = FWTNotifiableLogLevelInformation;
+    FWTLogInformation(logger, @"Message with %@", [self _argument]);
+    XCTAssertEqual(self.evaluatedArguments, 1);
+
+    [logger flush];
+    XCTAssertTrue([[self _logFileContent] containsString:@"Message with argument"]);
+}
+
+- (void)testConcurrentMessagesAreAppendedToTheLogFile
+{
+    FWTDefaultNotifiableLogger *logger = [[FWTDefaultNotifiableLogger alloc] initWithLogFileURL:self.logFileURL];
+    logger.logLevel = FWTNotifiableLogLevelInformation;
+    dispatch_apply(FWTConcurrentMessages, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        FWTLogInformation(logger, @"Message %lu", (unsigned long)index);
+    });
+    [logger flush];
+
+    NSArray<NSString *> *lines = [[[self _logFileContent] stringByTrimmingCharactersInSet:[NSCharacterSet newlineCharacterSet]] componentsSeparatedByString:@"\n"];
+    XCTAssertEqual(lines.count, FWTConcurrentMessages);
+    for (NSUInteger index = 0; index < FWTConcurrentMessages; index++) {
+        NSString *suffix = [NSString stringWithFormat:@"] Message %lu", (unsigned long)index];
+        NSUInteger matches = [lines indexesOfObjectsPassingTest:^BOOL(NSString *line, NSUInteger idx, BOOL *stop) {
+            return [line hasSuffix:suffix];
+        }].count;
+        XCTAssertEqual(matches, 1, @"%@", suffix);
+    }
+}
+
+- (void)testLogFileIsRotatedWhenItGrowsOverTheMaxSize
+{
+    FWTDefaultNotifiableLogger *logger = [[FWTDefaultNotifiableLogger alloc] initWithLogFileURL:self.logFileURL];
+    logger.logLevel = FWTNotifiableLogLevelInformation;
+    logger.maxLogFileSize = 1024;
+    NSString *message = [@"" stringByPaddingToLength:100 withString:@"-" startingAtIndex:0];
+    for (NSUInteger index = 0; index < 50; index++) {
+        [logger logMessage:message];
+        [logger flush];
+    }
+
+    NSURL *backupURL = [self.logFileURL.URLByDeletingPathExtension URLByAppendingPathExtension:@"1.log"];
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:self.logFileURL.path error:nil];
+    NSDictionary *backupAttributes = [[NSFileManager defaultManager] attributesOfItemAtPath:backupURL.path error:nil];
+    XCTAssertNotNil(backupAttributes);
+    XCTAssertLessThanOrEqual(attributes.fileSize, 1024);
+    XCTAssertGreaterThan(backupAttributes.fileSize, 1024);
+    XCTAssertLessThan(backupAttributes.fileSize, 1024 + 200);
+}
+
+- (void)testLogFileOfTheGroup
+{
+    NSURL *logFileURL = [FWTDefaultNotifiableLogger logFileURLWithGroupId:nil];
+    XCTAssertEqualObjects(logFileURL.lastPathComponent, @"notifiable.log");
+    XCTAssertEqualObjects(logFileURL.URLByDeletingLastPathComponent.lastPathComponent, @"Logs");
+    XCTAssertNil([[FWTDefaultNotifiableLogger alloc] init].logFileURL);
+}
+
+- (void)testRingBufferDropsWhenFull
+{
+    FWTLogRingBuffer *buffer = [[FWTLogRingBuffer alloc] initWithCapacity:3];
+    XCTAssertEqual(buffer.capacity, 4);
+    for (NSUInteger index = 0; index < 6; index++) {
+        XCTAssertEqual([buffer push:@(index)], index < 4);
+    }
+    XCTAssertEqual([buffer takeDroppedCount], 2);
+    XCTAssertEqual([buffer takeDroppedCount], 0);
+
+    for (NSUInteger index = 0; index < 4; index++) {
+        XCTAssertEqualObjects([buffer pop], @(index));
+    }
+    XCTAssertNil([buffer pop]);
+    XCTAssertTrue([buffer push:@4]);
+    XCTAssertEqualObjects([buffer pop], @4);
+}
+
+- (void)testRingBufferConcurrentPushesAndPops
+{
+    FWTLogRingBuffer *buffer = [[FWTLogRingBuffer alloc] initWithCapacity:256];
+    NSMutableSet<NSNumber *> *popped = [[NSMutableSet alloc] init];
+
+    dispatch_apply(FWTConcurrentObjects, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        while (![buffer push:@(index)]) {
+            id object = [buffer pop];
+            if (object != nil) {
+                @synchronized (popped) {
+                    [popped addObject:object];
+                }
+            }
+        }
+    });
+    id object;
+    while ((object = [buffer pop]) != nil) {
+        [popped addObject:object];
+    }
+
+    XCTAssertEqual(popped.count, FWTConcurrentObjects);
+    XCTAssertNil([buffer pop]);
+}
+
+@end
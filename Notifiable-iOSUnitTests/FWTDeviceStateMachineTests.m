@@ -0,0 +1,142 @@
+//
+//  FWTDeviceStateMachineTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTDeviceStateMachine.h"
+#import "FWTNotifiableStateStore.h"
+#import "FWTNotifiableDevice+Private.h"
+#import "FWTNotifiableOperation+Private.h"
+
+static NSUInteger const FWTInterleavedTransitions = 500;
+
+@interface FWTDeviceStateMachineTests : FWTTestCase
+
+@property (nonatomic, strong) NSURL *fileURL;
+@property (nonatomic, strong) FWTNotifiableStateStore *store;
+@property (nonatomic, strong) FWTDeviceStateMachine *stateMachine;
+
+@end
+
+@implementation FWTDeviceStateMachineTests
+
+- (void)setUp
+{
+    [super setUp];
+    NSString *fileName = [NSString stringWithFormat:@"%@.bin", [NSUUID UUID].UUIDString];
+    self.fileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]];
+    self.store = [[FWTNotifiableStateStore alloc] initWithFileURL:self.fileURL];
+    self.stateMachine = [[FWTDeviceStateMachine alloc] initWithStateStore:self.store];
+}
+
+- (void)tearDown
+{
+    [self.store clear];
+    [super tearDown];
+}
+
+- (void)testDeviceIsLoadedFromTheStore
+{
+    [self.store storeDevice:[self _device]];
+    FWTDeviceStateMachine *stateMachine = [[FWTDeviceStateMachine alloc] initWithStateStore:self.store];
+    XCTAssertEqualObjects(stateMachine.device.tokenId, @42);
+    XCTAssertEqual(stateMachine.state, FWTDeviceLifecycleStateAnonymous);
+    XCTAssertEqual(stateMachine.storeCount, 0);
+}
+
+- (void)testLifecycleStates
+{
+    XCTAssertEqual(self.stateMachine.state, FWTDeviceLifecycleStateUnregistered);
+
+    FWTNotifiableOperation *registration = [[FWTNotifiableOperation alloc] init];
+    [self.stateMachine beginOperation:registration registration:YES];
+    XCTAssertEqual(self.stateMachine.state, FWTDeviceLifecycleStateRegistering);
+
+    [self.stateMachine finishOperation:registration withTransition:^FWTNotifiableDevice *(FWTNotifiableDevice *device) {
+        return [self _device];
+    }];
+    XCTAssertEqual(self.stateMachine.state, FWTDeviceLifecycleStateAnonymous);
+
+    FWTNotifiableOperation *update = [[FWTNotifiableOperation alloc] init];
+    [self.stateMachine beginOperation:update registration:NO];
+    XCTAssertEqual(self.stateMachine.state, FWTDeviceLifecycleStateUpdating);
+
+    [self.stateMachine finishOperation:update withTransition:^FWTNotifiableDevice *(FWTNotifiableDevice *device) {
+        return [device deviceWithUser:@"user"];
+    }];
+    XCTAssertEqual(self.stateMachine.state, FWTDeviceLifecycleStateRegistered);
+
+    [self.stateMachine commitTransition:^FWTNotifiableDevice *(FWTNotifiableDevice *device) {
+        return nil;
+    }];
+    XCTAssertEqual(self.stateMachine.state, FWTDeviceLifecycleStateUnregistered);
+    XCTAssertNil([self.store device]);
+}
+
+- (void)testCancelledOperationIsNotTracked
+{
+    FWTNotifiableOperation *registration = [[FWTNotifiableOperation alloc] init];
+    [self.stateMachine beginOperation:registration registration:YES];
+    [registration cancel];
+    XCTAssertEqual(self.stateMachine.state, FWTDeviceLifecycleStateUnregistered);
+}
+
+- (void)testUnchangedDeviceIsNotStored
+{
+    [self.stateMachine commitTransition:^FWTNotifiableDevice *(FWTNotifiableDevice *device) {
+        return [self _device];
+    }];
+    XCTAssertEqual(self.stateMachine.storeCount, 1);
+
+    FWTNotifiableOperation *update = [[FWTNotifiableOperation alloc] init];
+    [self.stateMachine beginOperation:update registration:NO];
+    [self.stateMachine finishOperation:update withTransition:^FWTNotifiableDevice *(FWTNotifiableDevice *device) {
+        return device;
+    }];
+    [self.stateMachine commitTransition:^FWTNotifiableDevice *(FWTNotifiableDevice *device) {
+        return device;
+    }];
+    XCTAssertEqual(self.stateMachine.storeCount, 1);
+}
+
+- (void)testInterleavedTransitionsAreMerged
+{
+    [self.stateMachine commitTransition:^FWTNotifiableDevice *(FWTNotifiableDevice *device) {
+        return [self _device];
+    }];
+
+    dispatch_apply(FWTInterleavedTransitions, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        NSString *key = [NSString stringWithFormat:@"key%zu", index];
+        FWTDeviceTransition transition = ^FWTNotifiableDevice *(FWTNotifiableDevice *device) {
+            NSMutableDictionary *customProperties = [device.customProperties mutableCopy] ?: [NSMutableDictionary dictionary];
+            customProperties[key] = @(index);
+            return [device deviceWithCustomProperties:customProperties];
+        };
+
+        if (index % 3 == 0) {
+            [self.stateMachine commitTransition:transition];
+        } else {
+            FWTNotifiableOperation *operation = [[FWTNotifiableOperation alloc] init];
+            [self.stateMachine beginOperation:operation registration:(index % 3 == 1)];
+            [self.stateMachine finishOperation:operation withTransition:transition];
+        }
+    });
+
+    XCTAssertEqual(self.stateMachine.device.customProperties.count, FWTInterleavedTransitions);
+    XCTAssertEqual(self.stateMachine.storeCount, FWTInterleavedTransitions + 1);
+    XCTAssertEqual(self.stateMachine.state, FWTDeviceLifecycleStateAnonymous);
+
+    FWTNotifiableStateStore *reloaded = [[FWTNotifiableStateStore alloc] initWithFileURL:self.fileURL];
+    XCTAssertEqualObjects([reloaded device].customProperties, self.stateMachine.device.customProperties);
+}
+
+- (FWTNotifiableDevice *)_device
+{
+    return [[FWTNotifiableDevice alloc] initWithToken:[@"token" dataUsingEncoding:NSUTF8StringEncoding]
+                                              tokenId:@42
+                                            andLocale:[NSLocale localeWithLocaleIdentifier:@"en_US"]];
+}
+
+@end
@@ -0,0 +1,115 @@
+//
+//  FWTHMACSigningContextTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTHMACSigningContext.h"
+#import <CommonCrypto/CommonCrypto.h>
+
+static NSUInteger const FWTSigningBenchmarkIterations = 10000;
+
+@interface FWTHMACSigningContextTests : FWTTestCase
+
+@property (nonatomic, strong) FWTHMACSigningContext *context;
+@property (nonatomic, strong) NSDateFormatter *dateFormatter;
+
+@end
+
+@implementation FWTHMACSigningContextTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.context = [[FWTHMACSigningContext alloc] initWithSecretKey:@"secret_key"];
+    self.dateFormatter = [[NSDateFormatter alloc] init];
+    self.dateFormatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+    self.dateFormatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+    [self.dateFormatter setDateFormat:@"EEE',' dd' 'MMM' 'yyyy HH':'mm':'ss 'GMT'"];
+}
+
+- (void)testKnownSignature
+{
+    NSString *signature = [self.context signatureForMethod:@"METHOD"
+                                               contentType:@"content"
+                                                      path:@"path"
+                                                      date:@"Thu, 21 Jan 2016 16:25:39 GMT"];
+    XCTAssertEqualObjects(signature, @"mirA07fJMiUDlMc0hmkUeqDdgSg=");
+}
+
+- (void)testKeyLongerThanTheBlockIsHashed
+{
+    NSString *key = [@"" stringByPaddingToLength:100 withString:@"k" startingAtIndex:0];
+    FWTHMACSigningContext *context = [[FWTHMACSigningContext alloc] initWithSecretKey:key];
+    NSString *signature = [context signatureForMethod:@"POST"
+                                          contentType:@"application/json; charset=utf-8"
+                                                 path:@"api/v1/device_tokens"
+                                                 date:@"Thu, 21 Jan 2016 16:25:39 GMT"];
+    XCTAssertEqualObjects(signature, @"7gPm+vdjA4Cbazd0ni1TFgk3zY4=");
+}
+
+- (void)testDateStringMatchesTheFormatter
+{
+    for (NSTimeInterval timestamp = 0; timestamp < 400 * 24 * 3600; timestamp += 86399.5) {
+        NSDate *date = [NSDate dateWithTimeIntervalSince1970:1453393539 + timestamp];
+        XCTAssertEqualObjects([self.context dateStringForDate:date], [self.dateFormatter stringFromDate:date]);
+    }
+}
+
+- (void)testSignatureMatchesOneShotHMAC
+{
+    for (NSUInteger index = 0; index < 100; index++) {
+        NSString *path = [NSString stringWithFormat:@"api/v1/notifications/%lu/delivered", (unsigned long)index];
+        NSString *date = [self.context dateStringForDate:[NSDate dateWithTimeIntervalSince1970:1453393539 + index]];
+        XCTAssertEqualObjects([self.context signatureForMethod:@"POST" contentType:@"application/json; charset=utf-8" path:path date:date],
+                              [self _oneShotSignatureForMethod:@"POST" contentType:@"application/json; charset=utf-8" path:path date:[NSDate dateWithTimeIntervalSince1970:1453393539 + index]]);
+    }
+}
+
+- (void)testPerformanceOneShotSigning
+{
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < FWTSigningBenchmarkIterations; index++) {
+            [self _oneShotSignatureForMethod:@"POST"
+                                 contentType:@"application/json; charset=utf-8"
+                                        path:@"api/v1/notifications/42/delivered"
+                                        date:[NSDate date]];
+        }
+    }];
+}
+
+- (void)testPerformanceSigningContext
+{
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < FWTSigningBenchmarkIterations; index++) {
+            NSString *date = [self.context dateStringForDate:[NSDate date]];
+            [self.context signatureForMethod:@"POST"
+                                 contentType:@"application/json; charset=utf-8"
+                                        path:@"api/v1/notifications/42/delivered"
+                                        date:date];
+        }
+    }];
+}
+
+#pragma mark - Private
+
+// Signing path used before the signing context existed, kept as reference for the benchmark
+- (NSString *)_oneShotSignatureForMethod:(NSString *)method
+                             contentType:(NSString *)contentType
+                                    path:(NSString *)path
+                                    date:(NSDate *)date
+{
+    NSString *dateString = [self.dateFormatter stringFromDate:date];
+    NSString *uri = [NSString stringWithFormat:@"/%@", path];
+    NSString *canonicalString = [NSString stringWithFormat:@"%@,%@,,%@,%@", method, contentType, uri, dateString];
+    
+    unsigned char cHMAC[CC_SHA1_DIGEST_LENGTH];
+    const char *keyChar = [@"secret_key" UTF8String];
+    const char *stringChar = [canonicalString UTF8String];
+    CCHmac(kCCHmacAlgSHA1, keyChar, strlen(keyChar), stringChar, strlen(stringChar), cHMAC);
+    NSData *data = [[NSData alloc] initWithBytes:cHMAC length:sizeof(cHMAC)];
+    return [data base64EncodedStringWithOptions:0];
+}
+
+@end
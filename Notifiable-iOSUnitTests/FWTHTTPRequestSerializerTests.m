@@ -8,6 +8,8 @@
 
 #import <XCTest/XCTest.h>
 #import "FWTHTTPRequestSerializer.h"
+#import "FWTNotifiableLogger.h"
+#import <OCMock/OCMock.h>
 
 @interface FWTHTTPRequestSerializerTests : XCTestCase
 
@@ -45,10 +47,28 @@
     XCTAssertEqualObjects(request.allHTTPHeaderFields[@"Content-Type"], @"application/json; charset=utf-8");
     XCTAssertEqualObjects(request.allHTTPHeaderFields[@"Accept"], @"application/json");
     XCTAssertEqualObjects(request.allHTTPHeaderFields[@"header"], @"header");
-    XCTAssertEqualObjects(request.HTTPBody, [NSJSONSerialization dataWithJSONObject:parameters options:NSJSONWritingPrettyPrinted error:nil]);
+    XCTAssertEqualObjects(request.HTTPBody, [NSJSONSerialization dataWithJSONObject:parameters options:0 error:nil]);
+    XCTAssertNil(request.allHTTPHeaderFields[@"Content-Encoding"]);
     
 }
 
+- (void) testCachePolicyAndTimeout {
+    NSURLRequest *request = [self.serializer buildRequestWithBaseURL:[NSURL URLWithString:@"http://localhost"]
+                                                          parameters:@{@"string":@"string"}
+                                                          andHeaders:@{}
+                                                           forMethod:FWTHTTPMethodPOST];
+    XCTAssertEqual(request.cachePolicy, NSURLRequestReloadIgnoringLocalCacheData);
+    XCTAssertEqual(request.timeoutInterval, 30);
+    
+    self.serializer.timeoutInterval = 10;
+    request = [self.serializer buildRequestWithBaseURL:[NSURL URLWithString:@"http://localhost"]
+                                            parameters:@{}
+                                            andHeaders:@{}
+                                             forMethod:FWTHTTPMethodGET];
+    XCTAssertEqual(request.cachePolicy, NSURLRequestUseProtocolCachePolicy);
+    XCTAssertEqual(request.timeoutInterval, 10);
+}
+
 - (void) testGetSerializer {
     NSURLRequest *request = [self.serializer buildRequestWithBaseURL:[NSURL URLWithString:@"http://localhost"]
                                                           parameters:@{@"parameter1":@"parameter1"}
@@ -82,4 +102,43 @@
     
 }
 
+- (void) testCompressedBody {
+    NSMutableDictionary *parameters = [[NSMutableDictionary alloc] init];
+    for (NSInteger index = 0; index < 100; index++) {
+        parameters[[NSString stringWithFormat:@"property_%ld", (long)index]] = @"repeated value";
+    }
+    NSData *json = [NSJSONSerialization dataWithJSONObject:parameters options:0 error:nil];
+    
+    id logger = OCMProtocolMock(@protocol(FWTNotifiableLogger));
+    OCMExpect([logger logMessage:[OCMArg checkWithBlock:^BOOL(NSString *message) {
+        return [message containsString:@"bytes saved"];
+    }]]);
+    self.serializer.logger = logger;
+    self.serializer.compressionThreshold = 512;
+    
+    NSURLRequest *request = [self.serializer buildRequestWithBaseURL:[NSURL URLWithString:@"http://localhost"]
+                                                          parameters:parameters
+                                                          andHeaders:@{}
+                                                           forMethod:FWTHTTPMethodPOST];
+    
+    XCTAssertEqualObjects(request.allHTTPHeaderFields[@"Content-Encoding"], @"gzip");
+    XCTAssertLessThan(request.HTTPBody.length, json.length);
+    const unsigned char *bytes = request.HTTPBody.bytes;
+    XCTAssertEqual(bytes[0], 0x1f);
+    XCTAssertEqual(bytes[1], 0x8b);
+    OCMVerifyAll(logger);
+}
+
+- (void) testSmallBodyIsNotCompressed {
+    self.serializer.compressionThreshold = 512;
+    NSDictionary *parameters = @{@"string":@"string"};
+    NSURLRequest *request = [self.serializer buildRequestWithBaseURL:[NSURL URLWithString:@"http://localhost"]
+                                                          parameters:parameters
+                                                          andHeaders:@{}
+                                                           forMethod:FWTHTTPMethodPOST];
+    
+    XCTAssertNil(request.allHTTPHeaderFields[@"Content-Encoding"]);
+    XCTAssertEqualObjects(request.HTTPBody, [NSJSONSerialization dataWithJSONObject:parameters options:0 error:nil]);
+}
+
 @end
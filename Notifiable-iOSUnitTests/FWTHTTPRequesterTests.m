@@ -13,6 +13,7 @@
 #import <OCMock/OCMock.h>
 
 extern NSString * const FWTDeviceTokensPath;
+extern NSString * const FWTDeviceTokenPath;
 extern NSString * const FWTNotificationOpenPath;
 extern NSString * const FWTListDevicesPath;
 
@@ -75,37 +76,40 @@ NSString * const FWTTestURL = @"http://localhost:3000";
                                              andAuthenticator:self.authenticator]);
 }
 
+- (void)testSessionManagerSignsTheRequests
+{
+    FWTHTTPRequester *requester = [[FWTHTTPRequester alloc] initWithBaseURL:[NSURL URLWithString:FWTTestURL]
+                                                                    session:[NSURLSession sharedSession]
+                                                           andAuthenticator:self.authenticator];
+    XCTAssertEqual(requester.httpSessionManager.authenticator, self.authenticator);
+}
+
 - (void)testRegisterDevice
 {
-    OCMExpect([self.httpSessionManager POST:FWTDeviceTokensPath
-                                 parameters:OCMOCK_ANY
-                                    success:OCMOCK_ANY
-                                    failure:OCMOCK_ANY]);
-    
-    OCMExpect([self.authenticator authHeadersForPath:FWTDeviceTokensPath
-                                          httpMethod:@"POST"
-                                          andHeaders:OCMOCK_ANY]);
+    OCMExpect([self.httpSessionManager sendRequestWithMethod:FWTHTTPMethodPOST
+                                                pathTemplate:FWTDeviceTokensPath
+                                                  identifier:nil
+                                                  parameters:OCMOCK_ANY
+                                                  background:NO
+                                                     success:OCMOCK_ANY
+                                                     failure:OCMOCK_ANY]);
     
     [self.requester registerDeviceWithParams:OCMOCK_ANY
                                      success:nil
                                      failure:nil];
     
     OCMVerifyAll(self.httpSessionManager);
-    OCMVerifyAll(self.authenticator);
 }
 
 - (void)testUpdateDevice
 {
-    NSString *path = [NSString stringWithFormat:@"%@/42",FWTDeviceTokensPath];
-    
-    OCMExpect([self.httpSessionManager PATCH:path
-                                  parameters:OCMOCK_ANY
-                                     success:OCMOCK_ANY
-                                     failure:OCMOCK_ANY]);
-    
-    OCMExpect([self.authenticator authHeadersForPath:path
-                                          httpMethod:@"PATCH"
-                                          andHeaders:OCMOCK_ANY]);
+    OCMExpect([self.httpSessionManager sendRequestWithMethod:FWTHTTPMethodPATCH
+                                                pathTemplate:FWTDeviceTokenPath
+                                                  identifier:@"42"
+                                                  parameters:OCMOCK_ANY
+                                                  background:NO
+                                                     success:OCMOCK_ANY
+                                                     failure:OCMOCK_ANY]);
     
     [self.requester updateDeviceWithTokenId:@42
                                      params:OCMOCK_ANY
@@ -113,42 +117,35 @@ NSString * const FWTTestURL = @"http://localhost:3000";
                                     failure:nil];
     
     OCMVerifyAll(self.httpSessionManager);
-    OCMVerifyAll(self.authenticator);
 }
 
 - (void)testUnregisterDevice
 {
-    NSString *path = [NSString stringWithFormat:@"%@/42",FWTDeviceTokensPath];
-    
-    OCMExpect([self.httpSessionManager PATCH:path
-                                   parameters:OCMOCK_ANY
-                                      success:OCMOCK_ANY
-                                      failure:OCMOCK_ANY]);
-    
-    OCMExpect([self.authenticator authHeadersForPath:path
-                                          httpMethod:@"PATCH"
-                                          andHeaders:OCMOCK_ANY]);
+    OCMExpect([self.httpSessionManager sendRequestWithMethod:FWTHTTPMethodPATCH
+                                                pathTemplate:FWTDeviceTokenPath
+                                                  identifier:@"42"
+                                                  parameters:OCMOCK_ANY
+                                                  background:NO
+                                                     success:OCMOCK_ANY
+                                                     failure:OCMOCK_ANY]);
     
     [self.requester unregisterTokenId:@42
                               success:^(NSDictionary<NSString *, NSObject *>* _Nullable response) {}
                               failure:^(NSInteger responseCode, NSError * error) {}];
     
     OCMVerifyAll(self.httpSessionManager);
-    OCMVerifyAll(self.authenticator);
 }
 
 - (void)testMarkNotification
 {
     NSString *notificationId = @"1";
-    NSString *path = [NSString stringWithFormat:FWTNotificationOpenPath, notificationId];
-    OCMExpect([self.httpSessionManager POST:path
-                                 parameters:OCMOCK_ANY
-                                    success:OCMOCK_ANY
-                                    failure:OCMOCK_ANY]);
-    
-    OCMExpect([self.authenticator authHeadersForPath:path
-                                          httpMethod:@"POST"
-                                          andHeaders:OCMOCK_ANY]);
+    OCMExpect([self.httpSessionManager sendRequestWithMethod:FWTHTTPMethodPOST
+                                                pathTemplate:FWTNotificationOpenPath
+                                                  identifier:notificationId
+                                                  parameters:OCMOCK_ANY
+                                                  background:YES
+                                                     success:OCMOCK_ANY
+                                                     failure:OCMOCK_ANY]);
     
     [self.requester markNotificationAsOpenedWithId:notificationId
                                      deviceTokenId:OCMOCK_ANY
@@ -159,7 +156,6 @@ NSString * const FWTTestURL = @"http://localhost:3000";
                                            }];
     
     OCMVerifyAll(self.httpSessionManager);
-    OCMVerifyAll(self.authenticator);
 }
 
 @end
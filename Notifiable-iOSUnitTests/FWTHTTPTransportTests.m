@@ -0,0 +1,87 @@
+//
+//  FWTHTTPTransportTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "FWTHTTPTransport.h"
+#import "FWTStubURLProtocol.h"
+
+@interface FWTHTTPTransportTests : XCTestCase
+
+@property (nonatomic, strong) NSURLSession *session;
+@property (nonatomic, strong) FWTURLSessionTransport *transport;
+@property (nonatomic, strong) NSURLRequest *request;
+
+@end
+
+@implementation FWTHTTPTransportTests
+
+- (void)setUp
+{
+    [super setUp];
+    [FWTStubURLProtocol reset];
+    self.session = [NSURLSession sessionWithConfiguration:[FWTStubURLProtocol stubbedConfiguration:[NSURLSessionConfiguration ephemeralSessionConfiguration]]];
+    self.transport = [[FWTURLSessionTransport alloc] initWithSession:self.session];
+    self.transport.connectTimeout = 0.2;
+    self.request = [NSURLRequest requestWithURL:[NSURL URLWithString:@"https://notifiable.test/api/v1/device_tokens"]];
+}
+
+- (void)tearDown
+{
+    [self.session invalidateAndCancel];
+    [FWTStubURLProtocol reset];
+    [super tearDown];
+}
+
+- (void)testRequestWithoutResponseFailsAfterTheConnectTimeout
+{
+    [FWTStubURLProtocol setResponseBlock:^FWTStubResponse *(NSURLRequest *request) {
+        return nil;
+    }];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Timeout"];
+    NSDate *start = [NSDate date];
+    [self.transport sendRequest:self.request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+        XCTAssertEqualObjects(error.domain, NSURLErrorDomain);
+        XCTAssertEqual(error.code, NSURLErrorTimedOut);
+        XCTAssertLessThan([[NSDate date] timeIntervalSinceDate:start], 1);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testResponseWithinTheConnectTimeoutSucceeds
+{
+    [FWTStubURLProtocol setResponseBlock:^FWTStubResponse *(NSURLRequest *request) {
+        FWTStubResponse *response = [FWTStubResponse responseWithStatusCode:200 body:[@"{}" dataUsingEncoding:NSUTF8StringEncoding]];
+        response.delay = 0.05;
+        return response;
+    }];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Response"];
+    [self.transport sendRequest:self.request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+        XCTAssertNil(error);
+        XCTAssertEqual(((NSHTTPURLResponse *)response).statusCode, 200);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testCancelledRequestIsNotReportedAsTimeout
+{
+    [FWTStubURLProtocol setResponseBlock:^FWTStubResponse *(NSURLRequest *request) {
+        return nil;
+    }];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Cancelled"];
+    NSURLSessionTask *task = [self.transport sendRequest:self.request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+        XCTAssertEqual(error.code, NSURLErrorCancelled);
+        [expectation fulfill];
+    }];
+    [task cancel];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+@end
@@ -0,0 +1,195 @@
+//
+//  FWTListenerRegistryTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTListenerRegistry.h"
+#import "FWTNotifiableManager.h"
+
+static NSUInteger const FWTOrderedEvents = 1000;
+static void *FWTListenerQueueKey = &FWTListenerQueueKey;
+
+@interface FWTNotificationListener : NSObject <FWTNotifiableManagerListener>
+
+@property (nonatomic, strong) NSMutableArray<NSDictionary *> *notifications;
+@property (nonatomic, assign) BOOL receivedOnListenerQueue;
+@property (nonatomic, copy) dispatch_block_t notificationBlock;
+
+@end
+
+@implementation FWTNotificationListener
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self->_notifications = [[NSMutableArray alloc] init];
+        self->_receivedOnListenerQueue = YES;
+    }
+    return self;
+}
+
+- (void)applicationDidReciveNotification:(NSDictionary *)notification
+{
+    if (dispatch_get_specific(FWTListenerQueueKey) == NULL) {
+        self.receivedOnListenerQueue = NO;
+    }
+    [self.notifications addObject:notification];
+    if (self.notificationBlock) {
+        self.notificationBlock();
+    }
+}
+
+@end
+
+@interface FWTNotifiableManager (ListenerOrder)
+
++ (void)notifyListenersWithCapability:(FWTListenerCapability)capability
+                           usingBlock:(void(^)(id<FWTNotifiableManagerListener> listener))block;
+
+@end
+
+@interface FWTListenerRegistryTests : FWTTestCase
+
+@property (nonatomic, strong) FWTListenerRegistry *registry;
+@property (nonatomic, strong) dispatch_queue_t queue;
+
+@end
+
+@implementation FWTListenerRegistryTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.registry = [[FWTListenerRegistry alloc] init];
+    self.queue = dispatch_queue_create("com.futureworkshops.notifiable.tests", DISPATCH_QUEUE_CONCURRENT);
+    dispatch_queue_set_specific(self.queue, FWTListenerQueueKey, FWTListenerQueueKey, NULL);
+}
+
+- (void)testCapabilitiesOfListener
+{
+    XCTAssertEqual([FWTListenerRegistry capabilitiesOfListener:[[NSObject alloc] init]], FWTListenerCapabilityNone);
+    XCTAssertEqual([FWTListenerRegistry capabilitiesOfListener:[[FWTNotificationListener alloc] init]], FWTListenerCapabilityDidReceiveNotification);
+}
+
+- (void)testListenerRegisteredOnce
+{
+    FWTNotificationListener *listener = [[FWTNotificationListener alloc] init];
+    XCTAssertTrue([self.registry addListener:listener queue:self.queue]);
+    XCTAssertFalse([self.registry addListener:listener queue:nil]);
+    XCTAssertEqual(self.registry.count, 1);
+
+    [self.registry removeListener:listener];
+    XCTAssertEqual(self.registry.count, 0);
+}
+
+- (void)testReleasedListenerIsNotCounted
+{
+    @autoreleasepool {
+        FWTNotificationListener *listener = [[FWTNotificationListener alloc] init];
+        [self.registry addListener:listener queue:nil];
+        XCTAssertEqual(self.registry.count, 1);
+    }
+    XCTAssertEqual(self.registry.count, 0);
+}
+
+- (void)testEventsOnlyGoToTheListenersImplementingThem
+{
+    FWTNotificationListener *listener = [[FWTNotificationListener alloc] init];
+    [self.registry addListener:listener queue:self.queue];
+
+    __block NSUInteger calls = 0;
+    [self.registry notifyListenersWithCapability:FWTListenerCapabilityDidRegisterDevice usingBlock:^(id<FWTNotifiableManagerListener> listener) {
+        calls += 1;
+    }];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Notification"];
+    listener.notificationBlock = ^{
+        [expectation fulfill];
+    };
+    [self.registry notifyListenersWithCapability:FWTListenerCapabilityDidReceiveNotification usingBlock:^(id<FWTNotifiableManagerListener> listener) {
+        [listener applicationDidReciveNotification:@{@"n_id": @1}];
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+
+    XCTAssertEqual(calls, 0);
+    XCTAssertTrue(listener.receivedOnListenerQueue);
+}
+
+- (void)testEventsKeepTheirOrderOnAConcurrentQueue
+{
+    NSMutableArray<FWTNotificationListener *> *listeners = [[NSMutableArray alloc] init];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Notifications"];
+    expectation.expectedFulfillmentCount = FWTOrderedEvents * 3;
+    for (NSUInteger index = 0; index < 3; index++) {
+        FWTNotificationListener *listener = [[FWTNotificationListener alloc] init];
+        listener.notificationBlock = ^{
+            [expectation fulfill];
+        };
+        [self.registry addListener:listener queue:self.queue];
+        [listeners addObject:listener];
+    }
+
+    for (NSUInteger index = 0; index < FWTOrderedEvents; index++) {
+        NSDictionary *notification = @{@"n_id": @(index)};
+        [self.registry notifyListenersWithCapability:FWTListenerCapabilityDidReceiveNotification usingBlock:^(id<FWTNotifiableManagerListener> listener) {
+            [listener applicationDidReciveNotification:notification];
+        }];
+    }
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    for (FWTNotificationListener *listener in listeners) {
+        XCTAssertTrue(listener.receivedOnListenerQueue);
+        for (NSUInteger index = 0; index < FWTOrderedEvents; index++) {
+            XCTAssertEqualObjects(listener.notifications[index][@"n_id"], @(index));
+        }
+    }
+}
+
+- (void)testInlineEventsAreSentOnTheCallingThread
+{
+    FWTNotificationListener *listener = [[FWTNotificationListener alloc] init];
+    [self.registry addListener:listener queue:self.queue];
+
+    [self.registry notifyListenersInlineWithCapability:FWTListenerCapabilityDidReceiveNotification usingBlock:^(id<FWTNotifiableManagerListener> listener) {
+        [listener applicationDidReciveNotification:@{@"n_id": @1}];
+    }];
+
+    XCTAssertEqual(listener.notifications.count, 1);
+    XCTAssertFalse(listener.receivedOnListenerQueue);
+}
+
+- (void)testManagersReceiveTheEventsBeforeTheOtherListeners
+{
+    NSMutableArray<NSString *> *receivers = [[NSMutableArray alloc] init];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Notification"];
+    FWTNotifiableManager *manager = [[FWTNotifiableManager alloc] initWithDidRegisterBlock:nil
+                                                                      andNotificationBlock:^(FWTNotifiableManager *manager, FWTNotifiableDevice *device, NSDictionary *notification) {
+        // The other listeners would run meanwhile if they weren't waiting for the manager
+        [NSThread sleepForTimeInterval:0.1];
+        @synchronized(receivers) {
+            [receivers addObject:@"manager"];
+        }
+    }];
+    FWTNotificationListener *listener = [[FWTNotificationListener alloc] init];
+    listener.notificationBlock = ^{
+        @synchronized(receivers) {
+            [receivers addObject:@"listener"];
+        }
+        [expectation fulfill];
+    };
+    [FWTNotifiableManager registerManagerListener:listener queue:self.queue];
+
+    [FWTNotifiableManager notifyListenersWithCapability:FWTListenerCapabilityDidReceiveNotification usingBlock:^(id<FWTNotifiableManagerListener> listener) {
+        [listener applicationDidReciveNotification:@{@"n_id": @1}];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqualObjects(receivers, (@[@"manager", @"listener"]));
+    [FWTNotifiableManager unregisterManagerListener:listener];
+    XCTAssertNotNil(manager);
+}
+
+@end
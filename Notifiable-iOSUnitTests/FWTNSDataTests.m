@@ -8,6 +8,27 @@
 
 #import "FWTTestCase.h"
 #import "NSData+FWTNotifiable.h"
+#import <zlib.h>
+
+static NSUInteger const FWTHexBenchmarkIterations = 10000;
+
+/** Encoding used before the table-driven one, as the reference of the expected output */
+static NSString *FWTReferenceTokenString(NSData *data)
+{
+    const unsigned char *bytes = (const unsigned char *)data.bytes;
+    NSMutableString *hex = [NSMutableString new];
+    for (NSInteger i = 0; i < data.length; i++) {
+        [hex appendFormat:@"%02x", bytes[i]];
+    }
+    return [[hex stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"<>"]] stringByReplacingOccurrencesOfString:@" " withString:@""];
+}
+
+static NSData *FWTRandomData(NSUInteger length)
+{
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:length];
+    arc4random_buf(data.mutableBytes, length);
+    return [data copy];
+}
 
 @interface FWTNSDataTests : FWTTestCase
 
@@ -31,4 +52,103 @@
     XCTAssertEqualObjects(formattedData, @"4657544e53446174615465737473");
 }
 
+- (void) testTokenFormatMatchesTheReferenceEncoding
+{
+    uint8_t allBytes[256];
+    for (NSUInteger byte = 0; byte < 256; byte++) {
+        allBytes[byte] = (uint8_t)byte;
+    }
+    NSData *allBytesData = [NSData dataWithBytes:allBytes length:sizeof(allBytes)];
+    XCTAssertEqualObjects([allBytesData fwt_notificationTokenString], FWTReferenceTokenString(allBytesData));
+    
+    for (NSUInteger length = 0; length <= 100; length++) {
+        NSData *data = FWTRandomData(length);
+        NSString *tokenString = [data fwt_notificationTokenString];
+        XCTAssertEqualObjects(tokenString, FWTReferenceTokenString(data));
+        XCTAssertEqualObjects([tokenString dataUsingEncoding:NSASCIIStringEncoding], [FWTReferenceTokenString(data) dataUsingEncoding:NSASCIIStringEncoding]);
+    }
+}
+
+- (void) testTokenStringIsCachedOnImmutableData
+{
+    NSData *data = FWTRandomData(32);
+    NSString *tokenString = [data fwt_notificationTokenString];
+    XCTAssertEqual([data fwt_notificationTokenString], tokenString);
+    XCTAssertEqualObjects([[data copy] fwt_notificationTokenString], tokenString);
+    
+    NSMutableData *mutableData = [data mutableCopy];
+    XCTAssertEqualObjects([mutableData fwt_notificationTokenString], tokenString);
+    [mutableData replaceBytesInRange:NSMakeRange(0, 1) withBytes:"\xff"];
+    XCTAssertTrue([[mutableData fwt_notificationTokenString] hasPrefix:@"ff"]);
+}
+
+- (void) testPerformanceReferenceTokenString
+{
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < FWTHexBenchmarkIterations; index++) {
+            @autoreleasepool {
+                NSMutableData *data = [[NSMutableData alloc] initWithLength:32];
+                memcpy(data.mutableBytes, &index, sizeof(index));
+                FWTReferenceTokenString(data);
+            }
+        }
+    }];
+}
+
+- (void) testPerformanceTokenString
+{
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < FWTHexBenchmarkIterations; index++) {
+            // A new data on each iteration, so the encoding is measured rather than the cache
+            @autoreleasepool {
+                NSMutableData *data = [[NSMutableData alloc] initWithLength:32];
+                memcpy(data.mutableBytes, &index, sizeof(index));
+                [data fwt_notificationTokenString];
+            }
+        }
+    }];
+}
+
+- (void) testGzipRoundTrip
+{
+    NSMutableString *content = [[NSMutableString alloc] init];
+    for (NSInteger index = 0; index < 200; index++) {
+        [content appendFormat:@"{\"key_%ld\":\"value\"}", (long)index];
+    }
+    NSData *data = [content dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *compressed = [data fwt_gzipCompressedData];
+    XCTAssertNotNil(compressed);
+    XCTAssertLessThan(compressed.length, data.length);
+    
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    XCTAssertEqual(inflateInit2(&stream, 15 + 16), Z_OK);
+    NSMutableData *inflated = [[NSMutableData alloc] initWithLength:data.length];
+    stream.next_in = (Bytef *)compressed.bytes;
+    stream.avail_in = (uInt)compressed.length;
+    stream.next_out = (Bytef *)inflated.mutableBytes;
+    stream.avail_out = (uInt)inflated.length;
+    XCTAssertEqual(inflate(&stream, Z_FINISH), Z_STREAM_END);
+    inflateEnd(&stream);
+    
+    XCTAssertEqualObjects(inflated, data);
+}
+
+- (void) testGzipOfEmptyData
+{
+    XCTAssertNil([[NSData data] fwt_gzipCompressedData]);
+}
+
+- (void) testGzipDecompression
+{
+    NSMutableString *content = [[NSMutableString alloc] init];
+    for (NSInteger index = 0; index < 5000; index++) {
+        [content appendFormat:@"{\"key_%ld\":\"value\"}", (long)index];
+    }
+    NSData *data = [content dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertEqualObjects([[data fwt_gzipCompressedData] fwt_gzipDecompressedData], data);
+    XCTAssertNil([data fwt_gzipDecompressedData]);
+    XCTAssertNil([[NSData data] fwt_gzipDecompressedData]);
+}
+
 @end
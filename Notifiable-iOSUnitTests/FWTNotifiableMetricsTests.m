@@ -0,0 +1,137 @@
+//
+//  FWTNotifiableMetricsTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTDefaultNotifiableMetrics.h"
+#import "FWTHTTPSessionManager.h"
+#import "FWTNotifiableAuthenticator.h"
+
+static NSUInteger const FWTConcurrentRecords = 10000;
+
+/** Transport answering every request with a 200 and a small body, without a network */
+@interface FWTMetricsTransport : NSObject <FWTHTTPTransport>
+@end
+
+@implementation FWTMetricsTransport
+
+- (NSURLSessionTask *)sendRequest:(NSURLRequest *)request completionHandler:(FWTHTTPTransportCompletionHandler)handler
+{
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:request.URL
+                                                              statusCode:200
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:@{}];
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        handler([@"{\"id\":42}" dataUsingEncoding:NSUTF8StringEncoding], response, nil);
+    });
+    return nil;
+}
+
+@end
+
+@interface FWTNotifiableMetricsTests : FWTTestCase
+
+@property (nonatomic, strong) FWTDefaultNotifiableMetrics *metrics;
+
+@end
+
+@implementation FWTNotifiableMetricsTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.metrics = [[FWTDefaultNotifiableMetrics alloc] init];
+}
+
+- (void)testConcurrentRecordsAreCounted
+{
+    dispatch_apply(FWTConcurrentRecords, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        [self.metrics recordResponseFromEndpoint:FWTNotifiableMetricsEndpointUpdateDevice
+                                         latency:0.001
+                                       bytesSent:10
+                                   bytesReceived:2
+                                         success:(index % 4 != 0)];
+        [self.metrics recordRetryOfEndpoint:FWTNotifiableMetricsEndpointUpdateDevice];
+    });
+
+    NSDictionary *update = [self.metrics snapshot][@"update_device"];
+    XCTAssertEqualObjects(update[@"succeeded"], @(FWTConcurrentRecords * 3 / 4));
+    XCTAssertEqualObjects(update[@"failed"], @(FWTConcurrentRecords / 4));
+    XCTAssertEqualObjects(update[@"retries"], @(FWTConcurrentRecords));
+    XCTAssertEqualObjects(update[@"bytes_sent"], @(FWTConcurrentRecords * 10));
+    XCTAssertEqualObjects(update[@"bytes_received"], @(FWTConcurrentRecords * 2));
+    XCTAssertEqualObjects([update[@"latency_histogram"] firstObject], @(FWTConcurrentRecords));
+    XCTAssertEqualObjects([self.metrics snapshot][@"register_device"][@"succeeded"], @0);
+}
+
+- (void)testLatencyHistogramBuckets
+{
+    NSArray<NSNumber *> *latencies = @[@0.005, @0.010, @0.030, @0.300, @20];
+    for (NSNumber *latency in latencies) {
+        [self.metrics recordResponseFromEndpoint:FWTNotifiableMetricsEndpointRegisterDevice
+                                         latency:latency.doubleValue
+                                       bytesSent:0
+                                   bytesReceived:0
+                                         success:YES];
+    }
+
+    NSArray<NSNumber *> *histogram = [self.metrics snapshot][@"register_device"][@"latency_histogram"];
+    XCTAssertEqual(histogram.count, [FWTDefaultNotifiableMetrics latencyBucketBounds].count + 1);
+    XCTAssertEqualObjects(histogram[0], @2);
+    XCTAssertEqualObjects(histogram[2], @1);
+    XCTAssertEqualObjects(histogram[5], @1);
+    XCTAssertEqualObjects(histogram.lastObject, @1);
+}
+
+- (void)testReset
+{
+    [self.metrics recordSigningTime:0.002 ofEndpoint:FWTNotifiableMetricsEndpointNotificationOpened];
+    XCTAssertEqualObjects([self.metrics snapshot][@"notification_opened"][@"signing_ms"], @2);
+
+    [self.metrics reset];
+    XCTAssertEqualObjects([self.metrics snapshot][@"notification_opened"][@"signing_ms"], @0);
+}
+
+- (void)testExportedSnapshotCanBeRead
+{
+    [self.metrics recordRetryOfEndpoint:FWTNotifiableMetricsEndpointNotificationReceived];
+    NSError *error;
+    XCTAssertTrue([self.metrics exportSnapshotWithGroupId:nil error:&error]);
+    XCTAssertNil(error);
+
+    NSDictionary *snapshots = [FWTDefaultNotifiableMetrics exportedSnapshotsWithGroupId:nil];
+    NSString *processName = [NSBundle mainBundle].bundleIdentifier ?: [NSProcessInfo processInfo].processName;
+    NSDictionary *snapshot = snapshots[processName];
+    XCTAssertNotNil(snapshot[@"date"]);
+    XCTAssertEqualObjects(snapshot[@"endpoints"][@"notification_received"][@"retries"], @1);
+}
+
+- (void)testSessionManagerFeedsTheMetrics
+{
+    FWTHTTPSessionManager *sessionManager = [[FWTHTTPSessionManager alloc] initWithBaseURL:[NSURL URLWithString:@"https://notifiable.test"]
+                                                                                   session:[NSURLSession sharedSession]];
+    sessionManager.transport = [[FWTMetricsTransport alloc] init];
+    sessionManager.authenticator = [[FWTNotifiableAuthenticator alloc] initWithAccessId:@"access" andSecretKey:@"secret"];
+    sessionManager.metrics = self.metrics;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Requests"];
+    expectation.expectedFulfillmentCount = 2;
+    [sessionManager POST:@"api/v1/device_tokens" parameters:@{@"token": @"token"} success:^(id responseObject) {
+        [expectation fulfill];
+    } failure:nil];
+    [sessionManager POST:@"api/v1/notifications/1/opened" parameters:@{@"device_token_id": @"42"} success:^(id responseObject) {
+        [expectation fulfill];
+    } failure:nil];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+
+    NSDictionary *snapshot = [self.metrics snapshot];
+    XCTAssertEqualObjects(snapshot[@"register_device"][@"succeeded"], @1);
+    XCTAssertGreaterThan([snapshot[@"register_device"][@"bytes_sent"] unsignedIntegerValue], 0);
+    XCTAssertEqualObjects(snapshot[@"register_device"][@"bytes_received"], @9);
+    XCTAssertEqualObjects(snapshot[@"notification_opened"][@"succeeded"], @1);
+    XCTAssertEqualObjects(snapshot[@"update_device"][@"succeeded"], @0);
+}
+
+@end
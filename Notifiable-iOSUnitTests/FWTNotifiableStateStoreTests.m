@@ -0,0 +1,303 @@
+//
+//  FWTNotifiableStateStoreTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTNotifiableStateStore.h"
+#import "FWTServerConfiguration.h"
+#import "FWTNotifiableDevice.h"
+#import "NSUserDefaults+FWTNotifiable.h"
+
+static NSString * const FWTStateStoreTestsSuite = @"FWTNotifiableStateStoreTests";
+static NSUInteger const FWTColdStartBenchmarkIterations = 200;
+
+@interface FWTNotifiableStateStoreTests : FWTTestCase
+
+@property (nonatomic, strong) NSURL *fileURL;
+@property (nonatomic, strong) FWTNotifiableStateStore *store;
+@property (nonatomic, strong) NSUserDefaults *userDefaults;
+
+@end
+
+@implementation FWTNotifiableStateStoreTests
+
+- (void)setUp
+{
+    [super setUp];
+    NSString *fileName = [NSString stringWithFormat:@"%@.bin", [NSUUID UUID].UUIDString];
+    self.fileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]];
+    self.store = [[FWTNotifiableStateStore alloc] initWithFileURL:self.fileURL];
+    self.userDefaults = [[NSUserDefaults alloc] initWithSuiteName:FWTStateStoreTestsSuite];
+}
+
+- (void)tearDown
+{
+    [self.store clear];
+    [self.userDefaults removePersistentDomainForName:FWTStateStoreTestsSuite];
+    [super tearDown];
+}
+
+- (void)testEmptyStore
+{
+    XCTAssertNil([self.store configuration]);
+    XCTAssertNil([self.store device]);
+}
+
+- (void)testConfigurationAndDeviceSurviveANewInstance
+{
+    [self.store storeConfiguration:[self _configuration]];
+    [self.store storeDevice:[self _device]];
+
+    FWTNotifiableStateStore *reloaded = [[FWTNotifiableStateStore alloc] initWithFileURL:self.fileURL];
+    [self _assertConfiguration:[reloaded configuration]];
+    [self _assertDevice:[reloaded device]];
+}
+
+- (void)testStoringTheDeviceKeepsTheConfiguration
+{
+    [self.store storeConfiguration:[self _configuration]];
+    [self.store storeDevice:[self _device]];
+    [self.store storeDevice:nil];
+
+    XCTAssertNil([self.store device]);
+    [self _assertConfiguration:[self.store configuration]];
+}
+
+- (void)testDeviceWithoutOptionalFields
+{
+    NSData *token = [@"token" dataUsingEncoding:NSUTF8StringEncoding];
+    FWTNotifiableDevice *device = [[FWTNotifiableDevice alloc] initWithToken:token
+                                                                     tokenId:@7
+                                                                   andLocale:[NSLocale localeWithLocaleIdentifier:@"pt_BR"]];
+    [self.store storeDevice:device];
+
+    FWTNotifiableDevice *stored = [self.store device];
+    XCTAssertEqualObjects(stored.token, token);
+    XCTAssertEqualObjects(stored.tokenId, @7);
+    XCTAssertEqualObjects(stored.locale.localeIdentifier, @"pt_BR");
+    XCTAssertNil(stored.user);
+    XCTAssertNil(stored.name);
+    XCTAssertNil(stored.customProperties);
+    XCTAssertNil(stored.platformProperties);
+    XCTAssertNil([self.store configuration]);
+}
+
+- (void)testPropertiesThatAreNotValidJSONSurviveANewInstance
+{
+    NSData *token = [@"token" dataUsingEncoding:NSUTF8StringEncoding];
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1600000000];
+    NSData *avatar = [@"avatar" dataUsingEncoding:NSUTF8StringEncoding];
+    NSDictionary *customProperties = @{@"birthday": date, @"avatar": avatar, @"tags": @[@"a", @1]};
+    NSDictionary *platformProperties = @{@"installed": date};
+    FWTNotifiableDevice *device = [[FWTNotifiableDevice alloc] initWithToken:token
+                                                                     tokenId:@7
+                                                                      locale:[NSLocale localeWithLocaleIdentifier:@"pt_BR"]
+                                                                        user:@"user"
+                                                                        name:@"name"
+                                                            customProperties:customProperties
+                                                          platformProperties:platformProperties];
+    [self.store storeDevice:device];
+
+    FWTNotifiableStateStore *store = [[FWTNotifiableStateStore alloc] initWithFileURL:self.fileURL];
+    FWTNotifiableDevice *stored = [store device];
+    XCTAssertEqualObjects(stored.token, token);
+    XCTAssertEqualObjects(stored.customProperties, customProperties);
+    XCTAssertEqualObjects(stored.platformProperties, platformProperties);
+}
+
+- (void)testCorruptedFileIsIgnored
+{
+    [self.store storeConfiguration:[self _configuration]];
+    [self.store storeDevice:[self _device]];
+
+    NSData *data = [NSData dataWithContentsOfURL:self.fileURL];
+    [[data subdataWithRange:NSMakeRange(0, data.length - 10)] writeToURL:self.fileURL atomically:YES];
+    XCTAssertNil([self.store device]);
+
+    [[@"not a state file" dataUsingEncoding:NSUTF8StringEncoding] writeToURL:self.fileURL atomically:YES];
+    XCTAssertNil([self.store configuration]);
+    XCTAssertNil([self.store device]);
+}
+
+- (void)testNewerVersionIsIgnored
+{
+    [self.store storeConfiguration:[self _configuration]];
+    NSMutableData *data = [[NSData dataWithContentsOfURL:self.fileURL] mutableCopy];
+    uint8_t version = 0xFF;
+    [data replaceBytesInRange:NSMakeRange(4, 1) withBytes:&version];
+    [data writeToURL:self.fileURL atomically:YES];
+
+    XCTAssertNil([self.store configuration]);
+}
+
+- (void)testMigrationFromUserDefaults
+{
+    [self.userDefaults storeConfiguration:[self _configuration]];
+    [self.userDefaults storeDevice:[self _device]];
+
+    XCTAssertTrue([self.store migrateFromUserDefaults:self.userDefaults]);
+    [self _assertConfiguration:[self.store configuration]];
+    [self _assertDevice:[self.store device]];
+    XCTAssertNil([self.userDefaults storedConfiguration]);
+    XCTAssertNil([self.userDefaults storedDevice]);
+}
+
+- (void)testMigrationDoesNotOverrideTheStore
+{
+    [self.store storeDevice:[self _device]];
+    [self.userDefaults storeConfiguration:[self _configuration]];
+
+    XCTAssertFalse([self.store migrateFromUserDefaults:self.userDefaults]);
+    XCTAssertNil([self.store configuration]);
+    XCTAssertNotNil([self.userDefaults storedConfiguration]);
+}
+
+- (void)testSynchronizeToStore
+{
+    [self.store storeConfiguration:[self _configuration]];
+    [self.store storeDevice:[self _device]];
+
+    NSString *fileName = [NSString stringWithFormat:@"%@.bin", [NSUUID UUID].UUIDString];
+    FWTNotifiableStateStore *groupStore = [[FWTNotifiableStateStore alloc] initWithFileURL:[NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]]];
+    [self.store synchronizeToStore:groupStore];
+
+    [self _assertConfiguration:[groupStore configuration]];
+    [self _assertDevice:[groupStore device]];
+    [groupStore clear];
+}
+
+- (void)testReadsReuseTheDecodedState
+{
+    [self.store storeConfiguration:[self _configuration]];
+    [self.store storeDevice:[self _device]];
+
+    FWTNotifiableStateStore *reader = [[FWTNotifiableStateStore alloc] initWithFileURL:self.fileURL];
+    FWTServerConfiguration *configuration = nil;
+    FWTNotifiableDevice *device = nil;
+    [reader readConfiguration:&configuration device:&device];
+    NSUInteger changeCount = reader.changeCount;
+
+    XCTAssertEqual([reader configuration], configuration);
+    XCTAssertEqual([reader configuration], configuration);
+    XCTAssertEqual([reader device], device);
+    XCTAssertEqual(reader.changeCount, changeCount);
+}
+
+- (void)testSnapshotIsInvalidatedWhenTheFileIsReplaced
+{
+    [self.store storeDevice:[self _device]];
+    FWTNotifiableStateStore *extensionStore = [[FWTNotifiableStateStore alloc] initWithFileURL:self.fileURL];
+    XCTAssertEqualObjects([extensionStore device].tokenId, @42);
+    NSUInteger changeCount = extensionStore.changeCount;
+
+    // Written by the app, while the extension keeps its snapshot
+    [self.store storeConfiguration:[self _configuration]];
+    FWTNotifiableDevice *device = [[FWTNotifiableDevice alloc] initWithToken:[@"other" dataUsingEncoding:NSUTF8StringEncoding]
+                                                                     tokenId:@43
+                                                                   andLocale:[NSLocale localeWithLocaleIdentifier:@"en_GB"]];
+    [self.store storeDevice:device];
+
+    XCTAssertEqualObjects([extensionStore device].tokenId, @43);
+    [self _assertConfiguration:[extensionStore configuration]];
+    XCTAssertGreaterThan(extensionStore.changeCount, changeCount);
+
+    [self.store clear];
+    XCTAssertNil([extensionStore device]);
+    XCTAssertNil([extensionStore configuration]);
+}
+
+#pragma mark - Extension cold start
+
+// Work done by a notification service extension before the receipt can be sent, using the user defaults
+- (void)testPerformanceColdStartWithUserDefaults
+{
+    [self.userDefaults storeConfiguration:[self _configuration]];
+    [self.userDefaults storeDevice:[self _device]];
+
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < FWTColdStartBenchmarkIterations; index++) {
+            NSUserDefaults *userDefaults = [[NSUserDefaults alloc] initWithSuiteName:FWTStateStoreTestsSuite];
+            FWTServerConfiguration *configuration = [userDefaults storedConfiguration];
+            FWTNotifiableDevice *device = [userDefaults storedDevice];
+            XCTAssertNotNil(configuration.serverURL);
+            XCTAssertNotNil(device.tokenId);
+        }
+    }];
+}
+
+// Same work, reading from the state file on every notification
+- (void)testPerformanceColdStartWithStateStore
+{
+    [self.store storeConfiguration:[self _configuration]];
+    [self.store storeDevice:[self _device]];
+
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < FWTColdStartBenchmarkIterations; index++) {
+            FWTNotifiableStateStore *store = [[FWTNotifiableStateStore alloc] initWithFileURL:self.fileURL];
+            FWTServerConfiguration *configuration = [store configuration];
+            FWTNotifiableDevice *device = [store device];
+            XCTAssertNotNil(configuration.serverURL);
+            XCTAssertNotNil(device.tokenId);
+        }
+    }];
+}
+
+// Following notifications handled by the same extension process, using the decoded snapshot
+- (void)testPerformanceWarmReadsWithStateStore
+{
+    [self.store storeConfiguration:[self _configuration]];
+    [self.store storeDevice:[self _device]];
+
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < FWTColdStartBenchmarkIterations; index++) {
+            FWTServerConfiguration *configuration = [self.store configuration];
+            FWTNotifiableDevice *device = [self.store device];
+            XCTAssertNotNil(configuration.serverURL);
+            XCTAssertNotNil(device.tokenId);
+        }
+    }];
+}
+
+#pragma mark - Private
+
+- (FWTServerConfiguration *)_configuration
+{
+    return [[FWTServerConfiguration alloc] initWithServerURL:[NSURL URLWithString:@"https://notifiable.test"]
+                                                    accessId:@"access"
+                                                   secretKey:@"secret"
+                                                andSignature:FWTNotifiableSignatureHMACSHA256ContentSHA256];
+}
+
+- (FWTNotifiableDevice *)_device
+{
+    return [[FWTNotifiableDevice alloc] initWithToken:[@"token" dataUsingEncoding:NSUTF8StringEncoding]
+                                              tokenId:@42
+                                               locale:[NSLocale localeWithLocaleIdentifier:@"en_GB"]
+                                                 user:@"user"
+                                                 name:@"iPhone"
+                                     customProperties:@{@"onsite": @YES, @"level": @3}
+                                   platformProperties:@{@"os_version": @"13.3"}];
+}
+
+- (void)_assertConfiguration:(FWTServerConfiguration *)configuration
+{
+    XCTAssertEqualObjects(configuration.serverURL, [NSURL URLWithString:@"https://notifiable.test"]);
+    XCTAssertEqualObjects(configuration.serverAccessId, @"access");
+    XCTAssertEqualObjects(configuration.serverSecretKey, @"secret");
+    XCTAssertEqual(configuration.signature, FWTNotifiableSignatureHMACSHA256ContentSHA256);
+}
+
+- (void)_assertDevice:(FWTNotifiableDevice *)device
+{
+    XCTAssertEqualObjects(device.token, [@"token" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqualObjects(device.tokenId, @42);
+    XCTAssertEqualObjects(device.locale.localeIdentifier, @"en_GB");
+    XCTAssertEqualObjects(device.user, @"user");
+    XCTAssertEqualObjects(device.name, @"iPhone");
+    [self assertDictionary:device.customProperties withTarget:@{@"onsite": @YES, @"level": @3}];
+    [self assertDictionary:device.platformProperties withTarget:@{@"os_version": @"13.3"}];
+}
+
+@end
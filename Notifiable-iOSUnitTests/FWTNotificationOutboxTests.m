@@ -0,0 +1,255 @@
+//
+//  FWTNotificationOutboxTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import <OCMock/OCMock.h>
+#import "FWTNotificationOutbox.h"
+#import "FWTRequesterManager.h"
+
+@interface FWTNotificationOutboxTests : FWTTestCase
+
+@property (nonatomic, strong) NSURL *fileURL;
+@property (nonatomic, strong) FWTNotificationOutbox *outbox;
+@property (nonatomic, strong) id requesterManagerMock;
+
+@end
+
+@implementation FWTNotificationOutboxTests
+
+- (void)setUp
+{
+    [super setUp];
+    NSString *fileName = [NSString stringWithFormat:@"%@.journal", [NSUUID UUID].UUIDString];
+    self.fileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]];
+    self.outbox = [[FWTNotificationOutbox alloc] initWithFileURL:self.fileURL];
+    self.requesterManagerMock = OCMClassMock([FWTRequesterManager class]);
+}
+
+- (void)tearDown
+{
+    [self.outbox clear];
+    [self.requesterManagerMock stopMocking];
+    [super tearDown];
+}
+
+- (void)testEventsSurviveANewInstance
+{
+    [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@1 deviceTokenId:@42 user:nil];
+    FWTNotificationOutboxEvent *opened = [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeOpened notificationId:@2 deviceTokenId:@42 user:@"user"];
+
+    FWTNotificationOutbox *reloaded = [[FWTNotificationOutbox alloc] initWithFileURL:self.fileURL];
+    NSArray<FWTNotificationOutboxEvent *> *events = [reloaded pendingEvents];
+
+    XCTAssertEqual(events.count, 2);
+    XCTAssertEqualObjects(events[0].notificationId, @1);
+    XCTAssertEqual(events[0].type, FWTNotificationOutboxEventTypeReceived);
+    XCTAssertEqualObjects(events[1].notificationId, @2);
+    XCTAssertEqual(events[1].type, FWTNotificationOutboxEventTypeOpened);
+    XCTAssertEqualObjects(events[1].user, @"user");
+    XCTAssertEqual(events[1].sequence, opened.sequence);
+}
+
+- (void)testAcknowledgedEventsAreRemoved
+{
+    FWTNotificationOutboxEvent *first = [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@1 deviceTokenId:@42 user:nil];
+    [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@2 deviceTokenId:@42 user:nil];
+    [self.outbox acknowledgeEvent:first];
+
+    NSArray<FWTNotificationOutboxEvent *> *events = [[[FWTNotificationOutbox alloc] initWithFileURL:self.fileURL] pendingEvents];
+    XCTAssertEqual(events.count, 1);
+    XCTAssertEqualObjects(events.firstObject.notificationId, @2);
+}
+
+- (void)testEventsWrittenByAnotherProcessAreRead
+{
+    [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@1 deviceTokenId:@42 user:nil];
+    XCTAssertEqual([self.outbox pendingEvents].count, 1);
+
+    FWTNotificationOutbox *extension = [[FWTNotificationOutbox alloc] initWithFileURL:self.fileURL];
+    FWTNotificationOutboxEvent *event = [extension enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@2 deviceTokenId:@42 user:nil];
+    XCTAssertEqual([self.outbox pendingEvents].count, 2);
+
+    [extension acknowledgeEvent:event];
+    NSArray<FWTNotificationOutboxEvent *> *events = [self.outbox pendingEvents];
+    XCTAssertEqual(events.count, 1);
+    XCTAssertEqualObjects(events.firstObject.notificationId, @1);
+}
+
+- (void)testPerformancePendingEventsOfALargeJournal
+{
+    self.outbox.maxEvents = 1000;
+    self.outbox.compactionThreshold = NSUIntegerMax;
+    for (NSInteger index = 0; index < 500; index++) {
+        [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@(index) deviceTokenId:@42 user:nil];
+    }
+    [self measureBlock:^{
+        for (NSInteger index = 0; index < 100; index++) {
+            [self.outbox pendingEvents];
+        }
+    }];
+}
+
+- (void)testTornRecordIsIgnored
+{
+    [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@1 deviceTokenId:@42 user:nil];
+
+    NSFileHandle *handle = [NSFileHandle fileHandleForWritingToURL:self.fileURL error:nil];
+    [handle seekToEndOfFile];
+    [handle writeData:[@"{\"op\":\"add\",\"seq\":2,\"n_" dataUsingEncoding:NSUTF8StringEncoding]];
+    [handle closeFile];
+
+    FWTNotificationOutboxEvent *event = [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@3 deviceTokenId:@42 user:nil];
+    NSArray<FWTNotificationOutboxEvent *> *events = [self.outbox pendingEvents];
+
+    XCTAssertEqual(events.count, 2);
+    XCTAssertEqualObjects(events.lastObject.notificationId, @3);
+    XCTAssertEqual(event.sequence, 2);
+}
+
+- (void)testCompactionKeepsPendingEventsAndSequence
+{
+    self.outbox.compactionThreshold = 10;
+    FWTNotificationOutboxEvent *event;
+    for (NSInteger index = 0; index < 20; index++) {
+        event = [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@(index) deviceTokenId:@42 user:nil];
+        [self.outbox acknowledgeEvent:event];
+    }
+    [self.outbox compact];
+
+    NSString *content = [NSString stringWithContentsOfURL:self.fileURL encoding:NSUTF8StringEncoding error:nil];
+    XCTAssertEqual([content componentsSeparatedByString:@"\n"].count, 2);
+    XCTAssertEqual([self.outbox pendingEvents].count, 0);
+
+    FWTNotificationOutboxEvent *next = [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@99 deviceTokenId:@42 user:nil];
+    XCTAssertEqual(next.sequence, event.sequence + 1);
+}
+
+- (void)testOldestEventsAreDiscardedWhenFull
+{
+    self.outbox.maxEvents = 3;
+    for (NSInteger index = 0; index < 5; index++) {
+        [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@(index) deviceTokenId:@42 user:nil];
+    }
+
+    NSArray<FWTNotificationOutboxEvent *> *events = [self.outbox pendingEvents];
+    XCTAssertEqual(events.count, 3);
+    XCTAssertEqualObjects(events.firstObject.notificationId, @2);
+}
+
+- (void)testDrainSendsInOrderAndStopsOnFailure
+{
+    [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@1 deviceTokenId:@42 user:nil];
+    [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeOpened notificationId:@2 deviceTokenId:@42 user:@"user"];
+    [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@3 deviceTokenId:@42 user:nil];
+
+    NSMutableArray<NSNumber *> *sent = [[NSMutableArray alloc] init];
+    OCMStub([self.requesterManagerMock markNotificationAsReceivedWithId:OCMOCK_ANY deviceTokenId:OCMOCK_ANY completionHandler:OCMOCK_ANY]).andDo(^(NSInvocation *invocation) {
+        __unsafe_unretained NSNumber *notificationId;
+        __unsafe_unretained FWTSimpleRequestResponse handler;
+        [invocation getArgument:&notificationId atIndex:2];
+        [invocation getArgument:&handler atIndex:4];
+        [sent addObject:notificationId];
+        handler([notificationId isEqualToNumber:@1], nil);
+    });
+    OCMStub([self.requesterManagerMock markNotificationAsOpenedWithId:OCMOCK_ANY deviceTokenId:OCMOCK_ANY user:OCMOCK_ANY completionHandler:OCMOCK_ANY]).andDo(^(NSInvocation *invocation) {
+        __unsafe_unretained NSNumber *notificationId;
+        __unsafe_unretained FWTSimpleRequestResponse handler;
+        [invocation getArgument:&notificationId atIndex:2];
+        [invocation getArgument:&handler atIndex:5];
+        [sent addObject:notificationId];
+        handler(NO, nil);
+    });
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Drain"];
+    [self.outbox drainWithRequesterManager:self.requesterManagerMock completionHandler:^(NSUInteger sentEvents, NSUInteger pendingEvents) {
+        XCTAssertEqual(sentEvents, 1);
+        XCTAssertEqual(pendingEvents, 2);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+
+    XCTAssertEqualObjects(sent, (@[@1, @2]));
+    NSArray<FWTNotificationOutboxEvent *> *events = [self.outbox pendingEvents];
+    XCTAssertEqual(events.count, 2);
+    XCTAssertEqualObjects(events.firstObject.notificationId, @2);
+}
+
+- (void)testDrainSkipsEventsBeingSent
+{
+    FWTNotificationOutboxEvent *event = [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@1 deviceTokenId:@42 user:nil];
+    [self.outbox beginSendingEvent:event];
+
+    [[self.requesterManagerMock reject] markNotificationAsReceivedWithId:OCMOCK_ANY deviceTokenId:OCMOCK_ANY completionHandler:OCMOCK_ANY];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Drain"];
+    [self.outbox drainWithRequesterManager:self.requesterManagerMock completionHandler:^(NSUInteger sentEvents, NSUInteger pendingEvents) {
+        XCTAssertEqual(sentEvents, 0);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    OCMVerifyAll(self.requesterManagerMock);
+}
+
+- (void)testLeaseIsSharedWithOtherProcesses
+{
+    FWTNotificationOutboxEvent *event = [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@1 deviceTokenId:@42 user:nil];
+    XCTAssertTrue([self.outbox beginSendingEvent:event]);
+
+    FWTNotificationOutbox *extension = [[FWTNotificationOutbox alloc] initWithFileURL:self.fileURL];
+    XCTAssertFalse([extension beginSendingEvent:event]);
+
+    [self.outbox endSendingEvent:event];
+    XCTAssertTrue([extension beginSendingEvent:event]);
+}
+
+- (void)testLeasedEventIsEnqueuedAsynchronously
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Enqueued"];
+    __block FWTNotificationOutboxEvent *event = nil;
+    [self.outbox enqueueLeasedEventOfType:FWTNotificationOutboxEventTypeOpened
+                           notificationId:@1
+                            deviceTokenId:@42
+                                     user:@"user"
+                        completionHandler:^(FWTNotificationOutboxEvent * _Nullable leasedEvent) {
+        XCTAssertFalse([NSThread isMainThread]);
+        event = leasedEvent;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+
+    XCTAssertNotNil(event);
+    XCTAssertEqual([self.outbox pendingEvents].count, 1);
+    FWTNotificationOutbox *extension = [[FWTNotificationOutbox alloc] initWithFileURL:self.fileURL];
+    XCTAssertFalse([extension beginSendingEvent:event]);
+}
+
+- (void)testExpiredLeaseIsSentAgain
+{
+    self.outbox.sendLeaseDuration = 0;
+    FWTNotificationOutboxEvent *event = [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@1 deviceTokenId:@42 user:nil];
+    XCTAssertTrue([self.outbox beginSendingEvent:event]);
+
+    FWTNotificationOutbox *extension = [[FWTNotificationOutbox alloc] initWithFileURL:self.fileURL];
+    XCTAssertTrue([extension beginSendingEvent:event]);
+}
+
+- (void)testAcknowledgeEventsDeliveredOutsideTheOutbox
+{
+    [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@1 deviceTokenId:@42 user:nil];
+    [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeOpened notificationId:@1 deviceTokenId:@42 user:@"user"];
+    [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@2 deviceTokenId:@42 user:nil];
+    [self.outbox enqueueEventOfType:FWTNotificationOutboxEventTypeReceived notificationId:@3 deviceTokenId:@42 user:nil];
+
+    XCTAssertEqual([self.outbox acknowledgeEventsOfType:FWTNotificationOutboxEventTypeReceived notificationIds:@[@1, @2, @9]], 2);
+    XCTAssertEqual([self.outbox acknowledgeEventsOfType:FWTNotificationOutboxEventTypeReceived notificationIds:@[@1]], 0);
+
+    NSArray<FWTNotificationOutboxEvent *> *events = [[[FWTNotificationOutbox alloc] initWithFileURL:self.fileURL] pendingEvents];
+    XCTAssertEqual(events.count, 2);
+    XCTAssertEqual(events[0].type, FWTNotificationOutboxEventTypeOpened);
+    XCTAssertEqualObjects(events[1].notificationId, @3);
+}
+
+@end
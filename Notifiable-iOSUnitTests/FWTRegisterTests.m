@@ -13,6 +13,8 @@
 #import "FWTHTTPRequester.h"
 #import "FWTNotifiableDevice+Private.h"
 #import "NSData+FWTNotifiable.h"
+#import "NSError+FWTNotifiable.h"
+#import "FWTNotifiableOperation.h"
 
 @interface FWTRegisterTests : FWTTestCase
 
@@ -184,4 +186,61 @@
     XCTAssertNil(manager.currentDevice);
 }
 
+- (void) testLaterRegistrationSupersedesThePendingOne
+{
+    FWTNotifiableManager *manager = [[FWTNotifiableManager alloc] initWithURL:OCMOCK_ANY
+                                                                     accessId:OCMOCK_ANY
+                                                                    secretKey:OCMOCK_ANY
+                                                             didRegisterBlock:nil
+                                                         andNotificationBlock:nil];
+    [FWTNotifiableManager application:OCMOCK_ANY didRegisterForRemoteNotificationsWithDeviceToken:[@"test" dataUsingEncoding:NSUTF8StringEncoding]];
+    
+    NSMutableArray<FWTDeviceTokenIdResponse> *responses = [[NSMutableArray alloc] init];
+    void (^captureBlock)(NSInvocation *) = ^(NSInvocation *invocation) {
+        __unsafe_unretained FWTDeviceTokenIdResponse passedBlock;
+        [invocation getArgument:&passedBlock atIndex:8];
+        [responses addObject:[passedBlock copy]];
+    };
+    OCMStub([self.requesterManagerMock registerDeviceWithUserAlias:[OCMArg any]
+                                                             token:[OCMArg any]
+                                                              name:[OCMArg any]
+                                                            locale:[OCMArg any]
+                                                  customProperties:[OCMArg any]
+                                                platformProperties:[OCMArg any]
+                                                 completionHandler:[OCMArg any]]).andDo(captureBlock);
+    
+    XCTestExpectation *superseded = [self expectationWithDescription:@"Superseded"];
+    XCTestExpectation *registered = [self expectationWithDescription:@"Registered"];
+    FWTNotifiableOperation *first = [manager registerDeviceWithName:@"name"
+                                                          userAlias:@"first"
+                                                             locale:nil
+                                                   customProperties:nil
+                                                 platformProperties:nil
+                                               andCompletionHandler:^(FWTNotifiableDevice *device, NSError * _Nullable error) {
+                                                   XCTAssertEqual(error.code, FWTErrorCancelled);
+                                                   [superseded fulfill];
+                                               }];
+    FWTNotifiableOperation *second = [manager registerDeviceWithName:@"name"
+                                                           userAlias:@"second"
+                                                              locale:nil
+                                                    customProperties:nil
+                                                  platformProperties:nil
+                                                andCompletionHandler:^(FWTNotifiableDevice *device, NSError * _Nullable error) {
+                                                    XCTAssertNil(error);
+                                                    XCTAssertEqualObjects(device.user, @"second");
+                                                    [registered fulfill];
+                                                }];
+    XCTAssertTrue(first.isCancelled);
+    XCTAssertEqual(responses.count, 2);
+    
+    // The late response of the first registration doesn't override the device
+    responses[1](@42, nil);
+    responses[0](@41, nil);
+    
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(second.state, FWTNotifiableOperationStateFinished);
+    XCTAssertEqualObjects(manager.currentDevice.tokenId, @42);
+    XCTAssertEqualObjects(manager.currentDevice.user, @"second");
+}
+
 @end
@@ -0,0 +1,109 @@
+//
+//  FWTRequestCoalescerTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "FWTRequestCoalescer.h"
+#import "FWTNotifiableOperation.h"
+
+@interface FWTRequestCoalescerTests : XCTestCase
+
+@property (nonatomic, strong) FWTRequestCoalescer *coalescer;
+
+@end
+
+@implementation FWTRequestCoalescerTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.coalescer = [[FWTRequestCoalescer alloc] init];
+}
+
+- (void)testIdenticalRequestsJoinTheFirstOne
+{
+    XCTAssertTrue([self.coalescer addHandler:@"first" forKey:@"opened|42|1"]);
+    XCTAssertFalse([self.coalescer addHandler:@"second" forKey:@"opened|42|1"]);
+    XCTAssertTrue([self.coalescer addHandler:@"other" forKey:@"opened|42|2"]);
+    XCTAssertEqual(self.coalescer.count, 2);
+
+    XCTAssertEqualObjects([self.coalescer completeRequestWithKey:@"opened|42|1" remember:NO], (@[@"first", @"second"]));
+    XCTAssertEqualObjects([self.coalescer completeRequestWithKey:@"opened|42|1" remember:NO], @[]);
+    XCTAssertEqual(self.coalescer.count, 1);
+    XCTAssertTrue([self.coalescer addHandler:@"third" forKey:@"opened|42|1"]);
+}
+
+- (void)testCompletedRequestsAreRemembered
+{
+    [self.coalescer addHandler:@"handler" forKey:@"received|42|1"];
+    [self.coalescer completeRequestWithKey:@"received|42|1" remember:YES];
+    [self.coalescer addHandler:@"handler" forKey:@"received|42|2"];
+    [self.coalescer completeRequestWithKey:@"received|42|2" remember:NO];
+
+    XCTAssertTrue([self.coalescer didRecentlyCompleteRequestWithKey:@"received|42|1"]);
+    XCTAssertFalse([self.coalescer didRecentlyCompleteRequestWithKey:@"received|42|2"]);
+}
+
+- (void)testCompletedRequestsExpire
+{
+    self.coalescer.completedRequestLifetime = 0.1;
+    [self.coalescer addHandler:@"handler" forKey:@"received|42|1"];
+    [self.coalescer completeRequestWithKey:@"received|42|1" remember:YES];
+    XCTAssertTrue([self.coalescer didRecentlyCompleteRequestWithKey:@"received|42|1"]);
+
+    [NSThread sleepForTimeInterval:0.2];
+    XCTAssertFalse([self.coalescer didRecentlyCompleteRequestWithKey:@"received|42|1"]);
+}
+
+- (void)testRequestIsCancelledWhenAllTheCallersLeave
+{
+    FWTNotifiableOperation *request = nil;
+    FWTNotifiableOperation *joined = nil;
+    XCTAssertTrue([self.coalescer addHandler:@"first" forKey:@"register|42" request:&request]);
+    XCTAssertFalse([self.coalescer addHandler:@"second" forKey:@"register|42" request:&joined]);
+    XCTAssertEqual(request, joined);
+
+    XCTAssertFalse([self.coalescer removeHandler:@"first" forKey:@"register|42"]);
+    XCTAssertFalse(request.isCancelled);
+    XCTAssertTrue([self.coalescer removeHandler:@"second" forKey:@"register|42"]);
+    XCTAssertTrue(request.isCancelled);
+    XCTAssertEqual(self.coalescer.count, 0);
+
+    // A new request for the same key is not completed by the cancelled one
+    FWTNotifiableOperation *newRequest = nil;
+    XCTAssertTrue([self.coalescer addHandler:@"third" forKey:@"register|42" request:&newRequest]);
+    XCTAssertNotEqual(request, newRequest);
+    XCTAssertEqualObjects([self.coalescer completeRequest:request withKey:@"register|42" remember:NO], @[]);
+    XCTAssertEqualObjects([self.coalescer completeRequest:newRequest withKey:@"register|42" remember:NO], @[@"third"]);
+    XCTAssertTrue(newRequest.isFinished);
+    XCTAssertFalse(newRequest.isCancelled);
+}
+
+- (void)testKeysOfEqualDictionariesMatch
+{
+    NSMutableDictionary *first = [[NSMutableDictionary alloc] init];
+    NSMutableDictionary *second = [[NSMutableDictionary alloc] init];
+    for (NSInteger index = 0; index < 20; index++) {
+        first[[NSString stringWithFormat:@"key_%ld", (long)index]] = @(index);
+        second[[NSString stringWithFormat:@"key_%ld", (long)(19 - index)]] = @(19 - index);
+    }
+
+    NSString *key = [FWTRequestCoalescer keyWithComponents:@[@"register", first, [NSNull null]]];
+    XCTAssertEqualObjects(key, [FWTRequestCoalescer keyWithComponents:@[@"register", second, [NSNull null]]]);
+    second[@"key_0"] = @"changed";
+    XCTAssertNotEqualObjects(key, [FWTRequestCoalescer keyWithComponents:@[@"register", second, [NSNull null]]]);
+    XCTAssertNotEqualObjects(key, [FWTRequestCoalescer keyWithComponents:@[@"register", first, @"user"]]);
+}
+
+- (void)testKeysOfDifferentComponentsDoNotCollide
+{
+    XCTAssertNotEqualObjects([FWTRequestCoalescer keyWithComponents:@[@1]], [FWTRequestCoalescer keyWithComponents:@[@"1"]]);
+    XCTAssertNotEqualObjects([FWTRequestCoalescer keyWithComponents:@[[NSNull null]]], [FWTRequestCoalescer keyWithComponents:@[@"<null>"]]);
+    XCTAssertNotEqualObjects([FWTRequestCoalescer keyWithComponents:@[@"a|b", @"c"]], [FWTRequestCoalescer keyWithComponents:@[@"a", @"b|c"]]);
+    XCTAssertNotEqualObjects([FWTRequestCoalescer keyWithComponents:@[@{@"a": @"b;c=d"}]], [FWTRequestCoalescer keyWithComponents:@[@{@"a": @"b", @"c": @"d"}]]);
+    XCTAssertNotEqualObjects([FWTRequestCoalescer keyWithComponents:@[@[@"a,b"]]], [FWTRequestCoalescer keyWithComponents:@[@[@"a", @"b"]]]);
+}
+
+@end
@@ -0,0 +1,309 @@
+//
+//  FWTRequestPipelineBenchmarkTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTStubURLProtocol.h"
+#import <OCMock/OCMock.h>
+#import <malloc/malloc.h>
+#import <sys/resource.h>
+#import "FWTNotifiableManager.h"
+#import "FWTRequesterManager.h"
+#import "FWTHTTPRequester.h"
+#import "FWTNotifiableAuthenticator.h"
+
+static NSString * const FWTLoopbackHost = @"notifiable.loopback";
+static NSString * const FWTBenchmarkResultsEnvironmentKey = @"FWT_BENCHMARK_RESULTS";
+static NSUInteger const FWTPipelineBenchmarkIterations = 200;
+static NSUInteger const FWTReceiptBurstSize = 50;
+static NSUInteger const FWTRetryStormSize = 50;
+static NSUInteger const FWTRetryStormFailures = 2;
+static int64_t const FWTBenchmarkTimeout = 10 * NSEC_PER_SEC;
+
+static NSMutableDictionary<NSString *, NSNumber *> *loopbackFailures;
+static NSUInteger loopbackFailuresPerPath;
+static NSMutableArray<NSDictionary *> *benchmarkResults;
+
+/**
+ Response of the in-process stand-in of the Notifiable server to the device and notification
+ endpoints, failing each path with a 503 the configured number of times first.
+ */
+static FWTStubResponse *FWTLoopbackResponse(NSURLRequest *request)
+{
+    NSString *path = request.URL.path;
+    NSInteger statusCode = 200;
+    @synchronized([FWTStubURLProtocol class]) {
+        NSUInteger failures = [loopbackFailures[path] unsignedIntegerValue];
+        if (failures < loopbackFailuresPerPath) {
+            loopbackFailures[path] = @(failures + 1);
+            statusCode = 503;
+        }
+    }
+
+    NSData *body = [@"{}" dataUsingEncoding:NSUTF8StringEncoding];
+    if (statusCode == 200 && [request.HTTPMethod isEqualToString:@"POST"] && [path hasSuffix:@"device_tokens"]) {
+        body = [@"{\"id\":42}" dataUsingEncoding:NSUTF8StringEncoding];
+    }
+    return [FWTStubResponse responseWithStatusCode:statusCode body:body];
+}
+
+/**
+ Measures the full request pipeline, from the public calls to the loopback server and back:
+ serialization, signing, coalescing, retries and response handling.
+
+ Each benchmark reports the p50 and p99 latency, the CPU time and the growth of the heap per
+ operation. The results are written as JSON to the path in the FWT_BENCHMARK_RESULTS environment
+ variable, or to the temporary directory, and attached to the test run, so releases can be compared.
+ */
+@interface FWTRequestPipelineBenchmarkTests : FWTTestCase
+
+@property (nonatomic, strong) NSURLSession *session;
+@property (nonatomic, strong) FWTRequesterManager *requesterManager;
+
+@end
+
+@implementation FWTRequestPipelineBenchmarkTests
+
++ (void)setUp
+{
+    [super setUp];
+    benchmarkResults = [[NSMutableArray alloc] init];
+}
+
++ (void)tearDown
+{
+    NSDictionary *report = @{@"suite": NSStringFromClass(self),
+                             @"date": @([[NSDate date] timeIntervalSince1970]),
+                             @"results": benchmarkResults};
+    NSData *data = [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:nil];
+    NSString *path = [NSProcessInfo processInfo].environment[FWTBenchmarkResultsEnvironmentKey];
+    if (path.length == 0) {
+        path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"FWTRequestPipelineBenchmark.json"];
+    }
+    [data writeToFile:path atomically:YES];
+    NSLog(@"Benchmark results written to %@", path);
+    [super tearDown];
+}
+
+- (void)setUp
+{
+    [super setUp];
+    @synchronized([FWTStubURLProtocol class]) {
+        loopbackFailures = [[NSMutableDictionary alloc] init];
+        loopbackFailuresPerPath = 0;
+    }
+    [FWTStubURLProtocol reset];
+    FWTStubURLProtocol.recordsRequests = NO;
+    [FWTStubURLProtocol setResponseBlock:^FWTStubResponse *(NSURLRequest *request) {
+        return FWTLoopbackResponse(request);
+    }];
+
+    NSURLSessionConfiguration *configuration = [FWTStubURLProtocol stubbedConfiguration:[NSURLSessionConfiguration ephemeralSessionConfiguration]];
+    self.session = [NSURLSession sessionWithConfiguration:configuration];
+
+    FWTNotifiableAuthenticator *authenticator = [[FWTNotifiableAuthenticator alloc] initWithAccessId:@"access"
+                                                                                        andSecretKey:@"secret"];
+    FWTHTTPRequester *requester = [[FWTHTTPRequester alloc] initWithBaseURL:[self _serverURL]
+                                                                    session:self.session
+                                                           andAuthenticator:authenticator];
+    self.requesterManager = [[FWTRequesterManager alloc] initWithRequester:requester];
+    self.requesterManager.callbackQueue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+}
+
+- (void)tearDown
+{
+    [self.session invalidateAndCancel];
+    [FWTStubURLProtocol reset];
+    [super tearDown];
+}
+
+- (void)testRegisterBenchmark
+{
+    [self _benchmark:@"register" operations:FWTPipelineBenchmarkIterations concurrency:1 usingBlock:^(NSUInteger index, dispatch_block_t completion) {
+        [self.requesterManager registerDeviceWithUserAlias:@"user"
+                                                     token:[@"token" dataUsingEncoding:NSUTF8StringEncoding]
+                                                      name:[NSString stringWithFormat:@"device %lu", (unsigned long)index]
+                                                    locale:[NSLocale localeWithLocaleIdentifier:@"en_US"]
+                                          customProperties:nil
+                                        platformProperties:nil
+                                         completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+            XCTAssertEqualObjects(deviceTokenId, @42);
+            completion();
+        }];
+    }];
+}
+
+- (void)testUpdateBenchmark
+{
+    [self _benchmark:@"update" operations:FWTPipelineBenchmarkIterations concurrency:1 usingBlock:^(NSUInteger index, dispatch_block_t completion) {
+        [self.requesterManager updateDevice:@42
+                              withUserAlias:nil
+                                      token:nil
+                                       name:nil
+                                     locale:nil
+                           customProperties:@{@"index": @(index)}
+                         platformProperties:nil
+                          completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+            XCTAssertNil(error);
+            completion();
+        }];
+    }];
+}
+
+- (void)testReceiptBurstBenchmark
+{
+    [self _benchmark:@"receipt_burst" operations:FWTPipelineBenchmarkIterations concurrency:FWTReceiptBurstSize usingBlock:^(NSUInteger index, dispatch_block_t completion) {
+        [self.requesterManager markNotificationAsReceivedWithId:@(index + 1)
+                                                  deviceTokenId:@42
+                                              completionHandler:^(BOOL success, NSError * _Nullable error) {
+            XCTAssertTrue(success);
+            completion();
+        }];
+    }];
+}
+
+- (void)testRetryStormBenchmark
+{
+    @synchronized([FWTStubURLProtocol class]) {
+        loopbackFailuresPerPath = FWTRetryStormFailures;
+    }
+    self.requesterManager.retryAttempts = FWTRetryStormFailures + 1;
+    self.requesterManager.retryDelay = 0.001;
+    self.requesterManager.maxRetryDelay = 0.005;
+
+    [self _benchmark:@"retry_storm" operations:FWTPipelineBenchmarkIterations concurrency:FWTRetryStormSize usingBlock:^(NSUInteger index, dispatch_block_t completion) {
+        // Each device path fails twice before the server accepts it
+        [self.requesterManager updateDevice:@(index + 1)
+                              withUserAlias:nil
+                                      token:nil
+                                       name:@"device"
+                                     locale:nil
+                           customProperties:nil
+                         platformProperties:nil
+                          completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+            XCTAssertNil(error);
+            completion();
+        }];
+    }];
+}
+
+- (void)testManagerRegisterAndUpdateBenchmark
+{
+    [FWTNotifiableManager application:OCMOCK_ANY didRegisterForRemoteNotificationsWithDeviceToken:[@"token" dataUsingEncoding:NSUTF8StringEncoding]];
+    FWTNotifiableManager *manager = [[FWTNotifiableManager alloc] initWithURL:[self _serverURL]
+                                                                     accessId:@"access"
+                                                                    secretKey:@"secret"
+                                                                   urlSession:self.session
+                                                             didRegisterBlock:nil
+                                                         andNotificationBlock:nil];
+    manager.callbackQueue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+
+    [self _benchmark:@"manager_register_update" operations:FWTPipelineBenchmarkIterations concurrency:1 usingBlock:^(NSUInteger index, dispatch_block_t completion) {
+        [manager registerDeviceWithName:@"device"
+                              userAlias:@"user"
+                                 locale:[NSLocale localeWithLocaleIdentifier:@"en_US"]
+                       customProperties:nil
+                   andCompletionHandler:^(FWTNotifiableDevice * _Nullable device, NSError * _Nullable error) {
+            XCTAssertNil(error);
+            [manager updateDeviceToken:nil
+                            deviceName:nil
+                             userAlias:nil
+                                locale:nil
+                      customProperties:@{@"index": @(index)}
+                    platformProperties:nil
+                     completionHandler:^(FWTNotifiableDevice * _Nullable device, NSError * _Nullable error) {
+                XCTAssertNil(error);
+                completion();
+            }];
+        }];
+    }];
+}
+
+#pragma mark - Private
+
+- (NSURL *)_serverURL
+{
+    return [NSURL URLWithString:[NSString stringWithFormat:@"https://%@", FWTLoopbackHost]];
+}
+
+/**
+ Run the operations in rounds of `concurrency` operations started together, waiting for each round
+ to finish before the next one. The latency of an operation goes from its start to its completion.
+ */
+- (void)_benchmark:(NSString *)name
+        operations:(NSUInteger)operations
+       concurrency:(NSUInteger)concurrency
+        usingBlock:(void(^)(NSUInteger index, dispatch_block_t completion))block
+{
+    uint64_t *latencies = calloc(operations, sizeof(uint64_t));
+    struct rusage startUsage;
+    getrusage(RUSAGE_SELF, &startUsage);
+    malloc_statistics_t startHeap;
+    malloc_zone_statistics(NULL, &startHeap);
+
+    for (NSUInteger round = 0; round < operations; round += concurrency) {
+        dispatch_group_t group = dispatch_group_create();
+        NSUInteger end = MIN(round + concurrency, operations);
+        for (NSUInteger index = round; index < end; index++) {
+            dispatch_group_enter(group);
+            uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+            block(index, ^{
+                latencies[index] = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start;
+                dispatch_group_leave(group);
+            });
+        }
+        if (dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, FWTBenchmarkTimeout)) != 0) {
+            XCTFail(@"%@ timed out", name);
+            free(latencies);
+            return;
+        }
+    }
+
+    struct rusage endUsage;
+    getrusage(RUSAGE_SELF, &endUsage);
+    malloc_statistics_t endHeap;
+    malloc_zone_statistics(NULL, &endHeap);
+
+    NSMutableArray<NSNumber *> *sortedLatencies = [[NSMutableArray alloc] initWithCapacity:operations];
+    for (NSUInteger index = 0; index < operations; index++) {
+        [sortedLatencies addObject:@(latencies[index])];
+    }
+    free(latencies);
+    [sortedLatencies sortUsingSelector:@selector(compare:)];
+
+    double cpuTime = [self _secondsOfTime:endUsage.ru_utime] + [self _secondsOfTime:endUsage.ru_stime]
+                     - [self _secondsOfTime:startUsage.ru_utime] - [self _secondsOfTime:startUsage.ru_stime];
+    double heapGrowth = (double)endHeap.size_in_use - (double)startHeap.size_in_use;
+    NSDictionary *result = @{@"name": name,
+                             @"operations": @(operations),
+                             @"concurrency": @(concurrency),
+                             @"p50_ms": @([self _percentile:0.5 ofSortedLatencies:sortedLatencies] / 1e6),
+                             @"p99_ms": @([self _percentile:0.99 ofSortedLatencies:sortedLatencies] / 1e6),
+                             @"cpu_ms_per_operation": @(cpuTime * 1e3 / operations),
+                             @"heap_growth_bytes_per_operation": @(heapGrowth / operations)};
+    @synchronized(benchmarkResults) {
+        [benchmarkResults addObject:result];
+    }
+
+    XCTAttachment *attachment = [XCTAttachment attachmentWithPlistObject:result];
+    attachment.name = name;
+    attachment.lifetime = XCTAttachmentLifetimeKeepAlways;
+    [self addAttachment:attachment];
+    NSLog(@"%@", result);
+}
+
+- (double)_percentile:(double)percentile ofSortedLatencies:(NSArray<NSNumber *> *)latencies
+{
+    NSUInteger rank = (NSUInteger)ceil(percentile * latencies.count);
+    NSUInteger index = MIN(MAX(rank, 1), latencies.count) - 1;
+    return [latencies[index] doubleValue];
+}
+
+- (double)_secondsOfTime:(struct timeval)time
+{
+    return time.tv_sec + time.tv_usec / 1e6;
+}
+
+@end
@@ -0,0 +1,138 @@
+//
+//  FWTRequestTemplateTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTRequestTemplate.h"
+#import "FWTHTTPRequestSerializer.h"
+#import "FWTHTTPSessionManager.h"
+
+extern NSString * const FWTDeviceTokensPath;
+extern NSString * const FWTDeviceTokenPath;
+extern NSString * const FWTNotificationOpenPath;
+extern NSString * const FWTNotificationReceivedPath;
+extern NSString * const FWTNotificationBulkReceivedPath;
+
+static NSUInteger const FWTReceiptBurstSize = 1000;
+
+@interface FWTRequestTemplateTests : FWTTestCase
+
+@property (nonatomic, strong) FWTHTTPRequestSerializer *serializer;
+@property (nonatomic, copy) NSArray<NSString *> *notificationIds;
+@property (nonatomic, copy) NSDictionary<NSString *, NSString *> *headers;
+
+@end
+
+@implementation FWTRequestTemplateTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.serializer = [[FWTHTTPRequestSerializer alloc] init];
+    NSMutableArray<NSString *> *notificationIds = [[NSMutableArray alloc] initWithCapacity:FWTReceiptBurstSize];
+    for (NSUInteger index = 0; index < FWTReceiptBurstSize; index++) {
+        [notificationIds addObject:[@(index + 1000) stringValue]];
+    }
+    self.notificationIds = notificationIds;
+    self.headers = @{@"User-Agent": @"Notifiable-iOS"};
+}
+
+- (void)testURLMatchesTheAppendedPath
+{
+    NSArray<NSString *> *baseURLs = @[@"https://notifiable.test", @"https://notifiable.test/", @"http://localhost:3000/base"];
+    NSArray<NSString *> *pathTemplates = @[FWTDeviceTokensPath, FWTDeviceTokenPath, FWTNotificationOpenPath, FWTNotificationReceivedPath, FWTNotificationBulkReceivedPath];
+    for (NSString *baseURLString in baseURLs) {
+        NSURL *baseURL = [NSURL URLWithString:baseURLString];
+        for (NSString *pathTemplate in pathTemplates) {
+            FWTRequestTemplate *requestTemplate = [[FWTRequestTemplate alloc] initWithBaseURL:baseURL
+                                                                                 pathTemplate:pathTemplate
+                                                                                       method:FWTHTTPMethodPOST];
+            NSString *path = [pathTemplate stringByReplacingOccurrencesOfString:@"%@" withString:@"42"];
+            XCTAssertEqualObjects([requestTemplate pathWithIdentifier:@"42"], path);
+            XCTAssertEqualObjects([requestTemplate URLWithPath:path].absoluteString, [baseURL URLByAppendingPathComponent:path].absoluteString);
+        }
+    }
+}
+
+- (void)testEndpointOfTheTemplate
+{
+    NSURL *baseURL = [NSURL URLWithString:@"https://notifiable.test"];
+    XCTAssertEqual([[FWTRequestTemplate alloc] initWithBaseURL:baseURL pathTemplate:FWTDeviceTokensPath method:FWTHTTPMethodPOST].endpoint, FWTNotifiableMetricsEndpointRegisterDevice);
+    XCTAssertEqual([[FWTRequestTemplate alloc] initWithBaseURL:baseURL pathTemplate:FWTDeviceTokenPath method:FWTHTTPMethodPATCH].endpoint, FWTNotifiableMetricsEndpointUpdateDevice);
+    XCTAssertEqual([[FWTRequestTemplate alloc] initWithBaseURL:baseURL pathTemplate:FWTNotificationOpenPath method:FWTHTTPMethodPOST].endpoint, FWTNotifiableMetricsEndpointNotificationOpened);
+    XCTAssertEqual([[FWTRequestTemplate alloc] initWithBaseURL:baseURL pathTemplate:FWTNotificationReceivedPath method:FWTHTTPMethodPOST].endpoint, FWTNotifiableMetricsEndpointNotificationReceived);
+    XCTAssertEqual([[FWTRequestTemplate alloc] initWithBaseURL:baseURL pathTemplate:@"api/v2/other" method:FWTHTTPMethodGET].endpoint, FWTNotifiableMetricsEndpointOther);
+}
+
+- (void)testRequestMatchesTheUntemplatedRequest
+{
+    NSURL *baseURL = [NSURL URLWithString:@"https://notifiable.test"];
+    NSDictionary *parameters = @{@"device_token_id": @"42"};
+    for (NSNumber *method in @[@(FWTHTTPMethodPOST), @(FWTHTTPMethodPATCH), @(FWTHTTPMethodGET)]) {
+        FWTRequestTemplate *requestTemplate = [[FWTRequestTemplate alloc] initWithBaseURL:baseURL
+                                                                             pathTemplate:FWTNotificationReceivedPath
+                                                                                   method:method.unsignedIntegerValue];
+        NSString *path = [requestTemplate pathWithIdentifier:@"7"];
+        NSURLRequest *expected = [self.serializer buildRequestWithBaseURL:[baseURL URLByAppendingPathComponent:path]
+                                                               parameters:parameters
+                                                               andHeaders:self.headers
+                                                                forMethod:method.unsignedIntegerValue];
+        NSURLRequest *request = [self.serializer buildRequestWithTemplate:requestTemplate
+                                                                      URL:[requestTemplate URLWithPath:path]
+                                                               parameters:parameters
+                                                               andHeaders:self.headers];
+        XCTAssertEqualObjects(request.URL, expected.URL);
+        XCTAssertEqualObjects(request.HTTPMethod, expected.HTTPMethod);
+        XCTAssertEqualObjects(request.allHTTPHeaderFields, expected.allHTTPHeaderFields);
+        XCTAssertEqualObjects(request.HTTPBody, expected.HTTPBody);
+        XCTAssertEqual(request.cachePolicy, expected.cachePolicy);
+    }
+}
+
+- (void)testSessionManagerCachesTheTemplates
+{
+    FWTHTTPSessionManager *sessionManager = [[FWTHTTPSessionManager alloc] initWithBaseURL:[NSURL URLWithString:@"https://notifiable.test"]
+                                                                                   session:[NSURLSession sharedSession]];
+    FWTRequestTemplate *requestTemplate = [sessionManager requestTemplateForPath:FWTDeviceTokenPath method:FWTHTTPMethodPATCH];
+    XCTAssertEqual([sessionManager requestTemplateForPath:FWTDeviceTokenPath method:FWTHTTPMethodPATCH], requestTemplate);
+    XCTAssertNotEqual([sessionManager requestTemplateForPath:FWTDeviceTokenPath method:FWTHTTPMethodDELETE], requestTemplate);
+    XCTAssertEqual([sessionManager requestTemplateForPath:FWTDeviceTokenPath method:FWTHTTPMethodDELETE].method, FWTHTTPMethodDELETE);
+}
+
+- (void)testPerformanceReceiptBurstWithFormattedPaths
+{
+    NSURL *baseURL = [NSURL URLWithString:@"https://notifiable.test"];
+    [self measureBlock:^{
+        for (NSString *notificationId in self.notificationIds) {
+            @autoreleasepool {
+                NSString *path = [NSString stringWithFormat:FWTNotificationReceivedPath, notificationId];
+                [self.serializer buildRequestWithBaseURL:[baseURL URLByAppendingPathComponent:path]
+                                              parameters:@{@"device_token_id": @"42"}
+                                              andHeaders:self.headers
+                                               forMethod:FWTHTTPMethodPOST];
+            }
+        }
+    }];
+}
+
+- (void)testPerformanceReceiptBurstWithTemplate
+{
+    FWTRequestTemplate *requestTemplate = [[FWTRequestTemplate alloc] initWithBaseURL:[NSURL URLWithString:@"https://notifiable.test"]
+                                                                         pathTemplate:FWTNotificationReceivedPath
+                                                                               method:FWTHTTPMethodPOST];
+    [self measureBlock:^{
+        for (NSString *notificationId in self.notificationIds) {
+            @autoreleasepool {
+                NSString *path = [requestTemplate pathWithIdentifier:notificationId];
+                [self.serializer buildRequestWithTemplate:requestTemplate
+                                                      URL:[requestTemplate URLWithPath:path]
+                                               parameters:@{@"device_token_id": @"42"}
+                                               andHeaders:self.headers];
+            }
+        }
+    }];
+}
+
+@end
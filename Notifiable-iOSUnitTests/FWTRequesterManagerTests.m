@@ -13,9 +13,15 @@
 #import "FWTNotifiableLogger.h"
 #import "NSData+FWTNotifiable.h"
 #import "NSError+FWTNotifiable.h"
+#import "FWTHTTPSessionManager.h"
+#import "FWTNotifiableOperation.h"
+#import "FWTRetryScheduler.h"
+#import "FWTRequestDeadline.h"
 
 typedef BOOL(^FWTParameterValidationBlock)(NSDictionary *params);
 
+@class FWTNotifiableOperation;
+
 @interface FWTRequesterManager (Private)
 
 - (void)_updateDevice:(NSNumber *)deviceTokenId
@@ -27,6 +33,8 @@ typedef BOOL(^FWTParameterValidationBlock)(NSDictionary *params);
    platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
              attempts:(NSUInteger)attempts
         previousError:(NSError *)previousError
+             deadline:(FWTRequestDeadline *)deadline
+              request:(FWTNotifiableOperation *)request
     completionHandler:(FWTDeviceTokenIdResponse)handler;
 
 - (void)_registerDeviceWithUserAlias:(NSString *)userAlias
@@ -37,6 +45,8 @@ typedef BOOL(^FWTParameterValidationBlock)(NSDictionary *params);
                   platformProperties:(NSDictionary<NSString *, id> * _Nullable)platformProperties
                             attempts:(NSUInteger)attempts
                        previousError:(NSError *)previousError
+                            deadline:(FWTRequestDeadline *)deadline
+                             request:(FWTNotifiableOperation *)request
                    completionHandler:(FWTDeviceTokenIdResponse)handler;
 
 @end
@@ -284,6 +294,8 @@ typedef BOOL(^FWTParameterValidationBlock)(NSDictionary *params);
                               platformProperties:OCMOCK_ANY
                                         attempts:1
                                    previousError:OCMOCK_ANY
+                                        deadline:OCMOCK_ANY
+                                         request:OCMOCK_ANY
                                completionHandler:OCMOCK_ANY]).andForwardToRealObject();
     
     self.manager.retryAttempts = 2;
@@ -529,6 +541,8 @@ typedef BOOL(^FWTParameterValidationBlock)(NSDictionary *params);
                       platformProperties:OCMOCK_ANY
                                 attempts:1
                            previousError:OCMOCK_ANY
+                                deadline:OCMOCK_ANY
+                                 request:OCMOCK_ANY
                        completionHandler:OCMOCK_ANY]).andForwardToRealObject();
     
     self.manager.retryAttempts = 2;
@@ -593,6 +607,432 @@ typedef BOOL(^FWTParameterValidationBlock)(NSDictionary *params);
     OCMVerifyAll(self.httpRequesterMock);
 }
 
+#pragma mark - In-flight requests
+
+- (void)testIdenticalRegistersShareTheRequest
+{
+    __block NSInteger requests = 0;
+    __block FWTRequestManagerSuccessBlock success;
+    void(^block)(NSInvocation *) = ^(NSInvocation *invocation) {
+        FWTRequestManagerSuccessBlock argument;
+        [invocation getArgument:&argument atIndex:3];
+        requests += 1;
+        success = argument;
+    };
+    OCMStub([self.httpRequesterMock registerDeviceWithParams:OCMOCK_ANY
+                                                     success:OCMOCK_ANY
+                                                     failure:OCMOCK_ANY]).andDo(block);
+    
+    XCTestExpectation *first = [self expectationWithDescription:@"first"];
+    XCTestExpectation *second = [self expectationWithDescription:@"second"];
+    for (XCTestExpectation *expectation in @[first, second]) {
+        [self.manager registerDeviceWithUserAlias:@"user"
+                                            token:self.token
+                                             name:@"name"
+                                           locale:[NSLocale localeWithLocaleIdentifier:@"en_GB"]
+                                 customProperties:@{@"onsite": @YES, @"level": @3}
+                               platformProperties:nil
+                                completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+                                    XCTAssertEqualObjects(deviceTokenId, @42);
+                                    XCTAssertNil(error);
+                                    [expectation fulfill];
+                                }];
+    }
+    success(@{@"id": @42});
+    
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(requests, 1);
+}
+
+- (void)testDeliveredReceiptsAreNotSentAgain
+{
+    __block NSInteger requests = 0;
+    void(^block)(NSInvocation *) = ^(NSInvocation *invocation) {
+        FWTRequestManagerSuccessBlock success;
+        [invocation getArgument:&success atIndex:4];
+        requests += 1;
+        success(nil);
+    };
+    OCMStub([self.httpRequesterMock markNotificationAsReceivedWithId:@"1"
+                                                       deviceTokenId:@"42"
+                                                             success:OCMOCK_ANY
+                                                             failure:OCMOCK_ANY]).andDo(block);
+    
+    XCTestExpectation *first = [self expectationWithDescription:@"first"];
+    [self.manager markNotificationAsReceivedWithId:@1 deviceTokenId:@42 completionHandler:^(BOOL success, NSError * _Nullable error) {
+        XCTAssertTrue(success);
+        [first fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    
+    XCTestExpectation *duplicate = [self expectationWithDescription:@"duplicate"];
+    [self.manager markNotificationAsReceivedWithId:@1 deviceTokenId:@42 completionHandler:^(BOOL success, NSError * _Nullable error) {
+        XCTAssertTrue(success);
+        [duplicate fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(requests, 1);
+    
+    self.manager.receiptDeduplicationInterval = 0;
+    XCTestExpectation *resent = [self expectationWithDescription:@"resent"];
+    [self.manager markNotificationAsReceivedWithId:@1 deviceTokenId:@42 completionHandler:^(BOOL success, NSError * _Nullable error) {
+        [resent fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(requests, 2);
+}
+
+#pragma mark - Receipt batching
+
+- (void)testReceiptsAreBatched
+{
+    void(^block)(NSInvocation *) = ^(NSInvocation *invocation) {
+        FWTRequestManagerSuccessBlock success;
+        [invocation getArgument:&success atIndex:4];
+        success(@{@"results": @{@"2": @404}});
+    };
+    OCMExpect([self.httpRequesterMock markNotificationsAsReceivedWithIds:(@[@"1", @"2", @"3"])
+                                                           deviceTokenId:@"42"
+                                                                 success:OCMOCK_ANY
+                                                                 failure:OCMOCK_ANY]).andDo(block);
+    OCMReject([self.httpRequesterMock markNotificationAsReceivedWithId:OCMOCK_ANY
+                                                         deviceTokenId:OCMOCK_ANY
+                                                               success:OCMOCK_ANY
+                                                               failure:OCMOCK_ANY]);
+    
+    self.manager.receiptBatchWindow = 0.1;
+    self.manager.receiptBatchSize = 3;
+    
+    NSMutableArray<XCTestExpectation *> *expectations = [[NSMutableArray alloc] init];
+    for (NSNumber *notificationId in @[@1, @2, @3]) {
+        XCTestExpectation *expectation = [self expectationWithDescription:[notificationId stringValue]];
+        [expectations addObject:expectation];
+        [self.manager markNotificationAsReceivedWithId:notificationId
+                                         deviceTokenId:@42
+                                     completionHandler:^(BOOL success, NSError * _Nullable error) {
+                                         XCTAssertEqual(success, ![notificationId isEqualToNumber:@2]);
+                                         [expectation fulfill];
+                                     }];
+    }
+    
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    OCMVerifyAll(self.httpRequesterMock);
+}
+
+- (void)testReceiptsFallbackWhenBulkIsNotSupported
+{
+    void(^failureBlock)(NSInvocation *) = ^(NSInvocation *invocation) {
+        FWTRequestManagerFailureBlock failure;
+        [invocation getArgument:&failure atIndex:5];
+        failure(404, [NSError errorWithDomain:@"FWTNotifiableError" code:404 userInfo:nil]);
+    };
+    void(^successBlock)(NSInvocation *) = ^(NSInvocation *invocation) {
+        FWTRequestManagerSuccessBlock success;
+        [invocation getArgument:&success atIndex:4];
+        success(nil);
+    };
+    OCMExpect([self.httpRequesterMock markNotificationsAsReceivedWithIds:OCMOCK_ANY
+                                                           deviceTokenId:@"42"
+                                                                 success:OCMOCK_ANY
+                                                                 failure:OCMOCK_ANY]).andDo(failureBlock);
+    OCMStub([self.httpRequesterMock markNotificationAsReceivedWithId:OCMOCK_ANY
+                                                       deviceTokenId:@"42"
+                                                             success:OCMOCK_ANY
+                                                             failure:OCMOCK_ANY]).andDo(successBlock);
+    
+    self.manager.receiptBatchWindow = 0.1;
+    
+    XCTestExpectation *first = [self expectationWithDescription:@"first"];
+    XCTestExpectation *second = [self expectationWithDescription:@"second"];
+    [self.manager markNotificationAsReceivedWithId:@1 deviceTokenId:@42 completionHandler:^(BOOL success, NSError * _Nullable error) {
+        XCTAssertTrue(success);
+        [first fulfill];
+    }];
+    [self.manager markNotificationAsReceivedWithId:@2 deviceTokenId:@42 completionHandler:^(BOOL success, NSError * _Nullable error) {
+        XCTAssertTrue(success);
+        [second fulfill];
+    }];
+    
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    OCMVerifyAll(self.httpRequesterMock);
+}
+
+- (void)testBulkReceiptsAreRetriedWhenTheServerFails
+{
+    __block NSInteger requests = 0;
+    void(^block)(NSInvocation *) = ^(NSInvocation *invocation) {
+        requests += 1;
+        if (requests == 1) {
+            FWTRequestManagerFailureBlock failure;
+            [invocation getArgument:&failure atIndex:5];
+            failure(503, [NSError errorWithDomain:@"FWTNotifiableError" code:503 userInfo:nil]);
+        } else {
+            FWTRequestManagerSuccessBlock success;
+            [invocation getArgument:&success atIndex:4];
+            success(nil);
+        }
+    };
+    OCMStub([self.httpRequesterMock markNotificationsAsReceivedWithIds:(@[@"1", @"2"])
+                                                         deviceTokenId:@"42"
+                                                               success:OCMOCK_ANY
+                                                               failure:OCMOCK_ANY]).andDo(block);
+    OCMReject([self.httpRequesterMock markNotificationAsReceivedWithId:OCMOCK_ANY
+                                                         deviceTokenId:OCMOCK_ANY
+                                                               success:OCMOCK_ANY
+                                                               failure:OCMOCK_ANY]);
+
+    self.manager.receiptBatchWindow = 0.1;
+    self.manager.retryDelay = 0.1;
+
+    XCTestExpectation *first = [self expectationWithDescription:@"first"];
+    XCTestExpectation *second = [self expectationWithDescription:@"second"];
+    [self.manager markNotificationAsReceivedWithId:@1 deviceTokenId:@42 timeout:5 completionHandler:^(BOOL success, NSError * _Nullable error) {
+        XCTAssertTrue(success);
+        [first fulfill];
+    }];
+    [self.manager markNotificationAsReceivedWithId:@2 deviceTokenId:@42 timeout:5 completionHandler:^(BOOL success, NSError * _Nullable error) {
+        XCTAssertTrue(success);
+        [second fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(requests, 2);
+    OCMVerifyAll(self.httpRequesterMock);
+}
+
+- (void)testRetryIsSkippedWhenItWouldMissTheDeadline
+{
+    __block NSInteger requests = 0;
+    void(^failureBlock)(NSInvocation *) = ^(NSInvocation *invocation) {
+        FWTRequestManagerFailureBlock failure;
+        [invocation getArgument:&failure atIndex:5];
+        requests += 1;
+        failure(404, [NSError errorWithDomain:@"FWTNotifiableError" code:503 userInfo:@{FWTHTTPRetryAfterErrorKey: @60}]);
+    };
+    OCMStub([self.httpRequesterMock markNotificationAsReceivedWithId:@"1"
+                                                       deviceTokenId:@"42"
+                                                             success:OCMOCK_ANY
+                                                             failure:OCMOCK_ANY]).andDo(failureBlock);
+    
+    self.manager.maxRetryDelay = 60;
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Deadline"];
+    [self.manager markNotificationAsReceivedWithId:@1 deviceTokenId:@42 timeout:5 completionHandler:^(BOOL success, NSError * _Nullable error) {
+        XCTAssertFalse(success);
+        XCTAssertEqual(error.code, NSURLErrorTimedOut);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(requests, 1);
+}
+
+- (void)testOperationExpiresWhileWaitingForTheServer
+{
+    OCMStub([self.httpRequesterMock markNotificationAsReceivedWithId:OCMOCK_ANY
+                                                       deviceTokenId:OCMOCK_ANY
+                                                             success:OCMOCK_ANY
+                                                             failure:OCMOCK_ANY]);
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Deadline"];
+    [self.manager markNotificationAsReceivedWithId:@1 deviceTokenId:@42 timeout:0.2 completionHandler:^(BOOL success, NSError * _Nullable error) {
+        XCTAssertFalse(success);
+        XCTAssertEqual(error.code, NSURLErrorTimedOut);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+#pragma mark - Queues
+
+- (void)testCustomCallbackQueueKeepsTheWorkOffTheMainQueue
+{
+    static void *FWTCallbackQueueKey = &FWTCallbackQueueKey;
+    dispatch_queue_t callbackQueue = dispatch_queue_create("com.futureworkshops.notifiable.tests.callback", DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(callbackQueue, FWTCallbackQueueKey, FWTCallbackQueueKey, NULL);
+    
+    __block NSInteger requests = 0;
+    __block BOOL usedMainThread = NO;
+    void(^block)(NSInvocation *) = ^(NSInvocation *invocation) {
+        __unsafe_unretained FWTRequestManagerSuccessBlock successArgument;
+        __unsafe_unretained FWTRequestManagerFailureBlock failureArgument;
+        [invocation getArgument:&successArgument atIndex:4];
+        [invocation getArgument:&failureArgument atIndex:5];
+        FWTRequestManagerSuccessBlock success = successArgument;
+        FWTRequestManagerFailureBlock failure = failureArgument;
+        requests += 1;
+        NSInteger request = requests;
+        if (request > 1) {
+            usedMainThread = usedMainThread || [NSThread isMainThread];
+        }
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            if (request == 1) {
+                failure(500, [NSError errorWithDomain:@"FWTNotifiableError" code:500 userInfo:nil]);
+            } else {
+                success(@{});
+            }
+        });
+    };
+    OCMStub([self.httpRequesterMock updateDeviceWithTokenId:OCMOCK_ANY
+                                                     params:OCMOCK_ANY
+                                                    success:OCMOCK_ANY
+                                                    failure:OCMOCK_ANY]).andDo(block);
+    
+    self.manager.callbackQueue = callbackQueue;
+    self.manager.retryDelay = 0.1;
+    
+    // The main thread stays blocked, so any work sent to the main queue would never finish
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block BOOL calledOnCallbackQueue = NO;
+    __block NSError *result = nil;
+    [self.manager updateDevice:@42
+                 withUserAlias:@"user"
+                         token:nil
+                          name:nil
+                        locale:nil
+              customProperties:nil
+            platformProperties:nil
+             completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+                 calledOnCallbackQueue = dispatch_get_specific(FWTCallbackQueueKey) == FWTCallbackQueueKey;
+                 result = error;
+                 dispatch_semaphore_signal(semaphore);
+             }];
+    
+    long timedOut = dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2 * NSEC_PER_SEC)));
+    XCTAssertEqual(timedOut, 0);
+    XCTAssertTrue(calledOnCallbackQueue);
+    XCTAssertNil(result);
+    XCTAssertEqual(requests, 2);
+    XCTAssertFalse(usedMainThread);
+}
+
+#pragma mark - Cancellation
+
+- (void)testCancellingStopsThePendingRetry
+{
+    __block NSInteger requests = 0;
+    void(^block)(NSInvocation *) = ^(NSInvocation *invocation) {
+        __unsafe_unretained FWTRequestManagerFailureBlock failure;
+        [invocation getArgument:&failure atIndex:4];
+        requests += 1;
+        failure(500, [NSError errorWithDomain:@"FWTNotifiableError" code:500 userInfo:nil]);
+    };
+    OCMStub([self.httpRequesterMock unregisterTokenId:OCMOCK_ANY
+                                              success:OCMOCK_ANY
+                                              failure:OCMOCK_ANY]).andDo(block);
+    
+    self.manager.retryAttempts = 2;
+    self.manager.retryDelay = 0.3;
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Cancelled"];
+    FWTNotifiableOperation *operation = [self.manager unregisterTokenId:@42 completionHandler:^(BOOL success, NSError * _Nullable error) {
+        XCTAssertFalse(success);
+        XCTAssertEqual(error.code, FWTErrorCancelled);
+        [expectation fulfill];
+    }];
+    XCTAssertEqual(operation.state, FWTNotifiableOperationStateExecuting);
+    [operation cancel];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    
+    XCTAssertTrue(operation.isCancelled);
+    XCTAssertTrue(operation.progress.isCancelled);
+    // Waits past the retry delay, to be sure the retry never runs
+    XCTestExpectation *retryDelay = [self expectationWithDescription:@"Retry delay"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [retryDelay fulfill];
+    });
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(requests, 1);
+    XCTAssertEqual(self.manager.retryScheduler.pendingRetries, 0);
+}
+
+- (void)testExpiredDeadlineCancelsThePendingRetry
+{
+    FWTRequestDeadline *deadline = [[FWTRequestDeadline alloc] initWithTimeout:10];
+    __block BOOL retried = NO;
+    dispatch_block_t cancelRetry = [self.manager.retryScheduler scheduleOperation:^(dispatch_block_t completion) {
+        retried = YES;
+        completion();
+    } afterDelay:0.2];
+    [deadline addExpirationHandler:cancelRetry];
+    XCTAssertEqual(self.manager.retryScheduler.pendingRetries, 1);
+    
+    [deadline expire];
+    XCTAssertEqual(self.manager.retryScheduler.pendingRetries, 0);
+    
+    __block BOOL calledAfterExpiration = NO;
+    [deadline addExpirationHandler:^{
+        calledAfterExpiration = YES;
+    }];
+    XCTAssertTrue(calledAfterExpiration);
+    
+    XCTestExpectation *retryDelay = [self expectationWithDescription:@"Retry delay"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.3 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [retryDelay fulfill];
+    });
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertFalse(retried);
+}
+
+- (void)testFinishedDeadlineDropsTheExpirationHandlers
+{
+    FWTRequestDeadline *deadline = [[FWTRequestDeadline alloc] initWithTimeout:10];
+    __block BOOL expired = NO;
+    [deadline addExpirationHandler:^{
+        expired = YES;
+    }];
+    XCTAssertTrue([deadline finish]);
+    [deadline expire];
+    XCTAssertFalse(expired);
+}
+
+- (void)testCancelledCallerLeavesTheSharedRequest
+{
+    __block NSInteger requests = 0;
+    __block FWTRequestManagerSuccessBlock success;
+    void(^block)(NSInvocation *) = ^(NSInvocation *invocation) {
+        __unsafe_unretained FWTRequestManagerSuccessBlock argument;
+        [invocation getArgument:&argument atIndex:3];
+        requests += 1;
+        success = argument;
+    };
+    OCMStub([self.httpRequesterMock registerDeviceWithParams:OCMOCK_ANY
+                                                     success:OCMOCK_ANY
+                                                     failure:OCMOCK_ANY]).andDo(block);
+    
+    XCTestExpectation *cancelled = [self expectationWithDescription:@"Cancelled"];
+    XCTestExpectation *registered = [self expectationWithDescription:@"Registered"];
+    FWTNotifiableOperation *first = [self.manager registerDeviceWithUserAlias:@"user"
+                                                                        token:self.token
+                                                                         name:nil
+                                                                       locale:nil
+                                                             customProperties:nil
+                                                           platformProperties:nil
+                                                            completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+                                                                XCTAssertNil(deviceTokenId);
+                                                                XCTAssertEqual(error.code, FWTErrorCancelled);
+                                                                [cancelled fulfill];
+                                                            }];
+    FWTNotifiableOperation *second = [self.manager registerDeviceWithUserAlias:@"user"
+                                                                         token:self.token
+                                                                          name:nil
+                                                                        locale:nil
+                                                              customProperties:nil
+                                                            platformProperties:nil
+                                                             completionHandler:^(NSNumber * _Nullable deviceTokenId, NSError * _Nullable error) {
+                                                                 XCTAssertEqualObjects(deviceTokenId, @42);
+                                                                 XCTAssertNil(error);
+                                                                 [registered fulfill];
+                                                             }];
+    [first cancel];
+    success(@{@"id": @42});
+    
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(requests, 1);
+    XCTAssertEqual(first.state, FWTNotifiableOperationStateCancelled);
+    XCTAssertEqual(second.state, FWTNotifiableOperationStateFinished);
+    XCTAssertEqual(second.progress.fractionCompleted, 1);
+}
+
 #pragma mark - Private methods
 
 - (id) _registerParamsValidationWithBlock:(FWTParameterValidationBlock)block
@@ -0,0 +1,186 @@
+//
+//  FWTRequesterPoolTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <OCMock/OCMock.h>
+#import "FWTRequesterPool.h"
+#import "FWTRequesterManager.h"
+#import "FWTRetryScheduler.h"
+#import "FWTServerConfiguration.h"
+#import "FWTNotifiableLogger.h"
+
+@interface FWTRequesterPoolTests : XCTestCase
+
+@property (nonatomic, strong) FWTRequesterPool *pool;
+@property (nonatomic, strong) NSURLSession *session;
+@property (nonatomic, assign) NSUInteger builtManagers;
+
+@end
+
+@implementation FWTRequesterPoolTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.pool = [[FWTRequesterPool alloc] init];
+    self.session = [NSURLSession sessionWithConfiguration:[NSURLSessionConfiguration ephemeralSessionConfiguration]];
+    self.builtManagers = 0;
+}
+
+- (void)tearDown
+{
+    [self.session invalidateAndCancel];
+    [super tearDown];
+}
+
+- (void)testManagerIsReusedForTheSameConfiguration
+{
+    FWTRequesterManager *first = [self _managerForURL:@"https://one.test" groupId:@"group" session:self.session];
+    FWTRequesterManager *second = [self _managerForURL:@"https://one.test" groupId:@"group" session:self.session];
+
+    XCTAssertEqual(first, second);
+    XCTAssertEqual(self.builtManagers, 1);
+    XCTAssertEqual(self.pool.count, 1);
+}
+
+- (void)testDifferentConfigurationsUseDifferentManagers
+{
+    FWTRequesterManager *one = [self _managerForURL:@"https://one.test" groupId:nil session:self.session];
+    FWTRequesterManager *two = [self _managerForURL:@"https://two.test" groupId:nil session:self.session];
+    FWTRequesterManager *otherGroup = [self _managerForURL:@"https://one.test" groupId:@"group" session:self.session];
+    FWTRequesterManager *otherSession = [self _managerForURL:@"https://one.test" groupId:nil session:[NSURLSession sharedSession]];
+
+    XCTAssertNotEqual(one, two);
+    XCTAssertNotEqual(one, otherGroup);
+    XCTAssertNotEqual(one, otherSession);
+    XCTAssertEqual(self.builtManagers, 4);
+    XCTAssertEqual([self _managerForURL:@"https://two.test" groupId:nil session:self.session], two);
+}
+
+- (void)testRemoveManagersOfAGroup
+{
+    FWTRequesterManager *group = [self _managerForURL:@"https://one.test" groupId:@"group" session:self.session];
+    FWTRequesterManager *app = [self _managerForURL:@"https://one.test" groupId:nil session:self.session];
+
+    [self.pool removeRequesterManagersForGroupId:@"group"];
+
+    XCTAssertEqual(self.pool.count, 1);
+    XCTAssertNotEqual([self _managerForURL:@"https://one.test" groupId:@"group" session:self.session], group);
+    XCTAssertEqual([self _managerForURL:@"https://one.test" groupId:nil session:self.session], app);
+}
+
+- (void)testIdleManagersAreEvicted
+{
+    self.pool.idleTimeout = 0.05;
+    FWTRequesterManager *idle = [self _managerForURL:@"https://one.test" groupId:nil session:self.session];
+    [NSThread sleepForTimeInterval:0.1];
+
+    FWTRequesterManager *other = [self _managerForURL:@"https://two.test" groupId:nil session:self.session];
+    XCTAssertEqual(self.pool.count, 1);
+    XCTAssertNotEqual([self _managerForURL:@"https://one.test" groupId:nil session:self.session], idle);
+    XCTAssertNotNil(other);
+}
+
+- (void)testManagersWithPendingRetriesAreKept
+{
+    self.pool.idleTimeout = 0.05;
+    id retryScheduler = OCMClassMock([FWTRetryScheduler class]);
+    OCMStub([retryScheduler pendingRetries]).andReturn(1);
+
+    id busy = OCMClassMock([FWTRequesterManager class]);
+    OCMStub([busy retryScheduler]).andReturn(retryScheduler);
+    [self.pool requesterManagerForConfiguration:[self _configurationWithURL:@"https://one.test"]
+                                        groupId:nil
+                                        session:self.session
+                                       settings:nil
+                                        builder:^FWTRequesterManager *{
+        return busy;
+    }];
+    [NSThread sleepForTimeInterval:0.1];
+
+    [self _managerForURL:@"https://two.test" groupId:nil session:self.session];
+    XCTAssertEqual(self.pool.count, 2);
+}
+
+- (void)testConcurrentAccessBuildsASingleManager
+{
+    dispatch_apply(200, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        [self _managerForURL:@"https://one.test" groupId:@"group" session:self.session];
+    });
+    XCTAssertEqual(self.builtManagers, 1);
+}
+
+- (void)testSettingsAreAppliedWhenTheManagerIsRebuilt
+{
+    self.pool.idleTimeout = 0.05;
+    FWTRequesterSettings *settings = [[FWTRequesterSettings alloc] init];
+    settings.retryAttempts = 7;
+    settings.requestCompressionThreshold = 512;
+
+    id first = [self _managerForURL:@"https://one.test" settings:settings];
+    OCMVerify([first setRetryAttempts:7]);
+    [NSThread sleepForTimeInterval:0.1];
+    [self _managerForURL:@"https://two.test" groupId:nil session:self.session];
+
+    id rebuilt = [self _managerForURL:@"https://one.test" settings:settings];
+    XCTAssertNotEqual(first, rebuilt);
+    OCMVerify([rebuilt setRetryAttempts:7]);
+    OCMVerify([rebuilt setRequestCompressionThreshold:512]);
+}
+
+- (void)testDifferentSettingsUseDifferentManagers
+{
+    FWTRequesterSettings *settings = [[FWTRequesterSettings alloc] init];
+    FWTRequesterManager *defaults = [self _managerForURL:@"https://one.test" settings:nil];
+    XCTAssertEqual([self _managerForURL:@"https://one.test" settings:settings], defaults);
+
+    settings.logger = OCMProtocolMock(@protocol(FWTNotifiableLogger));
+    FWTRequesterManager *logged = [self _managerForURL:@"https://one.test" settings:settings];
+    XCTAssertNotEqual(logged, defaults);
+    XCTAssertEqual(self.builtManagers, 2);
+}
+
+- (void)testNilAndEmptyGroupShareTheManager
+{
+    FWTRequesterManager *app = [self _managerForURL:@"https://one.test" groupId:nil session:self.session];
+    XCTAssertEqual([self _managerForURL:@"https://one.test" groupId:@"" session:self.session], app);
+    XCTAssertNotEqual([self _managerForURL:@"https://one.test" groupId:@"(null)" session:self.session], app);
+}
+
+#pragma mark - Private
+
+- (FWTRequesterManager *)_managerForURL:(NSString *)url settings:(FWTRequesterSettings *)settings
+{
+    return [self.pool requesterManagerForConfiguration:[self _configurationWithURL:url]
+                                               groupId:nil
+                                               session:self.session
+                                              settings:settings
+                                               builder:^FWTRequesterManager *{
+        self.builtManagers += 1;
+        return OCMClassMock([FWTRequesterManager class]);
+    }];
+}
+
+- (FWTServerConfiguration *)_configurationWithURL:(NSString *)url
+{
+    return [[FWTServerConfiguration alloc] initWithServerURL:[NSURL URLWithString:url]
+                                                    accessId:@"access"
+                                                andSecretKey:@"secret"];
+}
+
+- (FWTRequesterManager *)_managerForURL:(NSString *)url groupId:(NSString *)groupId session:(NSURLSession *)session
+{
+    return [self.pool requesterManagerForConfiguration:[self _configurationWithURL:url]
+                                               groupId:groupId
+                                               session:session
+                                              settings:nil
+                                               builder:^FWTRequesterManager *{
+        self.builtManagers += 1;
+        return OCMClassMock([FWTRequesterManager class]);
+    }];
+}
+
+@end
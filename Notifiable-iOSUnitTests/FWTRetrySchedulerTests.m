@@ -0,0 +1,95 @@
+//
+//  FWTRetrySchedulerTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTTestCase.h"
+#import "FWTRetryScheduler.h"
+#import "FWTHTTPSessionManager.h"
+
+@interface FWTRetrySchedulerTests : FWTTestCase
+
+@end
+
+@implementation FWTRetrySchedulerTests
+
+- (void)testDelayGrowsExponentiallyWithJitter
+{
+    FWTRetryScheduler *scheduler = [[FWTRetryScheduler alloc] initWithBaseDelay:1 maxDelay:1000];
+    NSMutableSet<NSNumber *> *delays = [[NSMutableSet alloc] init];
+    for (NSUInteger retry = 0; retry < 6; retry++) {
+        for (NSInteger sample = 0; sample < 100; sample++) {
+            NSTimeInterval delay = [scheduler delayForRetry:retry error:nil];
+            XCTAssertGreaterThanOrEqual(delay, 0);
+            XCTAssertLessThanOrEqual(delay, pow(2, retry));
+            [delays addObject:@(delay)];
+        }
+    }
+    XCTAssertGreaterThan(delays.count, 500, @"The delays should be randomized");
+}
+
+- (void)testDelayIsCapped
+{
+    FWTRetryScheduler *scheduler = [[FWTRetryScheduler alloc] initWithBaseDelay:60 maxDelay:120];
+    for (NSInteger sample = 0; sample < 100; sample++) {
+        XCTAssertLessThanOrEqual([scheduler delayForRetry:40 error:nil], 120);
+    }
+}
+
+- (void)testRetryAfterIsRespected
+{
+    FWTRetryScheduler *scheduler = [[FWTRetryScheduler alloc] initWithBaseDelay:1 maxDelay:600];
+    NSError *error = [NSError errorWithDomain:@"FWTNotifiableError" code:503 userInfo:@{FWTHTTPRetryAfterErrorKey: @120}];
+    XCTAssertEqual([scheduler delayForRetry:0 error:error], 120);
+    
+    scheduler.maxDelay = 30;
+    XCTAssertEqual([scheduler delayForRetry:0 error:error], 30);
+}
+
+- (void)testRetryCounters
+{
+    FWTRetryScheduler *scheduler = [[FWTRetryScheduler alloc] initWithBaseDelay:0.1 maxDelay:0.1];
+    XCTestExpectation *fired = [self expectationWithDescription:@"Retry fired"];
+    __block dispatch_block_t finish;
+    [scheduler scheduleOperation:^(dispatch_block_t completion) {
+        XCTAssertFalse([NSThread isMainThread]);
+        finish = completion;
+        [fired fulfill];
+    } afterDelay:[scheduler delayForRetry:0 error:nil]];
+    XCTAssertEqual(scheduler.pendingRetries, 1);
+    XCTAssertEqual(scheduler.inFlightRetries, 0);
+    
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(scheduler.pendingRetries, 0);
+    XCTAssertEqual(scheduler.inFlightRetries, 1);
+    
+    finish();
+    finish();
+    XCTAssertEqual(scheduler.inFlightRetries, 0);
+}
+
+- (void)testCancelledRetryNeverFires
+{
+    FWTRetryScheduler *scheduler = [[FWTRetryScheduler alloc] initWithBaseDelay:0.1 maxDelay:0.1];
+    __block BOOL fired = NO;
+    dispatch_block_t cancel = [scheduler scheduleOperation:^(dispatch_block_t completion) {
+        fired = YES;
+        completion();
+    } afterDelay:0.1];
+    XCTAssertEqual(scheduler.pendingRetries, 1);
+    
+    cancel();
+    cancel();
+    XCTAssertEqual(scheduler.pendingRetries, 0);
+    
+    XCTestExpectation *delay = [self expectationWithDescription:@"Delay"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.3 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [delay fulfill];
+    });
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertFalse(fired);
+    XCTAssertEqual(scheduler.inFlightRetries, 0);
+}
+
+@end
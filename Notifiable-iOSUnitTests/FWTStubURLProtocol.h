@@ -0,0 +1,49 @@
+//
+//  FWTStubURLProtocol.h
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** Response given by the stub server to a request */
+@interface FWTStubResponse : NSObject
+
+@property (nonatomic, assign) NSInteger statusCode;
+@property (nonatomic, copy) NSDictionary<NSString *, NSString *> *headerFields;
+@property (nonatomic, copy, nullable) NSData *body;
+/** Time waited before answering */
+@property (nonatomic, assign) NSTimeInterval delay;
+
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode body:(nullable NSData *)body;
+
+@end
+
+/** Returns the response to a request. Nil leaves the request waiting until it is cancelled. */
+typedef FWTStubResponse * _Nullable (^FWTStubResponseBlock)(NSURLRequest *request);
+
+/**
+ In-process stand-in of a server, so the tests run the URL loading system without a network.
+ Every request is recorded and answered with the response block, by default a 200 with an
+ empty JSON object. The state is shared by the class, so each suite resets it on its setUp.
+ */
+@interface FWTStubURLProtocol : NSURLProtocol
+
+/** Requests loaded since the last reset, in order */
+@property (class, nonatomic, copy, readonly) NSArray<NSURLRequest *> *recordedRequests;
+/** Benchmarks turn it off, so the recorded requests don't count as heap growth. Default: YES */
+@property (class, nonatomic, assign) BOOL recordsRequests;
+
++ (void)setResponseBlock:(nullable FWTStubResponseBlock)responseBlock;
+
+/** Forget the recorded requests and restore the default response and recording */
++ (void)reset;
+
+/** Adds the stub to the protocols of the configuration, so its sessions load from the stub */
++ (NSURLSessionConfiguration *)stubbedConfiguration:(NSURLSessionConfiguration *)configuration;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,135 @@
+//
+//  FWTStubURLProtocol.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import "FWTStubURLProtocol.h"
+
+static NSMutableArray<NSURLRequest *> *recordedRequests;
+static FWTStubResponseBlock responseBlock;
+static BOOL recordsRequests = YES;
+
+@implementation FWTStubResponse
+
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode body:(NSData *)body
+{
+    FWTStubResponse *response = [[FWTStubResponse alloc] init];
+    response.statusCode = statusCode;
+    response.headerFields = @{@"Content-Type": @"application/json"};
+    response.body = body;
+    return response;
+}
+
+@end
+
+@interface FWTStubURLProtocol ()
+
+@property (atomic, assign) BOOL stopped;
+
+@end
+
+@implementation FWTStubURLProtocol
+
++ (NSArray<NSURLRequest *> *)recordedRequests
+{
+    @synchronized(self) {
+        return [recordedRequests copy] ?: @[];
+    }
+}
+
++ (BOOL)recordsRequests
+{
+    @synchronized(self) {
+        return recordsRequests;
+    }
+}
+
++ (void)setRecordsRequests:(BOOL)records
+{
+    @synchronized(self) {
+        recordsRequests = records;
+    }
+}
+
++ (void)setResponseBlock:(FWTStubResponseBlock)block
+{
+    @synchronized(self) {
+        responseBlock = [block copy];
+    }
+}
+
++ (void)reset
+{
+    @synchronized(self) {
+        recordedRequests = [[NSMutableArray alloc] init];
+        responseBlock = nil;
+        recordsRequests = YES;
+    }
+}
+
++ (NSURLSessionConfiguration *)stubbedConfiguration:(NSURLSessionConfiguration *)configuration
+{
+    configuration.protocolClasses = [@[self] arrayByAddingObjectsFromArray:configuration.protocolClasses ?: @[]];
+    return configuration;
+}
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request
+{
+    return YES;
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request
+{
+    return request;
+}
+
+- (void)startLoading
+{
+    FWTStubResponseBlock block;
+    @synchronized([FWTStubURLProtocol class]) {
+        if (recordedRequests == nil) {
+            recordedRequests = [[NSMutableArray alloc] init];
+        }
+        if (recordsRequests) {
+            [recordedRequests addObject:self.request];
+        }
+        block = responseBlock;
+    }
+
+    FWTStubResponse *stubResponse = block ? block(self.request) : [FWTStubResponse responseWithStatusCode:200 body:[@"{}" dataUsingEncoding:NSUTF8StringEncoding]];
+    if (stubResponse == nil) {
+        return;
+    }
+    if (stubResponse.delay <= 0) {
+        [self _answerWithResponse:stubResponse];
+        return;
+    }
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(stubResponse.delay * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        if (!self.stopped) {
+            [self _answerWithResponse:stubResponse];
+        }
+    });
+}
+
+- (void)stopLoading
+{
+    self.stopped = YES;
+}
+
+#pragma mark - Private
+
+- (void)_answerWithResponse:(FWTStubResponse *)stubResponse
+{
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                              statusCode:stubResponse.statusCode
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:stubResponse.headerFields];
+    [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+    if (stubResponse.body.length > 0) {
+        [self.client URLProtocol:self didLoadData:stubResponse.body];
+    }
+    [self.client URLProtocolDidFinishLoading:self];
+}
+
+@end
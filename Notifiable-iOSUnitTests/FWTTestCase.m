@@ -10,6 +10,8 @@
 #import "FWTRequesterManager.h"
 #import "FWTNotifiableManager.h"
 #import "FWTNotifiableDevice.h"
+#import "FWTNotificationOutbox.h"
+#import "FWTNotifiableStateStore.h"
 #import <OCMock/OCMock.h>
 
 typedef void(^FWTTestRegisterBlock)(FWTNotifiableDevice *device, NSError* error);
@@ -19,13 +21,15 @@ typedef void(^FWTTestRegisterBlock)(FWTNotifiableDevice *device, NSError* error)
 - (void)setUp
 {
     [super setUp];
-    [[NSUserDefaults standardUserDefaults] removeObjectForKey:@"FWTUserInfoNotifiableCurrentDeviceKey"];
+    [[FWTNotifiableStateStore storeWithGroupId:nil] storeDevice:nil];
+    [[FWTNotificationOutbox outboxWithGroupId:nil] clear];
 }
 
 - (void)tearDown
 {
     [super setUp];
-    [[NSUserDefaults standardUserDefaults] removeObjectForKey:@"FWTUserInfoNotifiableCurrentDeviceKey"];
+    [[FWTNotifiableStateStore storeWithGroupId:nil] storeDevice:nil];
+    [[FWTNotificationOutbox outboxWithGroupId:nil] clear];
 }
 
 - (void) assertDictionary:(NSDictionary *)origin withTarget:(NSDictionary *)target
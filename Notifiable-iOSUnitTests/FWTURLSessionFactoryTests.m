@@ -0,0 +1,68 @@
+//
+//  FWTURLSessionFactoryTests.m
+//  Notifiable-iOS
+//  Copyright © 2020 Future Workshops. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "FWTURLSessionFactory.h"
+#import "FWTStubURLProtocol.h"
+
+@interface FWTURLSessionFactoryTests : XCTestCase
+
+@property (nonatomic, strong) NSURLSession *session;
+
+@end
+
+@implementation FWTURLSessionFactoryTests
+
+- (void)setUp
+{
+    [super setUp];
+    [FWTStubURLProtocol reset];
+    NSURLSessionConfiguration *configuration = [FWTStubURLProtocol stubbedConfiguration:[FWTURLSessionFactory sessionConfiguration]];
+    self.session = [NSURLSession sessionWithConfiguration:configuration];
+}
+
+- (void)tearDown
+{
+    [self.session invalidateAndCancel];
+    [FWTStubURLProtocol reset];
+    [super tearDown];
+}
+
+- (void)testSharedSessionIsReused
+{
+    XCTAssertNotNil(FWTURLSessionFactory.sharedSession);
+    XCTAssertEqual(FWTURLSessionFactory.sharedSession, FWTURLSessionFactory.sharedSession);
+    XCTAssertNotEqual(FWTURLSessionFactory.sharedSession, [NSURLSession sharedSession]);
+}
+
+- (void)testSessionConfiguration
+{
+    NSURLSessionConfiguration *configuration = FWTURLSessionFactory.sharedSession.configuration;
+    XCTAssertNil(configuration.URLCache);
+    XCTAssertFalse(configuration.HTTPShouldSetCookies);
+    XCTAssertEqual(configuration.HTTPCookieAcceptPolicy, NSHTTPCookieAcceptPolicyNever);
+    XCTAssertEqual(configuration.requestCachePolicy, NSURLRequestReloadIgnoringLocalCacheData);
+    XCTAssertEqual(configuration.HTTPMaximumConnectionsPerHost, 2);
+}
+
+- (void)testEachHostIsWarmedOnce
+{
+    [FWTURLSessionFactory prewarmSession:self.session withURL:[NSURL URLWithString:@"https://notifiable.test"]];
+    [FWTURLSessionFactory prewarmSession:self.session withURL:[NSURL URLWithString:@"https://notifiable.test/api"]];
+    [FWTURLSessionFactory prewarmSession:self.session withURL:[NSURL URLWithString:@"https://other.test"]];
+    [FWTURLSessionFactory prewarmSession:self.session withURL:nil];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Prewarm"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.2 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+
+    NSPredicate *warmUp = [NSPredicate predicateWithFormat:@"HTTPMethod == %@", @"HEAD"];
+    XCTAssertEqual([FWTStubURLProtocol.recordedRequests filteredArrayUsingPredicate:warmUp].count, 2);
+}
+
+@end
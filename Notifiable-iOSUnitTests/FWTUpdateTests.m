@@ -12,6 +12,8 @@
 #import "FWTNotifiableManager.h"
 #import "FWTNotifiableDevice.h"
 #import "NSLocale+FWTNotifiable.h"
+#import "FWTNotifiableStateStore.h"
+#import "FWTNotifiableOperation.h"
 #import <OCMock/OCMock.h>
 
 @interface FWTUpdateTests : FWTTestCase
@@ -328,6 +330,150 @@
     [mockLocale stopMocking];
 }
 
+- (void) testUnchangedUpdateIsNotSent
+{
+    [self _registerAnonymousDevice];
+    
+    __block NSInteger updateRequests = 0;
+    [self _stubUpdateOnMock:self.requesterManagerMock withBlock:^(NSString *alias, NSData *token, NSString *name, NSLocale *locale, NSDictionary *customProperties, NSDictionary *platformProperties) {
+        updateRequests += 1;
+    }];
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"First update"];
+    [self.manager updateDeviceName:@"device" completionHandler:^(FWTNotifiableDevice *device, NSError * _Nullable error) {
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(updateRequests, 1);
+    XCTAssertEqual(self.manager.avoidedUpdateCount, 0);
+    
+    expectation = [self expectationWithDescription:@"Same update"];
+    [self.manager updateDeviceName:@"device" completionHandler:^(FWTNotifiableDevice *device, NSError * _Nullable error) {
+        XCTAssertNil(error);
+        XCTAssertEqualObjects(device.name, @"device");
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqual(updateRequests, 1);
+    XCTAssertEqual(self.manager.avoidedUpdateCount, 1);
+}
+
+- (void) testOnlyChangedFieldsAreSent
+{
+    [self _registerAnonymousDevice];
+    
+    __block NSString *sentName;
+    __block NSDictionary *sentCustomProperties;
+    __block NSDictionary *sentPlatformProperties;
+    [self _stubUpdateOnMock:self.requesterManagerMock withBlock:^(NSString *alias, NSData *token, NSString *name, NSLocale *locale, NSDictionary *customProperties, NSDictionary *platformProperties) {
+        sentName = name;
+        sentCustomProperties = customProperties;
+        sentPlatformProperties = platformProperties;
+    }];
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"First update"];
+    [self.manager updateDeviceToken:nil
+                         deviceName:@"device"
+                          userAlias:nil
+                             locale:nil
+                   customProperties:@{@"color": @"blue", @"size": @1}
+                 platformProperties:@{@"os_version": @"13.0", @"app_version": @"1.0"}
+                  completionHandler:^(FWTNotifiableDevice *device, NSError * _Nullable error) {
+                      [expectation fulfill];
+                  }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    XCTAssertEqualObjects(sentName, @"device");
+    
+    expectation = [self expectationWithDescription:@"Second update"];
+    [self.manager updateDeviceToken:self.tokenData
+                         deviceName:@"device"
+                          userAlias:nil
+                             locale:nil
+                   customProperties:@{@"color": @"red", @"size": @1}
+                 platformProperties:@{@"os_version": @"13.0", @"app_version": @"1.1"}
+                  completionHandler:^(FWTNotifiableDevice *device, NSError * _Nullable error) {
+                      XCTAssertEqualObjects(device.customProperties, (@{@"color": @"red", @"size": @1}));
+                      XCTAssertEqualObjects(device.platformProperties, (@{@"os_version": @"13.0", @"app_version": @"1.1"}));
+                      [expectation fulfill];
+                  }];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    
+    XCTAssertNil(sentName);
+    XCTAssertEqualObjects(sentCustomProperties, (@{@"color": @"red", @"size": @1}));
+    XCTAssertEqualObjects(sentPlatformProperties, @{@"app_version": @"1.1"});
+}
+
+- (void)testInterleavedUpdatesAndAssociationsAreMerged
+{
+    [self _registerDeviceWithUserAlias:@"user"];
+    [self _stubUpdateOnMock:self.requesterManagerMock withBlock:^(NSString *alias, NSData *token, NSString *name, NSLocale *locale, NSDictionary *customProperties, NSDictionary *platformProperties) {}];
+
+    NSUInteger calls = 300;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Interleaved"];
+    expectation.expectedFulfillmentCount = calls;
+    expectation.assertForOverFulfill = YES;
+    FWTNotifiableManager *manager = self.manager;
+    dispatch_apply(calls, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        FWTNotifiableOperationCompletionHandler handler = ^(FWTNotifiableDevice *device, NSError * _Nullable error) {
+            XCTAssertNil(error);
+            [expectation fulfill];
+        };
+        if (index % 2 == 0) {
+            [manager updateDeviceToken:nil
+                            deviceName:nil
+                             userAlias:nil
+                                locale:nil
+                      customProperties:nil
+                    platformProperties:@{[NSString stringWithFormat:@"key%zu", index]: @(index)}
+                     completionHandler:handler];
+        } else {
+            [manager associateDeviceToUser:(index % 4 == 1 ? @"user" : @"other") completionHandler:handler];
+        }
+    });
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    FWTNotifiableDevice *device = manager.currentDevice;
+    XCTAssertEqual(device.platformProperties.count, calls / 2);
+    XCTAssertTrue([@[@"user", @"other"] containsObject:device.user]);
+    XCTAssertEqualObjects(device.tokenId, self.deviceTokenId);
+
+    FWTNotifiableDevice *storedDevice = [[FWTNotifiableStateStore storeWithGroupId:nil] device];
+    XCTAssertEqualObjects(storedDevice.user, device.user);
+    XCTAssertEqualObjects(storedDevice.platformProperties, device.platformProperties);
+}
+
+- (void) _stubUpdateOnMock:(id)mock withBlock:(void(^)(NSString *alias, NSData *token, NSString *name, NSLocale *locale, NSDictionary *customProperties, NSDictionary *platformProperties))block
+{
+    NSNumber *tokenId = self.deviceTokenId;
+    OCMStub([mock updateDevice:OCMOCK_ANY
+                 withUserAlias:OCMOCK_ANY
+                         token:OCMOCK_ANY
+                          name:OCMOCK_ANY
+                        locale:OCMOCK_ANY
+              customProperties:OCMOCK_ANY
+            platformProperties:OCMOCK_ANY
+             completionHandler:OCMOCK_ANY]).andDo(^(NSInvocation *invocation) {
+        __unsafe_unretained NSString *alias;
+        __unsafe_unretained NSData *token;
+        __unsafe_unretained NSString *name;
+        __unsafe_unretained NSLocale *locale;
+        __unsafe_unretained NSDictionary *customProperties;
+        __unsafe_unretained NSDictionary *platformProperties;
+        __unsafe_unretained FWTDeviceTokenIdResponse handler;
+        [invocation getArgument:&alias atIndex:3];
+        [invocation getArgument:&token atIndex:4];
+        [invocation getArgument:&name atIndex:5];
+        [invocation getArgument:&locale atIndex:6];
+        [invocation getArgument:&customProperties atIndex:7];
+        [invocation getArgument:&platformProperties atIndex:8];
+        [invocation getArgument:&handler atIndex:9];
+        block(alias, token, name, locale, customProperties, platformProperties);
+        if (handler) {
+            handler(tokenId, nil);
+        }
+    });
+}
+
 - (void) _expectUpdateOnManager:(FWTNotifiableManager *)manager withBlock:(void(^)(FWTNotifiableManager* manager))block
 {
     id managerMock = OCMPartialMock(manager);